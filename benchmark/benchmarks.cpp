@@ -5,7 +5,9 @@
 #include <magnetron.h>
 #define ANKERL_NANOBENCH_IMPLEMENT
 #include <nanobench.h>
+#include <algorithm>
 #include <thread>
+#include <vector>
 
 #include "magnetron_internal.h"
 
@@ -49,7 +51,590 @@ static auto bench_cpu_compute(std::int64_t numel_per_dim) -> void {
     }
 }
 
+static auto sgemm_naive(const float* A, const float* B, float* C, std::int64_t M, std::int64_t N, std::int64_t K) -> void { // Reference: the former i-k-j loop of mag_blas_matmul_f32
+    for (std::int64_t i=0; i < M; ++i) {
+        for (std::int64_t j=0; j < N; ++j)
+            C[i*N + j] = 0.0f;
+        for (std::int64_t k=0; k < K; ++k) {
+            float a_ik = A[i*K + k];
+            for (std::int64_t j=0; j < N; ++j)
+                C[i*N + j] += a_ik*B[k*N + j];
+        }
+    }
+}
+
+static auto bench_cpu_sgemm(std::int64_t M, std::int64_t N, std::int64_t K) -> void {
+    ankerl::nanobench::Bench bench {};
+    bench.title("SGEMM " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .unit("FLOP")
+        .batch(2.0*static_cast<double>(M)*static_cast<double>(N)*static_cast<double>(K)) // Reported as FLOP/s
+        .minEpochIterations(M*N*K < 100'000'000 ? 10 : 1)
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = 1;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_normal(B, 0.0f, 1.0f);
+    std::vector<float> C (M*N);
+
+    bench.run("naive i-k-j loop", [&] {
+        sgemm_naive(static_cast<const float*>(mag_tensor_data_ptr(A)), static_cast<const float*>(mag_tensor_data_ptr(B)), C.data(), M, N, K);
+        ankerl::nanobench::doNotOptimizeAway(C.data());
+    });
+    bench.run("mag_matmul (blocked SGEMM)", [&] {
+        mag_tensor_t* R = mag_matmul(A, B);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+
+    mag_tensor_decref(B);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_sgemm_prepacked(std::int64_t M, std::int64_t N, std::int64_t K) -> void { // Small batch inference against fixed weights
+    ankerl::nanobench::Bench bench {};
+    bench.title("SGEMM pre-packed weights " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .unit("FLOP")
+        .batch(2.0*static_cast<double>(M)*static_cast<double>(N)*static_cast<double>(K))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = 1;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_normal(B, 0.0f, 1.0f);
+
+    auto exec_bench = [&](const char* name) {
+        bench.run(name, [&] {
+            mag_tensor_t* R = mag_matmul(A, B);
+            ankerl::nanobench::doNotOptimizeAway(R);
+            mag_tensor_decref(R);
+        });
+    };
+    exec_bench("mag_matmul (packing per call)");
+    mag_tensor_pack_weights(B);
+    exec_bench("mag_matmul (pre-packed weights)");
+
+    mag_tensor_decref(B);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_linear(std::int64_t M, std::int64_t N, std::int64_t K) -> void { // Dense layer forward: sigmoid(A x B + bias), unfused vs fused epilogue
+    ankerl::nanobench::Bench bench {};
+    bench.title("Linear + bias + sigmoid " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .unit("FLOP")
+        .batch(2.0*static_cast<double>(M)*static_cast<double>(N)*static_cast<double>(K))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = 1;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_normal(B, 0.0f, 1.0f);
+    mag_tensor_t* bias = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, N);
+    mag_tensor_fill_random_normal(bias, 0.0f, 1.0f);
+
+    bench.run("mag_matmul + mag_add + mag_sigmoid", [&] {
+        mag_tensor_t* Z = mag_matmul(A, B);
+        mag_tensor_t* Zb = mag_add(Z, bias);
+        mag_tensor_t* R = mag_sigmoid(Zb);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+        mag_tensor_decref(Zb);
+        mag_tensor_decref(Z);
+    });
+    bench.run("mag_linear (fused epilogue)", [&] {
+        mag_tensor_t* R = mag_linear(A, B, bias, MAG_ACTIVATION_SIGMOID);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+
+    mag_tensor_decref(bias);
+    mag_tensor_decref(B);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_matmul_q8(std::int64_t M, std::int64_t N, std::int64_t K) -> void { // Int8 weights stored as transposed [N, K], per-row scales
+    ankerl::nanobench::Bench bench {};
+    bench.title("Int8 matmul " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .unit("OP")
+        .batch(2.0*static_cast<double>(M)*static_cast<double>(N)*static_cast<double>(K))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = 1;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K);
+    mag_tensor_fill_random_normal(W, 0.0f, 1.0f);
+    mag_tensor_t* Wt = mag_transpose(W);
+    mag_tensor_t* Aq = mag_quantize(A, 0);
+    mag_tensor_t* Wq = mag_quantize(W, 0);
+    mag_tensor_t* Wqt = mag_transpose(Wq);
+
+    bench.run("f32 x f32", [&] {
+        mag_tensor_t* R = mag_matmul(A, Wt);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("i8 x f32 (rhs quantized on the fly)", [&] {
+        mag_tensor_t* R = mag_matmul(Aq, Wt);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("i8 x i8", [&] {
+        mag_tensor_t* R = mag_matmul(Aq, Wqt);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+
+    mag_tensor_decref(Wqt);
+    mag_tensor_decref(Wq);
+    mag_tensor_decref(Aq);
+    mag_tensor_decref(Wt);
+    mag_tensor_decref(W);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_matmul_qblock(std::int64_t M, std::int64_t N, std::int64_t K) -> void { // Block-quantized weights stored as transposed [N, K], F32 activations
+    ankerl::nanobench::Bench bench {};
+    bench.title("Block-quantized matmul " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .unit("OP")
+        .batch(2.0*static_cast<double>(M)*static_cast<double>(N)*static_cast<double>(K))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = 1;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K);
+    mag_tensor_fill_random_normal(W, 0.0f, 1.0f);
+    mag_tensor_t* Wt = mag_transpose(W);
+    mag_tensor_t* W8 = mag_cast(W, MAG_DTYPE_Q8);
+    mag_tensor_t* W8t = mag_transpose(W8);
+    mag_tensor_t* W4 = mag_cast(W, MAG_DTYPE_Q4);
+    mag_tensor_t* W4t = mag_transpose(W4);
+
+    bench.run("f32 x f32", [&] {
+        mag_tensor_t* R = mag_matmul(A, Wt);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("f32 x q8", [&] {
+        mag_tensor_t* R = mag_matmul(A, W8t);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("f32 x q4", [&] {
+        mag_tensor_t* R = mag_matmul(A, W4t);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+
+    mag_tensor_decref(W4t);
+    mag_tensor_decref(W4);
+    mag_tensor_decref(W8t);
+    mag_tensor_decref(W8);
+    mag_tensor_decref(Wt);
+    mag_tensor_decref(W);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_reduce(std::int64_t rows, std::int64_t cols, std::uint32_t threads) -> void { // Input bytes per second of full and row reductions
+    ankerl::nanobench::Bench bench {};
+    bench.title("Reduce " + std::to_string(rows) + "x" + std::to_string(cols) + " on " + std::to_string(threads) + " threads")
+        .unit("B")
+        .batch(static_cast<double>(rows*cols*sizeof(float)))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = threads;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, rows, cols);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    const std::int64_t row_axis[] = {0};
+
+    auto run = [&](const char* name, mag_tensor_t* (*op)(mag_tensor_t*)) {
+        bench.run(name, [&] {
+            mag_tensor_t* R = op(A);
+            ankerl::nanobench::doNotOptimizeAway(R);
+            mag_tensor_decref(R);
+        });
+    };
+    run("sum", &mag_sum);
+    run("mean", &mag_mean);
+    run("min", &mag_min);
+    run("max", &mag_max);
+    bench.run("sum over contiguous axis", [&] {
+        mag_tensor_t* R = mag_sum_axes(A, row_axis, 1, false);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("max over contiguous axis", [&] {
+        mag_tensor_t* R = mag_max_axes(A, row_axis, 1, false);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_elementwise(std::int64_t numel, std::uint32_t threads) -> void { // Memory throughput per elementwise op, bytes read + written
+    ankerl::nanobench::Bench bench {};
+    bench.title("Elementwise " + std::to_string(numel) + " elems on " + std::to_string(threads) + " threads")
+        .unit("B")
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = threads;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, numel);
+    mag_tensor_fill_random_uniform(A, 0.1f, 2.0f);
+    mag_tensor_t* B = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, numel);
+    mag_tensor_fill_random_uniform(B, 0.1f, 2.0f);
+
+    auto run = [&](const char* name, int streams, auto&& op) {
+        bench.batch(static_cast<double>(numel*streams*sizeof(float)));
+        bench.run(name, [&] {
+            mag_tensor_t* R = op();
+            ankerl::nanobench::doNotOptimizeAway(R);
+            mag_tensor_decref(R);
+        });
+    };
+    run("abs", 2, [&] { return mag_abs(A); });
+    run("neg", 2, [&] { return mag_neg(A); });
+    run("sqr", 2, [&] { return mag_sqr(A); });
+    run("sqrt", 2, [&] { return mag_sqrt(A); });
+    run("step", 2, [&] { return mag_step(A); });
+    run("log", 2, [&] { return mag_log(A); });
+    run("sin", 2, [&] { return mag_sin(A); });
+    run("cos", 2, [&] { return mag_cos(A); });
+    run("tanh", 2, [&] { return mag_tanh(A); });
+    run("adds", 2, [&] { return mag_adds(A, 1.5f); });
+    run("muls", 2, [&] { return mag_muls(A, 1.5f); });
+    run("divs", 2, [&] { return mag_divs(A, 1.5f); });
+    run("add", 3, [&] { return mag_add(A, B); });
+    run("mul", 3, [&] { return mag_mul(A, B); });
+    run("div", 3, [&] { return mag_div(A, B); });
+
+    mag_tensor_decref(B);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_fused(std::int64_t numel, std::uint32_t threads) -> void { // Eager elementwise chain vs. the same chain fused into one pass
+    ankerl::nanobench::Bench bench {};
+    bench.title("Fused (x - y)^2 * y + 3, " + std::to_string(numel) + " elems on " + std::to_string(threads) + " threads")
+        .unit("(x - y)^2 * y + 3")
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = threads;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* X = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, numel);
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    mag_tensor_t* Y = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, numel);
+    mag_tensor_fill_random_uniform(Y, 0.5f, 2.0f);
+
+    bench.run("eager", [&] {
+        mag_tensor_t* D = mag_sub(X, Y);
+        mag_tensor_t* S = mag_sqr(D);
+        mag_tensor_t* M = mag_mul(S, Y);
+        mag_tensor_t* R = mag_adds(M, 3.0f);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+        mag_tensor_decref(M);
+        mag_tensor_decref(S);
+        mag_tensor_decref(D);
+    });
+    mag_ctx_set_exec_mode(ctx, MAG_EXEC_MODE_DEFERRED);
+    mag_tensor_t* D = mag_sub(X, Y);
+    mag_tensor_t* S = mag_sqr(D);
+    mag_tensor_t* M = mag_mul(S, Y);
+    mag_tensor_t* R = mag_adds(M, 3.0f);
+    mag_tensor_eval_fused(R);
+    bench.run("fused", [&] {
+        mag_tensor_eval_fused(R);
+        ankerl::nanobench::doNotOptimizeAway(R);
+    });
+
+    mag_tensor_decref(R);
+    mag_tensor_decref(M);
+    mag_tensor_decref(S);
+    mag_tensor_decref(D);
+    mag_tensor_decref(Y);
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_replay(std::int64_t batch, std::int64_t dim, int layers, std::uint32_t threads) -> void { // Per-op overhead of a small inference step: eager vs. captured replay
+    ankerl::nanobench::Bench bench {};
+    bench.title(std::to_string(layers) + " scale-shift-tanh layers on " + std::to_string(batch) + "x" + std::to_string(dim) + ", " + std::to_string(threads) + " threads")
+        .unit("step")
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = threads;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* X = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, batch, dim);
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    std::vector<mag_tensor_t*> w {}, b {};
+    for (int l=0; l < layers; ++l) {
+        w.emplace_back(mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, dim));
+        mag_tensor_fill_random_uniform(w.back(), 0.5f, 1.5f);
+        b.emplace_back(mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, dim));
+        mag_tensor_fill_random_uniform(b.back(), -0.1f, 0.1f);
+    }
+    auto step = [&] {
+        mag_tensor_t* H = X;
+        mag_tensor_retain(H);
+        for (int l=0; l < layers; ++l) {
+            mag_tensor_t* S = mag_mul(H, w[l]);
+            mag_tensor_t* T = mag_add(S, b[l]);
+            mag_tensor_t* A = mag_tanh(T);
+            mag_tensor_decref(T);
+            mag_tensor_decref(S);
+            mag_tensor_decref(H);
+            H = A;
+        }
+        return H;
+    };
+
+    bench.run("eager", [&] {
+        mag_tensor_t* R = step();
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    mag_ctx_capture_begin(ctx);
+    mag_tensor_t* R = step();
+    mag_graph_t* g = mag_ctx_capture_end(ctx);
+    bench.run("replay", [&] {
+        mag_graph_execute(g);
+        ankerl::nanobench::doNotOptimizeAway(R);
+    });
+
+    mag_graph_destroy(g);
+    mag_tensor_decref(R);
+    for (int l=0; l < layers; ++l) {
+        mag_tensor_decref(w[l]);
+        mag_tensor_decref(b[l]);
+    }
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_broadcast(std::int64_t d0, std::int64_t d1, std::uint32_t threads) -> void { // Output bytes per second of broadcasting adds, shape[0] is the contiguous axis
+    ankerl::nanobench::Bench bench {};
+    bench.title("Broadcast add " + std::to_string(d0) + "x" + std::to_string(d1) + " on " + std::to_string(threads) + " threads")
+        .unit("B")
+        .batch(static_cast<double>(d0*d1*sizeof(float)))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = threads;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, d0, d1);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+
+    auto run = [&](const char* name, std::int64_t y0, std::int64_t y1) {
+        mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, y0, y1);
+        mag_tensor_fill_random_normal(B, 0.0f, 1.0f);
+        bench.run(name, [&] {
+            mag_tensor_t* R = mag_add(A, B);
+            ankerl::nanobench::doNotOptimizeAway(R);
+            mag_tensor_decref(R);
+        });
+        mag_tensor_decref(B);
+    };
+    run("same shape", d0, d1);
+    run("y contiguous row, repeated", d0, 1);
+    run("y splat along the contiguous axis", 1, d1);
+    run("y tiled", d0/4, d1/4);
+
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_matmul_bf16(std::int64_t M, std::int64_t N, std::int64_t K) -> void { // BF16 weights stored as transposed [N, K]
+    ankerl::nanobench::Bench bench {};
+    bench.title("BF16 matmul " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .unit("FLOP")
+        .batch(2.0*static_cast<double>(M)*static_cast<double>(N)*static_cast<double>(K))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = 1;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K);
+    mag_tensor_fill_random_normal(W, 0.0f, 1.0f);
+    mag_tensor_t* Wt = mag_transpose(W);
+    mag_tensor_t* Ab = mag_cast(A, MAG_DTYPE_BF16);
+    mag_tensor_t* Wb = mag_cast(W, MAG_DTYPE_BF16);
+    mag_tensor_t* Wbt = mag_transpose(Wb);
+
+    bench.run("f32 x f32", [&] {
+        mag_tensor_t* R = mag_matmul(A, Wt);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("f32 x bf16", [&] {
+        mag_tensor_t* R = mag_matmul(A, Wbt);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("bf16 x bf16", [&] {
+        mag_tensor_t* R = mag_matmul(Ab, Wbt);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+
+    mag_tensor_decref(Wbt);
+    mag_tensor_decref(Wb);
+    mag_tensor_decref(Ab);
+    mag_tensor_decref(Wt);
+    mag_tensor_decref(W);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_f16(std::int64_t M, std::int64_t N, std::int64_t K) -> void { // F16 storage: elementwise add and matmul against F32
+    ankerl::nanobench::Bench bench {};
+    bench.title("F16 storage " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .relative(true);
+
+    mag_device_descriptor_t desc {};
+    desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+    desc.thread_count = 1;
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_normal(B, 0.0f, 1.0f);
+    mag_tensor_t* Ah = mag_cast(A, MAG_DTYPE_F16);
+    mag_tensor_t* Bh = mag_cast(B, MAG_DTYPE_F16);
+
+    bench.run("f32 add", [&] {
+        mag_tensor_t* R = mag_add(A, A);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("f16 add", [&] {
+        mag_tensor_t* R = mag_add(Ah, Ah);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("f32 x f32 matmul", [&] {
+        mag_tensor_t* R = mag_matmul(A, B);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+    bench.run("f16 x f16 matmul", [&] {
+        mag_tensor_t* R = mag_matmul(Ah, Bh);
+        ankerl::nanobench::doNotOptimizeAway(R);
+        mag_tensor_decref(R);
+    });
+
+    mag_tensor_decref(Bh);
+    mag_tensor_decref(Ah);
+    mag_tensor_decref(B);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+static auto bench_cpu_sgemm_scaling(std::int64_t M, std::int64_t N, std::int64_t K) -> void { // Thread scaling curve, most interesting for skinny shapes
+    ankerl::nanobench::Bench bench {};
+    bench.title("SGEMM scaling " + std::to_string(M) + "x" + std::to_string(K) + " * " + std::to_string(K) + "x" + std::to_string(N))
+        .unit("FLOP")
+        .batch(2.0*static_cast<double>(M)*static_cast<double>(N)*static_cast<double>(K))
+        .relative(true);
+
+    auto exec_bench = [&](std::uint32_t threads) {
+        mag_device_descriptor_t desc {};
+        desc.type = MAG_COMPUTE_DEVICE_TYPE_CPU;
+        desc.thread_count = threads;
+        mag_ctx_t* ctx = mag_ctx_create2(&desc);
+        mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+        mag_tensor_fill_random_normal(A, 0.0f, 1.0f);
+        mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+        mag_tensor_fill_random_normal(B, 0.0f, 1.0f);
+        bench.run(std::to_string(threads) + " threads", [&] {
+            mag_tensor_t* R = mag_matmul(A, B);
+            ankerl::nanobench::doNotOptimizeAway(R);
+            mag_tensor_decref(R);
+        });
+        mag_tensor_decref(B);
+        mag_tensor_decref(A);
+        mag_ctx_destroy(ctx);
+    };
+
+    std::uint32_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::uint32_t i=1; i <= num_threads; i <<= 1)
+        exec_bench(i);
+}
+
 auto main() -> int {
+    bench_cpu_sgemm(2048, 2048, 2048);
+    bench_cpu_sgemm(1024, 1024, 1024);
+    bench_cpu_sgemm(512, 512, 512);
+    bench_cpu_sgemm(128, 128, 128);
+    bench_cpu_sgemm(1000, 1000, 250);
+    bench_cpu_sgemm(4096, 1, 4096);             // GEMV
+    bench_cpu_sgemm(4096, 4, 4096);             // Batched GEMV
+    bench_cpu_sgemm_prepacked(1, 4096, 1024);
+    bench_cpu_sgemm_prepacked(8, 4096, 1024);
+    bench_cpu_sgemm_prepacked(64, 1024, 1024);
+    bench_cpu_linear(256, 1024, 1024);
+    bench_cpu_linear(64, 4096, 256);
+    bench_cpu_matmul_q8(256, 1024, 1024);
+    bench_cpu_matmul_q8(1, 4096, 4096);        // Int8 GEMV
+    bench_cpu_matmul_qblock(256, 1024, 1024);
+    bench_cpu_matmul_qblock(1, 4096, 4096);    // Quantized GEMV
+    bench_cpu_reduce(4096, 4096, 1);
+    bench_cpu_reduce(4096, 4096, std::max(1u, std::thread::hardware_concurrency()));
+    bench_cpu_reduce(64, 4096, 1);             // Fits in L2
+    bench_cpu_elementwise(1<<16, 1);          // Fits in L2
+    bench_cpu_elementwise(1<<24, 1);
+    bench_cpu_elementwise(1<<24, std::max(1u, std::thread::hardware_concurrency()));
+    bench_cpu_fused(1<<22, 1);
+    bench_cpu_fused(1<<22, std::max(1u, std::thread::hardware_concurrency()));
+    bench_cpu_replay(4, 64, 8, 1);             // Overhead bound
+    bench_cpu_replay(4, 64, 8, std::max(1u, std::thread::hardware_concurrency()));
+    bench_cpu_broadcast(4096, 4096, 1);
+    bench_cpu_broadcast(4096, 4096, std::max(1u, std::thread::hardware_concurrency()));
+    bench_cpu_matmul_bf16(256, 1024, 1024);
+    bench_cpu_matmul_bf16(1, 4096, 4096);      // BF16 GEMV
+    bench_cpu_f16(256, 1024, 1024);
+    bench_cpu_sgemm_scaling(16384, 64, 256);    // Tall-skinny
+    bench_cpu_sgemm_scaling(64, 16384, 256);    // Short-wide
+    bench_cpu_sgemm_scaling(1024, 1024, 1024);  // Square reference
     //bench_cpu_compute(10000);
     bench_cpu_compute(1000);
     bench_cpu_compute(750);
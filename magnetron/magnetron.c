@@ -571,6 +571,7 @@ mag_ctx_t* mag_ctx_create2(const mag_device_descriptor_t* device_info) {
 static void mag_tensor_destroy(mag_tensor_t* t);
 
 void mag_ctx_destroy(mag_ctx_t* ctx) {
+    if (ctx->capture) mag_graph_destroy(ctx->capture); /* Unfinished capture, release its references */
 #ifdef MAG_DEBUG /* Check for leaked tensors in RC tracking list and print them */
     mag_tensor_node_t** head = &ctx->rc_tracked;
     mag_tensor_node_t* curr = *head;
@@ -866,26 +867,56 @@ const mag_dtype_meta_t* mag_dtype_meta_of(mag_dtype_t type) {
             sizeof(float),
             "f32"
         },
+        [MAG_DTYPE_I8] = {
+            sizeof(int8_t),
+            "i8"
+        },
+        [MAG_DTYPE_BF16] = {
+            sizeof(uint16_t),
+            "bf16"
+        },
+        [MAG_DTYPE_F16] = {
+            sizeof(uint16_t),
+            "f16"
+        },
+        [MAG_DTYPE_Q8] = {
+            sizeof(mag_block_q8_t),
+            "q8"
+        },
+        [MAG_DTYPE_Q4] = {
+            sizeof(mag_block_q4_t),
+            "q4"
+        },
+        [MAG_DTYPE_I32] = {
+            sizeof(int32_t),
+            "i32"
+        },
     };
     return &infos[type];
 }
 
+static int64_t mag_dtype_data_size(mag_dtype_t type, int64_t numel, int64_t qblock) { /* Buffer size in bytes, quantized dtypes store their scales behind the values. */
+    if (type == MAG_DTYPE_I8) return mag_q8_scales_offs(numel) + numel/qblock*(int64_t)sizeof(float);
+    if (mag_dtype_is_qblock(type)) return numel/MAG_QK*mag_dtype_meta_of(type)->size;
+    return numel*mag_dtype_meta_of(type)->size;
+}
+
 static bool mag_check_are_inputs_valid(mag_op_t op, mag_tensor_t** inputs, uint32_t numin) {
     const mag_op_meta_t* meta = mag_op_meta_of(op);
-    if (mag_unlikely(meta->argcount != numin || numin > MAG_MAX_INPUT_TENSORS)) {
+    if (mag_unlikely(numin > meta->argcount || numin + meta->optargcount < meta->argcount || numin > MAG_MAX_INPUT_TENSORS)) {
         mag_print_separator(stderr);
         fprintf(stderr,
             "Failed to execute operation: %s.\n"
-            "ERROR: Operation requires %u input tensors, but %u were provided.\n"
+            "ERROR: Operation requires %u to %u input tensors, but %u were provided.\n"
             "    Hint: Ensure the correct number of input tensors are provided.\n",
-            meta->mnemonic, meta->argcount, numin
+            meta->mnemonic, meta->argcount - meta->optargcount, meta->argcount, numin
         );
         mag_print_separator(stderr);
         fputc('\n', stderr);
         fflush(stderr);
         return false;
     }
-    for (uint32_t i=0; i < meta->argcount; ++i) {
+    for (uint32_t i=0; i < numin; ++i) {
         if (mag_unlikely(!inputs[i])) {
             mag_print_separator(stderr);
             fprintf(stderr,
@@ -899,6 +930,54 @@ static bool mag_check_are_inputs_valid(mag_op_t op, mag_tensor_t** inputs, uint3
             fflush(stderr);
             return false;
         }
+        if (mag_unlikely(!inputs[i]->storage.base)) {
+            mag_print_separator(stderr);
+            fprintf(stderr,
+                "Failed to execute operation: %s.\n"
+                "ERROR: Input tensor %u '%s' has no storage.\n"
+                "    Hint: Intermediates of a memory planned graph lose their storage in mag_graph_destroy.\n",
+                meta->mnemonic, i, inputs[i]->name
+            );
+            mag_print_separator(stderr);
+            fputc('\n', stderr);
+            fflush(stderr);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool mag_check_are_input_dtypes_valid(mag_op_t op, mag_tensor_t** inputs, uint32_t numin) { /* Quantized and storage tensors can only be moved around, converted and multiplied. */
+    switch (op) {
+        case MAG_OP_CLONE:
+        case MAG_OP_VIEW:
+        case MAG_OP_TRANSPOSE:
+        case MAG_OP_PERMUTE:
+        case MAG_OP_MATMUL:
+        case MAG_OP_LINEAR:
+        case MAG_OP_QUANTIZE:
+        case MAG_OP_DEQUANTIZE:
+        case MAG_OP_CAST:
+        case MAG_OP_GATHER: return true; /* Checked by the validators. */
+        default: break;
+    }
+    const mag_op_meta_t* meta = mag_op_meta_of(op);
+    bool elementwise = op >= MAG_OP_ABS && op <= MAG_OP_DIVS; /* Elementwise ops also take F16 operands, if all of them are F16. */
+    mag_dtype_t dtype = elementwise && numin && inputs[0]->dtype == MAG_DTYPE_F16 ? MAG_DTYPE_F16 : MAG_DTYPE_F32;
+    for (uint32_t i=0; i < numin; ++i) {
+        if (mag_unlikely(inputs[i]->dtype != dtype)) {
+            mag_print_separator(stderr);
+            fprintf(stderr,
+                "Failed to execute operation: %s.\n"
+                "ERROR: Input tensor %u '%s' has data type %s, but the operation requires %s.\n"
+                "    Hint: Convert quantized tensors using dequantize() and storage tensors using cast().\n",
+                meta->mnemonic, i, inputs[i]->name, mag_dtype_meta_of(inputs[i]->dtype)->name, mag_dtype_meta_of(dtype)->name
+            );
+            mag_print_separator(stderr);
+            fputc('\n', stderr);
+            fflush(stderr);
+            return false;
+        }
     }
     return true;
 }
@@ -1006,12 +1085,11 @@ static bool mag_check_is_shape_broadcastable(mag_op_t op, const mag_tensor_t* a,
     return false;
 }
 
-static bool mag_check_is_shape_matmulable(mag_op_t op, const mag_tensor_t* a, const mag_tensor_t* b) { /* Check if tensor shapes are broadcast-able. (b into a) */
+static bool mag_check_is_shape_matmulable(mag_op_t op, const mag_tensor_t* a, const mag_tensor_t* b) { /* Check if tensor shapes are matmul-able. Batch dims (2..5) are broadcast-able into each other. */
     const mag_op_meta_t* meta = mag_op_meta_of(op);
-    if (mag_likely(a->shape[1] == b->shape[0])) return true;
-    bool valid_dims = true;
+    bool valid_dims = a->shape[1] == b->shape[0];
     for (uint32_t i=2; i < MAG_MAX_DIMS; ++i)
-        valid_dims &= a->shape[i] == 1 && b->shape[i] == 1;
+        valid_dims &= mag_xmax(a->shape[i], b->shape[i]) % mag_xmin(a->shape[i], b->shape[i]) == 0;
     if (mag_likely(valid_dims)) return true;
 
     mag_print_separator(stderr);
@@ -1021,7 +1099,7 @@ static bool mag_check_is_shape_matmulable(mag_op_t op, const mag_tensor_t* a, co
     mag_fmt_dims(&shape_2, &b->shape, b->rank);
     fprintf(stderr,
         "Failed to execute operation: %s.\n"
-        "ERROR: Input tensor shapes are not compatible for matrix multiplication. The rows of the first tensor must match the columns of the second tensor.\n"
+        "ERROR: Input tensor shapes are not compatible for matrix multiplication. The columns of the first tensor must match the rows of the second tensor and the batch dimensions must be broadcast-able.\n"
         "    - Input Tensor 1 '%s' Shape: %s\n"
         "    - Input Tensor 2 '%s' Shape: %s\n"
         "    Hint: Adjust tensor shapes using transpose() or permute().\n",
@@ -1035,6 +1113,33 @@ static bool mag_check_is_shape_matmulable(mag_op_t op, const mag_tensor_t* a, co
     return false;
 }
 
+static bool mag_check_is_bias_broadcastable(mag_op_t op, const mag_tensor_t* r, const mag_tensor_t* bias) { /* Check if the bias rows and columns are 1 or match the result, batch dims are broadcast-able. */
+    const mag_op_meta_t* meta = mag_op_meta_of(op);
+    bool valid_dims = (bias->shape[0] == 1 || bias->shape[0] == r->shape[0]) && (bias->shape[1] == 1 || bias->shape[1] == r->shape[1]);
+    for (uint32_t i=2; i < MAG_MAX_DIMS; ++i)
+        valid_dims &= r->shape[i] % bias->shape[i] == 0;
+    if (mag_likely(valid_dims)) return true;
+    mag_print_separator(stderr);
+    char shape_1[MAG_FMT_DIM_BUF_SIZE];
+    char shape_2[MAG_FMT_DIM_BUF_SIZE];
+    mag_fmt_dims(&shape_1, &r->shape, r->rank);
+    mag_fmt_dims(&shape_2, &bias->shape, bias->rank);
+    fprintf(stderr,
+        "Failed to execute operation: %s.\n"
+        "ERROR: Bias shape is not compatible with the result. Bias rows and columns must be 1 or match the result and the batch dimensions must be broadcast-able.\n"
+        "    - Result Tensor '%s' Shape: %s\n"
+        "    - Bias Tensor '%s' Shape: %s\n"
+        "    Hint: Adjust tensor shapes using transpose() or permute().\n",
+        meta->mnemonic,
+        r->name, shape_1,
+        bias->name, shape_2
+    );
+    mag_print_separator(stderr);
+    fputc('\n', stderr);
+    fflush(stderr);
+    return false;
+}
+
 static bool mag_check_is_contiguous(mag_op_t op, const mag_tensor_t* a) {
     const mag_op_meta_t* meta = mag_op_meta_of(op);
     if (mag_likely(mag_tensor_is_contiguous(a))) return true;
@@ -1055,6 +1160,49 @@ static bool mag_check_is_contiguous(mag_op_t op, const mag_tensor_t* a) {
     return false;
 }
 
+static bool mag_tensor_is_contiguous_or_transposed(const mag_tensor_t* t) { /* Contiguous or a transposed view of the two leading dims of a contiguous tensor. */
+    return mag_tensor_is_contiguous(t) || (t->strides[1] == 1 && t->strides[0] == t->shape[1]);
+}
+
+static bool mag_check_is_contiguous_or_transposed(mag_op_t op, const mag_tensor_t* a) {
+    const mag_op_meta_t* meta = mag_op_meta_of(op);
+    if (mag_likely(mag_tensor_is_contiguous_or_transposed(a))) return true;
+    mag_print_separator(stderr);
+    char shape[MAG_FMT_DIM_BUF_SIZE];
+    mag_fmt_dims(&shape, &a->shape, a->rank);
+    fprintf(stderr,
+        "Failed to execute operation: %s.\n"
+        "ERROR: Tensor '%s' must be contiguous or a transpose of the two leading dimensions. Shape: %s\n"
+        "    Hint: Make tensor contiguous using clone().\n",
+        meta->mnemonic,
+        a->name,
+        shape
+    );
+    mag_print_separator(stderr);
+    fputc('\n', stderr);
+    fflush(stderr);
+    return false;
+}
+
+static bool mag_check_is_dtype(mag_op_t op, const mag_tensor_t* a, mag_dtype_t dtype) {
+    const mag_op_meta_t* meta = mag_op_meta_of(op);
+    if (mag_likely(a->dtype == dtype)) return true;
+    mag_print_separator(stderr);
+    fprintf(stderr,
+        "Failed to execute operation: %s.\n"
+        "ERROR: Tensor '%s' has data type %s, but the operation requires %s.\n"
+        "    Hint: Convert quantized tensors using dequantize() and storage tensors using cast().\n",
+        meta->mnemonic,
+        a->name,
+        mag_dtype_meta_of(a->dtype)->name,
+        mag_dtype_meta_of(dtype)->name
+    );
+    mag_print_separator(stderr);
+    fputc('\n', stderr);
+    fflush(stderr);
+    return false;
+}
+
 static bool mag_validate_op_unary(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
    return mag_check_is_shape_eq(op, result, inputs[0]);
 }
@@ -1075,20 +1223,175 @@ static bool mag_validate_op_scalar(mag_op_t op, mag_tensor_t* result, mag_tensor
     return mag_check_is_contiguous(op, inputs[0]);
 }
 
+static bool mag_tensor_is_k_contiguous(const mag_tensor_t* b) { /* Columns of the right-hand side are contiguous along K: a transposed view or a single column. */
+    return mag_tensor_is_transposed(b) || b->shape[1] == 1;
+}
+
+static bool mag_check_are_matmul_dtypes_valid(mag_op_t op, const mag_tensor_t* a, const mag_tensor_t* b) { /* F32 with BF16 or F16 in any combination, I8 x F32 or I8 x I8 (transposed b with the same block size), Q8/Q4 with F32. */
+    const mag_op_meta_t* meta = mag_op_meta_of(op);
+    bool valid;
+    if (mag_dtype_is_qblock(a->dtype) || mag_dtype_is_qblock(b->dtype)) { /* Blocks run along K: row-major a or transposed b */
+        valid = mag_dtype_is_qblock(a->dtype)
+            ? !mag_tensor_is_transposed(a) && b->dtype == MAG_DTYPE_F32
+            : mag_tensor_is_transposed(b) && a->dtype == MAG_DTYPE_F32;
+    } else if (a->dtype == MAG_DTYPE_I8) {
+        valid = mag_tensor_is_contiguous(a) && !mag_tensor_is_transposed(a);
+        valid &= b->dtype == MAG_DTYPE_F32 || (b->dtype == MAG_DTYPE_I8 && mag_tensor_is_k_contiguous(b) && b->qblock == a->qblock);
+    } else if (a->dtype == MAG_DTYPE_BF16 || b->dtype == MAG_DTYPE_BF16) {
+        valid = (a->dtype == MAG_DTYPE_F32 || a->dtype == MAG_DTYPE_BF16) && (b->dtype == MAG_DTYPE_F32 || b->dtype == MAG_DTYPE_BF16);
+    } else {
+        valid = (a->dtype == MAG_DTYPE_F32 || a->dtype == MAG_DTYPE_F16) && (b->dtype == MAG_DTYPE_F32 || b->dtype == MAG_DTYPE_F16);
+    }
+    if (mag_likely(valid)) return true;
+    mag_print_separator(stderr);
+    fprintf(stderr,
+        "Failed to execute operation: %s.\n"
+        "ERROR: Unsupported data types for matrix multiplication: %s x %s.\n"
+        "    - Input Tensor 1 '%s' Quantization block: %" PRIi64 "\n"
+        "    - Input Tensor 2 '%s' Quantization block: %" PRIi64 "\n"
+        "    Hint: Supported are f32/bf16 x f32/bf16, f32/f16 x f32/f16, i8 x f32, i8 x i8, q8/q4 x f32 and f32 x q8/q4, where quantized operands are quantized along the inner dimension (b as transposed view or single column), int8 ones with the same block size.\n",
+        meta->mnemonic,
+        mag_dtype_meta_of(a->dtype)->name, mag_dtype_meta_of(b->dtype)->name,
+        a->name, a->qblock,
+        b->name, b->qblock
+    );
+    mag_print_separator(stderr);
+    fputc('\n', stderr);
+    fflush(stderr);
+    return false;
+}
+
 static bool mag_validate_op_matmul(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
     bool valid = true;
     valid = valid && mag_check_is_shape_matmulable(op, inputs[0], inputs[1]);
+    valid = valid && mag_check_is_contiguous_or_transposed(op, inputs[0]);
+    valid = valid && mag_check_is_contiguous_or_transposed(op, inputs[1]);
+    valid = valid && mag_check_are_matmul_dtypes_valid(op, inputs[0], inputs[1]);
+    return valid;
+}
+
+static bool mag_validate_op_quantize(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
+    bool valid = true;
+    valid = valid && mag_check_is_shape_eq(op, result, inputs[0]);
+    valid = valid && mag_check_is_contiguous(op, inputs[0]);
+    valid = valid && mag_check_is_dtype(op, inputs[0], MAG_DTYPE_F32);
+    return valid;
+}
+
+static bool mag_validate_op_dequantize(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
+    bool valid = true;
+    valid = valid && mag_check_is_shape_eq(op, result, inputs[0]);
+    valid = valid && mag_check_is_contiguous(op, inputs[0]);
+    valid = valid && mag_check_is_dtype(op, inputs[0], MAG_DTYPE_I8); /* Q8/Q4 are dequantized by MAG_OP_CAST. */
+    return valid;
+}
+
+static bool mag_validate_op_cast(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
+    bool valid = true;
+    valid = valid && mag_check_is_shape_eq(op, result, inputs[0]);
     valid = valid && mag_check_is_contiguous(op, inputs[0]);
-    valid = valid && mag_check_is_contiguous(op, inputs[1]);
+    mag_assert(inputs[0]->dtype != MAG_DTYPE_I8 && inputs[0]->dtype != MAG_DTYPE_I32, "Only floating-point tensors can be cast, use dequantize() for quantized tensors");
+    mag_assert( /* Block-quantized types only convert from and to F32 */
+        !(mag_dtype_is_qblock(inputs[0]->dtype) || mag_dtype_is_qblock(result->dtype)) || inputs[0]->dtype == result->dtype || inputs[0]->dtype == MAG_DTYPE_F32 || result->dtype == MAG_DTYPE_F32,
+        "Block-quantized tensors can only be converted from and to F32, got: %s -> %s", mag_dtype_meta_of(inputs[0]->dtype)->name, mag_dtype_meta_of(result->dtype)->name
+    );
+    return valid;
+}
+
+static bool mag_validate_op_gather(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
+    const mag_tensor_t* x = inputs[0];
+    const mag_tensor_t* index = inputs[1];
+    bool valid = true;
+    int64_t axis = (int64_t)params[0].x.u32;
+    valid = valid && mag_check_is_contiguous(op, x);
+    valid = valid && mag_check_is_contiguous(op, index);
+    valid = valid && mag_check_is_dtype(op, x, MAG_DTYPE_F32);
+    valid = valid && mag_check_is_dtype(op, index, MAG_DTYPE_I32);
+    if (!valid) return false;
+    char msg[256] = {0};
+    int64_t dim = 0;
+    bool shape_ok = x->rank == index->rank;
+    while (shape_ok && dim < MAG_MAX_DIMS && (dim == axis || x->shape[dim] == index->shape[dim])) ++dim;
+    shape_ok = shape_ok && dim == MAG_MAX_DIMS;
+    if (!shape_ok) {
+        if (x->rank != index->rank) snprintf(msg, sizeof(msg), "Index rank %" PRIi64 " does not match the tensor rank %" PRIi64 ".", index->rank, x->rank);
+        else snprintf(msg, sizeof(msg), "Index extent %" PRIi64 " does not match the tensor extent %" PRIi64 " in axis %" PRIi64 ".", index->shape[dim], x->shape[dim], dim);
+    } else if (index->op == MAG_OP_NOP || (index->flags & MAG_TFLAG_EXEC_EAGER)) { /* Index data is available, deferred indices are clamped by the kernel */
+        const int32_t* bi = (const int32_t*)mag_tensor_data_ptr(index);
+        for (int64_t i=0; i < index->numel; ++i) {
+            if (bi[i] < 0 || bi[i] >= x->shape[axis]) {
+                snprintf(msg, sizeof(msg), "Gather index %d at position %" PRIi64 " is out of range [0, %" PRIi64 ").", bi[i], i, x->shape[axis]);
+                break;
+            }
+        }
+    }
+    if (mag_likely(!*msg)) return true;
+    mag_print_separator(stderr);
+    fprintf(stderr,
+        "Failed to execute operation: %s.\n"
+        "ERROR: %s\n"
+        "    Hint: The index must have the rank and shape of the tensor except along axis %" PRIi64 ", with values in [0, shape[axis]).\n",
+        mag_op_meta_of(op)->mnemonic,
+        msg,
+        axis
+    );
+    mag_print_separator(stderr);
+    fputc('\n', stderr);
+    fflush(stderr);
+    return false;
+}
+
+static bool mag_validate_op_norm(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) { /* Params: eps, bitmask of present affine inputs (weight, bias), which follow x. */
+    const mag_tensor_t* x = inputs[0];
+    bool valid = true;
+    valid = valid && mag_check_is_shape_eq(op, result, x);
+    valid = valid && mag_check_is_contiguous(op, x);
+    uint32_t numin = 1 + (params[1].x.u32 & 1) + (params[1].x.u32>>1 & 1);
+    for (uint32_t i=1; i < numin; ++i) {
+        valid = valid && mag_check_is_contiguous(op, inputs[i]);
+        mag_assert(inputs[i]->numel == x->shape[0], "Normalization weight and bias need %" PRIi64 " elements (the row length), got: %" PRIi64, x->shape[0], inputs[i]->numel);
+    }
+    return valid;
+}
+
+static bool mag_validate_op_scan(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
+    (void)params;
+    bool valid = true;
+    valid = valid && mag_check_is_shape_eq(op, result, inputs[0]);
+    valid = valid && mag_check_is_contiguous(op, inputs[0]);
+    return valid;
+}
+
+static bool mag_validate_op_linear(mag_op_t op, mag_tensor_t* result, mag_tensor_t** inputs, const mag_op_param_t* params) {
+    bool valid = mag_validate_op_matmul(op, result, inputs, params);
+    valid = valid && mag_check_is_bias_broadcastable(op, result, inputs[2]);
+    valid = valid && mag_check_is_contiguous(op, inputs[2]);
+    valid = valid && mag_check_is_dtype(op, inputs[2], MAG_DTYPE_F32); /* The epilogue reads the bias as F32 */
+    if (mag_unlikely(valid && params->x.u32 >= MAG_ACTIVATION__NUM)) {
+        mag_print_separator(stderr);
+        fprintf(stderr,
+            "Failed to execute operation: %s.\n"
+            "ERROR: Invalid activation: %u, expected one of the %u mag_activation_t values.\n"
+            "    Hint: Pass a mag_activation_t enumerator.\n",
+            mag_op_meta_of(op)->mnemonic,
+            params->x.u32,
+            (unsigned)MAG_ACTIVATION__NUM
+        );
+        mag_print_separator(stderr);
+        fputc('\n', stderr);
+        fflush(stderr);
+        return false;
+    }
     return valid;
 }
 
+static mag_tensor_t* mag_tensor_create_ex(mag_ctx_t* ctx, mag_dtype_t type, const int64_t* dims, int64_t rank, mag_tensor_t* view, size_t view_offs, int64_t qblock);
 static mag_tensor_t* mag_tensor_create(mag_ctx_t* ctx, mag_dtype_t type, const int64_t* dims, int64_t rank, mag_tensor_t* view, size_t view_offs);
 
 static mag_tensor_t* mag_result_constructor_routine_isomorph(mag_tensor_t** inputs, const mag_op_param_t* params) {
     (void)params;
     mag_tensor_t* base = *inputs;
-    return mag_tensor_create(base->ctx, base->dtype, base->shape, base->rank, NULL, 0);
+    return mag_tensor_create_ex(base->ctx, base->dtype, base->shape, base->rank, NULL, 0, base->qblock);
 }
 
 static mag_tensor_t* mag_result_constructor_routine_view(mag_tensor_t** inputs,  const mag_op_param_t* params) {
@@ -1097,10 +1400,45 @@ static mag_tensor_t* mag_result_constructor_routine_view(mag_tensor_t** inputs,
     return mag_tensor_create(base->ctx, base->dtype, base->shape, base->rank, base, 0);
 }
 
-static mag_tensor_t* mag_result_constructor_routine_scalar(mag_tensor_t** inputs,  const mag_op_param_t* params) {
+static mag_tensor_t* mag_result_constructor_routine_reduced(mag_tensor_t** inputs,  const mag_op_param_t* params) { /* Params: bitmask of reduced axes, keepdim. */
+    mag_tensor_t* base = *inputs;
+    uint32_t mask = params[0].x.u32;
+    bool keepdim = !!params[1].x.u32;
+    int64_t shape[MAG_MAX_DIMS];
+    int64_t rank = 0;
+    for (int64_t i=0; i < base->rank; ++i) {
+        if (!(mask & (1u<<i))) shape[rank++] = base->shape[i];
+        else if (keepdim) shape[rank++] = 1;
+    }
+    if (!rank) shape[rank++] = 1; /* Scalar */
+    return mag_tensor_create(base->ctx, base->dtype, shape, rank, NULL, 0);
+}
+
+static mag_tensor_t* mag_result_constructor_routine_argreduced(mag_tensor_t** inputs,  const mag_op_param_t* params) { /* Params: axis, keepdim. */
+    mag_tensor_t* base = *inputs;
+    uint32_t axis = params[0].x.u32;
+    bool keepdim = !!params[1].x.u32;
+    int64_t shape[MAG_MAX_DIMS];
+    int64_t rank = 0;
+    for (int64_t i=0; i < base->rank; ++i) {
+        if (i != axis) shape[rank++] = base->shape[i];
+        else if (keepdim) shape[rank++] = 1;
+    }
+    if (!rank) shape[rank++] = 1; /* Scalar */
+    return mag_tensor_create(base->ctx, MAG_DTYPE_I32, shape, rank, NULL, 0);
+}
+
+static mag_tensor_t* mag_result_constructor_routine_topk(mag_tensor_t** inputs,  const mag_op_param_t* params) { /* Params: k, axis. */
     mag_tensor_t* base = *inputs;
-    int64_t shape = 1;
-    return mag_tensor_create(base->ctx, base->dtype, &shape, shape, NULL, 0);
+    int64_t shape[MAG_MAX_DIMS];
+    memcpy(shape, base->shape, sizeof(shape));
+    shape[params[1].x.u32] = params[0].x.u32;
+    return mag_tensor_create(base->ctx, MAG_DTYPE_I32, shape, base->rank, NULL, 0);
+}
+
+static mag_tensor_t* mag_result_constructor_routine_gathered(mag_tensor_t** inputs,  const mag_op_param_t* params) {
+    (void)params;
+    return mag_tensor_create(inputs[0]->ctx, inputs[0]->dtype, inputs[1]->shape, inputs[1]->rank, NULL, 0);
 }
 
 static mag_tensor_t* mag_result_constructor_routine_transposed(mag_tensor_t** inputs,  const mag_op_param_t* params) {
@@ -1127,12 +1465,31 @@ static mag_tensor_t* mag_result_constructor_routine_permuted(mag_tensor_t** inpu
     return permuted;
 }
 
-static mag_tensor_t* mag_result_constructor_routine_matmul(mag_tensor_t** inputs,  const mag_op_param_t* params) { /* MxR = MxN * NxR */
+static mag_tensor_t* mag_result_constructor_routine_matmul(mag_tensor_t** inputs,  const mag_op_param_t* params) { /* MxR = MxN * NxR, batch dims are broadcasted. */
     (void)params;
     int64_t shape[MAG_MAX_DIMS];
     shape[0] = inputs[0]->shape[0]; /* M */
     shape[1] = inputs[1]->shape[1]; /* R */
-    return mag_tensor_create(inputs[0]->ctx, MAG_DTYPE_F32, shape, 2, NULL, 0);
+    for (uint32_t i=2; i < MAG_MAX_DIMS; ++i) /* Batch dims */
+        shape[i] = mag_xmax(inputs[0]->shape[i], inputs[1]->shape[i]);
+    int64_t rank = mag_xmax(2, mag_xmax(inputs[0]->rank, inputs[1]->rank));
+    return mag_tensor_create(inputs[0]->ctx, MAG_DTYPE_F32, shape, rank, NULL, 0);
+}
+
+static mag_tensor_t* mag_result_constructor_routine_quantized(mag_tensor_t** inputs,  const mag_op_param_t* params) {
+    mag_tensor_t* base = *inputs;
+    return mag_tensor_create_ex(base->ctx, MAG_DTYPE_I8, base->shape, base->rank, NULL, 0, params->x.i32);
+}
+
+static mag_tensor_t* mag_result_constructor_routine_dequantized(mag_tensor_t** inputs,  const mag_op_param_t* params) {
+    (void)params;
+    mag_tensor_t* base = *inputs;
+    return mag_tensor_create(base->ctx, MAG_DTYPE_F32, base->shape, base->rank, NULL, 0);
+}
+
+static mag_tensor_t* mag_result_constructor_routine_cast(mag_tensor_t** inputs,  const mag_op_param_t* params) {
+    mag_tensor_t* base = *inputs;
+    return mag_tensor_create(base->ctx, (mag_dtype_t)params->x.u32, base->shape, base->rank, NULL, 0);
 }
 
 const mag_op_meta_t* mag_op_meta_of(mag_op_t type) {
@@ -1192,37 +1549,37 @@ const mag_op_meta_t* mag_op_meta_of(mag_op_t type) {
         [MAG_OP_MEAN] = {
             .mnemonic = "mean",
             .argcount = 1,
-            .paramcount = 0,
-            .param_types = {MAG_OP_TPARAM_NONE},
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_U32, MAG_OP_TPARAM_U32},
             .inplace = false,
-            .r_alloc = &mag_result_constructor_routine_scalar,
+            .r_alloc = &mag_result_constructor_routine_reduced,
             .validator = &mag_validate_op_scalar
         },
         [MAG_OP_MIN] = {
             .mnemonic = "min",
             .argcount = 1,
-            .paramcount = 0,
-            .param_types = {MAG_OP_TPARAM_NONE},
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_U32, MAG_OP_TPARAM_U32},
             .inplace = false,
-            .r_alloc = &mag_result_constructor_routine_scalar,
+            .r_alloc = &mag_result_constructor_routine_reduced,
             .validator = &mag_validate_op_scalar
         },
         [MAG_OP_MAX] = {
             .mnemonic = "max",
             .argcount = 1,
-            .paramcount = 0,
-            .param_types = {MAG_OP_TPARAM_NONE},
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_U32, MAG_OP_TPARAM_U32},
             .inplace = false,
-            .r_alloc = &mag_result_constructor_routine_scalar,
+            .r_alloc = &mag_result_constructor_routine_reduced,
             .validator = &mag_validate_op_scalar
         },
         [MAG_OP_SUM] = {
             .mnemonic = "sum",
             .argcount = 1,
-            .paramcount = 0,
-            .param_types = {MAG_OP_TPARAM_NONE},
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_U32, MAG_OP_TPARAM_U32},
             .inplace = false,
-            .r_alloc = &mag_result_constructor_routine_scalar,
+            .r_alloc = &mag_result_constructor_routine_reduced,
             .validator = &mag_validate_op_scalar
         },
         [MAG_OP_ABS] = {
@@ -1494,6 +1851,125 @@ const mag_op_meta_t* mag_op_meta_of(mag_op_t type) {
             .inplace = true,
             .r_alloc = &mag_result_constructor_routine_matmul,
             .validator = &mag_validate_op_matmul
+        },
+        [MAG_OP_LINEAR] = {
+            .mnemonic = "linear",
+            .argcount = 3,
+            .paramcount = 1,
+            .param_types = {MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_matmul,
+            .validator = &mag_validate_op_linear
+        },
+        [MAG_OP_QUANTIZE] = {
+            .mnemonic = "quantize",
+            .argcount = 1,
+            .paramcount = 1,
+            .param_types = {MAG_OP_TPARAM_I32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_quantized,
+            .validator = &mag_validate_op_quantize
+        },
+        [MAG_OP_DEQUANTIZE] = {
+            .mnemonic = "dequantize",
+            .argcount = 1,
+            .paramcount = 0,
+            .param_types = {},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_dequantized,
+            .validator = &mag_validate_op_dequantize
+        },
+        [MAG_OP_CAST] = {
+            .mnemonic = "cast",
+            .argcount = 1,
+            .paramcount = 1,
+            .param_types = {MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_cast,
+            .validator = &mag_validate_op_cast
+        },
+        [MAG_OP_ARGMIN] = {
+            .mnemonic = "argmin",
+            .argcount = 1,
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_U32, MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_argreduced,
+            .validator = &mag_validate_op_scalar
+        },
+        [MAG_OP_ARGMAX] = {
+            .mnemonic = "argmax",
+            .argcount = 1,
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_U32, MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_argreduced,
+            .validator = &mag_validate_op_scalar
+        },
+        [MAG_OP_TOPK] = {
+            .mnemonic = "topk",
+            .argcount = 1,
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_U32, MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_topk,
+            .validator = &mag_validate_op_scalar
+        },
+        [MAG_OP_GATHER] = {
+            .mnemonic = "gather",
+            .argcount = 2,
+            .paramcount = 1,
+            .param_types = {MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_gathered,
+            .validator = &mag_validate_op_gather
+        },
+        [MAG_OP_LAYER_NORM] = {
+            .mnemonic = "layer_norm",
+            .argcount = 3,
+            .optargcount = 2,
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_F32, MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_isomorph,
+            .validator = &mag_validate_op_norm
+        },
+        [MAG_OP_RMS_NORM] = {
+            .mnemonic = "rms_norm",
+            .argcount = 2,
+            .optargcount = 1,
+            .paramcount = 2,
+            .param_types = {MAG_OP_TPARAM_F32, MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_isomorph,
+            .validator = &mag_validate_op_norm
+        },
+        [MAG_OP_CUMSUM] = {
+            .mnemonic = "cumsum",
+            .argcount = 1,
+            .paramcount = 1,
+            .param_types = {MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_isomorph,
+            .validator = &mag_validate_op_scan
+        },
+        [MAG_OP_CUMPROD] = {
+            .mnemonic = "cumprod",
+            .argcount = 1,
+            .paramcount = 1,
+            .param_types = {MAG_OP_TPARAM_U32},
+            .inplace = false,
+            .r_alloc = &mag_result_constructor_routine_isomorph,
+            .validator = &mag_validate_op_scan
+        },
+        [MAG_OP_FUSED] = {
+            .mnemonic = "fused",
+            .argcount = 0, /* Leaves are held by the program */
+            .paramcount = 0,
+            .param_types = {},
+            .inplace = false,
+            .r_alloc = NULL,
+            .validator = NULL
         }
     };
     return infos+type;
@@ -1501,7 +1977,7 @@ const mag_op_meta_t* mag_op_meta_of(mag_op_t type) {
 
 #undef mag_validate_inputs
 
-int64_t mag_tensor_data_size(const mag_tensor_t* t) { return t->numel*mag_dtype_meta_of(t->dtype)->size; }
+int64_t mag_tensor_data_size(const mag_tensor_t* t) { return mag_dtype_data_size(t->dtype, t->numel, t->qblock); }
 int64_t mag_tensor_numel(const mag_tensor_t* t) { return t->numel; }
 int64_t mag_tensor_num_rows(const mag_tensor_t* t) {
     mag_static_assert(MAG_MAX_DIMS == 6);
@@ -1516,7 +1992,11 @@ int64_t mag_tensor_num_cols(const mag_tensor_t* t) { return *t->shape; }
     }
 #endif
 
-static mag_tensor_t* mag_tensor_create(mag_ctx_t* ctx, mag_dtype_t type, const int64_t* dims, int64_t rank, mag_tensor_t* view, size_t view_offs) {
+/*
+** qblock is the number of elements per scale of MAG_DTYPE_I8 tensors, 0 selects one scale per row (shape[1] elements).
+** Views share the storage and thus the quantization of the viewed tensor, qblock is ignored for them and for other dtypes.
+*/
+static mag_tensor_t* mag_tensor_create_ex(mag_ctx_t* ctx, mag_dtype_t type, const int64_t* dims, int64_t rank, mag_tensor_t* view, size_t view_offs, int64_t qblock) {
     uintptr_t tr_id = mag_thread_id();
     mag_assert(tr_id == ctx->tr_id, "%" PRIx64 " != %" PRIx64 " Tensor must be created on the same thread as the context.", tr_id, ctx->tr_id);
     mag_assert(dims != NULL && rank >= 0 && rank <= MAG_MAX_DIMS, "Rank must be within (0, %d]", MAG_MAX_DIMS);
@@ -1528,11 +2008,15 @@ static mag_tensor_t* mag_tensor_create(mag_ctx_t* ctx, mag_dtype_t type, const i
         }
         mag_tensor_incref(view); /* Increment view tensor strong RC */
     }
-    int64_t dts = mag_dtype_meta_of(type)->size;
     int64_t numel = 1;
     for (int64_t i=0; i < rank; ++i) /* Calculate buffer size and check for overflow. */
         mag_assert2(dims[i] > 0 && !mag_imull64_ov(dims[i], numel, &numel)); /* Overflow in buffer size. Max: INT64_MAX. Reduce dimensions. */
-    int64_t numbytes = numel*dts;
+    if (view) qblock = view->qblock;
+    else if (type != MAG_DTYPE_I8) qblock = 0;
+    else if (!qblock) qblock = rank > 1 ? dims[1] : 1; /* One scale per row */
+    mag_assert(type != MAG_DTYPE_I8 || (qblock > 0 && numel % qblock == 0), "Quantization block %" PRIi64 " must divide numel %" PRIi64, qblock, numel);
+    mag_assert(view || !mag_dtype_is_qblock(type) || dims[rank > 1] % MAG_QK == 0, "Row length %" PRIi64 " of block-quantized tensors must be a multiple of %d", dims[rank > 1], MAG_QK);
+    int64_t numbytes = mag_dtype_data_size(type, numel, qblock);
     mag_assert2(!view || !numbytes || numbytes + view_offs <= mag_tensor_data_size(view)); /* Slice must be within viewed tensor data range. *//* Allocate memory for tensor struct on CPU RAM. */
     mag_tensor_t* t = mag_fixed_intrusive_pool_malloc(&ctx->tensor_pool);
     memset(t, 0, sizeof(*t));
@@ -1549,6 +2033,7 @@ static mag_tensor_t* mag_tensor_create(mag_ctx_t* ctx, mag_dtype_t type, const i
         .shape = {0},
         .strides = {0},
         .dtype = type,
+        .qblock = qblock,
         .storage = {0},
         .numel = numel,
         .flags = view ? MAG_TFLAG_VIEW : MAG_TFLAG_OWNER,
@@ -1560,7 +2045,10 @@ static mag_tensor_t* mag_tensor_create(mag_ctx_t* ctx, mag_dtype_t type, const i
         .grad = NULL,
         .pmon = {0},
         .name = "",
-        .ud = NULL
+        .ud = NULL,
+        .version = 0,
+        .packed = {0},
+        .fused = NULL
     };
     mag_tensor_incref(t); /* First strong RC=1 */
     /* Allocate device memory */
@@ -1587,6 +2075,10 @@ static mag_tensor_t* mag_tensor_create(mag_ctx_t* ctx, mag_dtype_t type, const i
     return t;
 }
 
+static mag_tensor_t* mag_tensor_create(mag_ctx_t* ctx, mag_dtype_t type, const int64_t* dims, int64_t rank, mag_tensor_t* view, size_t view_offs) {
+    return mag_tensor_create_ex(ctx, type, dims, rank, view, view_offs, 0);
+}
+
 static void mag_tensor_destroy(mag_tensor_t* t) {
     mag_ctx_t* ctx = t->ctx;
 #ifdef MAG_DEBUG  /* If tensor RC sanitize is enabled, invoke destructor and erase from tracking list */
@@ -1610,6 +2102,8 @@ static void mag_tensor_destroy(mag_tensor_t* t) {
         }
     }
 #endif
+    mag_tensor_unpack_weights(t);
+    if (t->fused) (*mag_alloc)(t->fused, 0);
     if (t->flags & MAG_TFLAG_OWNER) { /* Free device memory if tensor owns it. */
         mag_compute_device_t* dvc = t->ctx->device;
         void (*dtor)(mag_compute_device_t*, mag_storage_buffer_t*) = dvc->free_storage;
@@ -1665,6 +2159,7 @@ static void MAG_HOTPROC mag_op_exec(mag_tensor_t* R, mag_compute_device_t* dvc,
     uint64_t start = R->ctx->profiler_enabled ? mag_hpc_clock_ns() : 0;    /* Profiling monitoring */
     void (*exec)(mag_compute_device_t*, mag_tensor_t*) = ord == MAG_GRAPH_EVAL_ORDER_FORWARD ? dvc->eager_exec_fwd : dvc->eager_exec_bwd;
     (*exec)(dvc, R); /* Dispatch to backend. */
+    mag_tensor_mark_written(R);
     if (!R->ctx->profiler_enabled) return; /* Profiling disabled. */
     pmon->elapsed_ns = mag_hpc_clock_elapsed_ns(start);
     pmon->elapsed_ns_acc += pmon->elapsed_ns;
@@ -1673,6 +2168,8 @@ static void MAG_HOTPROC mag_op_exec(mag_tensor_t* R, mag_compute_device_t* dvc,
     ++pmon_op->n_execs;
 }
 
+static void mag_graph_capture(mag_graph_t* g, mag_tensor_t* r);
+
 static mag_tensor_t* MAG_HOTPROC mag_tensor_operator(
     mag_ctx_t* ctx,
     mag_op_t op,
@@ -1685,6 +2182,7 @@ static mag_tensor_t* MAG_HOTPROC mag_tensor_operator(
     /* Validate inputs and params first */
     mag_assert2(op != MAG_OP_NOP);
     mag_assert(inputs && mag_check_are_inputs_valid(op, inputs, numin), "Invalid input tensors for operation %s.", mag_op_meta_of(op)->mnemonic);
+    mag_assert(mag_check_are_input_dtypes_valid(op, inputs, numin), "Invalid input data types for operation %s.", mag_op_meta_of(op)->mnemonic);
     mag_assert(mag_check_are_op_params_valid(op, params, numparams), "Invalid parameters for operation %s.", mag_op_meta_of(op)->mnemonic);
 
     const mag_op_meta_t* meta = mag_op_meta_of(op);
@@ -1694,7 +2192,10 @@ static mag_tensor_t* MAG_HOTPROC mag_tensor_operator(
     mag_tensor_t* R = (inplace && numin && meta->inplace)                                                   /* Inplace requested? */
         ? mag_tensor_create(ctx, (*inputs)->dtype, (*inputs)->shape, (*inputs)->rank, *inputs, 0)  /* View R <- X for inplace aliasing op. */
         : (*r_alloc)(inputs, params);                                                                       /* Construct new result tensor. */
-    if (mag_unlikely(!(*validate_op)(op, R, inputs, params))) return NULL;                                  /* Validation failed. */
+    if (mag_unlikely(!(*validate_op)(op, R, inputs, params))) {                                             /* Validation failed. */
+        mag_tensor_decref(R);
+        return NULL;
+    }
     mag_tensor_t* grad = NULL;                                                                              /* ∇ᵦL = ∂L/∂B - Upper gradient tensor. */  /* TODO */
     if (gra == MAG_GRA_BWD && grad) {
         R->grad = R->grad                       /* ∇ₐL = ∑ᵢ (∂L/∂Bᵢ) ⋅ (∂Bᵢ/∂A) - Chain rule accumulate. */
@@ -1706,9 +2207,11 @@ static mag_tensor_t* MAG_HOTPROC mag_tensor_operator(
     for (uint32_t i=0; i < numin; ++i) {                             /* Set input tensors and flags. */
         R->op_inputs[i] = inputs[i];
     }
-    if (params) memcpy(R->op_params, params, sizeof(*params));   /* Copy operation parameters */
+    if (params) memcpy(R->op_params, params, numparams*sizeof(*params));   /* Copy operation parameters */
     if (ctx->exec_mode == MAG_EXEC_MODE_EAGER) {                    /* In eager execution mode, we execute immediately. */
         mag_op_exec(R, ctx->device, gra);                           /* Execute the operation immediately. */
+        R->flags |= MAG_TFLAG_EXEC_EAGER;                           /* Computed, deferred graphs treat it as a leaf. */
+        if (mag_unlikely(ctx->capture)) mag_graph_capture(ctx->capture, R); /* Record for replay. */
     }
     return R;
 }
@@ -1737,10 +2240,88 @@ mag_tensor_t* mag_permute(mag_tensor_t* x, uint32_t d0, uint32_t d1, uint32_t d2
     return mag_tensor_operator(x->ctx, MAG_OP_PERMUTE, false, &x, 1, params, sizeof(params)/sizeof(*params));
 }
 
-mag_tensor_t* mag_mean(mag_tensor_t* x) { return mag_tensor_operator(x->ctx, MAG_OP_MEAN, false, &x, 1, NULL, 0); }
-mag_tensor_t* mag_min(mag_tensor_t* x) { return mag_tensor_operator(x->ctx, MAG_OP_MIN, false, &x, 1, NULL, 0); }
-mag_tensor_t* mag_max(mag_tensor_t* x) { return mag_tensor_operator(x->ctx, MAG_OP_MAX, false, &x, 1, NULL, 0); }
-mag_tensor_t* mag_sum(mag_tensor_t* x) { return mag_tensor_operator(x->ctx, MAG_OP_SUM, false, &x, 1, NULL, 0); }
+static mag_tensor_t* mag_reduce_axes(mag_op_t op, mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim) {
+    uint32_t mask = 0;
+    if (!axes || !num_axes) mask = (1u<<x->rank)-1; /* All axes */
+    for (uint32_t i=0; axes && i < num_axes; ++i) {
+        mag_assert(axes[i] >= 0 && axes[i] < x->rank, "Axis %" PRIi64 " out of range for rank %" PRIi64, axes[i], x->rank);
+        mag_assert(!(mask & (1u<<axes[i])), "Axes must be unique, axis %" PRIi64 " is repeated", axes[i]);
+        mask |= 1u<<axes[i];
+    }
+    mag_op_param_t params[2] = {
+        {.type=MAG_OP_TPARAM_U32, .x.u32=mask},
+        {.type=MAG_OP_TPARAM_U32, .x.u32=keepdim}
+    };
+    return mag_tensor_operator(x->ctx, op, false, &x, 1, params, sizeof(params)/sizeof(*params));
+}
+
+mag_tensor_t* mag_mean(mag_tensor_t* x) { return mag_reduce_axes(MAG_OP_MEAN, x, NULL, 0, false); }
+mag_tensor_t* mag_min(mag_tensor_t* x) { return mag_reduce_axes(MAG_OP_MIN, x, NULL, 0, false); }
+mag_tensor_t* mag_max(mag_tensor_t* x) { return mag_reduce_axes(MAG_OP_MAX, x, NULL, 0, false); }
+mag_tensor_t* mag_sum(mag_tensor_t* x) { return mag_reduce_axes(MAG_OP_SUM, x, NULL, 0, false); }
+mag_tensor_t* mag_mean_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim) { return mag_reduce_axes(MAG_OP_MEAN, x, axes, num_axes, keepdim); }
+mag_tensor_t* mag_min_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim) { return mag_reduce_axes(MAG_OP_MIN, x, axes, num_axes, keepdim); }
+mag_tensor_t* mag_max_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim) { return mag_reduce_axes(MAG_OP_MAX, x, axes, num_axes, keepdim); }
+mag_tensor_t* mag_sum_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim) { return mag_reduce_axes(MAG_OP_SUM, x, axes, num_axes, keepdim); }
+static mag_tensor_t* mag_argreduce(mag_op_t op, mag_tensor_t* x, int64_t axis, bool keepdim) {
+    mag_assert(axis >= 0 && axis < x->rank, "Axis %" PRIi64 " out of range for rank %" PRIi64, axis, x->rank);
+    mag_assert(x->shape[axis] <= INT32_MAX, "Extent %" PRIi64 " of axis %" PRIi64 " exceeds the I32 index range", x->shape[axis], axis);
+    mag_op_param_t params[2] = {
+        {.type=MAG_OP_TPARAM_U32, .x.u32=(uint32_t)axis},
+        {.type=MAG_OP_TPARAM_U32, .x.u32=keepdim}
+    };
+    return mag_tensor_operator(x->ctx, op, false, &x, 1, params, sizeof(params)/sizeof(*params));
+}
+
+mag_tensor_t* mag_argmin(mag_tensor_t* x, int64_t axis, bool keepdim) { return mag_argreduce(MAG_OP_ARGMIN, x, axis, keepdim); }
+mag_tensor_t* mag_argmax(mag_tensor_t* x, int64_t axis, bool keepdim) { return mag_argreduce(MAG_OP_ARGMAX, x, axis, keepdim); }
+
+mag_tensor_t* mag_topk(mag_tensor_t* x, int64_t k, int64_t axis) {
+    mag_assert(axis >= 0 && axis < x->rank, "Axis %" PRIi64 " out of range for rank %" PRIi64, axis, x->rank);
+    mag_assert(x->shape[axis] <= INT32_MAX, "Extent %" PRIi64 " of axis %" PRIi64 " exceeds the I32 index range", x->shape[axis], axis);
+    mag_assert(k >= 1 && k <= x->shape[axis], "k must be in [1, %" PRIi64 "], got: %" PRIi64, x->shape[axis], k);
+    mag_op_param_t params[2] = {
+        {.type=MAG_OP_TPARAM_U32, .x.u32=(uint32_t)k},
+        {.type=MAG_OP_TPARAM_U32, .x.u32=(uint32_t)axis}
+    };
+    return mag_tensor_operator(x->ctx, MAG_OP_TOPK, false, &x, 1, params, sizeof(params)/sizeof(*params));
+}
+
+mag_tensor_t* mag_gather(mag_tensor_t* x, int64_t axis, mag_tensor_t* index) {
+    mag_assert(axis >= 0 && axis < x->rank, "Axis %" PRIi64 " out of range for rank %" PRIi64, axis, x->rank);
+    mag_op_param_t param = {.type=MAG_OP_TPARAM_U32, .x.u32=(uint32_t)axis};
+    return mag_tensor_operator(x->ctx, MAG_OP_GATHER, false, (mag_tensor_t*[]){x, index}, 2, &param, 1);
+}
+
+mag_tensor_t* mag_layer_norm(mag_tensor_t* x, mag_tensor_t* weight, mag_tensor_t* bias, float eps) {
+    mag_op_param_t params[2] = {
+        {.type=MAG_OP_TPARAM_F32, .x.f32=eps},
+        {.type=MAG_OP_TPARAM_U32, .x.u32=(weight ? 1u : 0u) | (bias ? 2u : 0u)}
+    };
+    mag_tensor_t* inputs[3] = {x};
+    uint32_t numin = 1;
+    if (weight) inputs[numin++] = weight; /* Only present affine inputs are passed, the bitmask tells which */
+    if (bias) inputs[numin++] = bias;
+    return mag_tensor_operator(x->ctx, MAG_OP_LAYER_NORM, false, inputs, numin, params, sizeof(params)/sizeof(*params));
+}
+
+mag_tensor_t* mag_rms_norm(mag_tensor_t* x, mag_tensor_t* weight, float eps) {
+    mag_op_param_t params[2] = {
+        {.type=MAG_OP_TPARAM_F32, .x.f32=eps},
+        {.type=MAG_OP_TPARAM_U32, .x.u32=weight ? 1u : 0u}
+    };
+    return mag_tensor_operator(x->ctx, MAG_OP_RMS_NORM, false, (mag_tensor_t*[]){x, weight}, weight ? 2 : 1, params, sizeof(params)/sizeof(*params));
+}
+
+static mag_tensor_t* mag_scan(mag_op_t op, mag_tensor_t* x, int64_t axis) {
+    mag_assert(axis >= 0 && axis < x->rank, "Axis %" PRIi64 " out of range for rank %" PRIi64, axis, x->rank);
+    mag_op_param_t param = {.type=MAG_OP_TPARAM_U32, .x.u32=(uint32_t)axis};
+    return mag_tensor_operator(x->ctx, op, false, &x, 1, &param, 1);
+}
+
+mag_tensor_t* mag_cumsum(mag_tensor_t* x, int64_t axis) { return mag_scan(MAG_OP_CUMSUM, x, axis); }
+mag_tensor_t* mag_cumprod(mag_tensor_t* x, int64_t axis) { return mag_scan(MAG_OP_CUMPROD, x, axis); }
+
 mag_tensor_t* mag_abs(mag_tensor_t* x) { return mag_tensor_operator(x->ctx, MAG_OP_ABS, false, &x, 1, NULL, 0); }
 mag_tensor_t* mag_abs_(mag_tensor_t* x) { return mag_tensor_operator(x->ctx, MAG_OP_ABS, true, &x, 1, NULL, 0); }
 mag_tensor_t* mag_neg(mag_tensor_t* x) { return mag_tensor_operator(x->ctx, MAG_OP_NEG, false, &x, 1, NULL, 0); }
@@ -1836,6 +2417,612 @@ mag_tensor_t* mag_matmul(mag_tensor_t* x, mag_tensor_t* y) {
     return mag_tensor_operator(x->ctx, MAG_OP_MATMUL, false, (mag_tensor_t*[]){x, y}, 2, NULL, 0);
 }
 
+mag_tensor_t* mag_linear(mag_tensor_t* x, mag_tensor_t* y, mag_tensor_t* bias, mag_activation_t act) {
+    mag_op_param_t param = {.type=MAG_OP_TPARAM_U32, .x.u32=(uint32_t)act};
+    return mag_tensor_operator(x->ctx, MAG_OP_LINEAR, false, (mag_tensor_t*[]){x, y, bias}, 3, &param, 1);
+}
+
+mag_tensor_t* mag_quantize(mag_tensor_t* x, int64_t block) {
+    int64_t row = x->shape[1];
+    mag_assert(block == 0 || (block > 0 && !(block & (block-1)) && row % block == 0), "Quantization block must be 0 (per row) or a power of two dividing the row length %" PRIi64 ", got: %" PRIi64, row, block);
+    mag_op_param_t param = {.type=MAG_OP_TPARAM_I32, .x.i32=(int32_t)(block ? block : row)};
+    return mag_tensor_operator(x->ctx, MAG_OP_QUANTIZE, false, &x, 1, &param, 1);
+}
+
+mag_tensor_t* mag_dequantize(mag_tensor_t* x) {
+    if (mag_dtype_is_qblock(x->dtype)) return mag_cast(x, MAG_DTYPE_F32);
+    return mag_tensor_operator(x->ctx, MAG_OP_DEQUANTIZE, false, &x, 1, NULL, 0);
+}
+
+mag_tensor_t* mag_cast(mag_tensor_t* x, mag_dtype_t type) {
+    mag_assert(type < MAG_DTYPE__NUM && type != MAG_DTYPE_I8 && type != MAG_DTYPE_I32, "Can only cast to F32, BF16, F16, Q8 or Q4, got: %s, use quantize() for int8", mag_dtype_meta_of(type)->name);
+    mag_op_param_t param = {.type=MAG_OP_TPARAM_U32, .x.u32=(uint32_t)type};
+    return mag_tensor_operator(x->ctx, MAG_OP_CAST, false, &x, 1, &param, 1);
+}
+
+/*
+** Elementwise fusion of deferred graphs. The chain of F32 elementwise nodes producing a root is compiled into a mag_fused_program_t,
+** its leaves are the first non-elementwise (or already materialized) inputs. Nodes must broadcast numpy style (extent 1 or the full extent),
+** so every leaf maps onto the result with plain strides (0 along broadcast dims). Intermediate nodes are not written.
+** Chains are cut after MAG_FUSED_MAX_INSTRS nodes, the remaining elementwise inputs become leaves which must be computed on their own.
+** Registers are reused as soon as their last consumer ran, which keeps long chains within MAG_FUSED_MAX_REGS tiles.
+*/
+struct mag_graph_map_t;
+static uint32_t* mag_graph_map_get(const struct mag_graph_map_t* m, const mag_tensor_t* t);
+
+typedef struct mag_fuse_builder_t {
+    mag_fused_program_t* p;
+    const mag_tensor_t* out;
+    const struct mag_graph_map_t* roots;        /* Nodes computed on their own (leaves of the chain), NULL to fuse every elementwise input */
+    uint32_t num_nodes;
+    mag_tensor_t* nodes[MAG_FUSED_MAX_INSTRS];  /* Fused nodes */
+    uint32_t uses[MAG_FUSED_MAX_INSTRS];        /* Remaining consumers of each node */
+    uint8_t slots[MAG_FUSED_MAX_INSTRS];        /* Register slot holding the value of each node, 0xff until emitted */
+    uint32_t live;                              /* Bitmask of occupied registers */
+} mag_fuse_builder_t;
+
+static bool mag_op_is_fusable(mag_op_t op) {
+    return op >= MAG_OP_ABS && op <= MAG_OP_DIVS && op != MAG_OP_SOFTMAX; /* Softmax normalizes whole rows */
+}
+
+static bool mag_fuse_is_node(const mag_fuse_builder_t* b, const mag_tensor_t* t) {
+    if (!mag_op_is_fusable(t->op) || t->dtype != MAG_DTYPE_F32) return false;
+    if (t != b->out && ((t->flags & MAG_TFLAG_EXEC_EAGER) || (b->roots && mag_graph_map_get(b->roots, t)))) return false; /* Materialized */
+    if (t->view_uplink && (t != b->out || memcmp(t->strides, t->op_inputs[0]->strides, sizeof(t->strides)) != 0))
+        return false; /* In-place nodes write their base buffer: only as root and element for element, otherwise they run on their own */
+    uint32_t argc = mag_op_meta_of(t->op)->argcount;
+    for (uint32_t i=0; i < argc; ++i)
+        if (t->op_inputs[i]->dtype != MAG_DTYPE_F32) return false;
+    for (int64_t i=0; i < MAG_MAX_DIMS; ++i) {
+        if (t->shape[i] != 1 && t->shape[i] != b->out->shape[i]) return false;
+        if (argc == 2 && t->op_inputs[1]->shape[i] != 1 && t->op_inputs[1]->shape[i] != t->shape[i]) return false; /* Repeating (tiled) broadcasts have no stride form */
+    }
+    return true;
+}
+
+static void mag_fuse_count(mag_fuse_builder_t* b, mag_tensor_t* t) {
+    for (uint32_t k=0; k < b->num_nodes; ++k) {
+        if (b->nodes[k] == t) {
+            ++b->uses[k];
+            return;
+        }
+    }
+    if (b->num_nodes == MAG_FUSED_MAX_INSTRS) return; /* Chain is full, t stays a leaf */
+    uint32_t k = b->num_nodes++;
+    b->nodes[k] = t;
+    b->uses[k] = 1;
+    b->slots[k] = 0xff;
+    uint32_t argc = mag_op_meta_of(t->op)->argcount;
+    for (uint32_t i=0; i < argc; ++i)
+        if (mag_fuse_is_node(b, t->op_inputs[i]))
+            mag_fuse_count(b, t->op_inputs[i]);
+}
+
+static int mag_fuse_leaf(mag_fuse_builder_t* b, mag_tensor_t* t) {
+    mag_fused_program_t* p = b->p;
+    for (uint32_t j=0; j < p->num_inputs; ++j)
+        if (p->inputs[j] == t) return (int)j;
+    if (p->num_inputs == MAG_FUSED_MAX_INPUTS) return -1;
+    if (t->dtype != MAG_DTYPE_F32) return -1;
+    int64_t* s = p->strides[p->num_inputs];
+    for (int64_t i=0; i < MAG_MAX_DIMS; ++i)
+        s[i] = t->shape[i] == b->out->shape[i] ? t->strides[i] : 0;
+    if (t->storage.base == b->out->storage.base && memcmp(s, b->out->strides, sizeof(b->out->strides)) != 0) return -1; /* Only element-for-element aliasing with the result is safe */
+    p->inputs[p->num_inputs] = t;
+    return (int)p->num_inputs++;
+}
+
+static void mag_fuse_release(mag_fuse_builder_t* b, int slot) {
+    if (slot < MAG_FUSED_MAX_INPUTS) return;
+    for (uint32_t k=0; k < b->num_nodes; ++k) {
+        if (b->slots[k] == slot) {
+            if (!--b->uses[k]) b->live &= ~(1u<<(slot - MAG_FUSED_MAX_INPUTS));
+            return;
+        }
+    }
+}
+
+static int mag_fuse_emit(mag_fuse_builder_t* b, mag_tensor_t* t) {
+    uint32_t k = 0;
+    while (k < b->num_nodes && b->nodes[k] != t) ++k;
+    if (k == b->num_nodes) return mag_fuse_leaf(b, t); /* Not part of the chain */
+    if (b->slots[k] != 0xff) return b->slots[k];
+    mag_fused_program_t* p = b->p;
+    bool binary = mag_op_meta_of(t->op)->argcount == 2;
+    int sa = mag_fuse_emit(b, t->op_inputs[0]);
+    int sb = binary ? mag_fuse_emit(b, t->op_inputs[1]) : 0;
+    if (sa < 0 || sb < 0 || p->num_instrs == MAG_FUSED_MAX_INSTRS) return -1;
+    mag_fuse_release(b, sa);
+    if (binary) mag_fuse_release(b, sb);
+    uint32_t reg = 0;
+    while (reg < MAG_FUSED_MAX_REGS && (b->live & (1u<<reg))) ++reg;
+    if (reg == MAG_FUSED_MAX_REGS) return -1;
+    b->live |= 1u<<reg;
+    p->num_regs = mag_xmax(p->num_regs, reg+1);
+    b->slots[k] = (uint8_t)(MAG_FUSED_MAX_INPUTS + reg);
+    p->code[p->num_instrs++] = (mag_fused_instr_t){
+        .op = t->op,
+        .dst = (uint8_t)reg,
+        .a = (uint8_t)sa,
+        .b = (uint8_t)sb,
+        .s = t->op >= MAG_OP_ADDS ? t->op_params[0].x.f32 : 0.0f
+    };
+    return b->slots[k];
+}
+
+/* Compiles the elementwise chain producing root into a program, NULL if root is no fusable node or the chain exceeds the leaf or register limits. */
+static mag_fused_program_t* mag_fuse_elementwise(mag_tensor_t* root, const struct mag_graph_map_t* roots) {
+    mag_fuse_builder_t b = {.out = root, .roots = roots};
+    if (!mag_fuse_is_node(&b, root)) return NULL;
+    mag_fused_program_t* p = (*mag_alloc)(NULL, sizeof(*p));
+    memset(p, 0, sizeof(*p));
+    b.p = p;
+    mag_fuse_count(&b, root);
+    if (mag_fuse_emit(&b, root) < 0) {
+        (*mag_alloc)(p, 0);
+        return NULL;
+    }
+    return p;
+}
+
+/* Rewrites root into the fused op running p, the fused nodes stay untouched. */
+static void mag_fuse_rewrite(mag_tensor_t* root, mag_fused_program_t* p) {
+    root->op = MAG_OP_FUSED;
+    root->fused = p;
+    memset(root->op_inputs, 0, sizeof(root->op_inputs));
+    memset(root->op_params, 0, sizeof(root->op_params));
+}
+
+void mag_tensor_eval_fused(mag_tensor_t* t) {
+    if (t->op == MAG_OP_FUSED) { /* Already fused, run it again */
+        mag_op_exec(t, t->ctx->device, MAG_GRA_FWD);
+        return;
+    }
+    mag_assert(mag_op_is_fusable(t->op), "Tensor must be the result of an elementwise op, got: %s", mag_op_meta_of(t->op)->mnemonic);
+    mag_fused_program_t* p = mag_fuse_elementwise(t, NULL);
+    if (mag_unlikely(!p)) { /* Too many leaves or registers: evaluate the elementwise inputs on their own first */
+        uint32_t argc = mag_op_meta_of(t->op)->argcount;
+        for (uint32_t i=0; i < argc; ++i)
+            if (mag_op_is_fusable(t->op_inputs[i]->op) || t->op_inputs[i]->op == MAG_OP_FUSED)
+                mag_tensor_eval_fused(t->op_inputs[i]);
+        mag_op_exec(t, t->ctx->device, MAG_GRA_FWD);
+        return;
+    }
+    for (uint32_t j=0; j < p->num_inputs; ++j) /* Elementwise leaves that could not join the chain (cut chains, repeating broadcasts) */
+        if (mag_op_is_fusable(p->inputs[j]->op) || p->inputs[j]->op == MAG_OP_FUSED)
+            mag_tensor_eval_fused(p->inputs[j]);
+    mag_fuse_rewrite(t, p);
+    mag_op_exec(t, t->ctx->device, MAG_GRA_FWD);
+}
+
+/*
+** Executor for deferred graphs. Compilation walks the graph from the outputs (iterative DFS, no recursion on deep graphs) and stores the op nodes
+** in post order, so every node runs after its inputs and branches not reaching an output are never visited. Tensors without an op and
+** tensors already computed eagerly are leaves. Elementwise chains are fused before scheduling.
+** Execution is a plain loop over the schedule, dispatching each node like eager mode does.
+*/
+typedef struct mag_graph_visit_t {
+    mag_tensor_t* t;
+    uint32_t next; /* Next input to visit */
+} mag_graph_visit_t;
+
+static uint32_t mag_graph_num_inputs(const mag_tensor_t* t) {
+    if (t->op == MAG_OP_FUSED) return t->fused->num_inputs;
+    uint32_t n = 0;
+    while (n < MAG_MAX_INPUT_TENSORS && t->op_inputs[n]) ++n;
+    return n;
+}
+
+static mag_tensor_t* mag_graph_input(const mag_tensor_t* t, uint32_t i) {
+    return t->op == MAG_OP_FUSED ? t->fused->inputs[i] : t->op_inputs[i];
+}
+
+static bool mag_graph_is_leaf(const mag_tensor_t* t) {
+    return t->op == MAG_OP_NOP || (t->flags & MAG_TFLAG_EXEC_EAGER);
+}
+
+/* Open addressing map from tensors to indices, cap is a power of two and the load factor stays below 1/2. */
+typedef struct mag_graph_map_t {
+    mag_tensor_t** keys;
+    uint32_t* vals;
+    size_t cap;
+    size_t len;
+} mag_graph_map_t;
+
+static size_t mag_graph_map_slot(mag_tensor_t* const* keys, size_t cap, const mag_tensor_t* t) {
+    size_t h = ((uintptr_t)t>>4)*0x9e3779b97f4a7c15ull & (cap-1);
+    while (keys[h] && keys[h] != t) h = (h+1) & (cap-1);
+    return h;
+}
+
+/* Returns the value of t, NULL if absent. */
+static uint32_t* mag_graph_map_get(const mag_graph_map_t* m, const mag_tensor_t* t) {
+    if (!m->cap) return NULL;
+    size_t h = mag_graph_map_slot(m->keys, m->cap, t);
+    return m->keys[h] ? m->vals+h : NULL;
+}
+
+/* Inserts t with value v, returns false if t was already present. */
+static bool mag_graph_map_put(mag_graph_map_t* m, mag_tensor_t* t, uint32_t v) {
+    if ((m->len+1)<<1 > m->cap) {
+        size_t ncap = m->cap ? m->cap<<1 : 64;
+        mag_tensor_t** nkeys = (*mag_alloc)(NULL, ncap*sizeof(*nkeys));
+        uint32_t* nvals = (*mag_alloc)(NULL, ncap*sizeof(*nvals));
+        memset(nkeys, 0, ncap*sizeof(*nkeys));
+        for (size_t i=0; i < m->cap; ++i) {
+            if (!m->keys[i]) continue;
+            size_t h = mag_graph_map_slot(nkeys, ncap, m->keys[i]);
+            nkeys[h] = m->keys[i];
+            nvals[h] = m->vals[i];
+        }
+        if (m->cap) {
+            (*mag_alloc)(m->keys, 0);
+            (*mag_alloc)(m->vals, 0);
+        }
+        m->keys = nkeys;
+        m->vals = nvals;
+        m->cap = ncap;
+    }
+    size_t h = mag_graph_map_slot(m->keys, m->cap, t);
+    if (m->keys[h]) return false;
+    m->keys[h] = t;
+    m->vals[h] = v;
+    ++m->len;
+    return true;
+}
+
+static void mag_graph_map_free(mag_graph_map_t* m) {
+    if (!m->cap) return;
+    (*mag_alloc)(m->keys, 0);
+    (*mag_alloc)(m->vals, 0);
+}
+
+/* Appends t to the growable array. */
+static void mag_graph_push(mag_tensor_t*** arr, uint32_t* len, uint32_t* cap, mag_tensor_t* t) {
+    mag_assert(*len < UINT32_MAX, "Graph too large");
+    if (*len == *cap) *arr = (*mag_alloc)(*arr, (*cap = *cap ? *cap<<1 : 16)*sizeof(**arr));
+    (*arr)[(*len)++] = t;
+}
+
+/* Precomputes the intra-op worker count of every node, so execution skips the work scaling. Shapes of scheduled nodes never change. */
+static void mag_graph_plan_workers(mag_graph_t* g) {
+    mag_compute_device_t* dvc = g->ctx->device;
+    if (!dvc->exec_workers || !dvc->exec_fwd_workers || !g->num_nodes) return;
+    g->workers = (*mag_alloc)(NULL, g->num_nodes*sizeof(*g->workers));
+    for (uint32_t i=0; i < g->num_nodes; ++i)
+        g->workers[i] = (*dvc->exec_workers)(dvc, g->nodes[i]);
+}
+
+static void mag_graph_retain(mag_graph_t* g, mag_tensor_t* t) {
+    mag_tensor_incref(t);
+    if (t->view_uplink) mag_tensor_incref(t->view_uplink); /* mag_tensor_decref releases the base of views too */
+    mag_graph_push(&g->retained, &g->num_retained, &g->retained_cap, t);
+}
+
+/* Records an eagerly executed node. Nodes and their inputs are retained, so the buffers stay fixed for replay even after the caller released them. */
+static void mag_graph_capture(mag_graph_t* g, mag_tensor_t* r) {
+    for (uint32_t i=0, argc=mag_graph_num_inputs(r); i < argc; ++i)
+        mag_graph_retain(g, mag_graph_input(r, i));
+    mag_graph_retain(g, r);
+    if (r->view_uplink) mag_graph_push(&g->views, &g->num_views, &g->views_cap, r);
+    if (r->op == MAG_OP_VIEW || r->op == MAG_OP_TRANSPOSE || r->op == MAG_OP_PERMUTE) return;
+    mag_graph_push(&g->nodes, &g->num_nodes, &g->nodes_cap, r);
+}
+
+void mag_ctx_capture_begin(mag_ctx_t* ctx) {
+    mag_assert(!ctx->capture, "Context is already capturing");
+    mag_assert(ctx->exec_mode == MAG_EXEC_MODE_EAGER, "Capturing requires eager execution mode");
+    mag_graph_t* g = (*mag_alloc)(NULL, sizeof(*g));
+    memset(g, 0, sizeof(*g));
+    g->ctx = ctx;
+    ctx->capture = g;
+}
+
+mag_graph_t* mag_ctx_capture_end(mag_ctx_t* ctx) {
+    mag_graph_t* g = ctx->capture;
+    mag_assert(g, "Context is not capturing, call mag_ctx_capture_begin first");
+    ctx->capture = NULL;
+    mag_graph_plan_workers(g);
+    return g;
+}
+
+/* Collects the op nodes reachable from the outputs in post order, views included. */
+static void mag_graph_walk(mag_tensor_t** outputs, uint32_t num_outputs, mag_tensor_t*** order, uint32_t* len, uint32_t* cap) {
+    mag_graph_map_t visited = {0};
+    size_t sp = 0, stack_cap = 16;
+    mag_graph_visit_t* stack = (*mag_alloc)(NULL, stack_cap*sizeof(*stack));
+    *len = 0;
+    for (uint32_t o=0; o < num_outputs; ++o) {
+        if (mag_graph_is_leaf(outputs[o]) || !mag_graph_map_put(&visited, outputs[o], 0)) continue;
+        stack[sp++] = (mag_graph_visit_t){.t = outputs[o], .next = 0};
+        while (sp) {
+            mag_graph_visit_t* top = stack+sp-1;
+            if (top->next < mag_graph_num_inputs(top->t)) {
+                mag_tensor_t* in = mag_graph_input(top->t, top->next++);
+                if (mag_graph_is_leaf(in) || !mag_graph_map_put(&visited, in, 0)) continue;
+                if (sp == stack_cap) stack = (*mag_alloc)(stack, (stack_cap <<= 1)*sizeof(*stack));
+                stack[sp++] = (mag_graph_visit_t){.t = in, .next = 0};
+                continue;
+            }
+            mag_graph_push(order, len, cap, stack[--sp].t); /* All inputs visited */
+        }
+    }
+    mag_graph_map_free(&visited);
+    (*mag_alloc)(stack, 0);
+}
+
+/*
+** Fuses the elementwise chains of the walked nodes into MAG_OP_FUSED nodes (see mag_tensor_eval_fused), starting at the outputs.
+** Chain roots are the nodes which must be computed: outputs and nodes read more than once or by a node outside of a chain (any other op or a view).
+** The remaining elementwise nodes join the chain of their single consumer and are no longer computed.
+*/
+static void mag_graph_fuse(mag_tensor_t** outputs, uint32_t num_outputs, mag_tensor_t** order, uint32_t len) {
+    mag_graph_map_t seen = {0}, roots = {0};
+    for (uint32_t o=0; o < num_outputs; ++o)
+        mag_graph_map_put(&roots, outputs[o], 0);
+    for (uint32_t i=0; i < len; ++i) {
+        mag_tensor_t* t = order[i];
+        bool chain = mag_op_is_fusable(t->op) && t->dtype == MAG_DTYPE_F32;
+        for (uint32_t j=0, argc=mag_graph_num_inputs(t); j < argc; ++j) {
+            mag_tensor_t* in = mag_graph_input(t, j);
+            if (!mag_graph_map_put(&seen, in, 0) || !chain)
+                mag_graph_map_put(&roots, in, 0);
+        }
+    }
+    for (uint32_t i=len; i--;) { /* Consumers first, inputs of a root turning out to be roots are visited afterwards */
+        mag_tensor_t* t = order[i];
+        if (!mag_op_is_fusable(t->op) || !mag_graph_map_get(&roots, t)) continue;
+        mag_fused_program_t* p = mag_fuse_elementwise(t, &roots);
+        if (!p) { /* Too many leaves or registers, keep the node and fuse its inputs on their own */
+            for (uint32_t j=0, argc=mag_graph_num_inputs(t); j < argc; ++j)
+                mag_graph_map_put(&roots, mag_graph_input(t, j), 0);
+            continue;
+        }
+        for (uint32_t j=0; j < p->num_inputs; ++j) /* Elementwise leaves that could not join the chain are scheduled as roots */
+            mag_graph_map_put(&roots, p->inputs[j], 0);
+        if (p->num_instrs == 1) (*mag_alloc)(p, 0); /* Single node, nothing to fuse */
+        else mag_fuse_rewrite(t, p);
+    }
+    mag_graph_map_free(&roots);
+    mag_graph_map_free(&seen);
+}
+
+mag_graph_t* mag_graph_compile(mag_tensor_t** outputs, uint32_t num_outputs) {
+    mag_assert(outputs && num_outputs, "Graph requires at least one output");
+    mag_ctx_t* ctx = (*outputs)->ctx;
+    for (uint32_t o=0; o < num_outputs; ++o)
+        mag_assert(outputs[o] && outputs[o]->ctx == ctx, "Graph outputs must be non-NULL tensors of the same context");
+    mag_graph_t* g = (*mag_alloc)(NULL, sizeof(*g));
+    memset(g, 0, sizeof(*g));
+    g->ctx = ctx;
+    g->num_outputs = num_outputs;
+    g->outputs = (*mag_alloc)(NULL, num_outputs*sizeof(*g->outputs));
+    memcpy(g->outputs, outputs, num_outputs*sizeof(*outputs));
+    mag_tensor_t** order = NULL;
+    uint32_t len = 0, cap = 0;
+    mag_graph_walk(outputs, num_outputs, &order, &len, &cap);
+    mag_graph_fuse(outputs, num_outputs, order, len);
+    mag_graph_walk(outputs, num_outputs, &order, &len, &cap); /* Fused nodes are no longer reachable */
+    for (uint32_t i=0; i < len; ++i) {
+        mag_tensor_t* t = order[i];
+        if (t->view_uplink) mag_graph_push(&g->views, &g->num_views, &g->views_cap, t);
+        if (t->op == MAG_OP_VIEW || t->op == MAG_OP_TRANSPOSE || t->op == MAG_OP_PERMUTE) continue; /* Views alias their input, nothing to compute */
+        mag_graph_push(&g->nodes, &g->num_nodes, &g->nodes_cap, t);
+    }
+    if (order) (*mag_alloc)(order, 0);
+    mag_graph_plan_workers(g);
+    return g;
+}
+
+void mag_graph_execute(mag_graph_t* g) {
+    mag_compute_device_t* dvc = g->ctx->device;
+    if (!g->workers || g->ctx->profiler_enabled) { /* Generic dispatch, which also updates the profiler */
+        for (uint32_t i=0; i < g->num_nodes; ++i)
+            mag_op_exec(g->nodes[i], dvc, MAG_GRA_FWD);
+        return;
+    }
+    void (*exec)(mag_compute_device_t*, mag_tensor_t*, uint32_t) = dvc->exec_fwd_workers;
+    for (uint32_t i=0; i < g->num_nodes; ++i) {
+        (*exec)(dvc, g->nodes[i], g->workers[i]);
+        mag_tensor_mark_written(g->nodes[i]);
+    }
+}
+
+uint32_t mag_graph_node_count(const mag_graph_t* g) {
+    return g->num_nodes;
+}
+
+/*
+** Static memory planner. Intermediates are the storage owners computed by the schedule that are neither outputs (or viewed by one)
+** nor referenced from outside of the graph. Each lives from the node computing it to the last node reading it (through any view).
+** Walking the schedule, a result takes the block of its first input if the op may run in place and that input dies at this node,
+** otherwise the best fitting free block of the arena or fresh space at its end. Blocks are returned after their last reader ran.
+*/
+typedef struct mag_graph_block_t {
+    size_t offs;
+    size_t size;
+} mag_graph_block_t;
+
+static void mag_graph_block_free(mag_graph_block_t* list, uint32_t* len, size_t* end, mag_graph_block_t b) { /* Sorted by offset, adjacent blocks are merged */
+    uint32_t i = 0;
+    while (i < *len && list[i].offs < b.offs) ++i;
+    if (i && list[i-1].offs + list[i-1].size == b.offs) {
+        b.offs = list[i-1].offs;
+        b.size += list[i-1].size;
+        memmove(list+i-1, list+i, (*len - i)*sizeof(*list));
+        --*len, --i;
+    }
+    if (i < *len && b.offs + b.size == list[i].offs) {
+        b.size += list[i].size;
+        memmove(list+i, list+i+1, (*len - i - 1)*sizeof(*list));
+        --*len;
+    }
+    if (b.offs + b.size == *end) { /* Tail block shrinks the arena instead */
+        *end = b.offs;
+        return;
+    }
+    memmove(list+i+1, list+i, (*len - i)*sizeof(*list));
+    list[i] = b;
+    ++*len;
+}
+
+static size_t mag_graph_block_alloc(mag_graph_block_t* list, uint32_t* len, size_t* end, size_t* peak, size_t size) {
+    uint32_t best = UINT32_MAX;
+    for (uint32_t i=0; i < *len; ++i)
+        if (list[i].size >= size && (best == UINT32_MAX || list[i].size < list[best].size))
+            best = i;
+    if (best == UINT32_MAX) {
+        size_t offs = *end;
+        *end += size;
+        *peak = mag_xmax(*peak, *end);
+        return offs;
+    }
+    size_t offs = list[best].offs;
+    list[best].offs += size;
+    list[best].size -= size;
+    if (!list[best].size) {
+        memmove(list+best, list+best+1, (*len - best - 1)*sizeof(*list));
+        --*len;
+    }
+    return offs;
+}
+
+static bool mag_graph_can_run_inplace(const mag_tensor_t* r, const mag_tensor_t* x) {
+    if (!mag_op_meta_of(r->op)->inplace || r->op == MAG_OP_MATMUL) return false; /* Matmul reads whole rows of x for every output */
+    if (x->view_uplink || r->dtype != x->dtype || r->numel != x->numel) return false;
+    if (memcmp(r->shape, x->shape, sizeof(r->shape)) != 0 || memcmp(r->strides, x->strides, sizeof(r->strides)) != 0) return false;
+    for (uint32_t i=1; i < MAG_MAX_INPUT_TENSORS && r->op_inputs[i]; ++i) /* Other operands must not read x at different positions */
+        if (mag_tensor_storage_root(r->op_inputs[i]) == x) return false;
+    return true;
+}
+
+size_t mag_graph_plan_memory(mag_graph_t* g) {
+    if (g->arena.base || g->num_retained) return g->planned_bytes; /* Planned already or captured, captured buffers stay fixed */
+    uint32_t n = g->num_nodes;
+    mag_graph_map_t index = {0}; /* Intermediate -> schedule index */
+    for (uint32_t i=0; i < n; ++i) {
+        mag_tensor_t* t = g->nodes[i];
+        if (!t->view_uplink && (t->flags & MAG_TFLAG_OWNER) && t->storage.size)
+            mag_graph_map_put(&index, t, i);
+    }
+    for (uint32_t o=0; o < g->num_outputs; ++o) { /* Outputs keep their buffers */
+        uint32_t* k = mag_graph_map_get(&index, mag_tensor_storage_root(g->outputs[o]));
+        if (k) *k = UINT32_MAX;
+    }
+    uint32_t* refs = (*mag_alloc)(NULL, (n+1)*sizeof(*refs)); /* Expected strong references: the owner and every view in the graph */
+    uint32_t* last = (*mag_alloc)(NULL, (n+1)*sizeof(*last)); /* Last reader */
+    for (uint32_t i=0; i < n; ++i) refs[i] = 1, last[i] = i;
+    for (uint32_t v=0; v < g->num_views; ++v) {
+        uint32_t* k = mag_graph_map_get(&index, g->views[v]->view_uplink);
+        if (k && *k != UINT32_MAX) ++refs[*k];
+    }
+    for (uint32_t i=0; i < n; ++i) {
+        mag_tensor_t* t = g->nodes[i];
+        uint32_t* k = mag_graph_map_get(&index, t);
+        if (k && *k != UINT32_MAX && t->rcb.rc_strong != refs[*k]) *k = UINT32_MAX; /* Held outside of the graph */
+        if (t->view_uplink && (k = mag_graph_map_get(&index, t->view_uplink)) && *k != UINT32_MAX) last[*k] = i; /* In-place node writes the viewed buffer */
+        for (uint32_t j=0, argc=mag_graph_num_inputs(t); j < argc; ++j)
+            if ((k = mag_graph_map_get(&index, mag_tensor_storage_root(mag_graph_input(t, j)))) && *k != UINT32_MAX)
+                last[*k] = i;
+    }
+    size_t align = MAG_CACHE_LINE_SIZE;
+    for (uint32_t i=0; i < n; ++i) {
+        uint32_t* k = mag_graph_map_get(&index, g->nodes[i]);
+        if (k && *k != UINT32_MAX) align = mag_xmax(align, g->nodes[i]->storage.alignment);
+    }
+    size_t* offs = (*mag_alloc)(NULL, (n+1)*sizeof(*offs));
+    uint32_t* dying = (*mag_alloc)(NULL, (n+1)*sizeof(*dying)); /* Intermediates bucketed by last reader, linked through next */
+    uint32_t* next = (*mag_alloc)(NULL, (n+1)*sizeof(*next));
+    for (uint32_t i=0; i < n; ++i) dying[i] = UINT32_MAX;
+    for (uint32_t i=0; i < n; ++i) {
+        uint32_t* k = mag_graph_map_get(&index, g->nodes[i]);
+        if (!k || *k == UINT32_MAX) continue;
+        next[i] = dying[last[i]];
+        dying[last[i]] = i;
+    }
+    mag_graph_block_t* free_list = (*mag_alloc)(NULL, (n+1)*sizeof(*free_list));
+    uint32_t num_free = 0;
+    size_t end = 0, peak = 0, unplanned = 0;
+    for (uint32_t i=0; i < n; ++i) {
+        mag_tensor_t* t = g->nodes[i];
+        uint32_t* k = mag_graph_map_get(&index, t);
+        if (k && *k != UINT32_MAX) {
+            size_t size = (t->storage.size + align-1) & ~(align-1);
+            uint32_t* kx = t->op_inputs[0] ? mag_graph_map_get(&index, t->op_inputs[0]) : NULL;
+            unplanned += size;
+            if (kx && *kx != UINT32_MAX && last[*kx] == i && mag_graph_can_run_inplace(t, t->op_inputs[0])) {
+                offs[i] = offs[*kx]; /* Take over the block of x */
+                for (uint32_t* p = dying+i; *p != UINT32_MAX; p = next+*p) {
+                    if (*p == *kx) {
+                        *p = next[*kx];
+                        break;
+                    }
+                }
+            } else {
+                offs[i] = mag_graph_block_alloc(free_list, &num_free, &end, &peak, size);
+            }
+        }
+        for (uint32_t d=dying[i]; d != UINT32_MAX; d = next[d]) {
+            size_t size = (g->nodes[d]->storage.size + align-1) & ~(align-1);
+            mag_graph_block_free(free_list, &num_free, &end, (mag_graph_block_t){.offs = offs[d], .size = size});
+        }
+    }
+    (*mag_alloc)(free_list, 0);
+    (*mag_alloc)(next, 0);
+    (*mag_alloc)(dying, 0);
+    if (peak) {
+        mag_compute_device_t* dvc = g->ctx->device;
+        (*dvc->alloc_storage)(dvc, &g->arena, peak);
+        for (uint32_t i=0; i < n; ++i) { /* Move the intermediates into the arena */
+            mag_tensor_t* t = g->nodes[i];
+            uint32_t* k = mag_graph_map_get(&index, t);
+            if (!k || *k == UINT32_MAX) continue;
+            mag_storage_buffer_t sto = g->arena;
+            sto.base += offs[i];
+            sto.size = t->storage.size;
+            (*dvc->free_storage)(dvc, &t->storage);
+            t->storage = sto;
+            t->flags &= ~MAG_TFLAG_OWNER; /* The graph owns the arena */
+        }
+        for (uint32_t v=0; v < g->num_views; ++v)
+            g->views[v]->storage = g->views[v]->view_uplink->storage;
+    }
+    (*mag_alloc)(offs, 0);
+    (*mag_alloc)(last, 0);
+    (*mag_alloc)(refs, 0);
+    mag_graph_map_free(&index);
+    g->planned_bytes = peak;
+    double mem_plan, mem_sum;
+    const char* unit_plan, *unit_sum;
+    mag_humanize_memory_size(peak, &mem_plan, &unit_plan);
+    mag_humanize_memory_size(unplanned, &mem_sum, &unit_sum);
+    mag_log_info("Graph memory plan: %.03f %s arena for %.03f %s of intermediates", mem_plan, unit_plan, mem_sum, unit_sum);
+    return peak;
+}
+
+static bool mag_graph_in_arena(const mag_graph_t* g, const mag_tensor_t* t) {
+    return t->storage.base >= g->arena.base && t->storage.base < g->arena.base + g->arena.size;
+}
+
+void mag_graph_destroy(mag_graph_t* g) {
+    if (g->arena.base) {
+        for (uint32_t v=0; v < g->num_views; ++v) /* Detach the planned intermediates and their views, so they do not point into the freed arena */
+            if (mag_graph_in_arena(g, g->views[v])) memset(&g->views[v]->storage, 0, sizeof(g->views[v]->storage));
+        for (uint32_t i=0; i < g->num_nodes; ++i)
+            if (mag_graph_in_arena(g, g->nodes[i])) memset(&g->nodes[i]->storage, 0, sizeof(g->nodes[i]->storage));
+        mag_compute_device_t* dvc = g->ctx->device;
+        (*dvc->free_storage)(dvc, &g->arena);
+    }
+    for (uint32_t i=0; i < g->num_retained; ++i)
+        mag_tensor_decref(g->retained[i]);
+    if (g->retained) (*mag_alloc)(g->retained, 0);
+    if (g->workers) (*mag_alloc)(g->workers, 0);
+    if (g->views) (*mag_alloc)(g->views, 0);
+    if (g->nodes) (*mag_alloc)(g->nodes, 0);
+    if (g->outputs) (*mag_alloc)(g->outputs, 0);
+    (*mag_alloc)(g, 0);
+}
+
 static MAG_AINLINE void mag_tensor_virtual_to_physical_index(const mag_tensor_t* t, int64_t v_idx, int64_t(*p_idx)[MAG_MAX_DIMS]) {
     mag_static_assert(MAG_MAX_DIMS == 6);
     mag_load_local_storage_group(t, d, shape);
@@ -1869,9 +3056,11 @@ void mag_tensor_copy_buffer_from(mag_tensor_t* t, const void* data, size_t size)
     mag_assert(size == (size_t) mag_tensor_data_size(t), "Buffer size mismatch: %zu != %lld", size, mag_tensor_data_size(t));
     mag_storage_buffer_t* sto = &t->storage;
     (*sto->cpy_host_device)(sto, 0, data, size);
+    mag_tensor_mark_written(t);
 }
 
 void mag_tensor_fill(mag_tensor_t* t, float x) {
+    mag_tensor_mark_written(t);
     if (x == 0.0f) {
         mag_storage_buffer_t* sto = &t->storage;
         (*sto->set)(sto, 0, 0); /* Zero out the buffer. */
@@ -1891,6 +3080,7 @@ void mag_tensor_fill(mag_tensor_t* t, float x) {
 
 void mag_tensor_fill_random_uniform(mag_tensor_t* t, float min, float max) {
     mag_assert2(t->ctx->device_type == MAG_COMPUTE_DEVICE_TYPE_CPU);
+    mag_tensor_mark_written(t);
     switch (t->dtype) {
         case MAG_DTYPE_F32: {
             int64_t n = mag_tensor_numel(t);
@@ -1903,6 +3093,7 @@ void mag_tensor_fill_random_uniform(mag_tensor_t* t, float min, float max) {
 
 void mag_tensor_fill_random_normal(mag_tensor_t* t, float mean, float stddev) {
     mag_assert2(t->ctx->device_type == MAG_COMPUTE_DEVICE_TYPE_CPU);
+    mag_tensor_mark_written(t);
     switch (t->dtype) {
         case MAG_DTYPE_F32: {
             int64_t n = mag_tensor_numel(t);
@@ -1923,6 +3114,29 @@ void mag_tensor_fill_random_normal(mag_tensor_t* t, float mean, float stddev) {
     }
 }
 
+bool mag_tensor_pack_weights(mag_tensor_t* t) {
+    mag_assert(t->rank >= 2 && mag_tensor_is_contiguous_or_transposed(t), "Packed weights must be a contiguous or transposed matrix");
+    if (mag_tensor_packed_weights(t)) return true; /* Already packed and up to date. */
+    mag_tensor_unpack_weights(t); /* Drop stale packing, if any. */
+    mag_compute_device_t* dvc = t->ctx->device;
+    void* (*pack)(mag_compute_device_t*, const mag_tensor_t*) = dvc->pack_weights;
+    if (!pack) return false; /* Not supported by the compute device. */
+    t->packed.data = (*pack)(dvc, t);
+    t->packed.version = mag_tensor_storage_root(t)->version;
+    return t->packed.data != NULL;
+}
+
+bool mag_tensor_is_packed(const mag_tensor_t* t) {
+    return mag_tensor_packed_weights(t) != NULL;
+}
+
+void mag_tensor_unpack_weights(mag_tensor_t* t) {
+    if (!t->packed.data) return;
+    mag_compute_device_t* dvc = t->ctx->device;
+    (*dvc->free_packed_weights)(dvc, t->packed.data);
+    t->packed.data = NULL;
+}
+
 uint64_t mag_tensor_get_packed_refcounts(const mag_tensor_t* t) {
     return (uint64_t)t->rcb.rc_strong|((uint64_t)t->rcb.rc_weak << 32);
 }
@@ -2031,6 +3245,7 @@ int64_t mag_tensor_rank(const mag_tensor_t* t) { return t->rank; }
 const int64_t* mag_tensor_shape(const mag_tensor_t* t) { return t->shape; }
 const int64_t* mag_tensor_strides(const mag_tensor_t* t) { return t->strides; }
 mag_dtype_t mag_tensor_dtype(const mag_tensor_t* t) { return t->dtype; }
+int64_t mag_tensor_quant_block(const mag_tensor_t* t) { return t->qblock; }
 
 void* mag_tensor_data_ptr(const mag_tensor_t* t) {
     return (void*)t->storage.base;
@@ -2108,6 +3323,12 @@ float mag_tensor_get_scalar_physical_index(mag_tensor_t* t, int64_t d0, int64_t
             (*sto->cpy_device_host)(sto, sizeof(r)*(d0*s0 + d1*s1 + d2*s2 + d3*s3 + d4*s4 + d5*s5), &r, sizeof(r));
             return r;
         }
+        case MAG_DTYPE_I32: {
+            int32_t r;
+            mag_storage_buffer_t* sto = &t->storage;
+            (*sto->cpy_device_host)(sto, sizeof(r)*(d0*s0 + d1*s1 + d2*s2 + d3*s3 + d4*s4 + d5*s5), &r, sizeof(r));
+            return (float)r;
+        }
         default: mag_panic("Unsupported data type: %s", mag_dtype_meta_of(t->dtype)->name);
     }
 }
@@ -2119,6 +3340,7 @@ void mag_tensor_set_scalar_physical_index(mag_tensor_t* t, int64_t d0, int64_t d
         case MAG_DTYPE_F32: {
             mag_storage_buffer_t* sto = &t->storage;
             (*sto->cpy_host_device)(sto, sizeof(x)*(d0*s0 + d1*s1 + d2*s2 + d3*s3 + d4*s4 + d5*s5), &x, sizeof(x));
+            mag_tensor_mark_written(t);
         } break;
         default: mag_panic("Unsupported data type: %s", mag_dtype_meta_of(t->dtype)->name);
     }
@@ -2137,6 +3359,12 @@ float mag_tensor_get_scalar_virtual_index(mag_tensor_t* t, int64_t v_idx) {
             (*sto->cpy_device_host)(sto, sizeof(r)*v_idx, &r, sizeof(r));
             return r;
         }
+        case MAG_DTYPE_I32: {
+            int32_t r;
+            mag_storage_buffer_t* sto = &t->storage;
+            (*sto->cpy_device_host)(sto, sizeof(r)*v_idx, &r, sizeof(r));
+            return (float)r;
+        }
         default:
             mag_panic("Unsupported data type: %s", mag_dtype_meta_of(t->dtype)->name);
     }
@@ -2153,6 +3381,7 @@ void mag_tensor_set_scalar_virtual_index(mag_tensor_t* t, int64_t v_idx, float x
         case MAG_DTYPE_F32: {
             mag_storage_buffer_t* sto = &t->storage;
             (*sto->cpy_host_device)(sto, sizeof(x)*v_idx, &x, sizeof(x));
+            mag_tensor_mark_written(t);
         } break;
         default:
             mag_panic("Unsupported data type: %s", mag_dtype_meta_of(t->dtype)->name);
@@ -2856,6 +4085,8 @@ mag_static_assert(sizeof(MAG_STO_MAGIC)-1 == sizeof(uint64_t));
 mag_static_assert(MAG_MAX_TENSOR_NAME_LEN % 8 == 0);
 mag_static_assert(MAG_DTYPE__NUM <= 0xff);
 mag_static_assert(MAG_MAX_DIMS <= 0xff);
+#define MAG_STO_DATA_ALIGN 4 /* Each tensor data record is zero padded to this alignment */
+#define mag_sto_data_pad(size) ((MAG_STO_DATA_ALIGN - (size_t)(size)%MAG_STO_DATA_ALIGN)%MAG_STO_DATA_ALIGN)
 #define mag_sto_sanitize(exp, ret) do { if (mag_unlikely(!(exp))) { mag_log_error("magnetron storage sanitize error: " #exp); return (ret); } } while (0)
 
 static bool mag_sto_write_file_header( /* Write file header -  file header must be same in every version. */
@@ -2900,6 +4131,7 @@ static bool mag_sto_write_tensor_header(
     const char (*name)[MAG_MAX_TENSOR_NAME_LEN],
     mag_tensor_flags_t flags,
     mag_dtype_t dtype,
+    int64_t qblock,
     int64_t rank,
     const int64_t (*shape)[MAG_MAX_DIMS]
 ) {
@@ -2911,7 +4143,13 @@ static bool mag_sto_write_tensor_header(
             memcpy(name_u64, *name, sizeof(*name));
             for (size_t i=0; i < sizeof(name_u64)/sizeof(*name_u64); ++i)   /* Write name as multiple u64 */
                 mag_sto_write_u64_le(p, name_u64[i]);
+            uint32_t qshift = 0;  /* Quantization block: 0 = one scale per row, n = 1<<(n-1) elements per scale */
+            if (qblock && qblock != (*shape)[1]) {
+                mag_sto_sanitize(qblock > 0 && !(qblock & (qblock-1)), false);
+                for (qshift=1; (1ll<<(qshift-1)) != qblock; ++qshift);
+            }
             uint32_t aux = 0;   /* Pack small fields into aux field */
+            aux |= qshift << 24;
             aux |= (flags & 0xff) << 16;
             aux |= (dtype & 0xff) << 8;
             aux |= (rank & 0xff);
@@ -2933,6 +4171,7 @@ static bool mag_sto_read_tensor_header(
     char (*name)[MAG_MAX_TENSOR_NAME_LEN],
     mag_tensor_flags_t* flags,
     mag_dtype_t* dtype,
+    int64_t* qblock,
     int64_t* rank,
     int64_t (*shape)[MAG_MAX_DIMS]
 ) {
@@ -2946,6 +4185,7 @@ static bool mag_sto_read_tensor_header(
             memcpy(name, name_u64, sizeof(*name));
             (*name)[sizeof(*name)-1] = '\0';
             uint32_t aux = mag_sto_read_u32_le(p); /* Read aux field */
+            uint32_t qshift = (aux >> 24) & 0xff;
             *flags = (mag_tensor_flags_t)((aux >> 16) & 0xff);
             *dtype = (mag_dtype_t)((aux >> 8) & 0xff);
             *rank = (int64_t)(aux & 0xff);
@@ -2962,6 +4202,10 @@ static bool mag_sto_read_tensor_header(
             mag_sto_sanitize(INT64_MAX/(*shape)[3] > (*shape)[0]*(*shape)[1]*(*shape)[2], false);
             mag_sto_sanitize(INT64_MAX/(*shape)[4] > (*shape)[0]*(*shape)[1]*(*shape)[2]*(*shape)[3], false);
             mag_sto_sanitize(INT64_MAX/(*shape)[5] > (*shape)[0]*(*shape)[1]*(*shape)[2]*(*shape)[3]*(*shape)[4], false);
+            mag_sto_sanitize(qshift <= 31 && (!qshift || *dtype == MAG_DTYPE_I8), false);
+            *qblock = *dtype != MAG_DTYPE_I8 ? 0 : qshift ? 1ll<<(qshift-1) : (*shape)[1];
+            mag_sto_sanitize(!*qblock || (*shape)[1]/(*qblock)*(*qblock) == (*shape)[1], false); /* Block must divide rows */
+            mag_sto_sanitize(!mag_dtype_is_qblock(*dtype) || (*shape)[*rank > 1]/MAG_QK*MAG_QK == (*shape)[*rank > 1], false); /* Rows must be whole blocks */
         } break;
         default: return false;
     }
@@ -2977,16 +4221,18 @@ static bool mag_sto_write_tensor_data(
     int64_t size
 ) {
     mag_sto_sanitize(size > 0, false);
-    mag_sto_sanitize(*p + size <= end, false);
+    size_t pad = mag_sto_data_pad(size);
+    mag_sto_sanitize(*p + size + pad <= end, false);
     const uint8_t* start = *p;
     switch (version) {
         case 1: {
             memcpy(*p, data, size);
-            *p += size;
+            memset(*p + size, 0, pad); /* Q8/Q4 blocks and odd F16 counts leave the record unaligned */
+            *p += size + pad;
         } break;
         default: return false;
     }
-    return mag_likely(*p - start == size);
+    return mag_likely(*p - start == size + (int64_t)pad);
 }
 
 static bool mag_sto_read_tensor_data(
@@ -2998,30 +4244,32 @@ static bool mag_sto_read_tensor_data(
     int64_t size
 ) {
     mag_sto_sanitize(size > 0, false);
-    mag_sto_sanitize(*p + size <= end, false);
+    size_t pad = mag_sto_data_pad(size);
+    mag_sto_sanitize(*p + size + pad <= end, false);
     const uint8_t* start = *p;
     switch (version) {
         case 1: {
             memcpy(data, *p, size); /* TODO: endianess conversion */
-            *p += size;
+            *p += size + pad; /* Skip alignment padding */
         } break;
         default: return false;
     }
-    return mag_likely(*p - start == size);
+    return mag_likely(*p - start == size + (int64_t)pad);
 }
 
-static size_t mag_accumulate_data_size(mag_dtype_t dtype, const int64_t (*shape)[MAG_MAX_DIMS]) {
-    size_t size = mag_dtype_meta_of(dtype)->size;
+static size_t mag_accumulate_data_size(mag_dtype_t dtype, int64_t qblock, const int64_t (*shape)[MAG_MAX_DIMS]) {
+    int64_t numel = 1;
     #pragma GCC unroll 6
-    for (size_t i=0; i < MAG_MAX_DIMS; ++i) size *= (size_t)mag_xmax(1, (*shape)[i]);
-    return size;
+    for (size_t i=0; i < MAG_MAX_DIMS; ++i) numel *= mag_xmax(1, (*shape)[i]);
+    return (size_t)mag_dtype_data_size(dtype, numel, qblock);
 }
 
 static size_t mag_sto_total_size(const mag_tensor_t** tensors, size_t n) {
     size_t total = MAG_STO_FILE_HEADER_SIZE;
     for (size_t i=0; i < n; ++i) {
         total += MAG_STO_TENSOR_HEADER_SIZE;
-        total += mag_accumulate_data_size(tensors[i]->dtype, &tensors[i]->shape);
+        size_t data_size = mag_accumulate_data_size(tensors[i]->dtype, tensors[i]->qblock, &tensors[i]->shape);
+        total += data_size + mag_sto_data_pad(data_size);
     }
     mag_assert((total & 3) == 0, "Unaligned storage size: %zu", total);
     return total;
@@ -3044,6 +4292,7 @@ static uint8_t* mag_sto_write_buffered(const mag_tensor_t** tensors, size_t n_te
             &t->name,
             t->flags,
             t->dtype,
+            t->qblock,
             t->rank,
             &t->shape
         ))) goto error;
@@ -3074,10 +4323,11 @@ MAG_EXPORT mag_tensor_t** mag_sto_read_buffered(mag_ctx_t* ctx, const uint8_t* b
         char name[MAG_MAX_TENSOR_NAME_LEN] = {0};
         mag_tensor_flags_t flags = 0;
         mag_dtype_t dtype = 0;
+        int64_t qblock = 0;
         int64_t rank = 0;
         int64_t shape[MAG_MAX_DIMS] = {0};
-        if (mag_unlikely(!mag_sto_read_tensor_header(&needle, end, *out_version, &name, &flags, &dtype, &rank, &shape))) goto error;   /* Read tensor header */
-        mag_tensor_t* t = mag_tensor_create(ctx, dtype, shape, rank, NULL, 0);   /* Create placeholder tensor */
+        if (mag_unlikely(!mag_sto_read_tensor_header(&needle, end, *out_version, &name, &flags, &dtype, &qblock, &rank, &shape))) goto error;   /* Read tensor header */
+        mag_tensor_t* t = mag_tensor_create_ex(ctx, dtype, shape, rank, NULL, 0, qblock);   /* Create placeholder tensor */
         mag_tensor_fmt_name(t, "%s", name);
         t->flags = flags;
         tensors[i] = t;
@@ -3085,7 +4335,7 @@ MAG_EXPORT mag_tensor_t** mag_sto_read_buffered(mag_ctx_t* ctx, const uint8_t* b
     for (size_t i=0; i < n_tensors; ++i) {  /* Read tensor data */
         mag_tensor_t* t = tensors[i];
         mag_assert2(t->ctx->device_type == MAG_COMPUTE_DEVICE_TYPE_CPU);
-        size_t data_size = mag_accumulate_data_size(t->dtype, &t->shape);
+        size_t data_size = mag_accumulate_data_size(t->dtype, t->qblock, &t->shape);
         mag_assert2(needle + data_size <= end && data_size == mag_tensor_data_size(t));
         if (mag_unlikely(!mag_sto_read_tensor_data(&needle, end, *out_version, t->dtype, (void*)t->storage.base, data_size))) goto error;  /* Read data into tensor's buffer */
     }
@@ -16,7 +16,7 @@ extern "C" {
 #define MAG_DEFAULT_CHUNK_CAP 128          /* Default capacity of memory chunk */
 #define MAG_MAX_DIMS 6                     /* Maximum number of dimensions for a tensor */
 #define MAG_MAX_TENSOR_NAME_LEN 64         /* Maximum length for tensor name */
-#define MAG_MAX_INPUT_TENSORS 2            /* Maximum number of input tensors for an operation */
+#define MAG_MAX_INPUT_TENSORS 3            /* Maximum number of input tensors for an operation */
 #define MAG_MAX_OP_PARAMS 6                /* Maximum number of parameters for an operation */
 
 #ifndef MAG_EXPORT
@@ -80,6 +80,17 @@ typedef enum mag_color_channels_t {
     MAG_COLOR_CHANNELS__NUM
 } mag_color_channels_t;
 
+typedef enum mag_activation_t { /* Activation function fused into the epilogue of mag_linear */
+    MAG_ACTIVATION_NONE = 0,    /* Identity */
+    MAG_ACTIVATION_SIGMOID = 1, /* x |-> 1/(1 + e^(-x)) */
+    MAG_ACTIVATION_RELU = 2,    /* x |-> max {x, 0} */
+    MAG_ACTIVATION_GELU = 3,    /* Tanh approximation of GELU */
+    MAG_ACTIVATION_SILU = 4,    /* x |-> x/(1 + e^(-x)) */
+    MAG_ACTIVATION_TANH = 5,    /* x |-> tanh x */
+
+    MAG_ACTIVATION__NUM
+} mag_activation_t;
+
 extern MAG_EXPORT void* (*mag_get_alloc_fn(void))(void* blk, size_t size); /* Get global allocator. */
 extern MAG_EXPORT void mag_set_alloc_fn(void* (*alloc)(void* blk, size_t size)); /* Set global allocator. */
 extern MAG_EXPORT void mag_set_log_mode(bool enabled); /* Enable/disable logging. */
@@ -128,12 +139,19 @@ typedef struct mag_tensor_t mag_tensor_t;
 
 typedef enum mag_dtype_t {
     MAG_DTYPE_F32,   /* 32-bit floating-point data type */
+    MAG_DTYPE_I8,    /* 8-bit symmetric quantized integer data type with one F32 scale per block of elements, see mag_quantize */
+    MAG_DTYPE_BF16,  /* 16-bit brain floating-point storage data type (F32 with truncated mantissa), see mag_cast */
+    MAG_DTYPE_F16,   /* 16-bit IEEE 754 half-precision floating-point storage data type, computed in F32, see mag_cast */
+    MAG_DTYPE_Q8,    /* 8-bit block-quantized weight data type, blocks of MAG_QK elements with one F16 scale (8.5 bits per element), see mag_cast */
+    MAG_DTYPE_Q4,    /* 4-bit block-quantized weight data type, blocks of MAG_QK elements with one F16 scale (4.5 bits per element), see mag_cast */
+    MAG_DTYPE_I32,   /* 32-bit signed integer index data type, produced by mag_argmax, mag_argmin and mag_topk */
     MAG_DTYPE__NUM /* Total number of data types */
 } mag_dtype_t;
 mag_static_assert(MAG_DTYPE__NUM <= 0xff);
+#define MAG_QK 32 /* Elements per block of the block-quantized data types MAG_DTYPE_Q8 and MAG_DTYPE_Q4 */
 
 typedef struct mag_dtype_meta_t {
-    int64_t size;         /* Size of the data type in bytes */
+    int64_t size;         /* Size of the data type in bytes, of one block of MAG_QK elements for block-quantized types */
     const char* name;    /* Name of the data type */
 } mag_dtype_meta_t;
 extern MAG_EXPORT const mag_dtype_meta_t* mag_dtype_meta_of(mag_dtype_t type);
@@ -233,6 +251,82 @@ extern MAG_EXPORT mag_tensor_t* mag_min(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_max(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_sum(mag_tensor_t* x);
 
+/**
+ * @brief Reduce a tensor over a set of axes by mean, min, max or sum.
+ *        The full reductions mag_mean, mag_min, mag_max and mag_sum are the same as reducing over all axes without keepdim.
+ *        Min and max ignore NaNs like fminf and fmaxf.
+ * @param x Contiguous F32 tensor.
+ * @param axes Axes to reduce, each in [0, rank) and unique. NULL or num_axes = 0 reduces over all axes.
+ * @param num_axes Number of axes.
+ * @param keepdim Keep the reduced axes with extent 1, otherwise they are removed (a reduction over all axes yields shape (1)).
+ * @return Reduced tensor.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_mean_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+extern MAG_EXPORT mag_tensor_t* mag_min_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+extern MAG_EXPORT mag_tensor_t* mag_max_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+extern MAG_EXPORT mag_tensor_t* mag_sum_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+
+/**
+ * @brief Index of the largest (argmax) or smallest (argmin) element along an axis.
+ *        Ties resolve to the lowest index. NaNs are ignored like in mag_max and mag_min, an all-NaN slice yields index 0.
+ * @param x Contiguous F32 tensor.
+ * @param axis Axis to reduce, in [0, rank). Its extent must not exceed INT32_MAX.
+ * @param keepdim Keep the reduced axis with extent 1, otherwise it is removed (reducing a rank 1 tensor yields shape (1)).
+ * @return MAG_DTYPE_I32 tensor of indices along axis.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_argmax(mag_tensor_t* x, int64_t axis, bool keepdim);
+extern MAG_EXPORT mag_tensor_t* mag_argmin(mag_tensor_t* x, int64_t axis, bool keepdim);
+
+/**
+ * @brief Indices of the k largest elements along an axis, ordered by descending value. Ties resolve to the lower index first, NaNs rank below all numbers.
+ *        Fetch the values with mag_gather(x, axis, indices).
+ * @param x Contiguous F32 tensor.
+ * @param k Number of elements to select, in [1, shape[axis]].
+ * @param axis Axis to select along, in [0, rank). Its extent must not exceed INT32_MAX.
+ * @return MAG_DTYPE_I32 tensor with the shape of x, except extent k along axis.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_topk(mag_tensor_t* x, int64_t k, int64_t axis);
+
+/**
+ * @brief Gather elements along an axis: r[..., i, ...] = x[..., index[..., i, ...], ...] where i is the coordinate along axis.
+ * @param x Contiguous F32 tensor.
+ * @param axis Axis to gather along, in [0, rank).
+ * @param index Contiguous MAG_DTYPE_I32 tensor with the rank and shape of x except along axis. Its values must be in [0, shape[axis]).
+ *        Out-of-range values are diagnosed if index holds its data at the call, values computed later by a deferred graph are clamped.
+ * @return F32 tensor with the shape of index, NULL if the shapes, dtypes or index values are invalid.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_gather(mag_tensor_t* x, int64_t axis, mag_tensor_t* index);
+
+/**
+ * @brief Layer normalization along the contiguous axis 0: every row of shape[0] elements becomes (x - mean)/√(var + eps) * weight + bias.
+ *        Mean and (biased) variance of a row are accumulated in F64 in one pass, the normalization is a second pass. Threads split the rows.
+ * @param x Contiguous F32 tensor.
+ * @param weight Contiguous F32 tensor with shape[0] elements of x, or NULL for no scale.
+ * @param bias Contiguous F32 tensor with shape[0] elements of x, or NULL for no shift.
+ * @param eps Added to the variance, e.g. 1e-5.
+ * @return F32 tensor with the shape of x.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_layer_norm(mag_tensor_t* x, mag_tensor_t* weight, mag_tensor_t* bias, float eps);
+
+/**
+ * @brief RMS normalization along the contiguous axis 0: every row of shape[0] elements becomes x/√(mean(x²) + eps) * weight.
+ * @param x Contiguous F32 tensor.
+ * @param weight Contiguous F32 tensor with shape[0] elements of x, or NULL for no scale.
+ * @param eps Added to the mean square, e.g. 1e-6.
+ * @return F32 tensor with the shape of x.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_rms_norm(mag_tensor_t* x, mag_tensor_t* weight, float eps);
+
+/**
+ * @brief Inclusive cumulative sum (cumsum) or product (cumprod) along an axis: r[..., i, ...] = x[..., 0, ...] + ... + x[..., i, ...].
+ *        Long rows are scanned in parallel as one block per thread plus an offset fix-up, so the rounding can differ slightly with the thread count.
+ * @param x Contiguous F32 tensor.
+ * @param axis Axis to scan along, in [0, rank).
+ * @return F32 tensor with the shape of x.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_cumsum(mag_tensor_t* x, int64_t axis);
+extern MAG_EXPORT mag_tensor_t* mag_cumprod(mag_tensor_t* x, int64_t axis);
+
 extern MAG_EXPORT mag_tensor_t* mag_abs(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_abs_(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_neg(mag_tensor_t* x);
@@ -249,6 +343,11 @@ extern MAG_EXPORT mag_tensor_t* mag_cos(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_cos_(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_step(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_step_(mag_tensor_t* x);
+/**
+ * @brief Numerically stable softmax along the contiguous axis 0: every row of shape[0] elements is mapped to e^(x-max x) / Σe^(x-max x).
+ *        Rows are computed in one fused online pass and split across threads. A NaN or +inf in a row makes the whole row NaN.
+ *        mag_softmax_dv takes the softmax output s and yields the Jacobian diagonal s*(1-s), like mag_sigmoid_dv.
+ */
 extern MAG_EXPORT mag_tensor_t* mag_softmax(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_softmax_(mag_tensor_t* x);
 extern MAG_EXPORT mag_tensor_t* mag_softmax_dv(mag_tensor_t* x);
@@ -294,6 +393,50 @@ extern MAG_EXPORT mag_tensor_t* mag_divs(mag_tensor_t* x, float xi);
 extern MAG_EXPORT mag_tensor_t* mag_divs_(mag_tensor_t* x, float xi);
 extern MAG_EXPORT mag_tensor_t* mag_matmul(mag_tensor_t* a, mag_tensor_t* b);
 
+/**
+ * @brief Fused linear layer: R = act(A x B + bias).
+ *        The bias add and activation are applied to each output tile while it is still cache-hot, instead of making
+ *        two more passes over the matmul result. Row i of the result takes row (i mod rows) of the bias, so bias is either
+ *        a per-row column [M, 1], a per-column row [1, N], a scalar [1, 1] or the full [M, N] matrix.
+ *        Batch dims of the bias are broadcasted (modulo) into the batch dims of the result.
+ * @param a Left operand, same constraints as mag_matmul.
+ * @param b Right operand, same constraints as mag_matmul. Pre-packed weights (see mag_tensor_pack_weights) are used.
+ * @param bias Contiguous bias tensor.
+ * @param act Activation applied after the bias add, MAG_ACTIVATION_NONE for none.
+ * @return Result tensor, shaped like mag_matmul(a, b).
+ */
+extern MAG_EXPORT mag_tensor_t* mag_linear(mag_tensor_t* a, mag_tensor_t* b, mag_tensor_t* bias, mag_activation_t act);
+
+/**
+ * @brief Quantize a F32 tensor to MAG_DTYPE_I8.
+ *        Each block of consecutive elements is scaled symmetrically by its absolute maximum: x ≈ scale*q with q in [-127, 127].
+ *        The buffer of the result holds the int8 values (padded to 4 bytes) followed by one F32 scale per block.
+ *        Int8 tensors can be multiplied with mag_matmul and mag_linear: the left operand a must be int8 and row-major,
+ *        the right operand b either F32 (quantized on the fly) or int8 with columns contiguous along K (a transposed view or a single column), quantized with the same block size.
+ * @param x Contiguous F32 tensor.
+ * @param block Elements per scale. 0 for one scale per row (shape[1] elements), else a power of two dividing shape[1].
+ * @return Quantized int8 tensor of the same shape.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_quantize(mag_tensor_t* x, int64_t block);
+extern MAG_EXPORT mag_tensor_t* mag_dequantize(mag_tensor_t* x); /* Dequantize a MAG_DTYPE_I8, MAG_DTYPE_Q8 or MAG_DTYPE_Q4 tensor to F32. */
+
+/**
+ * @brief Convert a tensor between the floating-point data types MAG_DTYPE_F32, MAG_DTYPE_F16 and MAG_DTYPE_BF16,
+ *        or between F32 and the block-quantized weight types MAG_DTYPE_Q8 and MAG_DTYPE_Q4.
+ *        Narrowing conversions round to nearest even, widening ones are exact.
+ *        BF16 tensors are storage types: besides moving them around, they can only be converted and multiplied with mag_matmul and mag_linear,
+ *        where they can be combined with F32 operands and are accumulated in F32. F32 operands are only rounded to BF16 on CPUs with AVX512-BF16 dot products.
+ *        F16 tensors can additionally be used with the elementwise (unary, scalar and binary) operators, if all operands are F16.
+ *        The operands are widened to F32 on load and the results rounded back to F16.
+ *        Q8 and Q4 tensors store blocks of MAG_QK consecutive elements of a row with one F16 scale d each, w ≈ d*q with q in [-127, 127] or [-8, 7].
+ *        The row length shape[1] must be a multiple of MAG_QK. They are multiplied with F32 operands by mag_matmul and mag_linear
+ *        and dequantized in registers: the quantized operand is either a row-major left operand a or a transposed view as right operand b.
+ * @param x Contiguous tensor.
+ * @param type Target data type.
+ * @return Converted tensor of the same shape, or a clone if the data type matches.
+ */
+extern MAG_EXPORT mag_tensor_t* mag_cast(mag_tensor_t* x, mag_dtype_t type);
+
 /**
  * @brief Increment reference count of tensor.
  *      Increment the strong reference count of the tensor. The tensor is not destroyed until the strong reference count reaches zero.
@@ -320,6 +463,81 @@ extern MAG_EXPORT void mag_tensor_fill(mag_tensor_t* t, float x); /* Set all ten
 extern MAG_EXPORT void mag_tensor_fill_random_uniform(mag_tensor_t* t, float min, float max); /* Fill tensor with random values from uniform distribution within [min, max] */
 extern MAG_EXPORT void mag_tensor_fill_random_normal(mag_tensor_t* t, float mean, float stddev); /* Fill tensor with random values from the normal distribution. */
 
+/**
+ * @brief Pre-pack a weight tensor for repeated matrix multiplications.
+ *      Converts the tensor once into the native panel layout of the matmul kernels and caches it on the tensor.
+ *      Every following mag_matmul with t as right-hand side operand (b) uses the packed copy and skips the per-call packing.
+ *      The cache is dropped automatically when the tensor (or a view sharing its storage) is written by an operator, fill or setter.
+ *      Writes through the raw mag_tensor_data_ptr are not tracked, call mag_tensor_unpack_weights afterwards.
+ *      Packing costs one additional copy of the tensor's memory.
+ * @param t Contiguous weight tensor of rank >= 2. Must not be NULL.
+ * @returns True if the tensor is packed, false if packing is not supported by the compute device or dtype.
+ */
+extern MAG_EXPORT bool mag_tensor_pack_weights(mag_tensor_t* t);
+extern MAG_EXPORT bool mag_tensor_is_packed(const mag_tensor_t* t); /* Check if the tensor has up-to-date packed weights. */
+extern MAG_EXPORT void mag_tensor_unpack_weights(mag_tensor_t* t); /* Drop packed weights of the tensor, if any. */
+
+/**
+ * @brief Evaluate a deferred elementwise expression in one fused pass.
+ *      For tensors recorded in MAG_EXEC_MODE_DEFERRED: the chain of F32 elementwise ops (unary, scalar and binary, softmax excluded) producing t
+ *      is compiled into a single kernel, which reads the leaf inputs once and writes only t. Intermediate tensors of the chain are not written.
+ *      Inputs broadcast numpy style (extent 1 or the full extent). Inputs produced by other ops must already hold their data.
+ *      Chains exceeding the fusion limits are split, t is rewritten into the fused op and can be evaluated again after its inputs changed.
+ * @param t Result of an elementwise op. Must not be NULL.
+ */
+extern MAG_EXPORT void mag_tensor_eval_fused(mag_tensor_t* t);
+
+/**
+ * @brief Compiled deferred or captured eager computation graph, see mag_graph_compile and mag_ctx_capture_begin.
+ */
+typedef struct mag_graph_t mag_graph_t;
+
+/**
+ * @brief Compile the deferred graph producing the outputs into an execution schedule.
+ *      Collects the op nodes reachable from the outputs in topological order, branches not reaching an output are skipped.
+ *      Tensors without an op and tensors computed in MAG_EXEC_MODE_EAGER are leaves, their data is read as is.
+ *      Chains of F32 elementwise ops are fused like mag_tensor_eval_fused: an elementwise node read only by the next op of its chain
+ *      is not computed, pass every tensor whose data is read afterwards as an output.
+ *      The graph does not reference the tensors (like op inputs of deferred tensors): keep them alive until mag_graph_destroy.
+ * @param outputs Output tensors of the same context. Must not be NULL.
+ * @param num_outputs Number of outputs, > 0.
+ * @returns Compiled graph, free with mag_graph_destroy.
+ */
+extern MAG_EXPORT mag_graph_t* mag_graph_compile(mag_tensor_t** outputs, uint32_t num_outputs);
+extern MAG_EXPORT void mag_graph_execute(mag_graph_t* g); /* Execute all nodes of the graph in order. Does not allocate, can be called repeatedly after the leaves changed. */
+extern MAG_EXPORT uint32_t mag_graph_node_count(const mag_graph_t* g); /* Get the number of scheduled op nodes */
+
+/**
+ * @brief Plan the memory of the intermediates of a compiled graph.
+ *      Tensor lifetimes are computed from the schedule, intermediates whose lifetimes do not overlap share the same memory of one arena,
+ *      elementwise nodes overwrite their first input in place if it is not read afterwards. Their own buffers are freed.
+ *      Intermediates are the op results which are neither outputs nor referenced outside of the graph (by an additional reference or a view).
+ *      After planning, their contents are only meaningful while mag_graph_execute runs, deferred ops outside of the graph must not read them.
+ *      Planning a graph twice or planning a captured graph has no effect.
+ *      mag_graph_destroy frees the arena and detaches the intermediates: their mag_tensor_data_ptr is NULL and ops assert when given them as inputs.
+ * @param g Compiled graph. Must not be NULL.
+ * @returns Planned peak memory of the intermediates in bytes (the arena size).
+ */
+extern MAG_EXPORT size_t mag_graph_plan_memory(mag_graph_t* g);
+extern MAG_EXPORT void mag_graph_destroy(mag_graph_t* g); /* Free the graph and its memory plan arena and release the references of a captured graph */
+
+/**
+ * @brief Start recording the ops executed in MAG_EXEC_MODE_EAGER into a graph for replay.
+ *      Ops execute as usual while capturing. Only ops are recorded, fills and copies into tensors are not.
+ * @param ctx Context in eager execution mode, not capturing already. Must not be NULL.
+ */
+extern MAG_EXPORT void mag_ctx_capture_begin(mag_ctx_t* ctx);
+
+/**
+ * @brief Stop recording and return the captured graph.
+ *      The graph references every recorded result and input, so their buffers stay fixed even if the caller releases its tensors.
+ *      mag_graph_execute replays the ops in the recorded order on the current contents of the inputs, without validation, allocation
+ *      or work scaling. Write new data into the captured inputs and read the results from the captured result tensors.
+ * @param ctx Capturing context. Must not be NULL.
+ * @returns Captured graph, free with mag_graph_destroy.
+ */
+extern MAG_EXPORT mag_graph_t* mag_ctx_capture_end(mag_ctx_t* ctx);
+
 extern MAG_EXPORT uint64_t mag_tensor_get_packed_refcounts(const mag_tensor_t* t); /* Return strong refcount is loword, weak refcount is hiword. */
 extern MAG_EXPORT void mag_tensor_retain(mag_tensor_t* t); /* Increment refcount */
 extern MAG_EXPORT size_t mag_tensor_get_memory_usage(const mag_tensor_t* t); /* Return memory used by this tensor in bytes. */
@@ -331,8 +549,9 @@ extern MAG_EXPORT int64_t mag_tensor_rank(const mag_tensor_t* t); /* Get the ran
 extern MAG_EXPORT const int64_t* mag_tensor_shape(const mag_tensor_t* t); /* Get the dimensions of the tensor */
 extern MAG_EXPORT const int64_t* mag_tensor_strides(const mag_tensor_t* t); /* Get the strides of the tensor */
 extern MAG_EXPORT mag_dtype_t mag_tensor_dtype(const mag_tensor_t* t); /* Get the data type of the tensor */
+extern MAG_EXPORT int64_t mag_tensor_quant_block(const mag_tensor_t* t); /* Get the number of elements per scale of a MAG_DTYPE_I8 tensor, 0 for other dtypes. */
 extern MAG_EXPORT void* mag_tensor_data_ptr(const mag_tensor_t* t); /* Get the tensor raw buffer pointer. Might pointer to GPU or any other device memory. */
-extern MAG_EXPORT int64_t mag_tensor_data_size(const mag_tensor_t* t); /* Get the size of the tensor buffer in bytes. */
+extern MAG_EXPORT int64_t mag_tensor_data_size(const mag_tensor_t* t); /* Get the size of the tensor buffer in bytes. Includes the scales of quantized tensors. */
 extern MAG_EXPORT int64_t mag_tensor_numel(const mag_tensor_t* t); /* Get the total amount of elements in the tensor. */
 extern MAG_EXPORT int64_t mag_tensor_num_rows(const mag_tensor_t* t); /* Get the number of rows (for 2D tensors) */
 extern MAG_EXPORT int64_t mag_tensor_num_cols(const mag_tensor_t* t); /* Get the number of columns (for 2D tensors) */
@@ -346,9 +565,9 @@ extern MAG_EXPORT bool mag_tensor_can_broadcast(const mag_tensor_t* a, const mag
 extern MAG_EXPORT bool mag_tensor_is_transposed(const mag_tensor_t* t); /* Check if the tensor is transposed */
 extern MAG_EXPORT bool mag_tensor_is_permuted(const mag_tensor_t* t); /* Check if the tensor is permuted */
 extern MAG_EXPORT bool mag_tensor_is_contiguous(const mag_tensor_t* t); /* Check if the tensor memory is contiguous */
-extern MAG_EXPORT float mag_tensor_get_scalar_physical_index(mag_tensor_t* t, int64_t d0, int64_t d1, int64_t d2, int64_t d3, int64_t d4, int64_t d5); /* Get scalar value at physical index */
+extern MAG_EXPORT float mag_tensor_get_scalar_physical_index(mag_tensor_t* t, int64_t d0, int64_t d1, int64_t d2, int64_t d3, int64_t d4, int64_t d5); /* Get scalar value at physical index, MAG_DTYPE_I32 values are converted to float */
 extern MAG_EXPORT void mag_tensor_set_scalar_physical_index(mag_tensor_t* t, int64_t d0, int64_t d1, int64_t d2, int64_t d3, int64_t d4, int64_t d5, float x); /* Set scalar value at physical index */
-extern MAG_EXPORT float mag_tensor_get_scalar_virtual_index(mag_tensor_t* t, int64_t v_idx); /* Get scalar value at virtual index */
+extern MAG_EXPORT float mag_tensor_get_scalar_virtual_index(mag_tensor_t* t, int64_t v_idx); /* Get scalar value at virtual index, MAG_DTYPE_I32 values are converted to float */
 extern MAG_EXPORT void mag_tensor_set_scalar_virtual_index(mag_tensor_t* t, int64_t v_idx, float x); /* Set scalar value at virtual index */
 extern MAG_EXPORT bool mag_tensor_eq(const mag_tensor_t* a, const mag_tensor_t* b); /* Check if two tensors are equal without epsilon. */
 extern MAG_EXPORT bool mag_tensor_is_close(const mag_tensor_t* a, const mag_tensor_t* b, float eps, double* percent_eq); /* Check if two tensors are equal with epsilon and percentage in equality. Set eps to < 0 to use machine epsilon. */
@@ -125,10 +125,10 @@ static const mag_cpu_op_info_t mag_cpu_op_infos[MAG_OP__NUM] = {
     [MAG_OP_VIEW]           = {.mt_support = false, .growth = 0.0, .threshold = 0},
     [MAG_OP_TRANSPOSE]      = {.mt_support = false, .growth = 0.0, .threshold = 0},
     [MAG_OP_PERMUTE]        = {.mt_support = false, .growth = 0.0, .threshold = 0},
-    [MAG_OP_MEAN]           = {.mt_support = false, .growth = 0.0, .threshold = 0},
-    [MAG_OP_MIN]            = {.mt_support = false, .growth = 0.0, .threshold = 0},
-    [MAG_OP_MAX]            = {.mt_support = false, .growth = 0.0, .threshold = 0},
-    [MAG_OP_SUM]            = {.mt_support = false, .growth = 0.0, .threshold = 0},
+    [MAG_OP_MEAN]           = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_MIN]            = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_MAX]            = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_SUM]            = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
     [MAG_OP_ABS]            = {.mt_support = true,  .growth = 0.1, .threshold = 0},
     [MAG_OP_NEG]            = {.mt_support = true,  .growth = 0.1, .threshold = 250000},
     [MAG_OP_LOG]            = {.mt_support = true,  .growth = 0.1, .threshold = 250000},
@@ -158,7 +158,20 @@ static const mag_cpu_op_info_t mag_cpu_op_infos[MAG_OP__NUM] = {
     [MAG_OP_SUBS]           = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
     [MAG_OP_MULS]           = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
     [MAG_OP_DIVS]           = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
-    [MAG_OP_MATMUL]         = {.mt_support = true,  .growth = 3.0, .threshold =  10000},
+    [MAG_OP_MATMUL]         = {.mt_support = true,  .growth = 3.0, .threshold = 262144},
+    [MAG_OP_LINEAR]         = {.mt_support = true,  .growth = 3.0, .threshold = 262144},
+    [MAG_OP_QUANTIZE]       = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_DEQUANTIZE]     = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_CAST]           = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_ARGMIN]         = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_ARGMAX]         = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_TOPK]           = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_GATHER]         = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_LAYER_NORM]     = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_RMS_NORM]       = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_CUMSUM]         = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_CUMPROD]        = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
+    [MAG_OP_FUSED]          = {.mt_support = true,  .growth = 0.2, .threshold = 250000},
 };
 
 typedef struct mag_worker_t mag_worker_t;
@@ -166,6 +179,8 @@ typedef struct mag_threadpool_t {
     mag_alignas(MAG_CACHE_LINE_SIZE) volatile bool interrupt;   /* Interrupt flag, 1=stop */
     mag_alignas(MAG_CACHE_LINE_SIZE) uint64_t phase;            /* Current compute phase */
     mag_alignas(MAG_CACHE_LINE_SIZE) uint64_t num_completed;    /* Number of workers that have completed their work */
+    mag_alignas(MAG_CACHE_LINE_SIZE) volatile mag_atomic_t cursor; /* Shared work item cursor for dynamically scheduled ops */
+    mag_reduce_partial_t partials[MAG_REDUCE_PARTIALS]; /* Per segment partials of full reductions */
     mag_cond_var_t cv;                              /* Condition variable for thread wakeup */
     mag_mutex_t mtx;                                /* Mutex for synchronization */
     uint32_t num_allocated_workers;                 /* Number of intra-op workers allocated */
@@ -208,7 +223,10 @@ static bool mag_worker_await_work(mag_worker_t* worker, mag_threadpool_t* pool)
 /* Execute the operation on the current thread */
 static void mag_worker_exec_thread_local(const mag_kernel_registry_t* kernels, mag_compute_payload_t* payload) {
     if (mag_likely(payload->node)) { /* Do the work 🦾 */
-        (*kernels->fwd[payload->node->op])(payload);
+        mag_op_t op = payload->node->op;
+        void (*kernel)(const mag_compute_payload_t*) = kernels->fwd[op];
+        if (payload->node->dtype == MAG_DTYPE_F16 && kernels->fwd_f16[op]) kernel = kernels->fwd_f16[op];
+        (*kernel)(payload);
         payload->node = NULL;
     }
 }
@@ -262,7 +280,7 @@ static mag_threadpool_t* mag_threadpool_create(uint32_t num_workers, const mag_k
     for (uint32_t ti=0; ti < num_workers; ++ti) { /* Initialize workers */
         workers[ti] = (mag_worker_t){
             .phase = 0,
-            .payload = (mag_compute_payload_t){.thread_num = num_workers, .thread_idx = ti, .node = NULL, },
+            .payload = (mag_compute_payload_t){.thread_num = num_workers, .thread_idx = ti, .node = NULL, .cursor = &pool->cursor, .partials = pool->partials},
             .pool = pool,
             .is_async = ti != 0 /* Main thread is worker but without thread */
         };
@@ -303,6 +321,7 @@ static void mag_threadpool_kickoff(mag_threadpool_t* pool, mag_tensor_t* node, u
     }
     ++pool->phase;
     pool->num_completed = 0; /* Reset completion counter */
+    pool->cursor = 0; /* Reset work item cursor */
     mag_mutex_unlock(&pool->mtx);
 }
 
@@ -329,14 +348,32 @@ static MAG_HOTPROC void mag_threadpool_parallel_compute(mag_threadpool_t* pool,
 
 static uint32_t mag_cpu_dynamic_work_scaling(mag_cpu_device_t* dvc, mag_op_t op, int64_t numel);
 
-static MAG_HOTPROC void mag_cpu_exec_fwd(mag_compute_device_t* dvc, mag_tensor_t* node) {
+/* Amount of work of an op for the worker scaling. Usually the number of output elements, but matmul scales with the inner dimension, reductions and selections with their input and fused chains with their length. */
+static int64_t mag_cpu_op_work(const mag_tensor_t* node) {
+    if (node->op == MAG_OP_MATMUL || node->op == MAG_OP_LINEAR) /* Multiply-accumulates: batches×M×N×K */
+        return node->numel*node->op_inputs[0]->shape[1];
+    if ((node->op >= MAG_OP_MEAN && node->op <= MAG_OP_SUM) || (node->op >= MAG_OP_ARGMIN && node->op <= MAG_OP_TOPK))
+        return node->op_inputs[0]->numel;
+    if (node->op == MAG_OP_FUSED) /* One pass per fused op */
+        return node->numel*node->fused->num_instrs;
+    return node->numel;
+}
+
+static uint32_t mag_cpu_exec_workers(mag_compute_device_t* dvc, const mag_tensor_t* node) {
+    return mag_cpu_dynamic_work_scaling(dvc->impl, node->op, mag_cpu_op_work(node));
+}
+
+static MAG_HOTPROC void mag_cpu_exec_fwd_workers(mag_compute_device_t* dvc, mag_tensor_t* node, uint32_t intraop_workers) {
     mag_cpu_device_t* cpu_dvc = dvc->impl;
-    uint32_t intraop_workers = mag_cpu_dynamic_work_scaling(cpu_dvc, node->op, node->numel);
     if (intraop_workers <= 1) { /* Main thread does the work (single threaded mode). */
+        mag_atomic_t cursor = 0;
+        mag_reduce_partial_t partials[MAG_REDUCE_PARTIALS];
         mag_compute_payload_t payload = {
             .node = node,
             .thread_idx = 0,
-            .thread_num = 1
+            .thread_num = 1,
+            .cursor = &cursor,
+            .partials = partials
         };
         mag_worker_exec_thread_local(&cpu_dvc->kernels, &payload);
         return; /* Done */
@@ -344,6 +381,10 @@ static MAG_HOTPROC void mag_cpu_exec_fwd(mag_compute_device_t* dvc, mag_tensor_t
     mag_threadpool_parallel_compute(cpu_dvc->pool, node, intraop_workers); /* Multithreaded mode. */
 }
 
+static MAG_HOTPROC void mag_cpu_exec_fwd(mag_compute_device_t* dvc, mag_tensor_t* node) {
+    mag_cpu_exec_fwd_workers(dvc, node, mag_cpu_exec_workers(dvc, node));
+}
+
 static MAG_HOTPROC void mag_cpu_exec_bwd(mag_compute_device_t* dvc, mag_tensor_t* root) {
     (void)dvc, (void)root;
     mag_panic("NYI");
@@ -389,6 +430,17 @@ static void mag_cpu_free_storage(mag_compute_device_t* dvc, mag_storage_buffer_t
     memset(buf, 0, sizeof(*buf)); /* Set to zero. */
 }
 
+static void* mag_cpu_pack_weights(mag_compute_device_t* dvc, const mag_tensor_t* t) {
+    mag_cpu_device_t* cpu_dvc = dvc->impl;
+    void* (*pack)(const mag_tensor_t*) = cpu_dvc->kernels.pack_matmul_rhs;
+    return pack ? (*pack)(t) : NULL;
+}
+
+static void mag_cpu_free_packed_weights(mag_compute_device_t* dvc, void* packed) {
+    (void)dvc;
+    mag_free_aligned(packed);
+}
+
 static mag_cpu_device_t* mag_cpu_init_device(mag_ctx_t* ctx, uint32_t num_threads) {
     mag_thread_sched_prio_t sched_prio = MAG_THREAD_SCHED_PRIO_HIGH;
     mag_cpu_device_t* dvc = (*mag_alloc)(NULL, sizeof(*dvc));
@@ -438,7 +490,11 @@ static mag_compute_device_t* mag_cpu_init_interface(mag_ctx_t* ctx, uint32_t num
         .eager_exec_fwd = &mag_cpu_exec_fwd,
         .eager_exec_bwd = &mag_cpu_exec_bwd,
         .alloc_storage = &mag_cpu_alloc_storage,
-        .free_storage = &mag_cpu_free_storage
+        .free_storage = &mag_cpu_free_storage,
+        .pack_weights = &mag_cpu_pack_weights,
+        .free_packed_weights = &mag_cpu_free_packed_weights,
+        .exec_workers = &mag_cpu_exec_workers,
+        .exec_fwd_workers = &mag_cpu_exec_fwd_workers
     };
     snprintf(dvc->name, sizeof(dvc->name), "%s", ctx->machine.cpu_name);
     return dvc;
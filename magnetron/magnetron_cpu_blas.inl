@@ -61,9 +61,25 @@
 
 typedef float mag_f32_t;
 typedef double mag_f64_t;
+typedef int8_t mag_i8_t;
+typedef int32_t mag_i32_t;
+typedef uint16_t mag_bf16_t; /* Raw BF16 bits */
+typedef uint16_t mag_f16_t; /* Raw IEEE 754 half bits */
 
 #define mag_f32p(t) ((const mag_f32_t*)(t)->storage.base)
 #define mag_f32p_mut(t) ((mag_f32_t*)(t)->storage.base)
+#define mag_i8p(t) ((const mag_i8_t*)(t)->storage.base)
+#define mag_i8p_mut(t) ((mag_i8_t*)(t)->storage.base)
+#define mag_i32p(t) ((const mag_i32_t*)(t)->storage.base)
+#define mag_i32p_mut(t) ((mag_i32_t*)(t)->storage.base)
+#define mag_f16p(t) ((const mag_f16_t*)(t)->storage.base)
+#define mag_f16p_mut(t) ((mag_f16_t*)(t)->storage.base)
+#define mag_f32_to_f32(x) (x) /* Identity conversions, so kernel templates can widen their operands to F32 and round back generically */
+#define mag_f32_from_f32(x) (x)
+#define mag_bf16p(t) ((const mag_bf16_t*)(t)->storage.base)
+#define mag_bf16p_mut(t) ((mag_bf16_t*)(t)->storage.base)
+#define mag_q8_scalesp(t) ((const mag_f32_t*)((t)->storage.base + mag_q8_scales_offs((t)->numel)))     /* F32 scales of a MAG_DTYPE_I8 tensor */
+#define mag_q8_scalesp_mut(t) ((mag_f32_t*)((t)->storage.base + mag_q8_scales_offs((t)->numel)))
 
 #if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
 
@@ -168,6 +184,32 @@ static __m512 mag_simd_tanh(__m512 x) { /* tanh' : ℝ -> (-1, 1), x |-> 1 / ((c
     return _mm512_fmadd_ps(two, inv, neg_one);
 }
 
+static void mag_simd_sincos(__m512 x, __m512 *osin, __m512 *ocos) {
+    __m512 sgn = _mm512_set1_ps(-0.0f);
+    __m512 sign_sin = _mm512_and_ps(x, sgn);
+    x = _mm512_andnot_ps(sgn, x);
+    __m512i emm2 = _mm512_cvttps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(1.27323954473516f)));
+    emm2 = _mm512_and_si512(_mm512_add_epi32(emm2, _mm512_set1_epi32(1)), _mm512_set1_epi32(~1));
+    __m512 y = _mm512_cvtepi32_ps(emm2);
+    __mmask16 poly_mask = _mm512_test_epi32_mask(emm2, _mm512_set1_epi32(2));
+    x = _mm512_fmadd_ps(y, _mm512_set1_ps(-0.78515625f), x);
+    x = _mm512_fmadd_ps(y, _mm512_set1_ps(-2.4187564849853515625e-4f), x);
+    x = _mm512_fmadd_ps(y, _mm512_set1_ps(-3.77489497744594108e-8f), x);
+    sign_sin = _mm512_xor_ps(sign_sin, _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_and_si512(emm2, _mm512_set1_epi32(4)), 29)));
+    __m512 sign_cos = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_andnot_si512(_mm512_sub_epi32(emm2, _mm512_set1_epi32(2)), _mm512_set1_epi32(4)), 29));
+    __m512 z = _mm512_mul_ps(x, x);
+    __m512 y1 = _mm512_fmadd_ps(_mm512_set1_ps(2.443315711809948e-005f), z, _mm512_set1_ps(-1.388731625493765e-003f));
+    __m512 y2 = _mm512_fmadd_ps(_mm512_set1_ps(-1.9515295891e-4f), z, _mm512_set1_ps(8.3321608736e-3f));
+    y1 = _mm512_fmadd_ps(y1, z, _mm512_set1_ps(4.166664568298827e-002f));
+    y2 = _mm512_fmadd_ps(y2, z, _mm512_set1_ps(-1.6666654611e-1f));
+    y1 = _mm512_mul_ps(_mm512_mul_ps(y1, z), z);
+    y1 = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y1);
+    y2 = _mm512_fmadd_ps(_mm512_mul_ps(y2, z), x, x);
+    y1 = _mm512_add_ps(y1, _mm512_set1_ps(1.0f));
+    *osin = _mm512_xor_ps(_mm512_mask_blend_ps(poly_mask, y2, y1), sign_sin);
+    *ocos = _mm512_xor_ps(_mm512_mask_blend_ps(poly_mask, y1, y2), sign_cos);
+}
+
 #elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
 
 static __m256 mag_simd_expf(const __m256 x) { /* exp(x) : ℝ -> (0, ∞), x |-> e^x. Error = 1.45358 + 0.5 ulps. x > 88.38 -> INF, x < -103.97 -> 0 */
@@ -210,6 +252,32 @@ static __m256 mag_simd_tanh(__m256 x) { /* tanh' : ℝ -> (-1, 1), x |-> 1 / ((c
     return _mm256_fmadd_ps(two, inv, neg_one);
 }
 
+static void mag_simd_sincos(__m256 x, __m256 *osin, __m256 *ocos) {
+    __m256 sgn = _mm256_set1_ps(-0.0f);
+    __m256 sign_sin = _mm256_and_ps(x, sgn);
+    x = _mm256_andnot_ps(sgn, x);
+    __m256i emm2 = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+    emm2 = _mm256_and_si256(_mm256_add_epi32(emm2, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 y = _mm256_cvtepi32_ps(emm2);
+    __m256 poly_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(emm2, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-0.78515625f), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-2.4187564849853515625e-4f), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-3.77489497744594108e-8f), x);
+    sign_sin = _mm256_xor_ps(sign_sin, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(emm2, _mm256_set1_epi32(4)), 29)));
+    __m256 sign_cos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(emm2, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y1 = _mm256_fmadd_ps(_mm256_set1_ps(2.443315711809948e-005f), z, _mm256_set1_ps(-1.388731625493765e-003f));
+    __m256 y2 = _mm256_fmadd_ps(_mm256_set1_ps(-1.9515295891e-4f), z, _mm256_set1_ps(8.3321608736e-3f));
+    y1 = _mm256_fmadd_ps(y1, z, _mm256_set1_ps(4.166664568298827e-002f));
+    y2 = _mm256_fmadd_ps(y2, z, _mm256_set1_ps(-1.6666654611e-1f));
+    y1 = _mm256_mul_ps(_mm256_mul_ps(y1, z), z);
+    y1 = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y1);
+    y2 = _mm256_fmadd_ps(_mm256_mul_ps(y2, z), x, x);
+    y1 = _mm256_add_ps(y1, _mm256_set1_ps(1.0f));
+    *osin = _mm256_xor_ps(_mm256_blendv_ps(y2, y1, poly_mask), sign_sin);
+    *ocos = _mm256_xor_ps(_mm256_blendv_ps(y1, y2, poly_mask), sign_cos);
+}
+
 #elif MAG_APPROXMATH && defined(__SSE2__)
 static __m128 mag_simd_expf(const __m128 x) { /* exp(x) : ℝ -> (0, ∞), x |-> e^x. Error = 1.45358 + 0.5 ulps. x > 88.38 -> INF, x < -103.97 -> 0 */
     __m128 r = _mm_set1_ps(0x1.8p23f);
@@ -255,17 +323,17 @@ static void mag_simd_sincos(__m128 x, __m128 *osin, __m128 *ocos) {
     __m128i sign_mask_sin = _mm_castps_si128(sign_mask_sin_ps);
     x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
     __m128 y = _mm_mul_ps(x, _mm_set1_ps(1.27323954473516f));
-    __m128i emm2 = _mm_cvtps_epi32(y);
+    __m128i emm2 = _mm_cvttps_epi32(y);
     emm2 = _mm_add_epi32(emm2, _mm_set1_epi32(1));
     emm2 = _mm_and_si128(emm2, _mm_set1_epi32(~1));
     y = _mm_cvtepi32_ps(emm2);
-    __m128i poly_mask = _mm_cmpeq_epi32(emm2, _mm_set1_epi32(2));
+    __m128i poly_mask = _mm_cmpeq_epi32(_mm_and_si128(emm2, _mm_set1_epi32(2)), _mm_set1_epi32(2));
     x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
     x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
     x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
-    __m128i tmp = _mm_cmpeq_epi32(emm2, _mm_set1_epi32(4));
+    __m128i tmp = _mm_cmpeq_epi32(_mm_and_si128(emm2, _mm_set1_epi32(4)), _mm_set1_epi32(4));
     sign_mask_sin = _mm_xor_si128(sign_mask_sin, tmp);
-    __m128i sign_mask_cos = _mm_cmpeq_epi32(_mm_sub_epi32(emm2, _mm_set1_epi32(2)), _mm_set1_epi32(4));
+    __m128i sign_mask_cos = _mm_cmpeq_epi32(_mm_and_si128(_mm_sub_epi32(emm2, _mm_set1_epi32(2)), _mm_set1_epi32(4)), _mm_set1_epi32(4));
     __m128 z = _mm_mul_ps(x, x);
     __m128 y1 = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-003f), _mm_mul_ps(z, _mm_set1_ps(2.443315711809948e-005f)));
     __m128 y2 = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(z, _mm_set1_ps(-1.9515295891e-4f)));
@@ -301,7 +369,33 @@ static void MAG_HOTPROC mag_vadd_f32(
 #ifdef MAG_ACCELERATE
     vDSP_vadd(y, 1, x, 1, o, 1, numel);
 #else
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        float32x4_t yi = vld1q_f32(y+i);
+        vst1q_f32(o+i, vaddq_f32(xi, yi));
+    }
+#elif defined(__AVX512F__)
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        __m512 yi = _mm512_loadu_ps(y+i);
+        _mm512_storeu_ps(o+i, _mm512_add_ps(xi, yi));
+    }
+#elif defined(__AVX__)
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        __m256 yi = _mm256_loadu_ps(y+i);
+        _mm256_storeu_ps(o+i, _mm256_add_ps(xi, yi));
+    }
+#elif defined(__SSE2__)
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        __m128 yi = _mm_loadu_ps(y+i);
+        _mm_storeu_ps(o+i, _mm_add_ps(xi, yi));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] + y[i];
     }
 #endif
@@ -316,7 +410,33 @@ static void MAG_HOTPROC mag_vsub_f32(
 #ifdef MAG_ACCELERATE
     vDSP_vsub(y, 1, x, 1, o, 1, numel);
 #else
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        float32x4_t yi = vld1q_f32(y+i);
+        vst1q_f32(o+i, vsubq_f32(xi, yi));
+    }
+#elif defined(__AVX512F__)
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        __m512 yi = _mm512_loadu_ps(y+i);
+        _mm512_storeu_ps(o+i, _mm512_sub_ps(xi, yi));
+    }
+#elif defined(__AVX__)
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        __m256 yi = _mm256_loadu_ps(y+i);
+        _mm256_storeu_ps(o+i, _mm256_sub_ps(xi, yi));
+    }
+#elif defined(__SSE2__)
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        __m128 yi = _mm_loadu_ps(y+i);
+        _mm_storeu_ps(o+i, _mm_sub_ps(xi, yi));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] - y[i];
     }
 #endif
@@ -331,7 +451,33 @@ static void MAG_HOTPROC mag_vmul_f32(
 #ifdef MAG_ACCELERATE
     vDSP_vmul(y, 1, x, 1, o, 1, numel);
 #else
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        float32x4_t yi = vld1q_f32(y+i);
+        vst1q_f32(o+i, vmulq_f32(xi, yi));
+    }
+#elif defined(__AVX512F__)
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        __m512 yi = _mm512_loadu_ps(y+i);
+        _mm512_storeu_ps(o+i, _mm512_mul_ps(xi, yi));
+    }
+#elif defined(__AVX__)
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        __m256 yi = _mm256_loadu_ps(y+i);
+        _mm256_storeu_ps(o+i, _mm256_mul_ps(xi, yi));
+    }
+#elif defined(__SSE2__)
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        __m128 yi = _mm_loadu_ps(y+i);
+        _mm_storeu_ps(o+i, _mm_mul_ps(xi, yi));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] * y[i];
     }
 #endif
@@ -346,7 +492,33 @@ static void MAG_HOTPROC mag_vdiv_f32(
 #ifdef MAG_ACCELERATE
     vDSP_vdiv(y, 1, x, 1, o, 1, numel);
 #else
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        float32x4_t yi = vld1q_f32(y+i);
+        vst1q_f32(o+i, vdivq_f32(xi, yi));
+    }
+#elif defined(__AVX512F__)
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        __m512 yi = _mm512_loadu_ps(y+i);
+        _mm512_storeu_ps(o+i, _mm512_div_ps(xi, yi));
+    }
+#elif defined(__AVX__)
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        __m256 yi = _mm256_loadu_ps(y+i);
+        _mm256_storeu_ps(o+i, _mm256_div_ps(xi, yi));
+    }
+#elif defined(__SSE2__)
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        __m128 yi = _mm_loadu_ps(y+i);
+        _mm_storeu_ps(o+i, _mm_div_ps(xi, yi));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] / y[i];
     }
 #endif
@@ -358,7 +530,33 @@ static void MAG_HOTPROC mag_vadds_f32(
     const mag_f32_t* x,
     const mag_f32_t y
 ) {
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vy = vdupq_n_f32(y);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vaddq_f32(xi, vy));
+    }
+#elif defined(__AVX512F__)
+    __m512 vy = _mm512_set1_ps(y);
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_add_ps(xi, vy));
+    }
+#elif defined(__AVX__)
+    __m256 vy = _mm256_set1_ps(y);
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_add_ps(xi, vy));
+    }
+#elif defined(__SSE2__)
+    __m128 vy = _mm_set1_ps(y);
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_add_ps(xi, vy));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] + y;
     }
 }
@@ -369,7 +567,33 @@ static void MAG_HOTPROC mag_vsubs_f32(
     const mag_f32_t* x,
     const mag_f32_t y
 ) {
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vy = vdupq_n_f32(y);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vsubq_f32(xi, vy));
+    }
+#elif defined(__AVX512F__)
+    __m512 vy = _mm512_set1_ps(y);
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_sub_ps(xi, vy));
+    }
+#elif defined(__AVX__)
+    __m256 vy = _mm256_set1_ps(y);
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_sub_ps(xi, vy));
+    }
+#elif defined(__SSE2__)
+    __m128 vy = _mm_set1_ps(y);
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_sub_ps(xi, vy));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] - y;
     }
 }
@@ -380,7 +604,33 @@ static void MAG_HOTPROC mag_vmuls_f32(
     const mag_f32_t* x,
     const mag_f32_t y
 ) {
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vy = vdupq_n_f32(y);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vmulq_f32(xi, vy));
+    }
+#elif defined(__AVX512F__)
+    __m512 vy = _mm512_set1_ps(y);
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_mul_ps(xi, vy));
+    }
+#elif defined(__AVX__)
+    __m256 vy = _mm256_set1_ps(y);
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_mul_ps(xi, vy));
+    }
+#elif defined(__SSE2__)
+    __m128 vy = _mm_set1_ps(y);
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_mul_ps(xi, vy));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] * y;
     }
 }
@@ -391,7 +641,33 @@ static void MAG_HOTPROC mag_vdivs_f32(
     const mag_f32_t* x,
     const mag_f32_t y
 ) {
-    for (int64_t i=0; i < numel; ++i) {
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vy = vdupq_n_f32(y);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vdivq_f32(xi, vy));
+    }
+#elif defined(__AVX512F__)
+    __m512 vy = _mm512_set1_ps(y);
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_div_ps(xi, vy));
+    }
+#elif defined(__AVX__)
+    __m256 vy = _mm256_set1_ps(y);
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_div_ps(xi, vy));
+    }
+#elif defined(__SSE2__)
+    __m128 vy = _mm_set1_ps(y);
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_div_ps(xi, vy));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
         o[i] = x[i] / y;
     }
 }
@@ -498,10 +774,10 @@ static mag_f32_t MAG_UNUSED MAG_HOTPROC mag_vdot_f32(
         vy[3] = _mm_loadu_ps(y+i+(3<<2));
         acc[3] = _mm_add_ps(acc[3], _mm_mul_ps(vx[3], vy[3]));
     }
+    acc[1] = _mm_add_ps(acc[1], acc[3]);
+    *acc = _mm_add_ps(*acc, acc[2]);
+    *acc = _mm_add_ps(*acc, acc[1]);
     #ifdef __SSE3__
-        acc[1] = _mm_add_ps(acc[1], acc[3]);
-        *acc = _mm_add_ps(*acc, acc[2]);
-        *acc = _mm_add_ps(*acc, acc[1]);
         *acc = _mm_hadd_ps(*acc, *acc);
         *acc = _mm_hadd_ps(*acc, *acc);
         mag_f32_t sum = _mm_cvtss_f32(*acc);
@@ -521,909 +797,4215 @@ static mag_f32_t MAG_UNUSED MAG_HOTPROC mag_vdot_f32(
 #endif
 }
 
-static mag_f64_t MAG_HOTPROC mag_vsum_f64_f32( /* Σx. */
+/*
+** Dot product of two int8 vectors with values in [-127, 127], accumulated exactly in int32.
+** The x86 paths multiply unsigned × signed bytes (VPDPBUSD, PMADDUBSW), so the sign of x is moved over to y first: x*y = |x|*(sign(x)*y).
+** -128 is excluded by the symmetric quantization, so neither |x| nor the negation of y overflows.
+*/
+static int32_t MAG_HOTPROC mag_vdot_i8(
     int64_t numel,
-    const mag_f32_t* x
+    const mag_i8_t* x,
+    const mag_i8_t* y
 ) {
-#ifdef MAG_ACCELERATE
-    mag_f32_t sum;
-    vDSP_sve(x, 1, &sum, numel);
-    return (mag_f64_t)sum;
-#else
-    mag_f64_t sum = 0.0;
-    for (int64_t i=0; i < numel; ++i) {
-        sum += (mag_f64_t)x[i];
+    int64_t i=0;
+    int32_t sum=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    int32x4_t acc = vdupq_n_s32(0);
+    #ifdef __ARM_FEATURE_DOTPROD
+        for (; i+15 < numel; i += 16)
+            acc = vdotq_s32(acc, vld1q_s8(x+i), vld1q_s8(y+i));
+    #else
+        for (; i+15 < numel; i += 16) {
+            int8x16_t vx = vld1q_s8(x+i);
+            int8x16_t vy = vld1q_s8(y+i);
+            acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(vx), vget_low_s8(vy)));
+            acc = vpadalq_s16(acc, vmull_high_s8(vx, vy));
+        }
+    #endif
+    sum = vaddvq_s32(acc);
+#elif defined(__AVX512VNNI__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+    __m512i zero = _mm512_setzero_si512();
+    __m512i acc = zero;
+    for (; i+63 < numel; i += 64) {
+        __m512i vx = _mm512_loadu_si512(x+i);
+        __m512i vy = _mm512_loadu_si512(y+i);
+        __m512i sy = _mm512_mask_sub_epi8(vy, _mm512_movepi8_mask(vx), zero, vy);
+        acc = _mm512_dpbusd_epi32(acc, _mm512_abs_epi8(vx), sy);
     }
-    return sum;
+    __m256i acc8 = _mm256_setzero_si256();
+    for (; i+31 < numel; i += 32) {
+        __m256i vx = _mm256_loadu_si256((const __m256i*)(x+i));
+        __m256i vy = _mm256_loadu_si256((const __m256i*)(y+i));
+        acc8 = _mm256_dpbusd_epi32(acc8, _mm256_sign_epi8(vx, vx), _mm256_sign_epi8(vy, vx));
+    }
+    sum = _mm512_reduce_add_epi32(_mm512_add_epi32(acc, _mm512_castsi256_si512(acc8)));
+#elif defined(__AVX2__)
+    __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc = _mm256_setzero_si256();
+    for (; i+31 < numel; i += 32) {
+        __m256i vx = _mm256_loadu_si256((const __m256i*)(x+i));
+        __m256i vy = _mm256_loadu_si256((const __m256i*)(y+i));
+        __m256i p16 = _mm256_maddubs_epi16(_mm256_sign_epi8(vx, vx), _mm256_sign_epi8(vy, vx)); /* Pairs sum to at most 2*127*127, no saturation */
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(p16, ones));
+    }
+    __m128i v0 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    v0 = _mm_hadd_epi32(v0, v0);
+    v0 = _mm_hadd_epi32(v0, v0);
+    sum = _mm_cvtsi128_si32(v0);
+#elif defined(__SSSE3__)
+    __m128i ones = _mm_set1_epi16(1);
+    __m128i acc = _mm_setzero_si128();
+    for (; i+15 < numel; i += 16) {
+        __m128i vx = _mm_loadu_si128((const __m128i*)(x+i));
+        __m128i vy = _mm_loadu_si128((const __m128i*)(y+i));
+        __m128i p16 = _mm_maddubs_epi16(_mm_sign_epi8(vx, vx), _mm_sign_epi8(vy, vx));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(p16, ones));
+    }
+    acc = _mm_hadd_epi32(acc, acc);
+    acc = _mm_hadd_epi32(acc, acc);
+    sum = _mm_cvtsi128_si32(acc);
 #endif
+    for (; i < numel; ++i) sum += (int32_t)x[i]*(int32_t)y[i]; /* Process leftovers scalar-wise */
+    return sum;
 }
 
-static mag_f32_t MAG_HOTPROC mag_vmin_f32( /* min x */
+/* Symmetric absmax quantization of a block: x ≈ scale*o with o in [-127, 127]. Returns the scale. */
+static mag_f32_t MAG_HOTPROC mag_vquantize_i8_f32(
     int64_t numel,
+    mag_i8_t* o,
     const mag_f32_t* x
 ) {
-    mag_f32_t min = INFINITY;
-    for (int64_t i=0; i < numel; ++i) {
-        min = fminf(min, x[i]);
+    int64_t i=0;
+    mag_f32_t amax = 0.0f;
+#if defined(__AVX512F__)
+    __m512 vmax = _mm512_setzero_ps();
+    for (; i+15 < numel; i += 16)
+        vmax = _mm512_max_ps(vmax, _mm512_abs_ps(_mm512_loadu_ps(x+i)));
+    amax = _mm512_reduce_max_ps(vmax);
+#elif defined(__AVX2__)
+    __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 vmax = _mm256_setzero_ps();
+    for (; i+7 < numel; i += 8)
+        vmax = _mm256_max_ps(vmax, _mm256_and_ps(mask, _mm256_loadu_ps(x+i)));
+    __m128 v = _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    amax = _mm_cvtss_f32(v);
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vmax = vdupq_n_f32(0.0f);
+    for (; i+3 < numel; i += 4)
+        vmax = vmaxq_f32(vmax, vabsq_f32(vld1q_f32(x+i)));
+    amax = vmaxvq_f32(vmax);
+#endif
+    for (; i < numel; ++i) amax = mag_xmax(amax, fabsf(x[i]));
+    mag_f32_t scale = amax/127.0f;
+    mag_f32_t inv = scale != 0.0f ? 1.0f/scale : 0.0f;
+    i = 0;
+#if defined(__AVX512F__)
+    __m512 vinv = _mm512_set1_ps(inv);
+    for (; i+15 < numel; i += 16) { /* Round to nearest even like lrintf, then narrow with saturation */
+        __m512i q = _mm512_cvtps_epi32(_mm512_mul_ps(_mm512_loadu_ps(x+i), vinv));
+        _mm_storeu_si128((__m128i*)(o+i), _mm512_cvtsepi32_epi8(q));
     }
-    return min;
+#elif defined(__AVX2__)
+    __m256 vinv = _mm256_set1_ps(inv);
+    __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i+31 < numel; i += 32) {
+        __m256i q0 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(x+i), vinv));
+        __m256i q1 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(x+i+8), vinv));
+        __m256i q2 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(x+i+16), vinv));
+        __m256i q3 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(x+i+24), vinv));
+        __m256i q = _mm256_packs_epi16(_mm256_packs_epi32(q0, q1), _mm256_packs_epi32(q2, q3)); /* Packs interleave 128-bit lanes */
+        _mm256_storeu_si256((__m256i*)(o+i), _mm256_permutevar8x32_epi32(q, perm));
+    }
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vinv = vdupq_n_f32(inv);
+    for (; i+7 < numel; i += 8) {
+        int32x4_t q0 = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(x+i), vinv));
+        int32x4_t q1 = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(x+i+4), vinv));
+        vst1_s8(o+i, vqmovn_s16(vcombine_s16(vqmovn_s32(q0), vqmovn_s32(q1))));
+    }
+#endif
+    for (; i < numel; ++i) o[i] = (mag_i8_t)lrintf(x[i]*inv);
+    return scale;
 }
 
-static mag_f32_t MAG_HOTPROC mag_vmax_f32( /* max x */
+static void MAG_HOTPROC mag_vdequantize_f32_i8( /* o = scale*x */
     int64_t numel,
-    const mag_f32_t* x
+    mag_f32_t* o,
+    const mag_i8_t* x,
+    mag_f32_t scale
 ) {
-    mag_f32_t min = -INFINITY;
-    for (int64_t i=0; i < numel; ++i) {
-        min = fmaxf(min, x[i]);
+    int64_t i=0;
+#if defined(__AVX512F__)
+    __m512 vs = _mm512_set1_ps(scale);
+    for (; i+15 < numel; i += 16)
+        _mm512_storeu_ps(o+i, _mm512_mul_ps(vs, _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(x+i))))));
+#elif defined(__AVX2__)
+    __m256 vs = _mm256_set1_ps(scale);
+    for (; i+7 < numel; i += 8)
+        _mm256_storeu_ps(o+i, _mm256_mul_ps(vs, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(x+i))))));
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vs = vdupq_n_f32(scale);
+    for (; i+7 < numel; i += 8) {
+        int16x8_t w = vmovl_s8(vld1_s8(x+i));
+        vst1q_f32(o+i, vmulq_f32(vs, vcvtq_f32_s32(vmovl_s16(vget_low_s16(w)))));
+        vst1q_f32(o+i+4, vmulq_f32(vs, vcvtq_f32_s32(vmovl_s16(vget_high_s16(w)))));
     }
-    return min;
+#endif
+    for (; i < numel; ++i) o[i] = scale*(mag_f32_t)x[i];
 }
 
-static void MAG_HOTPROC mag_vabs_f32( /* o = |x| */
+static MAG_AINLINE mag_bf16_t mag_bf16_from_f32(mag_f32_t x) { /* Round to nearest even, NaNs stay (quiet) NaNs. */
+    union { mag_f32_t f; uint32_t u; } b = {.f=x};
+    if ((b.u & 0x7fffffff) > 0x7f800000) return (mag_bf16_t)((b.u|0x400000)>>16);
+    return (mag_bf16_t)((b.u + 0x7fff + ((b.u>>16)&1))>>16);
+}
+
+static MAG_AINLINE mag_f32_t mag_bf16_to_f32(mag_bf16_t x) { /* Exact, BF16 is the upper half of a F32. */
+    union { uint32_t u; mag_f32_t f; } b = {.u=(uint32_t)x<<16};
+    return b.f;
+}
+
+static void MAG_HOTPROC mag_vcvt_bf16_f32( /* o = bf16(x) */
     int64_t numel,
-    mag_f32_t* o,
+    mag_bf16_t* o,
     const mag_f32_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = fabsf(x[i]);
+    int64_t i=0;
+#if defined(__AVX512BF16__)
+    for (; i+15 < numel; i += 16)
+        _mm256_storeu_si256((__m256i*)(o+i), (__m256i)_mm512_cvtneps_pbh(_mm512_loadu_ps(x+i)));
+#elif defined(__AVX512F__)
+    __m512i bias = _mm512_set1_epi32(0x7fff);
+    __m512i one = _mm512_set1_epi32(1);
+    __m512i qnan = _mm512_set1_epi32(0x400000);
+    for (; i+15 < numel; i += 16) {
+        __m512 v = _mm512_loadu_ps(x+i);
+        __m512i u = _mm512_castps_si512(v);
+        __m512i r = _mm512_add_epi32(u, _mm512_add_epi32(bias, _mm512_and_si512(_mm512_srli_epi32(u, 16), one)));
+        r = _mm512_mask_mov_epi32(r, _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q), _mm512_or_si512(u, qnan));
+        _mm256_storeu_si256((__m256i*)(o+i), _mm512_cvtepi32_epi16(_mm512_srli_epi32(r, 16)));
+    }
+#elif defined(__AVX2__)
+    __m256i bias = _mm256_set1_epi32(0x7fff);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i qnan = _mm256_set1_epi32(0x400000);
+    __m256i r[2];
+    for (; i+15 < numel; i += 16) {
+        for (int k=0; k < 2; ++k) {
+            __m256 v = _mm256_loadu_ps(x+i+(k<<3));
+            __m256i u = _mm256_castps_si256(v);
+            __m256i rk = _mm256_add_epi32(u, _mm256_add_epi32(bias, _mm256_and_si256(_mm256_srli_epi32(u, 16), one)));
+            rk = _mm256_blendv_epi8(rk, _mm256_or_si256(u, qnan), _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+            r[k] = _mm256_srli_epi32(rk, 16);
+        }
+        __m256i p = _mm256_packus_epi32(r[0], r[1]); /* Pack interleaves 128-bit lanes */
+        _mm256_storeu_si256((__m256i*)(o+i), _mm256_permute4x64_epi64(p, 0xd8));
+    }
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    uint32x4_t bias = vdupq_n_u32(0x7fff);
+    uint32x4_t one = vdupq_n_u32(1);
+    uint32x4_t qnan = vdupq_n_u32(0x400000);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t v = vld1q_f32(x+i);
+        uint32x4_t u = vreinterpretq_u32_f32(v);
+        uint32x4_t r = vaddq_u32(u, vaddq_u32(bias, vandq_u32(vshrq_n_u32(u, 16), one)));
+        r = vbslq_u32(vceqq_f32(v, v), r, vorrq_u32(u, qnan));
+        vst1_u16(o+i, vshrn_n_u32(r, 16));
     }
+#endif
+    for (; i < numel; ++i) o[i] = mag_bf16_from_f32(x[i]);
 }
 
-static void MAG_HOTPROC mag_vneg_f32( /* o = -x */
+static void MAG_HOTPROC mag_vcvt_f32_bf16( /* o = f32(x) */
     int64_t numel,
     mag_f32_t* o,
-    const mag_f32_t* x
+    const mag_bf16_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = -x[i];
+    int64_t i=0;
+#if defined(__AVX512F__)
+    for (; i+15 < numel; i += 16)
+        _mm512_storeu_si512(o+i, _mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(x+i))), 16));
+#elif defined(__AVX2__)
+    for (; i+7 < numel; i += 8)
+        _mm256_storeu_si256((__m256i*)(o+i), _mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(x+i))), 16));
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4)
+        vst1q_f32(o+i, vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(x+i), 16)));
+#endif
+    for (; i < numel; ++i) o[i] = mag_bf16_to_f32(x[i]);
+}
+
+#if defined(__AVX512BF16__)
+/*
+** Dot product of two BF16 vectors with VDPBF16PS, accumulated in F32.
+** Without it, BF16 operands are widened to F32 panels and multiplied by mag_sgemm_f32 instead, see mag_blas_matmul_f32.
+*/
+static mag_f32_t MAG_HOTPROC mag_vdot_bf16(
+    int64_t numel,
+    const mag_bf16_t* x,
+    const mag_bf16_t* y
+) {
+    int64_t i=0;
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    for (; i+63 < numel; i += 64) {
+        acc0 = _mm512_dpbf16_ps(acc0, (__m512bh)_mm512_loadu_si512(x+i), (__m512bh)_mm512_loadu_si512(y+i));
+        acc1 = _mm512_dpbf16_ps(acc1, (__m512bh)_mm512_loadu_si512(x+i+32), (__m512bh)_mm512_loadu_si512(y+i+32));
+    }
+    for (; i+31 < numel; i += 32)
+        acc0 = _mm512_dpbf16_ps(acc0, (__m512bh)_mm512_loadu_si512(x+i), (__m512bh)_mm512_loadu_si512(y+i));
+    mag_f32_t sum = _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+    for (; i < numel; ++i) sum += mag_bf16_to_f32(x[i])*mag_bf16_to_f32(y[i]); /* Process leftovers scalar-wise */
+    return sum;
+}
+#endif
+
+static MAG_AINLINE mag_f32_t mag_f16_to_f32(mag_f16_t x) { /* Exact */
+#ifdef __F16C__
+    return _cvtsh_ss(x);
+#else /* Shift exponent and mantissa into place and rescale in F32, which also normalizes subnormals. */
+    union { uint32_t u; mag_f32_t f; } b;
+    uint32_t w = (uint32_t)x<<16;
+    uint32_t sign = w & 0x80000000u;
+    uint32_t two_w = w+w;
+    if (two_w < 1u<<27) { /* Zero or subnormal */
+        b.u = (two_w>>17) | (126u<<23);
+        b.f -= 0.5f;
+    } else {
+        b.u = (two_w>>4) + (0xe0u<<23);
+        b.f *= 0x1.0p-112f;
     }
+    b.u |= sign;
+    return b.f;
+#endif
 }
 
-static void MAG_HOTPROC mag_vlog_f32( /* o = log x */
+static MAG_AINLINE mag_f16_t mag_f16_from_f32(mag_f32_t x) { /* Round to nearest even, overflows become ±Inf, NaNs stay NaNs. */
+#ifdef __F16C__
+    return _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC);
+#else /* Let the F32 adder do the rounding: scaling into the F16 exponent range leaves the rounded mantissa in the low bits. */
+    union { mag_f32_t f; uint32_t u; } b = {.f=x}, base = {.f=fabsf(x)*0x1.0p+112f*0x1.0p-110f};
+    uint32_t shl1_w = b.u+b.u;
+    uint32_t sign = b.u & 0x80000000u;
+    uint32_t bias = shl1_w & 0xff000000u;
+    if (bias < 0x71000000u) bias = 0x71000000u;
+    union { uint32_t u; mag_f32_t f; } rb = {.u=(bias>>1) + 0x07800000u};
+    base.f += rb.f;
+    uint32_t nonsign = ((base.u>>13) & 0x00007c00u) + (base.u & 0x00000fffu);
+    return (mag_f16_t)((sign>>16) | (shl1_w > 0xff000000u ? 0x7e00u : nonsign));
+#endif
+}
+
+static void MAG_HOTPROC mag_vcvt_f16_f32( /* o = f16(x) */
     int64_t numel,
-    mag_f32_t* o,
+    mag_f16_t* o,
     const mag_f32_t* x
 ) {
     int64_t i=0;
-#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
-    const float32x4_t one = vdupq_n_f32(1);
-    for (; i+3 < numel; i += 4) {
-        float32x4_t xi = vld1q_f32(x+i);
-        xi = vmaxq_f32(xi, vdupq_n_f32(0));
-        uint32x4_t invalid_mask = vcleq_f32(xi, vdupq_n_f32(0));
-        int32x4_t ux = vreinterpretq_s32_f32(xi);
-        int32x4_t emm0 = vshrq_n_s32(ux, 23);
-        ux = vandq_s32(ux, vdupq_n_s32(~0x7f800000u));
-        ux = vorrq_s32(ux, vreinterpretq_s32_f32(vdupq_n_f32(0.5f)));
-        xi = vreinterpretq_f32_s32(ux);
-        emm0 = vsubq_s32(emm0, vdupq_n_s32(0x7f));
-        float32x4_t e = vcvtq_f32_s32(emm0);
-        e = vaddq_f32(e, one);
-        uint32x4_t mask = vcltq_f32(xi, vdupq_n_f32(0.707106781186547524f));
-        float32x4_t tmp = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(xi), mask));
-        xi = vsubq_f32(xi, one);
-        e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(one), mask)));
-        xi = vaddq_f32(xi, tmp);
-        float32x4_t z = vmulq_f32(xi, xi);
-        float32x4_t y = vdupq_n_f32(7.0376836292e-2f);
-        y = vmlaq_f32(vdupq_n_f32(-1.1514610310e-1f), y, xi);
-        y = vmlaq_f32(vdupq_n_f32(1.1676998740e-1f), y, xi);
-        y = vmlaq_f32(vdupq_n_f32(-1.2420140846e-1f), y, xi);
-        y = vmlaq_f32(vdupq_n_f32(1.4249322787e-1f), y, xi);
-        y = vmlaq_f32(vdupq_n_f32(-1.6668057665e-1f), y, xi);
-        y = vmlaq_f32(vdupq_n_f32(2.0000714765e-1f), y, xi);
-        y = vmlaq_f32(vdupq_n_f32(-2.4999993993e-1f), y, xi);
-        y = vmlaq_f32(vdupq_n_f32(3.3333331174e-1f), y, xi);
-        y = vmulq_f32(y, xi);
-        y = vmulq_f32(y, z);
-        y = vmlaq_f32(y, e, vdupq_n_f32(-2.12194440e-4f));
-        y = vmlsq_f32(y, z, vdupq_n_f32(0.5f));
-        xi = vaddq_f32(xi, y);
-        xi = vmlaq_f32(xi, e, vdupq_n_f32(0.693359375f));
-        xi = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(xi), invalid_mask));
-        vst1q_f32(o+i, xi);
-    }
-#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
-/* TODO */
-#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
-/* TODO */
-#elif MAG_APPROXMATH && defined(__SSE2__)
-    const __m128 one = _mm_set1_ps(1.0f);
-    for (; i+3 < numel; i += 4) {
-        __m128 xi = _mm_loadu_ps(x+i);
-        xi = _mm_max_ps(xi, _mm_set1_ps(0.0f));
-        __m128 invalid_mask = _mm_cmple_ps(xi, _mm_set1_ps(0.0f));
-        __m128i ux = _mm_castps_si128(xi);
-        __m128i emm0 = _mm_srli_epi32(ux, 23);
-        ux = _mm_and_si128(ux, _mm_set1_epi32(~0x7f800000u));
-        ux = _mm_or_si128(ux, _mm_castps_si128(_mm_set1_ps(0.5f)));
-        xi = _mm_castsi128_ps(ux);
-        emm0 = _mm_sub_epi32(emm0, _mm_set1_epi32(0x7f));
-        __m128 e = _mm_cvtepi32_ps(emm0);
-        e = _mm_add_ps(e, one);
-        __m128 mask = _mm_cmplt_ps(xi, _mm_set1_ps(0.707106781186547524f));
-        __m128 tmp = _mm_and_ps(xi, mask);
-        xi = _mm_sub_ps(xi, one);
-        e = _mm_sub_ps(e, _mm_and_ps(one, mask));
-        xi = _mm_add_ps(xi, tmp);
-        __m128 z = _mm_mul_ps(xi, xi);
-        __m128 y = _mm_set1_ps(7.0376836292e-2f);
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-1.1514610310e-1f));
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(1.1676998740e-1f));
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-1.2420140846e-1f));
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(1.4249322787e-1f));
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-1.6668057665e-1f));
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(2.0000714765e-1f));
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-2.4999993993e-1f));
-        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(3.3333331174e-1f));
-        y = _mm_mul_ps(y, xi);
-        y = _mm_mul_ps(y, z);
-        y = _mm_add_ps(_mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)), y);
-        y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
-        xi = _mm_add_ps(xi, y);
-        xi = _mm_add_ps(_mm_mul_ps(e, _mm_set1_ps(0.693359375f)), xi);
-        xi = _mm_or_ps(xi, invalid_mask);
-        _mm_storeu_ps(o+i, xi);
-    }
+#if defined(__AVX512F__)
+    for (; i+15 < numel; i += 16)
+        _mm256_storeu_si256((__m256i*)(o+i), _mm512_cvtps_ph(_mm512_loadu_ps(x+i), _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC));
+#elif defined(__F16C__)
+    for (; i+7 < numel; i += 8)
+        _mm_storeu_si128((__m128i*)(o+i), _mm256_cvtps_ph(_mm256_loadu_ps(x+i), _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC));
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4)
+        vst1_u16(o+i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(x+i))));
 #endif
-    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
-        o[i] = logf(x[i]);
-    }
+    for (; i < numel; ++i) o[i] = mag_f16_from_f32(x[i]);
 }
 
-static void MAG_HOTPROC mag_vsqr_f32( /* o = x² */
+static void MAG_HOTPROC mag_vcvt_f32_f16( /* o = f32(x) */
     int64_t numel,
     mag_f32_t* o,
-    const mag_f32_t* x
+    const mag_f16_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i)
-        o[i] = x[i]*x[i];
+    int64_t i=0;
+#if defined(__AVX512F__)
+    for (; i+15 < numel; i += 16)
+        _mm512_storeu_ps(o+i, _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)(x+i))));
+#elif defined(__F16C__)
+    for (; i+7 < numel; i += 8)
+        _mm256_storeu_ps(o+i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(x+i))));
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4)
+        vst1q_f32(o+i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(x+i))));
+#endif
+    for (; i < numel; ++i) o[i] = mag_f16_to_f32(x[i]);
 }
 
-static void MAG_HOTPROC mag_vsqrt_f32( /* o = √x */
-    int64_t numel,
-    mag_f32_t* o,
+#define mag_qb_block(p, type, b) ((const void*)((const uint8_t*)(p) + (b)*mag_dtype_meta_of(type)->size)) /* Block b of a MAG_DTYPE_Q8 or MAG_DTYPE_Q4 buffer */
+
+/* Quantizes nb blocks of MAG_QK elements to Q8 or Q4. The scale is rounded to F16 first, so the weights are quantized against the stored scale. */
+static void MAG_HOTPROC mag_vquantize_qb_f32(
+    int64_t nb,
+    void* o,
+    mag_dtype_t type,
     const mag_f32_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = sqrtf(x[i]);
+    for (int64_t b=0; b < nb; ++b, x += MAG_QK) {
+        mag_f32_t amax = 0.0f;
+        for (int64_t i=0; i < MAG_QK; ++i) amax = mag_xmax(amax, fabsf(x[i]));
+        if (type == MAG_DTYPE_Q8) {
+            mag_block_q8_t* blk = (mag_block_q8_t*)o + b;
+            blk->d = mag_f16_from_f32(amax/127.0f);
+            mag_f32_t d = mag_f16_to_f32(blk->d);
+            mag_f32_t inv = d != 0.0f ? 1.0f/d : 0.0f;
+            for (int64_t i=0; i < MAG_QK; ++i) { /* Offset into the positive range, so truncation rounds to nearest */
+                int32_t q = (int32_t)(x[i]*inv + 127.5f) - 127;
+                blk->qs[i] = (int8_t)mag_xmax(-127, mag_xmin(127, q));
+            }
+        } else {
+            mag_block_q4_t* blk = (mag_block_q4_t*)o + b;
+            blk->d = mag_f16_from_f32(amax/7.0f);
+            mag_f32_t d = mag_f16_to_f32(blk->d);
+            mag_f32_t inv = d != 0.0f ? 1.0f/d : 0.0f;
+            for (int64_t i=0; i < MAG_QK/2; ++i) {
+                int32_t q0 = mag_xmax(0, mag_xmin(15, (int32_t)(x[i]*inv + 8.5f)));
+                int32_t q1 = mag_xmax(0, mag_xmin(15, (int32_t)(x[i + MAG_QK/2]*inv + 8.5f)));
+                blk->qs[i] = (uint8_t)(q0 | (q1<<4));
+            }
+        }
     }
 }
 
-static void MAG_HOTPROC mag_vsin_f32( /* o = sin x */
-    int64_t numel,
+static void MAG_HOTPROC mag_vdequantize_f32_qb( /* o = d*q */
+    int64_t nb,
     mag_f32_t* o,
-    const mag_f32_t* x
+    const void* x,
+    mag_dtype_t type
 ) {
-       int64_t i=0;
-#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
-    for (; i+3 < numel; i += 4) {
-        float32x4_t xi = vld1q_f32(x+i);
-        float32x4_t ocos;
-        mag_simd_sincos(xi, &xi, &ocos);
-        vst1q_f32(o+i, xi);
-    }
-#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
-    /* TODO */
-#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
-    /* TODO */
-#elif MAG_APPROXMATH && defined(__SSE2__)
-    for (; i+3 < numel; i += 4) {
-        __m128 xi = _mm_loadu_ps(x+i);
-        __m128 ocos;
-        mag_simd_sincos(xi, &xi, &ocos);
-        _mm_storeu_ps(o+i, xi);
-    }
+    for (int64_t b=0; b < nb; ++b, o += MAG_QK) {
+        if (type == MAG_DTYPE_Q8) {
+            const mag_block_q8_t* blk = (const mag_block_q8_t*)x + b;
+            mag_vdequantize_f32_i8(MAG_QK, o, blk->qs, mag_f16_to_f32(blk->d));
+        } else { /* Unpack the nibbles to int8 first */
+            const mag_block_q4_t* blk = (const mag_block_q4_t*)x + b;
+            mag_i8_t q[MAG_QK];
+#if defined(__SSE2__)
+            __m128i v = _mm_loadu_si128((const __m128i*)blk->qs);
+            __m128i m4 = _mm_set1_epi8(15);
+            __m128i o8 = _mm_set1_epi8(8);
+            _mm_storeu_si128((__m128i*)q, _mm_sub_epi8(_mm_and_si128(v, m4), o8));
+            _mm_storeu_si128((__m128i*)(q + MAG_QK/2), _mm_sub_epi8(_mm_and_si128(_mm_srli_epi16(v, 4), m4), o8));
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+            uint8x16_t v = vld1q_u8(blk->qs);
+            vst1q_s8(q, vsubq_s8(vreinterpretq_s8_u8(vandq_u8(v, vdupq_n_u8(15))), vdupq_n_s8(8)));
+            vst1q_s8(q + MAG_QK/2, vsubq_s8(vreinterpretq_s8_u8(vshrq_n_u8(v, 4)), vdupq_n_s8(8)));
+#else
+            for (int64_t i=0; i < MAG_QK/2; ++i) {
+                q[i] = (mag_i8_t)((blk->qs[i] & 15) - 8);
+                q[i + MAG_QK/2] = (mag_i8_t)((blk->qs[i] >> 4) - 8);
+            }
 #endif
-    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
-        o[i] = sinf(x[i]);
+            mag_vdequantize_f32_i8(MAG_QK, o, q, mag_f16_to_f32(blk->d));
+        }
     }
 }
 
-static void MAG_HOTPROC mag_vcos_f32( /* o = cos x */
-    int64_t numel,
-    mag_f32_t* o,
-    const mag_f32_t* x
+/*
+** Dot products o[j] = a · x_j for j < nx <= 4 of a row a of nb Q8 or Q4 blocks with the F32 vectors x_j = x + j*ldx.
+** Each block is widened and scaled in registers once and multiplied with all nx vectors, so the weights never pass through memory as F32.
+*/
+static void MAG_HOTPROC mag_vdot4_qb_f32(
+    int64_t nb,
+    const void* a,
+    mag_dtype_t type,
+    const mag_f32_t* x,
+    int64_t ldx,
+    int64_t nx,
+    mag_f32_t* o
 ) {
-    int64_t i=0;
-#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
-    for (; i+3 < numel; i += 4) {
-        float32x4_t xi = vld1q_f32(x+i);
-        float32x4_t osin;
-        mag_simd_sincos(xi, &osin, &xi);
-        vst1q_f32(o+i, xi);
+    const mag_f32_t* x0 = x; /* Missing vectors alias x_0, their sums are dropped */
+    const mag_f32_t* x1 = nx > 1 ? x + ldx : x;
+    const mag_f32_t* x2 = nx > 2 ? x + 2*ldx : x;
+    const mag_f32_t* x3 = nx > 3 ? x + 3*ldx : x;
+    mag_f32_t sum[4];
+    bool q8 = type == MAG_DTYPE_Q8;
+#if defined(__AVX512F__) && defined(__FMA__)
+    __m512 acc[4] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+    __m128i m4 = _mm_set1_epi8(15);
+    for (int64_t b=0; b < nb; ++b) {
+        __m512 w[2];
+        if (q8) {
+            const mag_block_q8_t* blk = (const mag_block_q8_t*)a + b;
+            __m512 d = _mm512_set1_ps(mag_f16_to_f32(blk->d));
+            w[0] = _mm512_mul_ps(d, _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)blk->qs))));
+            w[1] = _mm512_mul_ps(d, _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(blk->qs+16)))));
+        } else { /* w = d*q - 8d */
+            const mag_block_q4_t* blk = (const mag_block_q4_t*)a + b;
+            mag_f32_t df = mag_f16_to_f32(blk->d);
+            __m512 d = _mm512_set1_ps(df);
+            __m512 o8 = _mm512_set1_ps(-8.0f*df);
+            __m128i v = _mm_loadu_si128((const __m128i*)blk->qs);
+            w[0] = _mm512_fmadd_ps(d, _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_and_si128(v, m4))), o8);
+            w[1] = _mm512_fmadd_ps(d, _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_and_si128(_mm_srli_epi16(v, 4), m4))), o8);
+        }
+        int64_t k = b*MAG_QK;
+        for (int64_t h=0; h < 2; ++h, k += 16) {
+            acc[0] = _mm512_fmadd_ps(w[h], _mm512_loadu_ps(x0+k), acc[0]);
+            if (nx == 1) continue; /* GEMV */
+            acc[1] = _mm512_fmadd_ps(w[h], _mm512_loadu_ps(x1+k), acc[1]);
+            acc[2] = _mm512_fmadd_ps(w[h], _mm512_loadu_ps(x2+k), acc[2]);
+            acc[3] = _mm512_fmadd_ps(w[h], _mm512_loadu_ps(x3+k), acc[3]);
+        }
     }
-#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
-    /* TODO */
-#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
-    /* TODO */
-#elif MAG_APPROXMATH && defined(__SSE2__)
-    for (; i+3 < numel; i += 4) {
-        __m128 xi = _mm_loadu_ps(x+i);
-        __m128 osin;
-        mag_simd_sincos(xi, &osin, &xi);
-        _mm_storeu_ps(o+i, xi);
+    for (int64_t j=0; j < 4; ++j) sum[j] = _mm512_reduce_add_ps(acc[j]);
+#elif defined(__AVX2__) && defined(__FMA__)
+    __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+    __m128i m4 = _mm_set1_epi8(15);
+    for (int64_t b=0; b < nb; ++b) {
+        __m256 w[4];
+        if (q8) {
+            const mag_block_q8_t* blk = (const mag_block_q8_t*)a + b;
+            __m256 d = _mm256_set1_ps(mag_f16_to_f32(blk->d));
+            for (int64_t h=0; h < 4; ++h)
+                w[h] = _mm256_mul_ps(d, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(blk->qs + 8*h)))));
+        } else {
+            const mag_block_q4_t* blk = (const mag_block_q4_t*)a + b;
+            mag_f32_t df = mag_f16_to_f32(blk->d);
+            __m256 d = _mm256_set1_ps(df);
+            __m256 o8 = _mm256_set1_ps(-8.0f*df);
+            __m128i v = _mm_loadu_si128((const __m128i*)blk->qs);
+            __m128i lo = _mm_and_si128(v, m4);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), m4);
+            w[0] = _mm256_fmadd_ps(d, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(lo)), o8);
+            w[1] = _mm256_fmadd_ps(d, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8))), o8);
+            w[2] = _mm256_fmadd_ps(d, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(hi)), o8);
+            w[3] = _mm256_fmadd_ps(d, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8))), o8);
+        }
+        int64_t k = b*MAG_QK;
+        for (int64_t h=0; h < 4; ++h, k += 8) {
+            acc[0] = _mm256_fmadd_ps(w[h], _mm256_loadu_ps(x0+k), acc[0]);
+            if (nx == 1) continue; /* GEMV */
+            acc[1] = _mm256_fmadd_ps(w[h], _mm256_loadu_ps(x1+k), acc[1]);
+            acc[2] = _mm256_fmadd_ps(w[h], _mm256_loadu_ps(x2+k), acc[2]);
+            acc[3] = _mm256_fmadd_ps(w[h], _mm256_loadu_ps(x3+k), acc[3]);
+        }
     }
-#endif
-    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
-        o[i] = cosf(x[i]);
+    for (int64_t j=0; j < 4; ++j) {
+        __m128 v = _mm_add_ps(_mm256_castps256_ps128(acc[j]), _mm256_extractf128_ps(acc[j], 1));
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+        sum[j] = _mm_cvtss_f32(v);
+    }
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t acc[4] = {vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f)};
+    for (int64_t b=0; b < nb; ++b) {
+        int8x16_t q[2];
+        mag_f32_t df;
+        if (q8) {
+            const mag_block_q8_t* blk = (const mag_block_q8_t*)a + b;
+            df = mag_f16_to_f32(blk->d);
+            q[0] = vld1q_s8(blk->qs);
+            q[1] = vld1q_s8(blk->qs+16);
+        } else { /* Nibbles are in [0, 15], so the offset is removed in int8 */
+            const mag_block_q4_t* blk = (const mag_block_q4_t*)a + b;
+            df = mag_f16_to_f32(blk->d);
+            uint8x16_t v = vld1q_u8(blk->qs);
+            q[0] = vsubq_s8(vreinterpretq_s8_u8(vandq_u8(v, vdupq_n_u8(15))), vdupq_n_s8(8));
+            q[1] = vsubq_s8(vreinterpretq_s8_u8(vshrq_n_u8(v, 4)), vdupq_n_s8(8));
+        }
+        int64_t k = b*MAG_QK;
+        for (int64_t h=0; h < 2; ++h) {
+            int16x8_t q16[2] = {vmovl_s8(vget_low_s8(q[h])), vmovl_high_s8(q[h])};
+            for (int64_t e=0; e < 4; ++e, k += 4) {
+                int16x4_t q4 = e & 1 ? vget_high_s16(q16[e>>1]) : vget_low_s16(q16[e>>1]);
+                float32x4_t w = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(q4)), df);
+                acc[0] = vfmaq_f32(acc[0], w, vld1q_f32(x0+k));
+                if (nx == 1) continue; /* GEMV */
+                acc[1] = vfmaq_f32(acc[1], w, vld1q_f32(x1+k));
+                acc[2] = vfmaq_f32(acc[2], w, vld1q_f32(x2+k));
+                acc[3] = vfmaq_f32(acc[3], w, vld1q_f32(x3+k));
+            }
+        }
+    }
+    for (int64_t j=0; j < 4; ++j) sum[j] = vaddvq_f32(acc[j]);
+#else
+    (void)q8;
+    sum[0] = sum[1] = sum[2] = sum[3] = 0.0f;
+    for (int64_t b=0; b < nb; ++b) {
+        mag_f32_t w[MAG_QK];
+        mag_vdequantize_f32_qb(1, w, mag_qb_block(a, type, b), type);
+        int64_t k = b*MAG_QK;
+        for (int64_t i=0; i < MAG_QK; ++i) {
+            sum[0] += w[i]*x0[k+i];
+            sum[1] += w[i]*x1[k+i];
+            sum[2] += w[i]*x2[k+i];
+            sum[3] += w[i]*x3[k+i];
+        }
     }
+#endif
+    for (int64_t j=0; j < nx; ++j) o[j] = sum[j];
 }
 
-static void MAG_HOTPROC mag_vstep_f32( /* Heaviside step function. */
+/*
+** Σx, widened to F64 before accumulating so long rows keep their precision. Four independent accumulators hide the add latency.
+** The Accelerate path sums in F32.
+*/
+static mag_f64_t MAG_HOTPROC mag_vsum_f64_f32(
     int64_t numel,
-    mag_f32_t* o,
     const mag_f32_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = x[i] >= 0.0f ? 1.0f : 0.0f;
+#ifdef MAG_ACCELERATE
+    mag_f32_t sum;
+    vDSP_sve(x, 1, &sum, numel);
+    return (mag_f64_t)sum;
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    int64_t k = numel & -8;
+    float64x2_t acc[4] = {vdupq_n_f64(0), vdupq_n_f64(0), vdupq_n_f64(0), vdupq_n_f64(0)};
+    for (int64_t i=0; i < k; i += 8) {
+        float32x4_t v0 = vld1q_f32(x+i);
+        float32x4_t v1 = vld1q_f32(x+i+4);
+        acc[0] = vaddq_f64(acc[0], vcvt_f64_f32(vget_low_f32(v0)));
+        acc[1] = vaddq_f64(acc[1], vcvt_high_f64_f32(v0));
+        acc[2] = vaddq_f64(acc[2], vcvt_f64_f32(vget_low_f32(v1)));
+        acc[3] = vaddq_f64(acc[3], vcvt_high_f64_f32(v1));
+    }
+    acc[1] = vaddq_f64(acc[1], acc[3]);
+    *acc = vaddq_f64(*acc, acc[2]);
+    *acc = vaddq_f64(*acc, acc[1]);
+    mag_f64_t sum = vaddvq_f64(*acc);
+#elif defined(__AVX512F__)
+    int64_t k = numel & -32;
+    __m512d acc[4] = {_mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd()};
+    for (int64_t i=0; i < k; i += 32) {
+        acc[0] = _mm512_add_pd(acc[0], _mm512_cvtps_pd(_mm256_loadu_ps(x+i+(0<<3))));
+        acc[1] = _mm512_add_pd(acc[1], _mm512_cvtps_pd(_mm256_loadu_ps(x+i+(1<<3))));
+        acc[2] = _mm512_add_pd(acc[2], _mm512_cvtps_pd(_mm256_loadu_ps(x+i+(2<<3))));
+        acc[3] = _mm512_add_pd(acc[3], _mm512_cvtps_pd(_mm256_loadu_ps(x+i+(3<<3))));
+    }
+    acc[1] = _mm512_add_pd(acc[1], acc[3]);
+    *acc = _mm512_add_pd(*acc, acc[2]);
+    *acc = _mm512_add_pd(*acc, acc[1]);
+    mag_f64_t sum = _mm512_reduce_add_pd(*acc);
+#elif defined(__AVX__)
+    int64_t k = numel & -16;
+    __m256d acc[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+    for (int64_t i=0; i < k; i += 16) {
+        acc[0] = _mm256_add_pd(acc[0], _mm256_cvtps_pd(_mm_loadu_ps(x+i+(0<<2))));
+        acc[1] = _mm256_add_pd(acc[1], _mm256_cvtps_pd(_mm_loadu_ps(x+i+(1<<2))));
+        acc[2] = _mm256_add_pd(acc[2], _mm256_cvtps_pd(_mm_loadu_ps(x+i+(2<<2))));
+        acc[3] = _mm256_add_pd(acc[3], _mm256_cvtps_pd(_mm_loadu_ps(x+i+(3<<2))));
+    }
+    acc[1] = _mm256_add_pd(acc[1], acc[3]);
+    *acc = _mm256_add_pd(*acc, acc[2]);
+    *acc = _mm256_add_pd(*acc, acc[1]);
+    __m128d v0 = _mm_add_pd(_mm256_castpd256_pd128(*acc), _mm256_extractf128_pd(*acc, 1));
+    v0 = _mm_add_sd(v0, _mm_unpackhi_pd(v0, v0));
+    mag_f64_t sum = _mm_cvtsd_f64(v0);
+#elif defined(__SSE2__)
+    int64_t k = numel & -8;
+    __m128d acc[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+    for (int64_t i=0; i < k; i += 8) {
+        __m128 v0 = _mm_loadu_ps(x+i);
+        __m128 v1 = _mm_loadu_ps(x+i+4);
+        acc[0] = _mm_add_pd(acc[0], _mm_cvtps_pd(v0));
+        acc[1] = _mm_add_pd(acc[1], _mm_cvtps_pd(_mm_movehl_ps(v0, v0)));
+        acc[2] = _mm_add_pd(acc[2], _mm_cvtps_pd(v1));
+        acc[3] = _mm_add_pd(acc[3], _mm_cvtps_pd(_mm_movehl_ps(v1, v1)));
     }
+    acc[1] = _mm_add_pd(acc[1], acc[3]);
+    *acc = _mm_add_pd(*acc, acc[2]);
+    *acc = _mm_add_pd(*acc, acc[1]);
+    *acc = _mm_add_sd(*acc, _mm_unpackhi_pd(*acc, *acc));
+    mag_f64_t sum = _mm_cvtsd_f64(*acc);
+#else
+    int64_t k = 0;
+    mag_f64_t sum = 0.0;
+#endif
+#ifndef MAG_ACCELERATE
+    for (int64_t i=k; i < numel; ++i) sum += (mag_f64_t)x[i]; /* Process leftovers scalar-wise */
+    return sum;
+#endif
 }
 
-static void MAG_HOTPROC mag_vsoftmax_f32( /* softmax : ℝ -> (0, ∞), x |-> e^x */
+/*
+** min x and max x. NaNs are ignored like in fminf and fmaxf, an empty or all-NaN x yields +inf or -inf.
+** The x86 min/max instructions return their second operand if either is NaN, so with the accumulator second a NaN in x never replaces it.
+** NEON has IEEE minNum/maxNum (vminnmq_f32/vmaxnmq_f32) which ignore NaNs directly.
+*/
+static mag_f32_t MAG_HOTPROC mag_vmin_f32(
     int64_t numel,
-    mag_f32_t* o,
     const mag_f32_t* x
 ) {
-    int64_t i=0;
-#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
-    for (; i+3 < numel; i += 4) {
-        vst1q_f32(o+i, mag_simd_expf(vld1q_f32(x+i)));
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    int64_t k = numel & -16;
+    float32x4_t acc[4] = {vdupq_n_f32(INFINITY), vdupq_n_f32(INFINITY), vdupq_n_f32(INFINITY), vdupq_n_f32(INFINITY)};
+    for (int64_t i=0; i < k; i += 16) {
+        acc[0] = vminnmq_f32(acc[0], vld1q_f32(x+i+(0<<2)));
+        acc[1] = vminnmq_f32(acc[1], vld1q_f32(x+i+(1<<2)));
+        acc[2] = vminnmq_f32(acc[2], vld1q_f32(x+i+(2<<2)));
+        acc[3] = vminnmq_f32(acc[3], vld1q_f32(x+i+(3<<2)));
     }
-#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
-    for (; i+15 < numel; i += 16) {
-        _mm512_storeu_ps(o+i, mag_simd_expf(_mm512_loadu_ps(x+i)));
+    acc[1] = vminnmq_f32(acc[1], acc[3]);
+    *acc = vminnmq_f32(*acc, acc[2]);
+    *acc = vminnmq_f32(*acc, acc[1]);
+    mag_f32_t min = vminnmvq_f32(*acc);
+#elif defined(__AVX512F__)
+    int64_t k = numel & -64;
+    __m512 acc[4] = {_mm512_set1_ps(INFINITY), _mm512_set1_ps(INFINITY), _mm512_set1_ps(INFINITY), _mm512_set1_ps(INFINITY)};
+    for (int64_t i=0; i < k; i += 64) {
+        acc[0] = _mm512_min_ps(_mm512_loadu_ps(x+i+(0<<4)), acc[0]);
+        acc[1] = _mm512_min_ps(_mm512_loadu_ps(x+i+(1<<4)), acc[1]);
+        acc[2] = _mm512_min_ps(_mm512_loadu_ps(x+i+(2<<4)), acc[2]);
+        acc[3] = _mm512_min_ps(_mm512_loadu_ps(x+i+(3<<4)), acc[3]);
     }
-#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
-    for (; i+7 < numel; i += 8) {
-        _mm256_storeu_ps(o+i, mag_simd_expf(_mm256_loadu_ps(x+i)));
+    acc[1] = _mm512_min_ps(acc[1], acc[3]);
+    *acc = _mm512_min_ps(*acc, acc[2]);
+    *acc = _mm512_min_ps(*acc, acc[1]);
+    mag_f32_t min = _mm512_reduce_min_ps(*acc);
+#elif defined(__AVX__)
+    int64_t k = numel & -32;
+    __m256 acc[4] = {_mm256_set1_ps(INFINITY), _mm256_set1_ps(INFINITY), _mm256_set1_ps(INFINITY), _mm256_set1_ps(INFINITY)};
+    for (int64_t i=0; i < k; i += 32) {
+        acc[0] = _mm256_min_ps(_mm256_loadu_ps(x+i+(0<<3)), acc[0]);
+        acc[1] = _mm256_min_ps(_mm256_loadu_ps(x+i+(1<<3)), acc[1]);
+        acc[2] = _mm256_min_ps(_mm256_loadu_ps(x+i+(2<<3)), acc[2]);
+        acc[3] = _mm256_min_ps(_mm256_loadu_ps(x+i+(3<<3)), acc[3]);
     }
-#elif MAG_APPROXMATH && defined(__SSE2__)
-    for (; i+3 < numel; i += 4) {
-        _mm_storeu_ps(o+i, mag_simd_expf(_mm_loadu_ps(x+i)));
+    acc[1] = _mm256_min_ps(acc[1], acc[3]);
+    *acc = _mm256_min_ps(*acc, acc[2]);
+    *acc = _mm256_min_ps(*acc, acc[1]);
+    __m128 v0 = _mm_min_ps(_mm256_castps256_ps128(*acc), _mm256_extractf128_ps(*acc, 1));
+    v0 = _mm_min_ps(v0, _mm_movehl_ps(v0, v0));
+    v0 = _mm_min_ss(v0, _mm_shuffle_ps(v0, v0, _MM_SHUFFLE(1, 1, 1, 1)));
+    mag_f32_t min = _mm_cvtss_f32(v0);
+#elif defined(__SSE2__)
+    int64_t k = numel & -16;
+    __m128 acc[4] = {_mm_set1_ps(INFINITY), _mm_set1_ps(INFINITY), _mm_set1_ps(INFINITY), _mm_set1_ps(INFINITY)};
+    for (int64_t i=0; i < k; i += 16) {
+        acc[0] = _mm_min_ps(_mm_loadu_ps(x+i+(0<<2)), acc[0]);
+        acc[1] = _mm_min_ps(_mm_loadu_ps(x+i+(1<<2)), acc[1]);
+        acc[2] = _mm_min_ps(_mm_loadu_ps(x+i+(2<<2)), acc[2]);
+        acc[3] = _mm_min_ps(_mm_loadu_ps(x+i+(3<<2)), acc[3]);
     }
+    acc[1] = _mm_min_ps(acc[1], acc[3]);
+    *acc = _mm_min_ps(*acc, acc[2]);
+    *acc = _mm_min_ps(*acc, acc[1]);
+    *acc = _mm_min_ps(*acc, _mm_movehl_ps(*acc, *acc));
+    *acc = _mm_min_ss(*acc, _mm_shuffle_ps(*acc, *acc, _MM_SHUFFLE(1, 1, 1, 1)));
+    mag_f32_t min = _mm_cvtss_f32(*acc);
+#else
+    int64_t k = 0;
+    mag_f32_t min = INFINITY;
 #endif
-    for (; i < numel; ++i) o[i] = expf(x[i]); /* Process leftovers scalar-wise */
+    for (int64_t i=k; i < numel; ++i) min = fminf(min, x[i]); /* Process leftovers scalar-wise */
+    return min;
 }
 
-static void MAG_HOTPROC mag_vsoftmax_dv_f32( /* softmax' = softmax : ℝ -> (0, ∞), x |-> e^x */
+static mag_f32_t MAG_HOTPROC mag_vmax_f32(
     int64_t numel,
-    mag_f32_t* o,
     const mag_f32_t* x
 ) {
-    mag_vsoftmax_f32(numel, o, x);
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    int64_t k = numel & -16;
+    float32x4_t acc[4] = {vdupq_n_f32(-INFINITY), vdupq_n_f32(-INFINITY), vdupq_n_f32(-INFINITY), vdupq_n_f32(-INFINITY)};
+    for (int64_t i=0; i < k; i += 16) {
+        acc[0] = vmaxnmq_f32(acc[0], vld1q_f32(x+i+(0<<2)));
+        acc[1] = vmaxnmq_f32(acc[1], vld1q_f32(x+i+(1<<2)));
+        acc[2] = vmaxnmq_f32(acc[2], vld1q_f32(x+i+(2<<2)));
+        acc[3] = vmaxnmq_f32(acc[3], vld1q_f32(x+i+(3<<2)));
+    }
+    acc[1] = vmaxnmq_f32(acc[1], acc[3]);
+    *acc = vmaxnmq_f32(*acc, acc[2]);
+    *acc = vmaxnmq_f32(*acc, acc[1]);
+    mag_f32_t max = vmaxnmvq_f32(*acc);
+#elif defined(__AVX512F__)
+    int64_t k = numel & -64;
+    __m512 acc[4] = {_mm512_set1_ps(-INFINITY), _mm512_set1_ps(-INFINITY), _mm512_set1_ps(-INFINITY), _mm512_set1_ps(-INFINITY)};
+    for (int64_t i=0; i < k; i += 64) {
+        acc[0] = _mm512_max_ps(_mm512_loadu_ps(x+i+(0<<4)), acc[0]);
+        acc[1] = _mm512_max_ps(_mm512_loadu_ps(x+i+(1<<4)), acc[1]);
+        acc[2] = _mm512_max_ps(_mm512_loadu_ps(x+i+(2<<4)), acc[2]);
+        acc[3] = _mm512_max_ps(_mm512_loadu_ps(x+i+(3<<4)), acc[3]);
+    }
+    acc[1] = _mm512_max_ps(acc[1], acc[3]);
+    *acc = _mm512_max_ps(*acc, acc[2]);
+    *acc = _mm512_max_ps(*acc, acc[1]);
+    mag_f32_t max = _mm512_reduce_max_ps(*acc);
+#elif defined(__AVX__)
+    int64_t k = numel & -32;
+    __m256 acc[4] = {_mm256_set1_ps(-INFINITY), _mm256_set1_ps(-INFINITY), _mm256_set1_ps(-INFINITY), _mm256_set1_ps(-INFINITY)};
+    for (int64_t i=0; i < k; i += 32) {
+        acc[0] = _mm256_max_ps(_mm256_loadu_ps(x+i+(0<<3)), acc[0]);
+        acc[1] = _mm256_max_ps(_mm256_loadu_ps(x+i+(1<<3)), acc[1]);
+        acc[2] = _mm256_max_ps(_mm256_loadu_ps(x+i+(2<<3)), acc[2]);
+        acc[3] = _mm256_max_ps(_mm256_loadu_ps(x+i+(3<<3)), acc[3]);
+    }
+    acc[1] = _mm256_max_ps(acc[1], acc[3]);
+    *acc = _mm256_max_ps(*acc, acc[2]);
+    *acc = _mm256_max_ps(*acc, acc[1]);
+    __m128 v0 = _mm_max_ps(_mm256_castps256_ps128(*acc), _mm256_extractf128_ps(*acc, 1));
+    v0 = _mm_max_ps(v0, _mm_movehl_ps(v0, v0));
+    v0 = _mm_max_ss(v0, _mm_shuffle_ps(v0, v0, _MM_SHUFFLE(1, 1, 1, 1)));
+    mag_f32_t max = _mm_cvtss_f32(v0);
+#elif defined(__SSE2__)
+    int64_t k = numel & -16;
+    __m128 acc[4] = {_mm_set1_ps(-INFINITY), _mm_set1_ps(-INFINITY), _mm_set1_ps(-INFINITY), _mm_set1_ps(-INFINITY)};
+    for (int64_t i=0; i < k; i += 16) {
+        acc[0] = _mm_max_ps(_mm_loadu_ps(x+i+(0<<2)), acc[0]);
+        acc[1] = _mm_max_ps(_mm_loadu_ps(x+i+(1<<2)), acc[1]);
+        acc[2] = _mm_max_ps(_mm_loadu_ps(x+i+(2<<2)), acc[2]);
+        acc[3] = _mm_max_ps(_mm_loadu_ps(x+i+(3<<2)), acc[3]);
+    }
+    acc[1] = _mm_max_ps(acc[1], acc[3]);
+    *acc = _mm_max_ps(*acc, acc[2]);
+    *acc = _mm_max_ps(*acc, acc[1]);
+    *acc = _mm_max_ps(*acc, _mm_movehl_ps(*acc, *acc));
+    *acc = _mm_max_ss(*acc, _mm_shuffle_ps(*acc, *acc, _MM_SHUFFLE(1, 1, 1, 1)));
+    mag_f32_t max = _mm_cvtss_f32(*acc);
+#else
+    int64_t k = 0;
+    mag_f32_t max = -INFINITY;
+#endif
+    for (int64_t i=k; i < numel; ++i) max = fmaxf(max, x[i]); /* Process leftovers scalar-wise */
+    return max;
 }
 
-static void MAG_HOTPROC mag_vsigmoid_f32( /* σ : ℝ -> (0, 1), x |-> 1/(1 + e^(-x)) */
+static void MAG_HOTPROC mag_vabs_f32( /* o = |x| */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
     int64_t i=0;
-#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
-    const float32x4_t one = vdupq_n_f32(1.0f);
-    const float32x4_t zero = vdupq_n_f32(0.0f);
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
     for (; i+3 < numel; i += 4) {
-        float32x4_t xx = vld1q_f32(x+i);
-        float32x4_t neg_x = vsubq_f32(zero, xx);
-        float32x4_t exp_neg_x = mag_simd_expf(neg_x);
-        float32x4_t one_plus_exp_neg_x = vaddq_f32(one, exp_neg_x);
-        vst1q_f32(o+i, vdivq_f32(one, one_plus_exp_neg_x));
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vabsq_f32(xi));
     }
-#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
-    __m512 one = _mm512_set1_ps(1.0f);
-    __m512 zero = _mm512_setzero_ps();
+#elif defined(__AVX512F__)
     for (; i+15 < numel; i += 16) {
-        __m512 xx = _mm512_loadu_ps(x+i);
-        __m512 neg_x = _mm512_sub_ps(zero, xx);
-        __m512 exp_neg_x = mag_simd_expf(neg_x);
-        __m512 one_plus_exp_neg_x = _mm512_add_ps(one, exp_neg_x);
-        _mm512_storeu_ps(o+i, _mm512_div_ps(one, one_plus_exp_neg_x));
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_abs_ps(xi));
     }
-#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
-    __m256 one = _mm256_set1_ps(1.0f);
-    __m256 zero = _mm256_setzero_ps();
+#elif defined(__AVX__)
+    __m256 sgn = _mm256_set1_ps(-0.0f);
     for (; i+7 < numel; i += 8) {
-        __m256 xx = _mm256_loadu_ps(x+i);
-        __m256 neg_x = _mm256_sub_ps(zero, xx);
-        __m256 exp_neg_x = mag_simd_expf(neg_x);
-        __m256 one_plus_exp_neg_x = _mm256_add_ps(one, exp_neg_x);
-        _mm256_storeu_ps(o+i, _mm256_div_ps(one, one_plus_exp_neg_x));
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_andnot_ps(sgn, xi));
     }
-#elif MAG_APPROXMATH && defined(__SSE2__)
-    __m128 one = _mm_set1_ps(1.0f);
-    __m128 zero = _mm_setzero_ps();
+#elif defined(__SSE2__)
+    __m128 sgn = _mm_set1_ps(-0.0f);
     for (; i+3 < numel; i += 4) {
-        __m128 xx = _mm_loadu_ps(x+i);
-        __m128 neg_x = _mm_sub_ps(zero, xx);
-        __m128 exp_neg_x = mag_simd_expf(neg_x);
-        __m128 one_plus_exp_neg_x = _mm_add_ps(one, exp_neg_x);
-        _mm_storeu_ps(o+i, _mm_div_ps(one, one_plus_exp_neg_x));
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_andnot_ps(sgn, xi));
     }
 #endif
-    for (; i < numel; ++i) o[i] = 1.0f / (1.0f + expf(-x[i])); /* Process leftovers scalar-wise */
-}
-
-static void MAG_HOTPROC mag_vsigmoid_dv_f32( /* σ' : ℝ -> (0, 1), x |-> x * (1-x) */
-    int64_t numel,
-    mag_f32_t* o,
-    const mag_f32_t* x
-) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = x[i] * (1.0f - x[i]);
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = fabsf(x[i]);
     }
 }
 
-static void MAG_HOTPROC mag_vhard_sigmoid_f32( /* σ^ : ℝ -> (0, 1), x |-> min(1, max(0, (x + 3)/6)) */
+static void MAG_HOTPROC mag_vneg_f32( /* o = -x */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = fminf(1.0f, fmaxf(0.0f, (x[i] + 3.0f) / 6.0f));
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vnegq_f32(xi));
+    }
+#elif defined(__AVX512F__)
+    __m512i sgn = _mm512_set1_epi32(INT32_MIN);
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(xi), sgn)));
+    }
+#elif defined(__AVX__)
+    __m256 sgn = _mm256_set1_ps(-0.0f);
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_xor_ps(sgn, xi));
+    }
+#elif defined(__SSE2__)
+    __m128 sgn = _mm_set1_ps(-0.0f);
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_xor_ps(sgn, xi));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = -x[i];
     }
 }
 
-static void MAG_HOTPROC mag_vsilu_f32( /* silu : ℝ -> ℝ, x |-> x/(1 + e^(-x)) */
+static void MAG_HOTPROC mag_vlog_f32( /* o = log x */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
     int64_t i=0;
 #if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
-    float32x4_t one = vdupq_n_f32(1.0f);
-    float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1);
     for (; i+3 < numel; i += 4) {
-        float32x4_t xx = vld1q_f32(x+i);
-        float32x4_t neg_x = vsubq_f32(zero, xx);
-        float32x4_t exp_neg_x = mag_simd_expf(neg_x);
-        float32x4_t one_plus_exp_neg_x = vaddq_f32(one, exp_neg_x);
-        vst1q_f32(o+i, vdivq_f32(xx, one_plus_exp_neg_x));
+        float32x4_t x0 = vld1q_f32(x+i);
+        float32x4_t xi = vmaxq_f32(x0, vdupq_n_f32(0));
+        uint32x4_t sub = vcltq_f32(xi, vdupq_n_f32(0x1p-126f)); /* Subnormals are scaled into the normal range first */
+        xi = vbslq_f32(sub, vmulq_f32(xi, vdupq_n_f32(0x1p23f)), xi);
+        uint32x4_t invalid_mask = vcleq_f32(xi, vdupq_n_f32(0));
+        int32x4_t ux = vreinterpretq_s32_f32(xi);
+        int32x4_t emm0 = vshrq_n_s32(ux, 23);
+        ux = vandq_s32(ux, vdupq_n_s32(~0x7f800000u));
+        ux = vorrq_s32(ux, vreinterpretq_s32_f32(vdupq_n_f32(0.5f)));
+        xi = vreinterpretq_f32_s32(ux);
+        emm0 = vsubq_s32(emm0, vdupq_n_s32(0x7f));
+        float32x4_t e = vcvtq_f32_s32(emm0);
+        e = vaddq_f32(e, one);
+        e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(sub, vreinterpretq_u32_f32(vdupq_n_f32(23.0f)))));
+        uint32x4_t mask = vcltq_f32(xi, vdupq_n_f32(0.707106781186547524f));
+        float32x4_t tmp = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(xi), mask));
+        xi = vsubq_f32(xi, one);
+        e = vsubq_f32(e, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(one), mask)));
+        xi = vaddq_f32(xi, tmp);
+        float32x4_t z = vmulq_f32(xi, xi);
+        float32x4_t y = vdupq_n_f32(7.0376836292e-2f);
+        y = vmlaq_f32(vdupq_n_f32(-1.1514610310e-1f), y, xi);
+        y = vmlaq_f32(vdupq_n_f32(1.1676998740e-1f), y, xi);
+        y = vmlaq_f32(vdupq_n_f32(-1.2420140846e-1f), y, xi);
+        y = vmlaq_f32(vdupq_n_f32(1.4249322787e-1f), y, xi);
+        y = vmlaq_f32(vdupq_n_f32(-1.6668057665e-1f), y, xi);
+        y = vmlaq_f32(vdupq_n_f32(2.0000714765e-1f), y, xi);
+        y = vmlaq_f32(vdupq_n_f32(-2.4999993993e-1f), y, xi);
+        y = vmlaq_f32(vdupq_n_f32(3.3333331174e-1f), y, xi);
+        y = vmulq_f32(y, xi);
+        y = vmulq_f32(y, z);
+        y = vmlaq_f32(y, e, vdupq_n_f32(-2.12194440e-4f));
+        y = vmlsq_f32(y, z, vdupq_n_f32(0.5f));
+        xi = vaddq_f32(xi, y);
+        xi = vmlaq_f32(xi, e, vdupq_n_f32(0.693359375f));
+        xi = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(xi), invalid_mask));
+        xi = vbslq_f32(vceqq_f32(x0, vdupq_n_f32(0)), vdupq_n_f32(-INFINITY), xi); /* Same special values as logf */
+        xi = vbslq_f32(vceqq_f32(x0, vdupq_n_f32(INFINITY)), x0, xi);
+        vst1q_f32(o+i, xi);
     }
 #elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
-    __m512 one = _mm512_set1_ps(1);
-    __m512 zero = _mm512_setzero_ps();
+    const __m512 one = _mm512_set1_ps(1.0f);
     for (; i+15 < numel; i += 16) {
-        __m512 xx = _mm512_loadu_ps(x+i);
-        __m512 neg_x = _mm512_sub_ps(zero, xx);
-        __m512 exp_neg_x = mag_simd_expf(neg_x);
-        __m512 one_plus_exp_neg_x = _mm512_add_ps(one, exp_neg_x);
-        _mm512_storeu_ps(o+i, _mm512_div_ps(xx, one_plus_exp_neg_x));
+        __m512 x0 = _mm512_loadu_ps(x+i);
+        __m512 xi = _mm512_getmant_ps(x0, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_zero); /* x = m*2^e with m in [0.5, 1), subnormals included */
+        __m512 e = _mm512_add_ps(_mm512_getexp_ps(x0), one);
+        __mmask16 mask = _mm512_cmp_ps_mask(xi, _mm512_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+        xi = _mm512_sub_ps(_mm512_mask_add_ps(xi, mask, xi, xi), one);
+        e = _mm512_mask_sub_ps(e, mask, e, one);
+        __m512 z = _mm512_mul_ps(xi, xi);
+        __m512 y = _mm512_set1_ps(7.0376836292e-2f);
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(-1.1514610310e-1f));
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(1.1676998740e-1f));
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(-1.2420140846e-1f));
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(1.4249322787e-1f));
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(-1.6668057665e-1f));
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(2.0000714765e-1f));
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(-2.4999993993e-1f));
+        y = _mm512_fmadd_ps(y, xi, _mm512_set1_ps(3.3333331174e-1f));
+        y = _mm512_mul_ps(_mm512_mul_ps(y, xi), z);
+        y = _mm512_fmadd_ps(e, _mm512_set1_ps(-2.12194440e-4f), y);
+        y = _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), y);
+        xi = _mm512_add_ps(xi, y);
+        xi = _mm512_fmadd_ps(e, _mm512_set1_ps(0.693359375f), xi);
+        xi = _mm512_mask_mov_ps(xi, _mm512_cmp_ps_mask(x0, _mm512_setzero_ps(), _CMP_NGE_UQ), _mm512_set1_ps(NAN)); /* Same special values as logf */
+        xi = _mm512_mask_mov_ps(xi, _mm512_cmp_ps_mask(x0, _mm512_setzero_ps(), _CMP_EQ_OQ), _mm512_set1_ps(-INFINITY));
+        xi = _mm512_mask_mov_ps(xi, _mm512_cmp_ps_mask(x0, _mm512_set1_ps(INFINITY), _CMP_EQ_OQ), x0);
+        _mm512_storeu_ps(o+i, xi);
     }
 #elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
-    __m256 one = _mm256_set1_ps(1);
-    __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
     for (; i+7 < numel; i += 8) {
-        const __m256 xx = _mm256_loadu_ps(x+i);
-        __m256 neg_x = _mm256_sub_ps(zero, xx);
-        __m256 exp_neg_x = mag_simd_expf(neg_x);
-        __m256 one_plus_exp_neg_x = _mm256_add_ps(one, exp_neg_x);
-        _mm256_storeu_ps(o+i, _mm256_div_ps(xx, one_plus_exp_neg_x));
+        __m256 x0 = _mm256_loadu_ps(x+i);
+        __m256 sub = _mm256_cmp_ps(x0, _mm256_set1_ps(0x1p-126f), _CMP_LT_OQ); /* Subnormals are scaled into the normal range first */
+        __m256 xi = _mm256_blendv_ps(x0, _mm256_mul_ps(x0, _mm256_set1_ps(0x1p23f)), sub);
+        __m256i ux = _mm256_castps_si256(xi);
+        __m256i emm0 = _mm256_srli_epi32(ux, 23);
+        ux = _mm256_and_si256(ux, _mm256_set1_epi32(~0x7f800000u));
+        ux = _mm256_or_si256(ux, _mm256_castps_si256(_mm256_set1_ps(0.5f)));
+        xi = _mm256_castsi256_ps(ux);
+        emm0 = _mm256_sub_epi32(emm0, _mm256_set1_epi32(0x7f));
+        __m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(emm0), one);
+        e = _mm256_sub_ps(e, _mm256_and_ps(sub, _mm256_set1_ps(23.0f)));
+        __m256 mask = _mm256_cmp_ps(xi, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+        __m256 tmp = _mm256_and_ps(xi, mask);
+        xi = _mm256_sub_ps(xi, one);
+        e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+        xi = _mm256_add_ps(xi, tmp);
+        __m256 z = _mm256_mul_ps(xi, xi);
+        __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(-1.1514610310e-1f));
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(1.1676998740e-1f));
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(-1.2420140846e-1f));
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(1.4249322787e-1f));
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(-1.6668057665e-1f));
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(2.0000714765e-1f));
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(-2.4999993993e-1f));
+        y = _mm256_fmadd_ps(y, xi, _mm256_set1_ps(3.3333331174e-1f));
+        y = _mm256_mul_ps(_mm256_mul_ps(y, xi), z);
+        y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+        y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+        xi = _mm256_add_ps(xi, y);
+        xi = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), xi);
+        xi = _mm256_blendv_ps(xi, _mm256_set1_ps(NAN), _mm256_cmp_ps(x0, _mm256_setzero_ps(), _CMP_NGE_UQ)); /* Same special values as logf */
+        xi = _mm256_blendv_ps(xi, _mm256_set1_ps(-INFINITY), _mm256_cmp_ps(x0, _mm256_setzero_ps(), _CMP_EQ_OQ));
+        xi = _mm256_blendv_ps(xi, x0, _mm256_cmp_ps(x0, _mm256_set1_ps(INFINITY), _CMP_EQ_OQ));
+        _mm256_storeu_ps(o+i, xi);
     }
 #elif MAG_APPROXMATH && defined(__SSE2__)
-    __m128 one = _mm_set1_ps(1);
-    __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
     for (; i+3 < numel; i += 4) {
-        __m128 xx = _mm_loadu_ps(x+i);
-        __m128 neg_x = _mm_sub_ps(zero, xx);
-        __m128 exp_neg_x = mag_simd_expf(neg_x);
-        __m128 one_plus_exp_neg_x = _mm_add_ps(one, exp_neg_x);
-        _mm_storeu_ps(o+i, _mm_div_ps(xx, one_plus_exp_neg_x));
+        __m128 x0 = _mm_loadu_ps(x+i);
+        __m128 xi = _mm_max_ps(x0, _mm_set1_ps(0.0f));
+        __m128 sub = _mm_cmplt_ps(xi, _mm_set1_ps(0x1p-126f)); /* Subnormals are scaled into the normal range first */
+        xi = _mm_or_ps(_mm_andnot_ps(sub, xi), _mm_and_ps(sub, _mm_mul_ps(xi, _mm_set1_ps(0x1p23f))));
+        __m128 invalid_mask = _mm_cmple_ps(xi, _mm_set1_ps(0.0f));
+        __m128i ux = _mm_castps_si128(xi);
+        __m128i emm0 = _mm_srli_epi32(ux, 23);
+        ux = _mm_and_si128(ux, _mm_set1_epi32(~0x7f800000u));
+        ux = _mm_or_si128(ux, _mm_castps_si128(_mm_set1_ps(0.5f)));
+        xi = _mm_castsi128_ps(ux);
+        emm0 = _mm_sub_epi32(emm0, _mm_set1_epi32(0x7f));
+        __m128 e = _mm_cvtepi32_ps(emm0);
+        e = _mm_add_ps(e, one);
+        e = _mm_sub_ps(e, _mm_and_ps(sub, _mm_set1_ps(23.0f)));
+        __m128 mask = _mm_cmplt_ps(xi, _mm_set1_ps(0.707106781186547524f));
+        __m128 tmp = _mm_and_ps(xi, mask);
+        xi = _mm_sub_ps(xi, one);
+        e = _mm_sub_ps(e, _mm_and_ps(one, mask));
+        xi = _mm_add_ps(xi, tmp);
+        __m128 z = _mm_mul_ps(xi, xi);
+        __m128 y = _mm_set1_ps(7.0376836292e-2f);
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-1.1514610310e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(1.1676998740e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-1.2420140846e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(1.4249322787e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-1.6668057665e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(2.0000714765e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(-2.4999993993e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, xi), _mm_set1_ps(3.3333331174e-1f));
+        y = _mm_mul_ps(y, xi);
+        y = _mm_mul_ps(y, z);
+        y = _mm_add_ps(_mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)), y);
+        y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+        xi = _mm_add_ps(xi, y);
+        xi = _mm_add_ps(_mm_mul_ps(e, _mm_set1_ps(0.693359375f)), xi);
+        xi = _mm_or_ps(xi, invalid_mask);
+        __m128 zero_mask = _mm_cmpeq_ps(x0, _mm_setzero_ps()); /* Same special values as logf */
+        __m128 inf_mask = _mm_cmpeq_ps(x0, _mm_set1_ps(INFINITY));
+        xi = _mm_or_ps(_mm_andnot_ps(zero_mask, xi), _mm_and_ps(zero_mask, _mm_set1_ps(-INFINITY)));
+        xi = _mm_or_ps(_mm_andnot_ps(inf_mask, xi), _mm_and_ps(inf_mask, x0));
+        _mm_storeu_ps(o+i, xi);
     }
 #endif
-    for (; i < numel; ++i) {
-        o[i] = x[i] / (1.0f + expf(-x[i]));
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = logf(x[i]);
     }
 }
 
-static void MAG_HOTPROC mag_vsilu_dv_f32( /* silu' : ℝ -> TODO */
+static void MAG_HOTPROC mag_vsqr_f32( /* o = x² */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        mag_panic("NYI!");
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vmulq_f32(xi, xi));
+    }
+#elif defined(__AVX512F__)
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_mul_ps(xi, xi));
+    }
+#elif defined(__AVX__)
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_mul_ps(xi, xi));
+    }
+#elif defined(__SSE2__)
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_mul_ps(xi, xi));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = x[i]*x[i];
     }
 }
 
-static void MAG_HOTPROC mag_vtanh_f32( /* tanh : ℝ -> (-1, 1), x |-> tanh x */
+static void MAG_HOTPROC mag_vsqrt_f32( /* o = √x */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
     int64_t i=0;
-#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
     for (; i+3 < numel; i += 4) {
-        vst1q_f32(o+i, mag_simd_tanh(vld1q_f32(x+i)));
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vsqrtq_f32(xi));
     }
-#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
+#elif defined(__AVX512F__)
     for (; i+15 < numel; i += 16) {
-        _mm512_storeu_ps(o+i, mag_simd_tanh(_mm512_loadu_ps(x+i)));
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_sqrt_ps(xi));
     }
-#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
+#elif defined(__AVX__)
     for (; i+7 < numel; i += 8) {
-        _mm256_storeu_ps(o+i, mag_simd_tanh(_mm256_loadu_ps(x+i)));
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_sqrt_ps(xi));
     }
-#elif MAG_APPROXMATH && defined(__SSE2__)
+#elif defined(__SSE2__)
     for (; i+3 < numel; i += 4) {
-        _mm_storeu_ps(o+i, mag_simd_tanh(_mm_loadu_ps(x+i)));
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_sqrt_ps(xi));
     }
 #endif
-    for (; i < numel; ++i) {
-        o[i] = tanhf(x[i]);
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = sqrtf(x[i]);
     }
 }
 
-static void MAG_HOTPROC mag_vtanh_dv_f32( /* tanh' : ℝ -> (-1, 1), x |-> 1 / ((cosh x)^2) */
+static void MAG_HOTPROC mag_vsin_f32( /* o = sin x */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        const mag_f32_t cx = coshf(x[i]);
-        o[i] = 1.0f / (cx*cx);
+    int64_t i=0;
+#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        if (mag_unlikely(!vminvq_u32(vcleq_f32(vabsq_f32(xi), vdupq_n_f32(8192.0f))))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+4; ++j) o[j] = sinf(x[j]);
+            continue;
+        }
+        float32x4_t ocos;
+        mag_simd_sincos(xi, &xi, &ocos);
+        vst1q_f32(o+i, xi);
     }
-}
-
-static void MAG_HOTPROC mag_vrelu_f32( /* relu : ℝ -> ℝ^+, x |-> max {x, 0} */
-    int64_t numel,
-    mag_f32_t* o,
-    const mag_f32_t* x
-) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = mag_xmax(x[i], 0.0f);
+#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        if (mag_unlikely(_mm512_cmp_ps_mask(_mm512_abs_ps(xi), _mm512_set1_ps(8192.0f), _CMP_NLE_UQ))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+16; ++j) o[j] = sinf(x[j]);
+            continue;
+        }
+        __m512 ocos;
+        mag_simd_sincos(xi, &xi, &ocos);
+        _mm512_storeu_ps(o+i, xi);
     }
-}
-
-static void MAG_HOTPROC mag_vrelu_dv_f32( /* relu' : ℝ -> ℝ^+, x |-> { 0 if x < 0, UB if x = 0, else 1 */
-    int64_t numel,
-    mag_f32_t* o,
-    const mag_f32_t* x
-) {
-    for (int64_t i=0; i < numel; ++i) {
-        o[i] = x[i] <= 0.0f ? 0.0f : 1.0f; /* relu' is mathematically undefined for x = 0, but we return 0 in this case. */
+#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        if (mag_unlikely(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), xi), _mm256_set1_ps(8192.0f), _CMP_NLE_UQ)))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+8; ++j) o[j] = sinf(x[j]);
+            continue;
+        }
+        __m256 ocos;
+        mag_simd_sincos(xi, &xi, &ocos);
+        _mm256_storeu_ps(o+i, xi);
+    }
+#elif MAG_APPROXMATH && defined(__SSE2__)
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        if (mag_unlikely(_mm_movemask_ps(_mm_cmpnle_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), xi), _mm_set1_ps(8192.0f))))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+4; ++j) o[j] = sinf(x[j]);
+            continue;
+        }
+        __m128 ocos;
+        mag_simd_sincos(xi, &xi, &ocos);
+        _mm_storeu_ps(o+i, xi);
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = sinf(x[i]);
     }
 }
 
-static void MAG_HOTPROC mag_vgelu_f32( /* gelu : ℝ -> ℝ, x |-> TODO */
+static void MAG_HOTPROC mag_vcos_f32( /* o = cos x */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
     int64_t i=0;
 #if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
-    float32x4_t half = vdupq_n_f32(0.5f);
-    float32x4_t one = vdupq_n_f32(1.0f);
-    float32x4_t coeff1 = vdupq_n_f32(0.79788456080286535587989211986876f);
-    float32x4_t coeff2 = vdupq_n_f32(MAG_GELU_COEFF);
     for (; i+3 < numel; i += 4) {
-        float32x4_t xx = vld1q_f32(x+i);
-        float32x4_t a = vaddq_f32(one, vmulq_f32(coeff2, vmulq_f32(xx, xx)));
-        float32x4_t b = vaddq_f32(one, mag_simd_tanh(vmulq_f32(coeff1, vmulq_f32(xx, a))));
-        float32x4_t c = vmulq_f32(half, vmulq_f32(xx, b));
-        vst1q_f32(o+i, c);
+        float32x4_t xi = vld1q_f32(x+i);
+        if (mag_unlikely(!vminvq_u32(vcleq_f32(vabsq_f32(xi), vdupq_n_f32(8192.0f))))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+4; ++j) o[j] = cosf(x[j]);
+            continue;
+        }
+        float32x4_t osin;
+        mag_simd_sincos(xi, &osin, &xi);
+        vst1q_f32(o+i, xi);
     }
 #elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
-    __m512 half = _mm512_set1_ps(0.5f);
-    __m512 one = _mm512_set1_ps(1.0f);
-    __m512 coeff1 = _mm512_set1_ps(0.79788456080286535587989211986876f);
-    __m512 coeff2 = _mm512_set1_ps(MAG_GELU_COEFF);
     for (; i+15 < numel; i += 16) {
-        __m512 xx = _mm512_loadu_ps(x+i);
-        __m512 a = _mm512_fmadd_ps(coeff2, _mm512_mul_ps(xx, xx), one);
-        __m512 b = _mm512_add_ps(one, mag_simd_tanh(_mm512_mul_ps(coeff1, _mm512_mul_ps(xx, a))));
-        __m512 c = _mm512_mul_ps(half, _mm512_mul_ps(xx, b));
-        _mm512_storeu_ps(o+i, c);
+        __m512 xi = _mm512_loadu_ps(x+i);
+        if (mag_unlikely(_mm512_cmp_ps_mask(_mm512_abs_ps(xi), _mm512_set1_ps(8192.0f), _CMP_NLE_UQ))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+16; ++j) o[j] = cosf(x[j]);
+            continue;
+        }
+        __m512 osin;
+        mag_simd_sincos(xi, &osin, &xi);
+        _mm512_storeu_ps(o+i, xi);
     }
 #elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
-    __m256 half = _mm256_set1_ps(0.5f);
-    __m256 one = _mm256_set1_ps(1.0f);
-    __m256 coeff1 = _mm256_set1_ps(0.79788456080286535587989211986876f);
-    __m256 coeff2 = _mm256_set1_ps(MAG_GELU_COEFF);
     for (; i+7 < numel; i += 8) {
-        __m256 xx = _mm256_loadu_ps(x+i);
-        __m256 a = _mm256_fmadd_ps(coeff2, _mm256_mul_ps(xx, xx), one);
-        __m256 b = _mm256_add_ps(one, mag_simd_tanh(_mm256_mul_ps(coeff1, _mm256_mul_ps(xx, a))));
-        __m256 c = _mm256_mul_ps(half, _mm256_mul_ps(xx, b));
-        _mm256_storeu_ps(o+i, c);
+        __m256 xi = _mm256_loadu_ps(x+i);
+        if (mag_unlikely(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), xi), _mm256_set1_ps(8192.0f), _CMP_NLE_UQ)))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+8; ++j) o[j] = cosf(x[j]);
+            continue;
+        }
+        __m256 osin;
+        mag_simd_sincos(xi, &osin, &xi);
+        _mm256_storeu_ps(o+i, xi);
     }
 #elif MAG_APPROXMATH && defined(__SSE2__)
-    __m128 half = _mm_set1_ps(0.5f);
-    __m128 one = _mm_set1_ps(1.0f);
-    __m128 coeff1 = _mm_set1_ps(0.79788456080286535587989211986876f);
-    __m128 coeff2 = _mm_set1_ps(MAG_GELU_COEFF);
     for (; i+3 < numel; i += 4) {
-        __m128 xx = _mm_loadu_ps(x+i);
-        __m128 a = _mm_add_ps(one, _mm_mul_ps(coeff2, _mm_mul_ps(xx, xx)));
-        __m128 b = _mm_add_ps(one, mag_simd_tanh(_mm_mul_ps(coeff1, _mm_mul_ps(xx, a))));
-        __m128 c = _mm_mul_ps(half, _mm_mul_ps(xx, b));
-        _mm_storeu_ps(o+i, c);
+        __m128 xi = _mm_loadu_ps(x+i);
+        if (mag_unlikely(_mm_movemask_ps(_mm_cmpnle_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), xi), _mm_set1_ps(8192.0f))))) { /* Outside the range reduction (or NaN), libm takes the block */
+            for (int64_t j=i; j < i+4; ++j) o[j] = cosf(x[j]);
+            continue;
+        }
+        __m128 osin;
+        mag_simd_sincos(xi, &osin, &xi);
+        _mm_storeu_ps(o+i, xi);
     }
 #endif
-    for (; i < numel; ++i) {
-        o[i] = 0.5f*x[i]*(1.0f + tanhf(0.79788456080286535587989211986876f*x[i]*(1.0f + MAG_GELU_COEFF*x[i]*x[i])));
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = cosf(x[i]);
     }
 }
 
-static void MAG_HOTPROC mag_vgelu_dv_f32( /* gelu' : ℝ -> ℝ, x |-> TODO */
+static void MAG_HOTPROC mag_vstep_f32( /* Heaviside step function. */
     int64_t numel,
     mag_f32_t* o,
     const mag_f32_t* x
 ) {
-    for (int64_t i=0; i < numel; ++i) {
-        mag_panic("NYI"); /* TODO */
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.0f));
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xi = vld1q_f32(x+i);
+        vst1q_f32(o+i, vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(xi, zero), one)));
     }
+#elif defined(__AVX512F__)
+    __m512 zero = _mm512_setzero_ps();
+    __m512 one = _mm512_set1_ps(1.0f);
+    for (; i+15 < numel; i += 16) {
+        __m512 xi = _mm512_loadu_ps(x+i);
+        _mm512_storeu_ps(o+i, _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(xi, zero, _CMP_GE_OQ), one));
+    }
+#elif defined(__AVX__)
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    for (; i+7 < numel; i += 8) {
+        __m256 xi = _mm256_loadu_ps(x+i);
+        _mm256_storeu_ps(o+i, _mm256_and_ps(_mm256_cmp_ps(xi, zero, _CMP_GE_OQ), one));
+    }
+#elif defined(__SSE2__)
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    for (; i+3 < numel; i += 4) {
+        __m128 xi = _mm_loadu_ps(x+i);
+        _mm_storeu_ps(o+i, _mm_and_ps(_mm_cmpge_ps(xi, zero), one));
+    }
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = x[i] >= 0.0f ? 1.0f : 0.0f;
+    }
+}
+
+static mag_f64_t MAG_HOTPROC mag_vexpsubs_sum_f32( /* o = e^(x-m), returns Σo */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x,
+    mag_f32_t m
+) {
+    int64_t i=0;
+    mag_f64_t sum = 0.0;
+#if MAG_APPROXMATH && ((defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64))
+    float32x4_t vm = vdupq_n_f32(m);
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t e = mag_simd_expf(vsubq_f32(vld1q_f32(x+i), vm));
+        vst1q_f32(o+i, e);
+        acc = vaddq_f32(acc, e);
+    }
+    sum = (mag_f64_t)vaddvq_f32(acc);
+#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
+    __m512 vm = _mm512_set1_ps(m);
+    __m512 acc = _mm512_setzero_ps();
+    for (; i+15 < numel; i += 16) {
+        __m512 e = mag_simd_expf(_mm512_sub_ps(_mm512_loadu_ps(x+i), vm));
+        _mm512_storeu_ps(o+i, e);
+        acc = _mm512_add_ps(acc, e);
+    }
+    sum = (mag_f64_t)_mm512_reduce_add_ps(acc);
+#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
+    __m256 vm = _mm256_set1_ps(m);
+    __m256 acc = _mm256_setzero_ps();
+    for (; i+7 < numel; i += 8) {
+        __m256 e = mag_simd_expf(_mm256_sub_ps(_mm256_loadu_ps(x+i), vm));
+        _mm256_storeu_ps(o+i, e);
+        acc = _mm256_add_ps(acc, e);
+    }
+    __m128 v0 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    v0 = _mm_add_ps(v0, _mm_movehl_ps(v0, v0));
+    v0 = _mm_add_ss(v0, _mm_shuffle_ps(v0, v0, 1));
+    sum = (mag_f64_t)_mm_cvtss_f32(v0);
+#elif MAG_APPROXMATH && defined(__SSE2__)
+    __m128 vm = _mm_set1_ps(m);
+    __m128 acc = _mm_setzero_ps();
+    for (; i+3 < numel; i += 4) {
+        __m128 e = mag_simd_expf(_mm_sub_ps(_mm_loadu_ps(x+i), vm));
+        _mm_storeu_ps(o+i, e);
+        acc = _mm_add_ps(acc, e);
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = (mag_f64_t)_mm_cvtss_f32(acc);
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        o[i] = expf(x[i]-m);
+        sum += (mag_f64_t)o[i];
+    }
+    return sum;
+}
+
+#define MAG_SOFTMAX_BLOCK 1024 /* Elements of a softmax row exponentiated at once, the block stays in L1 between its max, exp and rescale. */
+#define MAG_SOFTMAX_MAX_BLOCKS 256 /* Rows up to this many blocks (1 MiB) are read once, longer rows take a second exp pass. */
+
+/*
+** softmax : ℝⁿ -> (0, 1)ⁿ, x |-> e^(x-max x) / Σe^(x-max x) over one contiguous row.
+** Online softmax: the running max m and normalizer s are carried blockwise, s is rescaled by e^(m_old-m_new) whenever a block raises the max.
+** Each block is exponentiated against the running max of its time and written out once, the final pass multiplies it by e^(m_block-m)/s.
+** So x is read once and o written once, the rescale pass hits the cache for rows up to MAG_SOFTMAX_MAX_BLOCKS blocks.
+** Longer rows compute m and s first and exponentiate again in the output pass, instead of keeping a per block max array.
+** A NaN or +inf in the row makes the whole row NaN, an all -inf row is NaN (0/0).
+*/
+static void MAG_HOTPROC mag_vsoftmax_f32(
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    mag_f32_t mb[MAG_SOFTMAX_MAX_BLOCKS], tmp[MAG_SOFTMAX_BLOCK];
+    int64_t nb = (numel + MAG_SOFTMAX_BLOCK - 1)/MAG_SOFTMAX_BLOCK;
+    bool fused = nb <= MAG_SOFTMAX_MAX_BLOCKS;
+    mag_f32_t m = -INFINITY;
+    mag_f64_t s = 0.0;
+    for (int64_t b=0; b < nb; ++b) {
+        int64_t i = b*MAG_SOFTMAX_BLOCK;
+        int64_t n = mag_xmin(MAG_SOFTMAX_BLOCK, numel-i);
+        mag_f32_t bm = mag_vmax_f32(n, x+i);
+        if (bm > m) {
+            s *= (mag_f64_t)expf(m-bm);
+            m = bm;
+        }
+        mag_f32_t* po = fused ? o+i : tmp; /* The unfused pass only needs the sum, o may alias x. */
+        if (mag_unlikely(m == -INFINITY)) { /* All -inf (or NaN) so far, these terms contribute e^-inf = 0 once a finite max shows up. */
+            for (int64_t j=0; j < n; ++j) po[j] = 0.0f;
+        } else {
+            s += mag_vexpsubs_sum_f32(n, po, x+i, m);
+        }
+        if (fused) mb[b] = m;
+    }
+    mag_f64_t inv = 1.0/s;
+    if (fused) {
+        for (int64_t b=0; b < nb; ++b) {
+            int64_t i = b*MAG_SOFTMAX_BLOCK;
+            mag_vmuls_f32(mag_xmin(MAG_SOFTMAX_BLOCK, numel-i), o+i, o+i, (mag_f32_t)((mag_f64_t)expf(mb[b]-m)*inv));
+        }
+    } else {
+        for (int64_t i=0; i < numel; i += MAG_SOFTMAX_BLOCK) {
+            int64_t n = mag_xmin(MAG_SOFTMAX_BLOCK, numel-i);
+            mag_vexpsubs_sum_f32(n, o+i, x+i, m);
+            mag_vmuls_f32(n, o+i, o+i, (mag_f32_t)inv);
+        }
+    }
+}
+
+static void MAG_HOTPROC mag_vsoftmax_dv_f32( /* softmax' : (0, 1) -> (0, 1/4], s |-> s * (1-s), diagonal of the softmax Jacobian from the softmax output s */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        o[i] = x[i] * (1.0f - x[i]);
+    }
+}
+
+static void MAG_HOTPROC mag_vsigmoid_f32( /* σ : ℝ -> (0, 1), x |-> 1/(1 + e^(-x)) */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    int64_t i=0;
+#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xx = vld1q_f32(x+i);
+        float32x4_t neg_x = vsubq_f32(zero, xx);
+        float32x4_t exp_neg_x = mag_simd_expf(neg_x);
+        float32x4_t one_plus_exp_neg_x = vaddq_f32(one, exp_neg_x);
+        vst1q_f32(o+i, vdivq_f32(one, one_plus_exp_neg_x));
+    }
+#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 zero = _mm512_setzero_ps();
+    for (; i+15 < numel; i += 16) {
+        __m512 xx = _mm512_loadu_ps(x+i);
+        __m512 neg_x = _mm512_sub_ps(zero, xx);
+        __m512 exp_neg_x = mag_simd_expf(neg_x);
+        __m512 one_plus_exp_neg_x = _mm512_add_ps(one, exp_neg_x);
+        _mm512_storeu_ps(o+i, _mm512_div_ps(one, one_plus_exp_neg_x));
+    }
+#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 zero = _mm256_setzero_ps();
+    for (; i+7 < numel; i += 8) {
+        __m256 xx = _mm256_loadu_ps(x+i);
+        __m256 neg_x = _mm256_sub_ps(zero, xx);
+        __m256 exp_neg_x = mag_simd_expf(neg_x);
+        __m256 one_plus_exp_neg_x = _mm256_add_ps(one, exp_neg_x);
+        _mm256_storeu_ps(o+i, _mm256_div_ps(one, one_plus_exp_neg_x));
+    }
+#elif MAG_APPROXMATH && defined(__SSE2__)
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+    for (; i+3 < numel; i += 4) {
+        __m128 xx = _mm_loadu_ps(x+i);
+        __m128 neg_x = _mm_sub_ps(zero, xx);
+        __m128 exp_neg_x = mag_simd_expf(neg_x);
+        __m128 one_plus_exp_neg_x = _mm_add_ps(one, exp_neg_x);
+        _mm_storeu_ps(o+i, _mm_div_ps(one, one_plus_exp_neg_x));
+    }
+#endif
+    for (; i < numel; ++i) o[i] = 1.0f / (1.0f + expf(-x[i])); /* Process leftovers scalar-wise */
+}
+
+static void MAG_HOTPROC mag_vsigmoid_dv_f32( /* σ' : ℝ -> (0, 1), x |-> x * (1-x) */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        o[i] = x[i] * (1.0f - x[i]);
+    }
+}
+
+static void MAG_HOTPROC mag_vhard_sigmoid_f32( /* σ^ : ℝ -> (0, 1), x |-> min(1, max(0, (x + 3)/6)) */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        o[i] = fminf(1.0f, fmaxf(0.0f, (x[i] + 3.0f) / 6.0f));
+    }
+}
+
+static void MAG_HOTPROC mag_vsilu_f32( /* silu : ℝ -> ℝ, x |-> x/(1 + e^(-x)) */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    int64_t i=0;
+#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xx = vld1q_f32(x+i);
+        float32x4_t neg_x = vsubq_f32(zero, xx);
+        float32x4_t exp_neg_x = mag_simd_expf(neg_x);
+        float32x4_t one_plus_exp_neg_x = vaddq_f32(one, exp_neg_x);
+        vst1q_f32(o+i, vdivq_f32(xx, one_plus_exp_neg_x));
+    }
+#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
+    __m512 one = _mm512_set1_ps(1);
+    __m512 zero = _mm512_setzero_ps();
+    for (; i+15 < numel; i += 16) {
+        __m512 xx = _mm512_loadu_ps(x+i);
+        __m512 neg_x = _mm512_sub_ps(zero, xx);
+        __m512 exp_neg_x = mag_simd_expf(neg_x);
+        __m512 one_plus_exp_neg_x = _mm512_add_ps(one, exp_neg_x);
+        _mm512_storeu_ps(o+i, _mm512_div_ps(xx, one_plus_exp_neg_x));
+    }
+#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
+    __m256 one = _mm256_set1_ps(1);
+    __m256 zero = _mm256_setzero_ps();
+    for (; i+7 < numel; i += 8) {
+        const __m256 xx = _mm256_loadu_ps(x+i);
+        __m256 neg_x = _mm256_sub_ps(zero, xx);
+        __m256 exp_neg_x = mag_simd_expf(neg_x);
+        __m256 one_plus_exp_neg_x = _mm256_add_ps(one, exp_neg_x);
+        _mm256_storeu_ps(o+i, _mm256_div_ps(xx, one_plus_exp_neg_x));
+    }
+#elif MAG_APPROXMATH && defined(__SSE2__)
+    __m128 one = _mm_set1_ps(1);
+    __m128 zero = _mm_setzero_ps();
+    for (; i+3 < numel; i += 4) {
+        __m128 xx = _mm_loadu_ps(x+i);
+        __m128 neg_x = _mm_sub_ps(zero, xx);
+        __m128 exp_neg_x = mag_simd_expf(neg_x);
+        __m128 one_plus_exp_neg_x = _mm_add_ps(one, exp_neg_x);
+        _mm_storeu_ps(o+i, _mm_div_ps(xx, one_plus_exp_neg_x));
+    }
+#endif
+    for (; i < numel; ++i) {
+        o[i] = x[i] / (1.0f + expf(-x[i]));
+    }
+}
+
+static void MAG_HOTPROC mag_vsilu_dv_f32( /* silu' : ℝ -> TODO */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        mag_panic("NYI!");
+    }
+}
+
+static void MAG_HOTPROC mag_vtanh_f32( /* tanh : ℝ -> (-1, 1), x |-> tanh x */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    int64_t i=0;
+#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    for (; i+3 < numel; i += 4) {
+        vst1q_f32(o+i, mag_simd_tanh(vld1q_f32(x+i)));
+    }
+#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
+    for (; i+15 < numel; i += 16) {
+        _mm512_storeu_ps(o+i, mag_simd_tanh(_mm512_loadu_ps(x+i)));
+    }
+#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
+    for (; i+7 < numel; i += 8) {
+        _mm256_storeu_ps(o+i, mag_simd_tanh(_mm256_loadu_ps(x+i)));
+    }
+#elif MAG_APPROXMATH && defined(__SSE2__)
+    for (; i+3 < numel; i += 4) {
+        _mm_storeu_ps(o+i, mag_simd_tanh(_mm_loadu_ps(x+i)));
+    }
+#endif
+    for (; i < numel; ++i) {
+        o[i] = tanhf(x[i]);
+    }
+}
+
+static void MAG_HOTPROC mag_vtanh_dv_f32( /* tanh' : ℝ -> (-1, 1), x |-> 1 / ((cosh x)^2) */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        const mag_f32_t cx = coshf(x[i]);
+        o[i] = 1.0f / (cx*cx);
+    }
+}
+
+static void MAG_HOTPROC mag_vrelu_f32( /* relu : ℝ -> ℝ^+, x |-> max {x, 0} */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        o[i] = mag_xmax(x[i], 0.0f);
+    }
+}
+
+static void MAG_HOTPROC mag_vrelu_dv_f32( /* relu' : ℝ -> ℝ^+, x |-> { 0 if x < 0, UB if x = 0, else 1 */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        o[i] = x[i] <= 0.0f ? 0.0f : 1.0f; /* relu' is mathematically undefined for x = 0, but we return 0 in this case. */
+    }
+}
+
+static void MAG_HOTPROC mag_vgelu_f32( /* gelu : ℝ -> ℝ, x |-> TODO */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    int64_t i=0;
+#if MAG_APPROXMATH && (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t half = vdupq_n_f32(0.5f);
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t coeff1 = vdupq_n_f32(0.79788456080286535587989211986876f);
+    float32x4_t coeff2 = vdupq_n_f32(MAG_GELU_COEFF);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t xx = vld1q_f32(x+i);
+        float32x4_t a = vaddq_f32(one, vmulq_f32(coeff2, vmulq_f32(xx, xx)));
+        float32x4_t b = vaddq_f32(one, mag_simd_tanh(vmulq_f32(coeff1, vmulq_f32(xx, a))));
+        float32x4_t c = vmulq_f32(half, vmulq_f32(xx, b));
+        vst1q_f32(o+i, c);
+    }
+#elif MAG_APPROXMATH && defined(__AVX512F__) && defined(__AVX512DQ__)
+    __m512 half = _mm512_set1_ps(0.5f);
+    __m512 one = _mm512_set1_ps(1.0f);
+    __m512 coeff1 = _mm512_set1_ps(0.79788456080286535587989211986876f);
+    __m512 coeff2 = _mm512_set1_ps(MAG_GELU_COEFF);
+    for (; i+15 < numel; i += 16) {
+        __m512 xx = _mm512_loadu_ps(x+i);
+        __m512 a = _mm512_fmadd_ps(coeff2, _mm512_mul_ps(xx, xx), one);
+        __m512 b = _mm512_add_ps(one, mag_simd_tanh(_mm512_mul_ps(coeff1, _mm512_mul_ps(xx, a))));
+        __m512 c = _mm512_mul_ps(half, _mm512_mul_ps(xx, b));
+        _mm512_storeu_ps(o+i, c);
+    }
+#elif MAG_APPROXMATH && defined(__AVX2__) && defined(__FMA__)
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 coeff1 = _mm256_set1_ps(0.79788456080286535587989211986876f);
+    __m256 coeff2 = _mm256_set1_ps(MAG_GELU_COEFF);
+    for (; i+7 < numel; i += 8) {
+        __m256 xx = _mm256_loadu_ps(x+i);
+        __m256 a = _mm256_fmadd_ps(coeff2, _mm256_mul_ps(xx, xx), one);
+        __m256 b = _mm256_add_ps(one, mag_simd_tanh(_mm256_mul_ps(coeff1, _mm256_mul_ps(xx, a))));
+        __m256 c = _mm256_mul_ps(half, _mm256_mul_ps(xx, b));
+        _mm256_storeu_ps(o+i, c);
+    }
+#elif MAG_APPROXMATH && defined(__SSE2__)
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 coeff1 = _mm_set1_ps(0.79788456080286535587989211986876f);
+    __m128 coeff2 = _mm_set1_ps(MAG_GELU_COEFF);
+    for (; i+3 < numel; i += 4) {
+        __m128 xx = _mm_loadu_ps(x+i);
+        __m128 a = _mm_add_ps(one, _mm_mul_ps(coeff2, _mm_mul_ps(xx, xx)));
+        __m128 b = _mm_add_ps(one, mag_simd_tanh(_mm_mul_ps(coeff1, _mm_mul_ps(xx, a))));
+        __m128 c = _mm_mul_ps(half, _mm_mul_ps(xx, b));
+        _mm_storeu_ps(o+i, c);
+    }
+#endif
+    for (; i < numel; ++i) {
+        o[i] = 0.5f*x[i]*(1.0f + tanhf(0.79788456080286535587989211986876f*x[i]*(1.0f + MAG_GELU_COEFF*x[i]*x[i])));
+    }
+}
+
+static void MAG_HOTPROC mag_vgelu_dv_f32( /* gelu' : ℝ -> ℝ, x |-> TODO */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x
+) {
+    for (int64_t i=0; i < numel; ++i) {
+        mag_panic("NYI"); /* TODO */
+    }
+}
+
+static void mag_blas_nop(const mag_compute_payload_t* payload) { (void)payload; }
+
+static void mag_blas_clone(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    mag_assert2(mag_tensor_is_shape_eq(x, r));
+    mag_f32_t* b_r = mag_f32p_mut(r);
+    const mag_f32_t* b_x = mag_f32p(x);
+    memcpy(b_r, b_x, mag_tensor_data_size(r));
+}
+
+#define MAG_REDUCE_TILE 1024 /* Output elements of a vertical reduction accumulated at once, they stay in L1 while all reduced slices are combined. */
+
+/* o = combine(o, x) elementwise for the vertical reductions. Min and max ignore NaNs like fminf and fmaxf, written as selects so they vectorize. */
+static void MAG_HOTPROC mag_vreduce_acc_f32(mag_op_t op, int64_t numel, mag_f32_t* o, const mag_f32_t* x) {
+    switch (op) {
+        case MAG_OP_MIN:
+            for (int64_t i=0; i < numel; ++i)
+                o[i] = x[i] < o[i] || o[i] != o[i] ? x[i] : o[i];
+        break;
+        case MAG_OP_MAX:
+            for (int64_t i=0; i < numel; ++i)
+                o[i] = x[i] > o[i] || o[i] != o[i] ? x[i] : o[i];
+        break;
+        default: mag_vadd_f32(numel, o, o, x); break;
+    }
+}
+
+/*
+** Reduction of x over a subset of its axes, given by the bitmask in op_params[0]. The result is contiguous and addressed through
+** the shape of x with the reduced axes collapsed to 1, so keepdim (op_params[1]) only changes the reported shape.
+** If the contiguous axis 0 is reduced, each output element is a horizontal reduction of contiguous runs of x (mag_vsum_f64_f32, mag_vmin_f32, mag_vmax_f32).
+** Otherwise output rows are reduced vertically: each reduced slice of x is combined elementwise with a tile of the row, which vectorizes along axis 0.
+** Threads split the flat output range, so long rows are split as well.
+*/
+static void MAG_HOTPROC mag_blas_reduce_axes_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    mag_op_t op = r->op;
+    uint32_t mask = r->op_params[0].x.u32;
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    int64_t os[MAG_MAX_DIMS]; /* Output strides over the axes of x, 0 for reduced axes */
+    int64_t rn[MAG_MAX_DIMS]; /* Extents and strides of the reduced axes besides axis 0 */
+    int64_t rs[MAG_MAX_DIMS];
+    int64_t nr = 0;
+    int64_t nred = 1; /* Number of reduced slices */
+    int64_t ostride = 1;
+    for (int64_t k=0; k < MAG_MAX_DIMS; ++k) {
+        if (!(mask & (1u<<k))) {
+            os[k] = ostride;
+            ostride *= x->shape[k];
+        } else {
+            os[k] = 0;
+            if (k > 0 && x->shape[k] > 1) {
+                rn[nr] = x->shape[k];
+                rs[nr++] = x->strides[k];
+                nred *= x->shape[k];
+            }
+        }
+    }
+    int64_t d0 = x->shape[0];
+    bool horizontal = mask & 1;
+    mag_f32_t mean = (mag_f32_t)r->numel/(mag_f32_t)x->numel;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t chunk = (r->numel + tc - 1)/tc;
+    int64_t o0 = ti*chunk;
+    int64_t o1 = mag_xmin(o0 + chunk, r->numel);
+    for (int64_t o=o0; o < o1;) {
+        int64_t xo = 0; /* Offset of the first reduced element in x */
+        for (int64_t k=0; k < MAG_MAX_DIMS; ++k)
+            if (os[k]) xo += o/os[k]%x->shape[k]*x->strides[k];
+        int64_t n = horizontal ? 1 : mag_xmin(mag_xmin(d0 - o%d0, o1 - o), MAG_REDUCE_TILE); /* Output elements of this step */
+        mag_f32_t* pr = br + o;
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        int64_t idx[MAG_MAX_DIMS] = {0};
+        int64_t so = 0; /* Offset of the current reduced slice */
+        mag_f64_t sum = 0.0;
+        mag_f32_t ext = op == MAG_OP_MIN ? INFINITY : -INFINITY;
+        for (int64_t s=0; s < nred; ++s) {
+            const mag_f32_t* px = bx + xo + so;
+            mag_bnd_chk(px, bx, mag_tensor_data_size(x));
+            if (horizontal) {
+                switch (op) {
+                    case MAG_OP_MIN: ext = fminf(mag_vmin_f32(d0, px), ext); break;
+                    case MAG_OP_MAX: ext = fmaxf(mag_vmax_f32(d0, px), ext); break;
+                    default: sum += mag_vsum_f64_f32(d0, px); break;
+                }
+            } else {
+                if (!s) memcpy(pr, px, n*sizeof(*pr));
+                else mag_vreduce_acc_f32(op, n, pr, px);
+            }
+            for (int64_t k=0; k < nr; ++k) { /* Advance to the next reduced slice */
+                so += rs[k];
+                if (++idx[k] < rn[k]) break;
+                so -= rn[k]*rs[k];
+                idx[k] = 0;
+            }
+        }
+        if (horizontal) *pr = op == MAG_OP_MIN || op == MAG_OP_MAX ? ext : (mag_f32_t)(op == MAG_OP_MEAN ? sum*mean : sum);
+        else if (op == MAG_OP_MEAN) for (int64_t i=0; i < n; ++i) pr[i] *= mean;
+        o += n;
+    }
+}
+
+/*
+** Full reduction of all elements of the contiguous x to a scalar.
+** x is split into MAG_REDUCE_PARTIALS segments whose bounds only depend on numel. Workers reduce every thread_num-th segment into
+** its own cache line padded slot, and the last worker to finish combines the slots in a fixed pairwise tree.
+** So the rounding of sum and mean is the same for any thread count. Partial reductions are forwarded to mag_blas_reduce_axes_f32.
+*/
+static void MAG_HOTPROC mag_blas_reduce_full_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    if (r->numel > 1) {
+        mag_blas_reduce_axes_f32(payload);
+        return;
+    }
+    const mag_tensor_t* x = r->op_inputs[0];
+    mag_op_t op = r->op;
+    mag_f32_t* b_r = mag_f32p_mut(r);
+    const mag_f32_t* b_x = mag_f32p(x);
+    mag_reduce_partial_t* part = payload->partials;
+    int64_t numel = x->numel;
+    for (int64_t j=payload->thread_idx; j < MAG_REDUCE_PARTIALS; j += payload->thread_num) {
+        int64_t i0 = j*numel/MAG_REDUCE_PARTIALS;
+        int64_t i1 = (j+1)*numel/MAG_REDUCE_PARTIALS;
+        const mag_f32_t* p_x = b_x + i0;
+        mag_bnd_chk(p_x, b_x, mag_tensor_data_size(x));
+        switch (op) {
+            case MAG_OP_MIN: part[j].v = mag_vmin_f32(i1 - i0, p_x); break;
+            case MAG_OP_MAX: part[j].v = mag_vmax_f32(i1 - i0, p_x); break;
+            default: part[j].v = mag_vsum_f64_f32(i1 - i0, p_x); break;
+        }
+    }
+    if (mag_atomic_fetch_add(payload->cursor, 1, MAG_MO_SEQ_CST) != payload->thread_num-1) return; /* Not the last worker */
+    for (int64_t w=1; w < MAG_REDUCE_PARTIALS; w <<= 1) {
+        for (int64_t j=0; j+w < MAG_REDUCE_PARTIALS; j += w<<1) {
+            switch (op) {
+                case MAG_OP_MIN: part[j].v = fmin(part[j].v, part[j+w].v); break;
+                case MAG_OP_MAX: part[j].v = fmax(part[j].v, part[j+w].v); break;
+                default: part[j].v += part[j+w].v; break;
+            }
+        }
+    }
+    *b_r = (mag_f32_t)(op == MAG_OP_MEAN ? part->v/(mag_f64_t)numel : part->v);
+}
+
+static void MAG_HOTPROC mag_blas_mean_f32(const mag_compute_payload_t* payload) {
+    mag_blas_reduce_full_f32(payload);
+}
+
+static void MAG_HOTPROC mag_blas_min_f32(const mag_compute_payload_t* payload) {
+    mag_blas_reduce_full_f32(payload);
+}
+
+static void MAG_HOTPROC mag_blas_max_f32(const mag_compute_payload_t* payload) {
+    mag_blas_reduce_full_f32(payload);
+}
+
+static void MAG_HOTPROC mag_blas_sum_f32(const mag_compute_payload_t* payload) {
+    mag_blas_reduce_full_f32(payload);
+}
+
+/*
+** Index of the first maximum of x, or of the first minimum if neg (the search then runs on -x). NaNs never compare greater and are skipped.
+** The SIMD paths keep a vector of the best values and one of their indices, updated by compare and blend. Each lane sees ascending indices
+** and only takes strictly greater values, so it holds its first maximum, and the lowest index among the lanes with the overall maximum wins.
+*/
+static int64_t MAG_HOTPROC mag_vargmax_f32(
+    int64_t numel,
+    const mag_f32_t* x,
+    bool neg
+) {
+    mag_f32_t sgn = neg ? -1.0f : 1.0f;
+    mag_f32_t best = -INFINITY;
+    int64_t bi = 0;
+    int64_t i = 0;
+    mag_f32_t lb[16]; /* Best value and index per lane */
+    mag_i32_t li[16];
+    int nl = 0;
+#if defined(__AVX512F__)
+    if (numel >= 16) {
+        __m512i vs = _mm512_set1_epi32(neg ? INT32_MIN : 0);
+        __m512 vb = _mm512_set1_ps(-INFINITY);
+        __m512i vi = _mm512_setzero_si512();
+        __m512i vc = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        __m512i vn = _mm512_set1_epi32(16);
+        for (; i+15 < numel; i += 16) {
+            __m512 v = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_loadu_ps(x+i)), vs));
+            __mmask16 m = _mm512_cmp_ps_mask(v, vb, _CMP_GT_OQ);
+            vb = _mm512_mask_mov_ps(vb, m, v);
+            vi = _mm512_mask_mov_epi32(vi, m, vc);
+            vc = _mm512_add_epi32(vc, vn);
+        }
+        _mm512_storeu_ps(lb, vb);
+        _mm512_storeu_si512(li, vi);
+        nl = 16;
+    }
+#elif defined(__AVX2__)
+    if (numel >= 8) {
+        __m256 vs = _mm256_castsi256_ps(_mm256_set1_epi32(neg ? INT32_MIN : 0));
+        __m256 vb = _mm256_set1_ps(-INFINITY);
+        __m256 vi = _mm256_setzero_ps(); /* Indices as raw int32 bits, so they can be blended like the values */
+        __m256i vc = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i vn = _mm256_set1_epi32(8);
+        for (; i+7 < numel; i += 8) {
+            __m256 v = _mm256_xor_ps(_mm256_loadu_ps(x+i), vs);
+            __m256 m = _mm256_cmp_ps(v, vb, _CMP_GT_OQ);
+            vb = _mm256_blendv_ps(vb, v, m);
+            vi = _mm256_blendv_ps(vi, _mm256_castsi256_ps(vc), m);
+            vc = _mm256_add_epi32(vc, vn);
+        }
+        _mm256_storeu_ps(lb, vb);
+        _mm256_storeu_si256((__m256i*)li, _mm256_castps_si256(vi));
+        nl = 8;
+    }
+#elif defined(__SSE2__)
+    if (numel >= 4) {
+        __m128 vs = _mm_castsi128_ps(_mm_set1_epi32(neg ? INT32_MIN : 0));
+        __m128 vb = _mm_set1_ps(-INFINITY);
+        __m128i vi = _mm_setzero_si128();
+        __m128i vc = _mm_setr_epi32(0, 1, 2, 3);
+        __m128i vn = _mm_set1_epi32(4);
+        for (; i+3 < numel; i += 4) {
+            __m128 v = _mm_xor_ps(_mm_loadu_ps(x+i), vs);
+            __m128 m = _mm_cmpgt_ps(v, vb);
+            __m128i mi = _mm_castps_si128(m);
+            vb = _mm_or_ps(_mm_and_ps(m, v), _mm_andnot_ps(m, vb));
+            vi = _mm_or_si128(_mm_and_si128(mi, vc), _mm_andnot_si128(mi, vi));
+            vc = _mm_add_epi32(vc, vn);
+        }
+        _mm_storeu_ps(lb, vb);
+        _mm_storeu_si128((__m128i*)li, vi);
+        nl = 4;
+    }
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    if (numel >= 4) {
+        uint32x4_t vs = vdupq_n_u32(neg ? 0x80000000u : 0);
+        float32x4_t vb = vdupq_n_f32(-INFINITY);
+        int32x4_t vi = vdupq_n_s32(0);
+        int32x4_t vc = {0, 1, 2, 3};
+        int32x4_t vn = vdupq_n_s32(4);
+        for (; i+3 < numel; i += 4) {
+            float32x4_t v = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vld1q_f32(x+i)), vs));
+            uint32x4_t m = vcgtq_f32(v, vb);
+            vb = vbslq_f32(m, v, vb);
+            vi = vbslq_s32(m, vc, vi);
+            vc = vaddq_s32(vc, vn);
+        }
+        vst1q_f32(lb, vb);
+        vst1q_s32(li, vi);
+        nl = 4;
+    }
+#endif
+    for (int l=0; l < nl; ++l) { /* Combine lanes: largest value, lowest index on ties */
+        if (lb[l] > best || (lb[l] == best && li[l] < bi)) {
+            best = lb[l];
+            bi = li[l];
+        }
+    }
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        mag_f32_t v = sgn*x[i];
+        if (v > best) {
+            best = v;
+            bi = i;
+        }
+    }
+    if (best == -INFINITY) /* Nothing was greater than the initial -inf: the first -inf if any, otherwise all NaN */
+        for (bi=0; bi < numel && sgn*x[bi] != -INFINITY; ++bi);
+    return bi < numel ? bi : 0;
+}
+
+/*
+** Argmax and argmin along the axis in op_params[0]. x is viewed as [outer, n, inner] with n the extent of the axis and inner the product of the faster axes.
+** If the axis is the contiguous axis 0 (inner = 1), each output is a horizontal search with mag_vargmax_f32.
+** Otherwise a tile of inner elements keeps its best values and indices while the n slices stream by, which vectorizes along inner.
+*/
+static void MAG_HOTPROC mag_blas_argreduce_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    int64_t axis = r->op_params[0].x.u32;
+    bool neg = r->op == MAG_OP_ARGMIN;
+    mag_f32_t sgn = neg ? -1.0f : 1.0f;
+    mag_i32_t* br = mag_i32p_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    int64_t inner = 1;
+    for (int64_t k=0; k < axis; ++k) inner *= x->shape[k];
+    int64_t n = x->shape[axis];
+    int64_t outer = x->numel/(inner*n);
+    int64_t tiles = (inner + MAG_REDUCE_TILE - 1)/MAG_REDUCE_TILE;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t work = outer*tiles;
+    int64_t chunk = (work + tc - 1)/tc;
+    int64_t w1 = mag_xmin((ti+1)*chunk, work);
+    mag_f32_t bv[MAG_REDUCE_TILE];
+    for (int64_t w=ti*chunk; w < w1; ++w) {
+        int64_t o = w/tiles;
+        int64_t i0 = w%tiles*MAG_REDUCE_TILE;
+        int64_t ni = mag_xmin(inner - i0, MAG_REDUCE_TILE);
+        const mag_f32_t* px = bx + o*n*inner + i0;
+        mag_i32_t* pr = br + o*inner + i0;
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        if (inner == 1) {
+            *pr = (mag_i32_t)mag_vargmax_f32(n, px, neg);
+            continue;
+        }
+        for (int64_t i=0; i < ni; ++i) {
+            bv[i] = sgn*px[i];
+            pr[i] = 0;
+        }
+        for (int64_t j=1; j < n; ++j) {
+            const mag_f32_t* ps = px + j*inner;
+            mag_bnd_chk(ps, bx, mag_tensor_data_size(x));
+            for (int64_t i=0; i < ni; ++i) { /* Take greater values, and any number over a NaN */
+                mag_f32_t v = sgn*ps[i];
+                bool m = v > bv[i] || (bv[i] != bv[i] && v == v);
+                bv[i] = m ? v : bv[i];
+                pr[i] = m ? (mag_i32_t)j : pr[i];
+            }
+        }
+    }
+}
+
+/* True if any of the 16 elements at x is >= y. NaNs compare false. */
+static MAG_AINLINE bool mag_vany_ge16_f32(const mag_f32_t* x, mag_f32_t y) {
+#if defined(__AVX512F__)
+    return _mm512_cmp_ps_mask(_mm512_loadu_ps(x), _mm512_set1_ps(y), _CMP_GE_OQ) != 0;
+#elif defined(__AVX__)
+    __m256 vy = _mm256_set1_ps(y);
+    __m256 m = _mm256_or_ps(_mm256_cmp_ps(_mm256_loadu_ps(x), vy, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(x+8), vy, _CMP_GE_OQ));
+    return _mm256_movemask_ps(m) != 0;
+#elif defined(__SSE2__)
+    __m128 vy = _mm_set1_ps(y);
+    __m128 m0 = _mm_or_ps(_mm_cmpge_ps(_mm_loadu_ps(x), vy), _mm_cmpge_ps(_mm_loadu_ps(x+4), vy));
+    __m128 m1 = _mm_or_ps(_mm_cmpge_ps(_mm_loadu_ps(x+8), vy), _mm_cmpge_ps(_mm_loadu_ps(x+12), vy));
+    return _mm_movemask_ps(_mm_or_ps(m0, m1)) != 0;
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vy = vdupq_n_f32(y);
+    uint32x4_t m0 = vorrq_u32(vcgeq_f32(vld1q_f32(x), vy), vcgeq_f32(vld1q_f32(x+4), vy));
+    uint32x4_t m1 = vorrq_u32(vcgeq_f32(vld1q_f32(x+8), vy), vcgeq_f32(vld1q_f32(x+12), vy));
+    return vmaxvq_u32(vorrq_u32(m0, m1)) != 0;
+#else
+    bool any = false;
+    for (int i=0; i < 16; ++i) any |= x[i] >= y;
+    return any;
+#endif
+}
+
+/* Top-k candidate. key orders all floats as integers, with NaN below -inf and -0 equal to +0. */
+typedef struct mag_topk_entry_t {
+    int32_t key;
+    int32_t idx;
+} mag_topk_entry_t;
+
+static MAG_AINLINE int32_t mag_topk_key(mag_f32_t x) {
+    if (x != x) return INT32_MIN;
+    x += 0.0f; /* -0 + 0 = +0, so both zeros tie like they compare */
+    int32_t b;
+    memcpy(&b, &x, sizeof(b));
+    return b ^ ((b>>31) & 0x7fffffff); /* Flip the magnitude of negative numbers, so larger floats have larger keys */
+}
+
+static MAG_AINLINE bool mag_topk_worse(mag_topk_entry_t a, mag_topk_entry_t b) { /* Lower value, or the same value at a later index */
+    return a.key < b.key || (a.key == b.key && a.idx > b.idx);
+}
+
+static void mag_topk_sift_down(mag_topk_entry_t* h, int64_t k, int64_t i) { /* Restore the heap with the worst entry on top */
+    for (;;) {
+        int64_t c = (i<<1) + 1;
+        if (c >= k) break;
+        if (c+1 < k && mag_topk_worse(h[c+1], h[c])) ++c;
+        if (!mag_topk_worse(h[c], h[i])) break;
+        mag_topk_entry_t t = h[c];
+        h[c] = h[i];
+        h[i] = t;
+        i = c;
+    }
+}
+
+/*
+** Partial selection of the k largest elements of the contiguous row x of length n, written to o in descending order.
+** A heap keeps the current k best with the worst on top. A new element only enters if it beats the top, so for k << n almost all
+** elements are rejected, a block of 16 at once by a single SIMD compare against the top value.
+*/
+static void MAG_HOTPROC mag_vtopk_f32(int64_t n, const mag_f32_t* x, int64_t k, mag_topk_entry_t* h, mag_i32_t* o) {
+    for (int64_t i=0; i < k; ++i)
+        h[i] = (mag_topk_entry_t){.key = mag_topk_key(x[i]), .idx = (int32_t)i};
+    for (int64_t i=(k>>1)-1; i >= 0; --i)
+        mag_topk_sift_down(h, k, i);
+    mag_f32_t thr = h->key == INT32_MIN ? -INFINITY : x[h->idx]; /* Everything below the top is rejected */
+    for (int64_t i=k; i < n;) {
+        if (i+16 <= n && !mag_vany_ge16_f32(x+i, thr)) {
+            i += 16;
+            continue;
+        }
+        for (int64_t e=mag_xmin(i+16, n); i < e; ++i) {
+            int32_t key = mag_topk_key(x[i]);
+            if (key <= h->key) continue; /* Ties keep the earlier index */
+            *h = (mag_topk_entry_t){.key = key, .idx = (int32_t)i};
+            mag_topk_sift_down(h, k, 0);
+            thr = h->key == INT32_MIN ? -INFINITY : x[h->idx];
+        }
+    }
+    for (int64_t j=k-1; j >= 0; --j) { /* Pop the worst entries into the back */
+        o[j] = h->idx;
+        *h = h[j];
+        mag_topk_sift_down(h, j, 0);
+    }
+}
+
+/* Top-k indices along the axis in op_params[1]. Rows along other axes than the contiguous axis 0 are copied into a contiguous buffer first. */
+static void MAG_HOTPROC mag_blas_topk_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    int64_t k = r->op_params[0].x.u32;
+    int64_t axis = r->op_params[1].x.u32;
+    mag_i32_t* br = mag_i32p_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    int64_t inner = 1;
+    for (int64_t a=0; a < axis; ++a) inner *= x->shape[a];
+    int64_t n = x->shape[axis];
+    int64_t rows = x->numel/n;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t chunk = (rows + tc - 1)/tc;
+    int64_t r0 = ti*chunk;
+    int64_t r1 = mag_xmin(r0 + chunk, rows);
+    if (r0 >= r1) return;
+    mag_topk_entry_t* h = mag_alloc_aligned(k*sizeof(*h), MAG_CACHE_LINE_SIZE);
+    mag_f32_t* row = inner > 1 ? mag_alloc_aligned(n*sizeof(*row), MAG_CACHE_LINE_SIZE) : NULL;
+    mag_i32_t* out = inner > 1 ? mag_alloc_aligned(k*sizeof(*out), MAG_CACHE_LINE_SIZE) : NULL;
+    for (int64_t ri=r0; ri < r1; ++ri) {
+        int64_t o = ri/inner;
+        int64_t i = ri%inner;
+        const mag_f32_t* px = bx + o*n*inner + i;
+        mag_i32_t* pr = br + o*k*inner + i;
+        mag_bnd_chk(px, bx, mag_tensor_data_size(x));
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        if (inner == 1) {
+            mag_vtopk_f32(n, px, k, h, pr);
+            continue;
+        }
+        for (int64_t j=0; j < n; ++j) row[j] = px[j*inner];
+        mag_vtopk_f32(n, row, k, h, out);
+        for (int64_t j=0; j < k; ++j) pr[j*inner] = out[j];
+    }
+    mag_free_aligned(h);
+    if (row) mag_free_aligned(row);
+    if (out) mag_free_aligned(out);
+}
+
+/* r[o, j, i] = x[o, index[o, j, i], i] with the gathered axis in the middle, like mag_blas_argreduce_f32. Threads split the rows o, j. */
+static void MAG_HOTPROC mag_blas_gather_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    const mag_tensor_t* index = r->op_inputs[1];
+    int64_t axis = r->op_params[0].x.u32;
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    const mag_i32_t* bi = mag_i32p(index);
+    int64_t inner = 1;
+    for (int64_t a=0; a < axis; ++a) inner *= x->shape[a];
+    int64_t n = x->shape[axis];
+    int64_t m = index->shape[axis];
+    int64_t rows = r->numel/inner;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t chunk = (rows + tc - 1)/tc;
+    int64_t r0 = ti*chunk;
+    int64_t r1 = mag_xmin(r0 + chunk, rows);
+    for (int64_t ri=r0; ri < r1; ++ri) {
+        const mag_f32_t* px = bx + ri/m*n*inner;
+        const mag_i32_t* pi = bi + ri*inner;
+        mag_f32_t* pr = br + ri*inner;
+        for (int64_t i=0; i < inner; ++i) {
+            int64_t j = mag_xmin(mag_xmax(pi[i], 0), n-1); /* Indices computed in deferred graphs skip validation, clamp them */
+            pr[i] = px[j*inner + i];
+        }
+    }
+}
+
+/*
+** Σ(x-c) and Σ(x-c)² accumulated in F64, in a single pass over x.
+** Shifting by a sample c of x (its first element) keeps the variance Σ(x-c)²/n - (Σ(x-c)/n)² from cancelling when |mean| >> std.
+*/
+static void MAG_HOTPROC mag_vmoments_f64_f32(
+    int64_t numel,
+    const mag_f32_t* x,
+    mag_f64_t c,
+    mag_f64_t* s1,
+    mag_f64_t* s2
+) {
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    int64_t k = numel & -4;
+    float64x2_t vc = vdupq_n_f64(c);
+    float64x2_t a1[2] = {vdupq_n_f64(0), vdupq_n_f64(0)};
+    float64x2_t a2[2] = {vdupq_n_f64(0), vdupq_n_f64(0)};
+    for (int64_t i=0; i < k; i += 4) {
+        float32x4_t v = vld1q_f32(x+i);
+        float64x2_t d0 = vsubq_f64(vcvt_f64_f32(vget_low_f32(v)), vc);
+        float64x2_t d1 = vsubq_f64(vcvt_high_f64_f32(v), vc);
+        a1[0] = vaddq_f64(a1[0], d0);
+        a1[1] = vaddq_f64(a1[1], d1);
+        a2[0] = vfmaq_f64(a2[0], d0, d0);
+        a2[1] = vfmaq_f64(a2[1], d1, d1);
+    }
+    mag_f64_t sum1 = vaddvq_f64(vaddq_f64(a1[0], a1[1]));
+    mag_f64_t sum2 = vaddvq_f64(vaddq_f64(a2[0], a2[1]));
+#elif defined(__AVX512F__)
+    int64_t k = numel & -16;
+    __m512d vc = _mm512_set1_pd(c);
+    __m512d a1[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    __m512d a2[2] = {_mm512_setzero_pd(), _mm512_setzero_pd()};
+    for (int64_t i=0; i < k; i += 16) {
+        __m512d d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(x+i)), vc);
+        __m512d d1 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(x+i+8)), vc);
+        a1[0] = _mm512_add_pd(a1[0], d0);
+        a1[1] = _mm512_add_pd(a1[1], d1);
+        a2[0] = _mm512_fmadd_pd(d0, d0, a2[0]);
+        a2[1] = _mm512_fmadd_pd(d1, d1, a2[1]);
+    }
+    mag_f64_t sum1 = _mm512_reduce_add_pd(_mm512_add_pd(a1[0], a1[1]));
+    mag_f64_t sum2 = _mm512_reduce_add_pd(_mm512_add_pd(a2[0], a2[1]));
+#elif defined(__AVX__)
+    int64_t k = numel & -8;
+    __m256d vc = _mm256_set1_pd(c);
+    __m256d a1[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d a2[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    for (int64_t i=0; i < k; i += 8) {
+        __m256d d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(x+i)), vc);
+        __m256d d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(x+i+4)), vc);
+        a1[0] = _mm256_add_pd(a1[0], d0);
+        a1[1] = _mm256_add_pd(a1[1], d1);
+#ifdef __FMA__
+        a2[0] = _mm256_fmadd_pd(d0, d0, a2[0]);
+        a2[1] = _mm256_fmadd_pd(d1, d1, a2[1]);
+#else
+        a2[0] = _mm256_add_pd(a2[0], _mm256_mul_pd(d0, d0));
+        a2[1] = _mm256_add_pd(a2[1], _mm256_mul_pd(d1, d1));
+#endif
+    }
+    a1[0] = _mm256_add_pd(a1[0], a1[1]);
+    a2[0] = _mm256_add_pd(a2[0], a2[1]);
+    __m128d v1 = _mm_add_pd(_mm256_castpd256_pd128(a1[0]), _mm256_extractf128_pd(a1[0], 1));
+    __m128d v2 = _mm_add_pd(_mm256_castpd256_pd128(a2[0]), _mm256_extractf128_pd(a2[0], 1));
+    mag_f64_t sum1 = _mm_cvtsd_f64(_mm_add_sd(v1, _mm_unpackhi_pd(v1, v1)));
+    mag_f64_t sum2 = _mm_cvtsd_f64(_mm_add_sd(v2, _mm_unpackhi_pd(v2, v2)));
+#elif defined(__SSE2__)
+    int64_t k = numel & -4;
+    __m128d vc = _mm_set1_pd(c);
+    __m128d a1[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    __m128d a2[2] = {_mm_setzero_pd(), _mm_setzero_pd()};
+    for (int64_t i=0; i < k; i += 4) {
+        __m128 v = _mm_loadu_ps(x+i);
+        __m128d d0 = _mm_sub_pd(_mm_cvtps_pd(v), vc);
+        __m128d d1 = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), vc);
+        a1[0] = _mm_add_pd(a1[0], d0);
+        a1[1] = _mm_add_pd(a1[1], d1);
+        a2[0] = _mm_add_pd(a2[0], _mm_mul_pd(d0, d0));
+        a2[1] = _mm_add_pd(a2[1], _mm_mul_pd(d1, d1));
+    }
+    a1[0] = _mm_add_pd(a1[0], a1[1]);
+    a2[0] = _mm_add_pd(a2[0], a2[1]);
+    mag_f64_t sum1 = _mm_cvtsd_f64(_mm_add_sd(a1[0], _mm_unpackhi_pd(a1[0], a1[0])));
+    mag_f64_t sum2 = _mm_cvtsd_f64(_mm_add_sd(a2[0], _mm_unpackhi_pd(a2[0], a2[0])));
+#else
+    int64_t k = 0;
+    mag_f64_t sum1 = 0.0, sum2 = 0.0;
+#endif
+    for (int64_t i=k; i < numel; ++i) { /* Process leftovers scalar-wise */
+        mag_f64_t d = (mag_f64_t)x[i] - c;
+        sum1 += d;
+        sum2 += d*d;
+    }
+    *s1 = sum1;
+    *s2 = sum2;
+}
+
+static void MAG_HOTPROC mag_vnorm_f32( /* o = ((x - c) - m)*rstd*w + b with mean c + m split like in mag_vmoments_f64_f32, w and b may be NULL */
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x,
+    mag_f32_t c,
+    mag_f32_t m,
+    mag_f32_t rstd,
+    const mag_f32_t* w,
+    const mag_f32_t* b
+) { /* Branch outside of the loops, so each one is a plain vectorizable stream */
+    if (w && b) for (int64_t i=0; i < numel; ++i) o[i] = ((x[i] - c) - m)*rstd*w[i] + b[i];
+    else if (w) for (int64_t i=0; i < numel; ++i) o[i] = ((x[i] - c) - m)*rstd*w[i];
+    else if (b) for (int64_t i=0; i < numel; ++i) o[i] = ((x[i] - c) - m)*rstd + b[i];
+    else for (int64_t i=0; i < numel; ++i) o[i] = ((x[i] - c) - m)*rstd;
+}
+
+/*
+** LayerNorm (MAG_OP_LAYER_NORM) and RMSNorm (MAG_OP_RMS_NORM) of the contiguous rows along axis 0.
+** Params: eps, bitmask of the present affine inputs: weight (1) in slot 1, bias (2) in slot 2. Threads split the rows.
+** Each row is read twice: once for its F64 moments and once to normalize, the second read mostly hits the cache.
+** x - c is exact for the values near the shift c = x[0], so rows with |mean| >> std keep their precision in F32 as well.
+*/
+static void MAG_HOTPROC mag_blas_norm_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    bool rms = r->op == MAG_OP_RMS_NORM;
+    mag_f64_t eps = (mag_f64_t)r->op_params[0].x.f32;
+    uint32_t affine = r->op_params[1].x.u32;
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    const mag_f32_t* bw = affine & 1 ? mag_f32p(r->op_inputs[1]) : NULL;
+    const mag_f32_t* bb = affine & 2 ? mag_f32p(r->op_inputs[1 + (affine & 1)]) : NULL; /* Present affine inputs are packed after x */
+    int64_t cols = *x->shape;
+    int64_t rows = x->numel/cols;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t chunk = (rows + tc - 1)/tc;
+    int64_t ra = ti*chunk;
+    int64_t rb = mag_xmin(ra + chunk, rows);
+    for (int64_t i=ra; i < rb; ++i) {
+        mag_f32_t* pr = br + i*cols;
+        const mag_f32_t* px = bx + i*cols;
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        mag_bnd_chk(px, bx, mag_tensor_data_size(x));
+        mag_f32_t c = rms ? 0.0f : *px;
+        mag_f64_t s1, s2;
+        mag_vmoments_f64_f32(cols, px, c, &s1, &s2);
+        mag_f64_t m = rms ? 0.0 : s1/(mag_f64_t)cols;
+        mag_f64_t var = mag_xmax(s2/(mag_f64_t)cols - m*m, 0.0); /* Mean square for RMSNorm */
+        mag_vnorm_f32(cols, pr, px, c, (mag_f32_t)m, (mag_f32_t)(1.0/sqrt(var + eps)), bw, bb);
+    }
+}
+
+/*
+** Inclusive scan of x into o, continuing from carry: o[i] = carry ∘ x[0] ∘ ... ∘ x[i] with ∘ = + or × (prod). Returns the last o.
+** Each vector is scanned in-register in log2(lanes) steps: shift the lanes up by 1, 2, 4, ... filling in the identity and combine.
+** Then the broadcast carry is combined in and the last lane becomes the next carry. The additive identity is -0, so x + id = x also for x = -0.
+** Always inlined with a constant prod, so the op selection folds away.
+*/
+static MAG_AINLINE mag_f32_t mag_vscan_f32(
+    int64_t numel,
+    mag_f32_t* o,
+    const mag_f32_t* x,
+    mag_f32_t carry,
+    bool prod
+) {
+    mag_f32_t id = prod ? 1.0f : -0.0f;
+    int64_t i=0;
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    float32x4_t vid = vdupq_n_f32(id);
+    float32x4_t c = vdupq_n_f32(carry);
+    for (; i+3 < numel; i += 4) {
+        float32x4_t v = vld1q_f32(x+i);
+        float32x4_t s = vextq_f32(vid, v, 3);
+        v = prod ? vmulq_f32(v, s) : vaddq_f32(v, s);
+        s = vextq_f32(vid, v, 2);
+        v = prod ? vmulq_f32(v, s) : vaddq_f32(v, s);
+        v = prod ? vmulq_f32(v, c) : vaddq_f32(v, c);
+        vst1q_f32(o+i, v);
+        c = vdupq_laneq_f32(v, 3);
+    }
+    carry = vgetq_lane_f32(c, 0);
+#elif defined(__AVX512F__)
+    __m512i vid = _mm512_castps_si512(_mm512_set1_ps(id));
+    __m512 c = _mm512_set1_ps(carry);
+    __m512i last = _mm512_set1_epi32(15);
+    for (; i+15 < numel; i += 16) {
+        __m512 v = _mm512_loadu_ps(x+i);
+        __m512 s = _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), vid, 15)); /* Lanes up by 1 */
+        v = prod ? _mm512_mul_ps(v, s) : _mm512_add_ps(v, s);
+        s = _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), vid, 14));
+        v = prod ? _mm512_mul_ps(v, s) : _mm512_add_ps(v, s);
+        s = _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), vid, 12));
+        v = prod ? _mm512_mul_ps(v, s) : _mm512_add_ps(v, s);
+        s = _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v), vid, 8));
+        v = prod ? _mm512_mul_ps(v, s) : _mm512_add_ps(v, s);
+        v = prod ? _mm512_mul_ps(v, c) : _mm512_add_ps(v, c);
+        _mm512_storeu_ps(o+i, v);
+        c = _mm512_permutexvar_ps(last, v);
+    }
+    carry = _mm512_cvtss_f32(c);
+#elif defined(__AVX2__)
+    __m256i id1 = _mm256_castps_si256(_mm256_setr_ps(id, 0.0f, 0.0f, 0.0f, id, 0.0f, 0.0f, 0.0f)); /* Identity bits for the lanes vacated by the shifts, 0 bits elsewhere */
+    __m256i id2 = _mm256_castps_si256(_mm256_setr_ps(id, id, 0.0f, 0.0f, id, id, 0.0f, 0.0f));
+    __m256 id4 = _mm256_setr_ps(id, id, id, id, 0.0f, 0.0f, 0.0f, 0.0f);
+    __m256 c = _mm256_set1_ps(carry);
+    for (; i+7 < numel; i += 8) {
+        __m256 v = _mm256_loadu_ps(x+i);
+        __m256 s = _mm256_castsi256_ps(_mm256_or_si256(_mm256_slli_si256(_mm256_castps_si256(v), 4), id1)); /* Lanes up by 1 within each half */
+        v = prod ? _mm256_mul_ps(v, s) : _mm256_add_ps(v, s);
+        s = _mm256_castsi256_ps(_mm256_or_si256(_mm256_slli_si256(_mm256_castps_si256(v), 8), id2));
+        v = prod ? _mm256_mul_ps(v, s) : _mm256_add_ps(v, s);
+        s = _mm256_permute2f128_ps(v, v, 0x08); /* Low half to the high half, zero low half */
+        s = _mm256_or_ps(_mm256_shuffle_ps(s, s, 0xff), id4); /* Broadcast the low half total */
+        v = prod ? _mm256_mul_ps(v, s) : _mm256_add_ps(v, s);
+        v = prod ? _mm256_mul_ps(v, c) : _mm256_add_ps(v, c);
+        _mm256_storeu_ps(o+i, v);
+        c = _mm256_permute2f128_ps(v, v, 0x11);
+        c = _mm256_shuffle_ps(c, c, 0xff);
+    }
+    carry = _mm256_cvtss_f32(c);
+#elif defined(__SSE2__)
+    __m128i id1 = _mm_castps_si128(_mm_setr_ps(id, 0.0f, 0.0f, 0.0f));
+    __m128i id2 = _mm_castps_si128(_mm_setr_ps(id, id, 0.0f, 0.0f));
+    __m128 c = _mm_set1_ps(carry);
+    for (; i+3 < numel; i += 4) {
+        __m128 v = _mm_loadu_ps(x+i);
+        __m128 s = _mm_castsi128_ps(_mm_or_si128(_mm_slli_si128(_mm_castps_si128(v), 4), id1));
+        v = prod ? _mm_mul_ps(v, s) : _mm_add_ps(v, s);
+        s = _mm_castsi128_ps(_mm_or_si128(_mm_slli_si128(_mm_castps_si128(v), 8), id2));
+        v = prod ? _mm_mul_ps(v, s) : _mm_add_ps(v, s);
+        v = prod ? _mm_mul_ps(v, c) : _mm_add_ps(v, c);
+        _mm_storeu_ps(o+i, v);
+        c = _mm_shuffle_ps(v, v, 0xff);
+    }
+    carry = _mm_cvtss_f32(c);
+#endif
+    for (; i < numel; ++i) { /* Process leftovers scalar-wise */
+        carry = prod ? carry*x[i] : carry + x[i];
+        o[i] = carry;
+    }
+    return carry;
+}
+
+/*
+** Inclusive scan along the axis in op_params[0]: cumulative sum (MAG_OP_CUMSUM) or product (MAG_OP_CUMPROD), x viewed as [outer, n, inner].
+** Contiguous rows (axis 0) are scanned with mag_vscan_f32, one row per work item. With fewer rows than threads, each row is split into one block per thread instead:
+** every thread scans its block and publishes the block total in payload->partials, then after a barrier folds the totals of the blocks before it into its own.
+** Other axes scan whole slices, o[j] = o[j-1] ∘ x[j], over vertical tiles of MAG_REDUCE_TILE elements like mag_blas_argreduce_f32, so o[j-1] stays in L1.
+*/
+static void MAG_HOTPROC mag_blas_scan_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    int64_t axis = r->op_params[0].x.u32;
+    bool prod = r->op == MAG_OP_CUMPROD;
+    mag_f32_t id = prod ? 1.0f : -0.0f;
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    int64_t inner = 1;
+    for (int64_t k=0; k < axis; ++k) inner *= x->shape[k];
+    int64_t n = x->shape[axis];
+    int64_t outer = x->numel/(inner*n);
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    if (inner == 1 && outer < tc && outer*tc <= MAG_REDUCE_PARTIALS) {
+        mag_reduce_partial_t* part = payload->partials;
+        int64_t b0 = ti*n/tc;
+        int64_t b1 = (ti+1)*n/tc;
+        for (int64_t o=0; o < outer; ++o) {
+            mag_f32_t* pr = br + o*n + b0;
+            const mag_f32_t* px = bx + o*n + b0;
+            mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+            part[o*tc + ti].v = prod ? mag_vscan_f32(b1 - b0, pr, px, id, true) : mag_vscan_f32(b1 - b0, pr, px, id, false);
+        }
+        mag_atomic_fetch_add(payload->cursor, 1, MAG_MO_SEQ_CST);
+        while (mag_atomic_load(payload->cursor, MAG_MO_SEQ_CST) < tc) /* Barrier: wait for all block totals */
+            mag_thread_yield();
+        if (!ti) return; /* The first block has nothing before it */
+        for (int64_t o=0; o < outer; ++o) {
+            mag_f32_t c = id;
+            for (int64_t j=0; j < ti; ++j)
+                c = prod ? c*(mag_f32_t)part[o*tc + j].v : c + (mag_f32_t)part[o*tc + j].v;
+            mag_f32_t* pr = br + o*n + b0;
+            if (prod) mag_vmuls_f32(b1 - b0, pr, pr, c);
+            else mag_vadds_f32(b1 - b0, pr, pr, c);
+        }
+        return;
+    }
+    int64_t tiles = (inner + MAG_REDUCE_TILE - 1)/MAG_REDUCE_TILE;
+    int64_t work = outer*tiles;
+    int64_t chunk = (work + tc - 1)/tc;
+    int64_t w1 = mag_xmin((ti+1)*chunk, work);
+    for (int64_t w=ti*chunk; w < w1; ++w) {
+        int64_t o = w/tiles;
+        int64_t i0 = w%tiles*MAG_REDUCE_TILE;
+        int64_t ni = mag_xmin(inner - i0, MAG_REDUCE_TILE);
+        const mag_f32_t* px = bx + o*n*inner + i0;
+        mag_f32_t* pr = br + o*n*inner + i0;
+        mag_bnd_chk(pr + (n-1)*inner, br, mag_tensor_data_size(r));
+        if (inner == 1) {
+            if (prod) mag_vscan_f32(n, pr, px, id, true);
+            else mag_vscan_f32(n, pr, px, id, false);
+            continue;
+        }
+        memcpy(pr, px, ni*sizeof(*pr));
+        for (int64_t j=1; j < n; ++j) {
+            if (prod) mag_vmul_f32(ni, pr + j*inner, pr + (j-1)*inner, px + j*inner);
+            else mag_vadd_f32(ni, pr + j*inner, pr + (j-1)*inner, px + j*inner);
+        }
+    }
+}
+
+#define MAG_FUSED_TILE 256 /* Elements per register of a fused program, MAG_FUSED_MAX_REGS + MAG_FUSED_MAX_INPUTS tiles stay within L1 */
+
+static void (*const mag_fused_unary_f32[MAG_OP__NUM])(int64_t, mag_f32_t*, const mag_f32_t*) = {
+    [MAG_OP_ABS] = &mag_vabs_f32,
+    [MAG_OP_NEG] = &mag_vneg_f32,
+    [MAG_OP_LOG] = &mag_vlog_f32,
+    [MAG_OP_SQR] = &mag_vsqr_f32,
+    [MAG_OP_SQRT] = &mag_vsqrt_f32,
+    [MAG_OP_SIN] = &mag_vsin_f32,
+    [MAG_OP_COS] = &mag_vcos_f32,
+    [MAG_OP_STEP] = &mag_vstep_f32,
+    [MAG_OP_SOFTMAX_DV] = &mag_vsoftmax_dv_f32,
+    [MAG_OP_SIGMOID] = &mag_vsigmoid_f32,
+    [MAG_OP_SIGMOID_DV] = &mag_vsigmoid_dv_f32,
+    [MAG_OP_HARD_SIGMOID] = &mag_vhard_sigmoid_f32,
+    [MAG_OP_SILU] = &mag_vsilu_f32,
+    [MAG_OP_SILU_DV] = &mag_vsilu_dv_f32,
+    [MAG_OP_TANH] = &mag_vtanh_f32,
+    [MAG_OP_TANH_DV] = &mag_vtanh_dv_f32,
+    [MAG_OP_RELU] = &mag_vrelu_f32,
+    [MAG_OP_RELU_DV] = &mag_vrelu_dv_f32,
+    [MAG_OP_GELU] = &mag_vgelu_f32,
+    [MAG_OP_GELU_DV] = &mag_vgelu_dv_f32,
+};
+
+static void (*const mag_fused_binary_f32[MAG_OP__NUM])(int64_t, mag_f32_t*, const mag_f32_t*, const mag_f32_t*) = {
+    [MAG_OP_ADD] = &mag_vadd_f32,
+    [MAG_OP_SUB] = &mag_vsub_f32,
+    [MAG_OP_MUL] = &mag_vmul_f32,
+    [MAG_OP_DIV] = &mag_vdiv_f32,
+};
+
+static void (*const mag_fused_scalar_f32[MAG_OP__NUM])(int64_t, mag_f32_t*, const mag_f32_t*, mag_f32_t) = {
+    [MAG_OP_ADDS] = &mag_vadds_f32,
+    [MAG_OP_SUBS] = &mag_vsubs_f32,
+    [MAG_OP_MULS] = &mag_vmuls_f32,
+    [MAG_OP_DIVS] = &mag_vdivs_f32,
+};
+
+/*
+** Fused elementwise program (see mag_fused_program_t). The iteration space of the result and all leaves is collapsed like in mag_collapse_dims,
+** rows are split over the threads like mag_cpu_blas_impl_binary. Each row is processed in MAG_FUSED_TILE chunks: leaves are used in place when unit strided,
+** splat once per row when broadcast along it and gathered otherwise. Every instruction is one vector routine call on L1 resident tiles,
+** the last one writes the result directly.
+*/
+static void MAG_HOTPROC mag_blas_fused_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_fused_program_t* p = r->fused;
+    mag_f32_t* br = mag_f32p_mut(r);
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    uint32_t ni = p->num_inputs;
+    const mag_f32_t* bl[MAG_FUSED_MAX_INPUTS];
+    for (uint32_t j=0; j < ni; ++j) bl[j] = mag_f32p(p->inputs[j]);
+    int64_t nd = 0;
+    int64_t d[MAG_MAX_DIMS], rs[MAG_MAX_DIMS], ls[MAG_FUSED_MAX_INPUTS][MAG_MAX_DIMS];
+    for (int64_t i=0; i < MAG_MAX_DIMS; ++i) {
+        int64_t n = r->shape[i];
+        if (n == 1) continue;
+        bool merge = nd && rs[nd-1]*d[nd-1] == r->strides[i];
+        for (uint32_t j=0; merge && j < ni; ++j) merge = ls[j][nd-1]*d[nd-1] == p->strides[j][i];
+        if (merge) {
+            d[nd-1] *= n;
+            continue;
+        }
+        d[nd] = n;
+        rs[nd] = r->strides[i];
+        for (uint32_t j=0; j < ni; ++j) ls[j][nd] = p->strides[j][i];
+        ++nd;
+    }
+    if (!nd) {
+        *d = *rs = 1;
+        for (uint32_t j=0; j < ni; ++j) ls[j][0] = 1;
+        nd = 1;
+    }
+    int64_t n0 = *d, rs0 = *rs;
+    int64_t rows = r->numel/n0;
+    int64_t np = rows < tc ? (tc + rows - 1)/rows : 1; /* Pieces per row */
+    int64_t seg = (n0 + np - 1)/np;
+    int64_t work = rows*np;
+    int64_t chunk = (work + tc - 1)/tc;
+    int64_t wa = ti*chunk;
+    int64_t wb = mag_xmin(wa + chunk, work);
+    if (mag_unlikely(wa >= wb)) return;
+    int64_t c[MAG_MAX_DIMS];
+    int64_t ro = wa/np, o_r = 0, o_l[MAG_FUSED_MAX_INPUTS] = {0};
+    for (int64_t k=1; k < nd; ++k) {
+        c[k] = ro % d[k];
+        ro /= d[k];
+        o_r += c[k]*rs[k];
+        for (uint32_t j=0; j < ni; ++j) o_l[j] += c[k]*ls[j][k];
+    }
+    int64_t pc = wa % np;
+    mag_f32_t regs[MAG_FUSED_MAX_REGS][MAG_FUSED_TILE];
+    mag_f32_t tiles[MAG_FUSED_MAX_INPUTS][MAG_FUSED_TILE];
+    mag_f32_t to[MAG_FUSED_TILE];
+    const mag_f32_t* slot[MAG_FUSED_MAX_INPUTS + MAG_FUSED_MAX_REGS];
+    for (uint32_t k=0; k < p->num_regs; ++k) slot[MAG_FUSED_MAX_INPUTS + k] = regs[k];
+    for (int64_t w=wa; w < wb; ++w) {
+        int64_t i0 = pc*seg;
+        int64_t i1 = mag_xmin(i0 + seg, n0);
+        mag_f32_t* pr = br + o_r;
+        mag_bnd_chk(pr + i0*rs0, br, mag_tensor_data_size(r));
+        for (uint32_t j=0; j < ni; ++j) {
+            if (ls[j][0]) continue;
+            mag_f32_t v = bl[j][o_l[j]]; /* Broadcast along the row: splat once */
+            int64_t m = mag_xmin(MAG_FUSED_TILE, i1 - i0);
+            for (int64_t e=0; e < m; ++e) tiles[j][e] = v;
+        }
+        for (int64_t i=i0; i < i1; i += MAG_FUSED_TILE) {
+            int64_t n = mag_xmin(MAG_FUSED_TILE, i1 - i);
+            for (uint32_t j=0; j < ni; ++j) {
+                int64_t s0 = ls[j][0];
+                const mag_f32_t* pl = bl[j] + o_l[j] + i*s0;
+                if (s0 == 1) slot[j] = pl;
+                else {
+                    slot[j] = tiles[j];
+                    if (s0) for (int64_t e=0; e < n; ++e) tiles[j][e] = pl[e*s0];
+                }
+            }
+            for (uint32_t k=0; k < p->num_instrs; ++k) {
+                const mag_fused_instr_t* ins = p->code+k;
+                mag_f32_t* po = k+1 < p->num_instrs ? regs[ins->dst] : rs0 == 1 ? pr + i : to;
+                if (ins->op >= MAG_OP_ADDS) (*mag_fused_scalar_f32[ins->op])(n, po, slot[ins->a], ins->s);
+                else if (ins->op >= MAG_OP_ADD) (*mag_fused_binary_f32[ins->op])(n, po, slot[ins->a], slot[ins->b]);
+                else (*mag_fused_unary_f32[ins->op])(n, po, slot[ins->a]);
+            }
+            if (rs0 != 1) for (int64_t e=0; e < n; ++e) pr[(i+e)*rs0] = to[e];
+        }
+        if (++pc < np) continue;
+        pc = 0;
+        for (int64_t k=1; k < nd; ++k) { /* Next row: increment the coordinates with carry */
+            o_r += rs[k];
+            for (uint32_t j=0; j < ni; ++j) o_l[j] += ls[j][k];
+            if (++c[k] < d[k]) break;
+            o_r -= rs[k]*d[k];
+            for (uint32_t j=0; j < ni; ++j) o_l[j] -= ls[j][k]*d[k];
+            c[k] = 0;
+        }
+    }
+}
+
+/*
+** F16 elementwise kernels widen MAG_F16_TILE elements at a time into F32 stack buffers, run the F32 vector routine on them
+** and round the result back to F16. So all F16 ops share the F32 math and its SIMD paths.
+*/
+#define MAG_F16_TILE 256
+
+static void MAG_HOTPROC mag_vunary_f16(
+    int64_t numel,
+    mag_f16_t* o,
+    const mag_f16_t* x,
+    void (*f)(int64_t, mag_f32_t*, const mag_f32_t*)
+) {
+    mag_f32_t tx[MAG_F16_TILE], to[MAG_F16_TILE];
+    for (int64_t i=0; i < numel; i += MAG_F16_TILE) {
+        int64_t n = mag_xmin(MAG_F16_TILE, numel-i);
+        mag_vcvt_f32_f16(n, tx, x+i);
+        (*f)(n, to, tx);
+        mag_vcvt_f16_f32(n, o+i, to);
+    }
+}
+
+static void MAG_HOTPROC mag_vunary_scalar_f16(
+    int64_t numel,
+    mag_f16_t* o,
+    const mag_f16_t* x,
+    mag_f32_t y,
+    void (*f)(int64_t, mag_f32_t*, const mag_f32_t*, mag_f32_t)
+) {
+    mag_f32_t tx[MAG_F16_TILE], to[MAG_F16_TILE];
+    for (int64_t i=0; i < numel; i += MAG_F16_TILE) {
+        int64_t n = mag_xmin(MAG_F16_TILE, numel-i);
+        mag_vcvt_f32_f16(n, tx, x+i);
+        (*f)(n, to, tx, y);
+        mag_vcvt_f16_f32(n, o+i, to);
+    }
+}
+
+static void MAG_HOTPROC mag_vbinary_f16(
+    int64_t numel,
+    mag_f16_t* o,
+    const mag_f16_t* x,
+    const mag_f16_t* y,
+    void (*f)(int64_t, mag_f32_t*, const mag_f32_t*, const mag_f32_t*)
+) {
+    mag_f32_t tx[MAG_F16_TILE], ty[MAG_F16_TILE], to[MAG_F16_TILE];
+    for (int64_t i=0; i < numel; i += MAG_F16_TILE) {
+        int64_t n = mag_xmin(MAG_F16_TILE, numel-i);
+        mag_vcvt_f32_f16(n, tx, x+i);
+        mag_vcvt_f32_f16(n, ty, y+i);
+        (*f)(n, to, tx, ty);
+        mag_vcvt_f16_f32(n, o+i, to);
+    }
+}
+
+static void MAG_HOTPROC mag_vsoftmax_f16( /* Softmax of one F16 row, widened tile by tile: the max and normalizer are found in a first pass, the second pass exponentiates again and writes. */
+    int64_t numel,
+    mag_f16_t* o,
+    const mag_f16_t* x
+) {
+    mag_f32_t tx[MAG_F16_TILE], to[MAG_F16_TILE];
+    mag_f32_t m = -INFINITY;
+    mag_f64_t s = 0.0;
+    for (int64_t i=0; i < numel; i += MAG_F16_TILE) {
+        int64_t n = mag_xmin(MAG_F16_TILE, numel-i);
+        mag_vcvt_f32_f16(n, tx, x+i);
+        mag_f32_t bm = mag_vmax_f32(n, tx);
+        if (bm > m) {
+            s *= (mag_f64_t)expf(m-bm);
+            m = bm;
+        }
+        if (mag_likely(m != -INFINITY)) s += mag_vexpsubs_sum_f32(n, to, tx, m);
+    }
+    mag_f32_t inv = (mag_f32_t)(1.0/s);
+    for (int64_t i=0; i < numel; i += MAG_F16_TILE) {
+        int64_t n = mag_xmin(MAG_F16_TILE, numel-i);
+        mag_vcvt_f32_f16(n, tx, x+i);
+        mag_vexpsubs_sum_f32(n, to, tx, m);
+        mag_vmuls_f32(n, to, to, inv);
+        mag_vcvt_f16_f32(n, o+i, to);
+    }
+}
+
+#define mag_cpu_blas_impl_vunary_f16(name) \
+    static void MAG_HOTPROC mag_v##name##_f16(int64_t numel, mag_f16_t* o, const mag_f16_t* x) { \
+        mag_vunary_f16(numel, o, x, &mag_v##name##_f32); \
+    }
+
+#define mag_cpu_blas_impl_vunary_scalar_f16(name) \
+    static void MAG_HOTPROC mag_v##name##s_f16(int64_t numel, mag_f16_t* o, const mag_f16_t* x, mag_f32_t y) { \
+        mag_vunary_scalar_f16(numel, o, x, y, &mag_v##name##s_f32); \
+    }
+
+#define mag_cpu_blas_impl_vbinary_f16(name) \
+    static void MAG_HOTPROC mag_v##name##_f16(int64_t numel, mag_f16_t* o, const mag_f16_t* x, const mag_f16_t* y) { \
+        mag_vbinary_f16(numel, o, x, y, &mag_v##name##_f32); \
+    }
+
+mag_cpu_blas_impl_vunary_f16(abs)
+mag_cpu_blas_impl_vunary_f16(neg)
+mag_cpu_blas_impl_vunary_f16(log)
+mag_cpu_blas_impl_vunary_f16(sqr)
+mag_cpu_blas_impl_vunary_f16(sqrt)
+mag_cpu_blas_impl_vunary_f16(sin)
+mag_cpu_blas_impl_vunary_f16(cos)
+mag_cpu_blas_impl_vunary_f16(step)
+mag_cpu_blas_impl_vunary_f16(softmax_dv)
+mag_cpu_blas_impl_vunary_f16(sigmoid)
+mag_cpu_blas_impl_vunary_f16(sigmoid_dv)
+mag_cpu_blas_impl_vunary_f16(hard_sigmoid)
+mag_cpu_blas_impl_vunary_f16(silu)
+mag_cpu_blas_impl_vunary_f16(silu_dv)
+mag_cpu_blas_impl_vunary_f16(tanh)
+mag_cpu_blas_impl_vunary_f16(tanh_dv)
+mag_cpu_blas_impl_vunary_f16(relu)
+mag_cpu_blas_impl_vunary_f16(relu_dv)
+mag_cpu_blas_impl_vunary_f16(gelu)
+mag_cpu_blas_impl_vunary_f16(gelu_dv)
+mag_cpu_blas_impl_vunary_scalar_f16(add)
+mag_cpu_blas_impl_vunary_scalar_f16(sub)
+mag_cpu_blas_impl_vunary_scalar_f16(mul)
+mag_cpu_blas_impl_vunary_scalar_f16(div)
+mag_cpu_blas_impl_vbinary_f16(add)
+mag_cpu_blas_impl_vbinary_f16(sub)
+mag_cpu_blas_impl_vbinary_f16(mul)
+mag_cpu_blas_impl_vbinary_f16(div)
+
+#undef mag_cpu_blas_impl_vunary_f16
+#undef mag_cpu_blas_impl_vunary_scalar_f16
+#undef mag_cpu_blas_impl_vbinary_f16
+
+/*
+** Row-wise operator: threads split the rows along axis 0, each row is processed whole by mag_v<name>_<T>.
+** Strided rows are gathered into (and scattered from) a row buffer, because the vector routine needs the whole row at once.
+*/
+#define mag_cpu_blas_impl_rowwise(T, name) \
+    static void MAG_HOTPROC mag_blas_##name##_##T(const mag_compute_payload_t* payload) { \
+        mag_tensor_t* r = payload->node; \
+        const mag_tensor_t* x = r->op_inputs[0]; \
+        mag_##T##_t* br = mag_##T##p_mut(r); \
+        const mag_##T##_t* bx = mag_##T##p(x); \
+        int64_t tc = payload->thread_num; \
+        int64_t ti = payload->thread_idx; \
+        int64_t cols = *x->shape; \
+        int64_t rows = x->numel/cols; \
+        int64_t chunk = (rows + tc - 1)/tc; \
+        int64_t ra = ti*chunk; \
+        int64_t rb = mag_xmin(ra + chunk, rows); \
+        if (ra >= rb) return; \
+        const int64_t* rst = br == bx ? x->strides : r->strides; /* In-place results alias x, so they are laid out through x's strides */ \
+        bool dense = true; \
+        for (int64_t k=0, e=1; k < MAG_MAX_DIMS; e *= x->shape[k++]) \
+            if (x->shape[k] > 1 && (rst[k] != e || x->strides[k] != e)) dense = false; \
+        int64_t rs0 = dense ? 1 : *rst, xs0 = dense ? 1 : *x->strides; \
+        mag_##T##_t* tx = xs0 != 1 ? mag_alloc_aligned(cols*sizeof(*tx), MAG_CACHE_LINE_SIZE) : NULL; \
+        mag_##T##_t* to = rs0 != 1 ? mag_alloc_aligned(cols*sizeof(*to), MAG_CACHE_LINE_SIZE) : NULL; \
+        for (int64_t i=ra; i < rb; ++i) { \
+            int64_t o_r = i*cols, o_x = i*cols; \
+            if (!dense) { /* Row offsets through the strides of the outer axes */ \
+                int64_t ro = i; \
+                o_r = o_x = 0; \
+                for (int64_t k=1; k < MAG_MAX_DIMS; ++k) { \
+                    int64_t c = ro % x->shape[k]; \
+                    ro /= x->shape[k]; \
+                    o_r += c*rst[k]; \
+                    o_x += c*x->strides[k]; \
+                } \
+            } \
+            mag_##T##_t* pr = br + o_r; \
+            const mag_##T##_t* px = bx + o_x; \
+            mag_bnd_chk(pr + (cols-1)*rs0, br, mag_tensor_data_size(r)); \
+            mag_bnd_chk(px + (cols-1)*xs0, bx, mag_tensor_data_size(x)); \
+            if (tx) for (int64_t j=0; j < cols; ++j) tx[j] = px[j*xs0]; \
+            mag_v##name##_##T(cols, to ? to : pr, tx ? tx : px); \
+            if (to) for (int64_t j=0; j < cols; ++j) pr[j*rs0] = to[j]; \
+        } \
+        if (tx) mag_free_aligned(tx); \
+        if (to) mag_free_aligned(to); \
+    }
+
+mag_cpu_blas_impl_rowwise(f32, softmax)
+mag_cpu_blas_impl_rowwise(f16, softmax)
+
+#undef mag_cpu_blas_impl_rowwise
+
+/*
+** Iteration space of an elementwise op from x into r with arbitrary strides: extent 1 dims are dropped and neighbouring dims are merged
+** where both tensors are linear across them. Returns the number of dims left (at least one), d[0] is the innermost.
+** A contiguous pair collapses into a single dim with unit strides, a permuted view into its runs.
+*/
+static int64_t mag_collapse_dims(const mag_tensor_t* r, const mag_tensor_t* x, int64_t* d, int64_t* rs, int64_t* xs) {
+    int64_t nd = 0;
+    for (int64_t i=0; i < MAG_MAX_DIMS; ++i) {
+        int64_t n = r->shape[i];
+        if (n == 1) continue;
+        if (nd && rs[nd-1]*d[nd-1] == r->strides[i] && xs[nd-1]*d[nd-1] == x->strides[i]) {
+            d[nd-1] *= n;
+            continue;
+        }
+        d[nd] = n;
+        rs[nd] = r->strides[i];
+        xs[nd] = x->strides[i];
+        ++nd;
+    }
+    if (!nd) {
+        *d = *rs = *xs = 1;
+        nd = 1;
+    }
+    return nd;
+}
+
+#define MAG_STRIDED_TILE 256 /* Elements of a strided row gathered into a stack tile for the vector routine */
+
+/*
+** Elementwise rows of a collapsed iteration space (see mag_collapse_dims), threads split the rows along d[0].
+** Rows with unit strides run vcall directly on the tensors, strided operands are gathered into (and scattered from) MAG_STRIDED_TILE stack tiles,
+** so the vector routine vcall(n, po, px) still does the math.
+*/
+#define mag_cpu_blas_strided_rows(T, vcall) \
+    do { \
+        int64_t rows = r->numel/d[0]; \
+        int64_t chunk = (rows + tc - 1)/tc; \
+        int64_t r0 = ti*chunk; \
+        int64_t r1 = mag_xmin(r0 + chunk, rows); \
+        mag_##T##_t tx[MAG_STRIDED_TILE], to[MAG_STRIDED_TILE]; \
+        for (int64_t ri=r0; ri < r1; ++ri) { \
+            int64_t ro = ri, ro_r = 0, ro_x = 0; \
+            for (int64_t k=1; k < nd; ++k) { \
+                int64_t c = ro % d[k]; \
+                ro /= d[k]; \
+                ro_r += c*rs[k]; \
+                ro_x += c*xs[k]; \
+            } \
+            mag_##T##_t* pr = br + ro_r; \
+            const mag_##T##_t* pxr = bx + ro_x; \
+            mag_bnd_chk(pr + (d[0]-1)*rs[0], br, mag_tensor_data_size(r)); \
+            mag_bnd_chk(pxr + (d[0]-1)*xs[0], bx, mag_tensor_data_size(x)); \
+            if (rs[0] == 1 && xs[0] == 1) { \
+                int64_t n = d[0]; \
+                mag_##T##_t* po = pr; \
+                const mag_##T##_t* px = pxr; \
+                vcall; \
+                continue; \
+            } \
+            for (int64_t i=0; i < d[0]; i += MAG_STRIDED_TILE) { \
+                int64_t n = mag_xmin(MAG_STRIDED_TILE, d[0]-i); \
+                mag_##T##_t* po = rs[0] == 1 ? pr+i : to; \
+                const mag_##T##_t* px = xs[0] == 1 ? pxr+i : tx; \
+                if (xs[0] != 1) for (int64_t j=0; j < n; ++j) tx[j] = pxr[(i+j)*xs[0]]; \
+                vcall; \
+                if (rs[0] != 1) for (int64_t j=0; j < n; ++j) pr[(i+j)*rs[0]] = to[j]; \
+            } \
+        } \
+    } while (0)
+
+/*
+** Unary elementwise kernels. Contiguous operands (and in-place ops, which map the shared storage elementwise) take the flat path,
+** split into one chunk per thread. Other views walk their strides with mag_cpu_blas_strided_rows.
+*/
+#define mag_cpu_blas_impl_unary(T, name) \
+    static void MAG_HOTPROC mag_blas_##name##_##T(const mag_compute_payload_t* payload) { \
+        mag_tensor_t* r = payload->node; \
+        const mag_tensor_t* x = r->op_inputs[0]; \
+        mag_##T##_t* br = mag_##T##p_mut(r); \
+        const mag_##T##_t* bx = mag_##T##p(x); \
+        int64_t tc = payload->thread_num; \
+        int64_t ti = payload->thread_idx; \
+        int64_t d[MAG_MAX_DIMS], rs[MAG_MAX_DIMS], xs[MAG_MAX_DIMS]; \
+        int64_t nd = mag_collapse_dims(r, x, d, rs, xs); \
+        if (mag_unlikely(!(nd == 1 && *rs == 1 && *xs == 1) && br != bx)) { \
+            mag_cpu_blas_strided_rows(T, mag_v##name##_##T(n, po, px)); \
+            return; \
+        } \
+        int64_t numel = r->numel; \
+        int64_t chunk = (numel + tc - 1)/tc; \
+        int64_t ra = ti*chunk; \
+        int64_t vmel = mag_xmin(ra + chunk, numel) - ra; \
+        if (mag_unlikely(vmel <= 0)) return; \
+        mag_##T##_t* pr = br + ra; \
+        const mag_##T##_t* px = bx + ra; \
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r)); \
+        mag_bnd_chk(px, bx, mag_tensor_data_size(x)); \
+        mag_v##name##_##T(vmel, pr, px); \
+    }
+
+mag_cpu_blas_impl_unary(f32, abs)
+mag_cpu_blas_impl_unary(f32, neg)
+mag_cpu_blas_impl_unary(f32, log)
+mag_cpu_blas_impl_unary(f32, sqr)
+mag_cpu_blas_impl_unary(f32, sqrt)
+mag_cpu_blas_impl_unary(f32, sin)
+mag_cpu_blas_impl_unary(f32, cos)
+mag_cpu_blas_impl_unary(f32, step)
+mag_cpu_blas_impl_unary(f32, softmax_dv)
+mag_cpu_blas_impl_unary(f32, sigmoid)
+mag_cpu_blas_impl_unary(f32, sigmoid_dv)
+mag_cpu_blas_impl_unary(f32, hard_sigmoid)
+mag_cpu_blas_impl_unary(f32, silu)
+mag_cpu_blas_impl_unary(f32, silu_dv)
+mag_cpu_blas_impl_unary(f32, tanh)
+mag_cpu_blas_impl_unary(f32, tanh_dv)
+mag_cpu_blas_impl_unary(f32, relu)
+mag_cpu_blas_impl_unary(f32, relu_dv)
+mag_cpu_blas_impl_unary(f32, gelu)
+mag_cpu_blas_impl_unary(f32, gelu_dv)
+
+mag_cpu_blas_impl_unary(f16, abs)
+mag_cpu_blas_impl_unary(f16, neg)
+mag_cpu_blas_impl_unary(f16, log)
+mag_cpu_blas_impl_unary(f16, sqr)
+mag_cpu_blas_impl_unary(f16, sqrt)
+mag_cpu_blas_impl_unary(f16, sin)
+mag_cpu_blas_impl_unary(f16, cos)
+mag_cpu_blas_impl_unary(f16, step)
+mag_cpu_blas_impl_unary(f16, softmax_dv)
+mag_cpu_blas_impl_unary(f16, sigmoid)
+mag_cpu_blas_impl_unary(f16, sigmoid_dv)
+mag_cpu_blas_impl_unary(f16, hard_sigmoid)
+mag_cpu_blas_impl_unary(f16, silu)
+mag_cpu_blas_impl_unary(f16, silu_dv)
+mag_cpu_blas_impl_unary(f16, tanh)
+mag_cpu_blas_impl_unary(f16, tanh_dv)
+mag_cpu_blas_impl_unary(f16, relu)
+mag_cpu_blas_impl_unary(f16, relu_dv)
+mag_cpu_blas_impl_unary(f16, gelu)
+mag_cpu_blas_impl_unary(f16, gelu_dv)
+
+#undef mag_cpu_blas_impl_unary
+
+#define mag_cpu_blas_impl_unary_scalar(T, name) \
+    static void MAG_HOTPROC mag_blas_##name##s_##T(const mag_compute_payload_t* payload) { \
+        mag_tensor_t* r = payload->node; \
+        const mag_tensor_t* x = r->op_inputs[0]; \
+        mag_f32_t xi = r->op_params->x.f32; /* Scalars are always F32 */ \
+        mag_##T##_t* br = mag_##T##p_mut(r); \
+        const mag_##T##_t* bx = mag_##T##p(x); \
+        int64_t tc = payload->thread_num; \
+        int64_t ti = payload->thread_idx; \
+        int64_t d[MAG_MAX_DIMS], rs[MAG_MAX_DIMS], xs[MAG_MAX_DIMS]; \
+        int64_t nd = mag_collapse_dims(r, x, d, rs, xs); \
+        if (mag_unlikely(!(nd == 1 && *rs == 1 && *xs == 1) && br != bx)) { \
+            mag_cpu_blas_strided_rows(T, mag_v##name##s_##T(n, po, px, xi)); \
+            return; \
+        } \
+        int64_t numel = r->numel; \
+        int64_t chunk = (numel + tc - 1)/tc; \
+        int64_t ra = ti*chunk; \
+        int64_t vmel = mag_xmin(ra + chunk, numel) - ra; \
+        if (mag_unlikely(vmel <= 0)) return; \
+        mag_##T##_t* pr = br + ra; \
+        const mag_##T##_t* px = bx + ra; \
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r)); \
+        mag_bnd_chk(px, bx, mag_tensor_data_size(x)); \
+        mag_v##name##s_##T(vmel, pr, px, xi); \
+    }
+
+mag_cpu_blas_impl_unary_scalar(f32, add)
+mag_cpu_blas_impl_unary_scalar(f32, sub)
+mag_cpu_blas_impl_unary_scalar(f32, mul)
+mag_cpu_blas_impl_unary_scalar(f32, div)
+
+mag_cpu_blas_impl_unary_scalar(f16, add)
+mag_cpu_blas_impl_unary_scalar(f16, sub)
+mag_cpu_blas_impl_unary_scalar(f16, mul)
+mag_cpu_blas_impl_unary_scalar(f16, div)
+
+#undef mag_cpu_blas_impl_unary_scalar
+#undef mag_cpu_blas_strided_rows
+
+/*
+** Iteration space of a broadcasting binary op r = x op y. Every extent of y divides the matching extent of x and y repeats along it
+** (see mag_tensor_can_broadcast), so each dim splits into an inner part of y's extent and an outer repeat count, where y has stride 0.
+** Extent 1 parts are dropped and neighbouring dims are merged where all three tensors are linear across them (a stride 0 run stays linear).
+** d[0] is the innermost run, the rest is walked with carried coordinates, so no div/mod per element or row.
+*/
+typedef struct mag_bcast_iter_t {
+    int64_t nd;
+    int64_t d[MAG_MAX_DIMS<<1];
+    int64_t rs[MAG_MAX_DIMS<<1];
+    int64_t xs[MAG_MAX_DIMS<<1];
+    int64_t ys[MAG_MAX_DIMS<<1];
+} mag_bcast_iter_t;
+
+static void mag_bcast_iter_init(mag_bcast_iter_t* it, const mag_tensor_t* r, const mag_tensor_t* x, const mag_tensor_t* y) {
+    int64_t nd = 0;
+    for (int64_t i=0; i < MAG_MAX_DIMS; ++i) {
+        int64_t yd = y->shape[i];
+        int64_t part[2][4] = {
+            {yd, r->strides[i], x->strides[i], y->strides[i]},
+            {x->shape[i]/yd, r->strides[i]*yd, x->strides[i]*yd, 0}
+        };
+        for (int p=0; p < 2; ++p) {
+            int64_t n = part[p][0];
+            if (n == 1) continue;
+            if (nd) {
+                int64_t dp = it->d[nd-1];
+                if (it->rs[nd-1]*dp == part[p][1] && it->xs[nd-1]*dp == part[p][2] && it->ys[nd-1]*dp == part[p][3]) {
+                    it->d[nd-1] *= n;
+                    continue;
+                }
+            }
+            it->d[nd] = n;
+            it->rs[nd] = part[p][1];
+            it->xs[nd] = part[p][2];
+            it->ys[nd] = part[p][3];
+            ++nd;
+        }
+    }
+    if (!nd) {
+        *it->d = *it->rs = *it->xs = *it->ys = 1;
+        nd = 1;
+    }
+    it->nd = nd;
+}
+
+/*
+** Binary elementwise kernels over mag_bcast_iter_t. Threads split the rows of the iteration space, and when there are fewer rows than threads
+** every row is cut into pieces too, so a fully collapsed (same shape, contiguous) op still spreads over all threads.
+** Inner runs go to the vector routines: mag_v##name with unit strides, the scalar splat mag_v##name##s when y is broadcast along the run,
+** strided operands are gathered into (and scattered from) MAG_STRIDED_TILE stack tiles.
+*/
+#define mag_cpu_blas_impl_binary(T, name, op) \
+    static void MAG_HOTPROC mag_blas_##name##_##T(const mag_compute_payload_t* payload) { \
+        mag_tensor_t* r = payload->node; \
+        const mag_tensor_t* x = r->op_inputs[0]; \
+        const mag_tensor_t* y = r->op_inputs[1]; \
+        mag_##T##_t* br = mag_##T##p_mut(r); \
+        const mag_##T##_t* bx = mag_##T##p(x); \
+        const mag_##T##_t* by = mag_##T##p(y); \
+        int64_t tc = payload->thread_num; \
+        int64_t ti = payload->thread_idx; \
+        mag_bcast_iter_t it; \
+        mag_bcast_iter_init(&it, r, x, y); \
+        int64_t nd = it.nd; \
+        int64_t n0 = *it.d, rs0 = *it.rs, xs0 = *it.xs, ys0 = *it.ys; \
+        int64_t rows = r->numel/n0; \
+        int64_t np = rows < tc ? (tc + rows - 1)/rows : 1; /* Pieces per row */ \
+        int64_t seg = (n0 + np - 1)/np; \
+        int64_t work = rows*np; \
+        int64_t chunk = (work + tc - 1)/tc; \
+        int64_t wa = ti*chunk; \
+        int64_t wb = mag_xmin(wa + chunk, work); \
+        if (mag_unlikely(wa >= wb)) return; \
+        int64_t c[MAG_MAX_DIMS<<1]; \
+        int64_t ro = wa/np, o_r = 0, o_x = 0, o_y = 0; \
+        for (int64_t k=1; k < nd; ++k) { /* Start coordinates once, carried from here on */ \
+            c[k] = ro % it.d[k]; \
+            ro /= it.d[k]; \
+            o_r += c[k]*it.rs[k]; \
+            o_x += c[k]*it.xs[k]; \
+            o_y += c[k]*it.ys[k]; \
+        } \
+        int64_t p = wa % np; \
+        mag_##T##_t tx[MAG_STRIDED_TILE], ty[MAG_STRIDED_TILE], to[MAG_STRIDED_TILE]; \
+        for (int64_t w=wa; w < wb; ++w) { \
+            int64_t i0 = p*seg; \
+            int64_t i1 = mag_xmin(i0 + seg, n0); \
+            if (i0 < i1) { \
+                mag_##T##_t* pr = br + o_r + i0*rs0; \
+                const mag_##T##_t* px = bx + o_x + i0*xs0; \
+                const mag_##T##_t* py = by + o_y + i0*ys0; \
+                int64_t n = i1 - i0; \
+                mag_bnd_chk(pr + (n-1)*rs0, br, mag_tensor_data_size(r)); \
+                mag_bnd_chk(px + (n-1)*xs0, bx, mag_tensor_data_size(x)); \
+                mag_bnd_chk(py + (n-1)*ys0, by, mag_tensor_data_size(y)); \
+                if (mag_likely(rs0 == 1 && xs0 == 1 && ys0 == 1)) { \
+                    mag_v##name##_##T(n, pr, px, py); \
+                } else if (rs0 == 1 && xs0 == 1 && ys0 == 0) { \
+                    mag_v##name##s_##T(n, pr, px, mag_##T##_to_f32(*py)); \
+                } else { \
+                    for (int64_t i=0; i < n; i += MAG_STRIDED_TILE) { \
+                        int64_t m = mag_xmin(MAG_STRIDED_TILE, n-i); \
+                        mag_##T##_t* po = rs0 == 1 ? pr+i : to; \
+                        const mag_##T##_t* pxt = xs0 == 1 ? px+i : tx; \
+                        const mag_##T##_t* pyt = ys0 == 1 ? py+i : ty; \
+                        if (xs0 != 1) for (int64_t j=0; j < m; ++j) tx[j] = px[(i+j)*xs0]; \
+                        if (ys0 == 0) mag_v##name##s_##T(m, po, pxt, mag_##T##_to_f32(*py)); \
+                        else { \
+                            if (ys0 != 1) for (int64_t j=0; j < m; ++j) ty[j] = py[(i+j)*ys0]; \
+                            mag_v##name##_##T(m, po, pxt, pyt); \
+                        } \
+                        if (rs0 != 1) for (int64_t j=0; j < m; ++j) pr[(i+j)*rs0] = to[j]; \
+                    } \
+                } \
+            } \
+            if (++p < np) continue; \
+            p = 0; \
+            for (int64_t k=1; k < nd; ++k) { /* Next row: increment the coordinates with carry */ \
+                o_r += it.rs[k]; \
+                o_x += it.xs[k]; \
+                o_y += it.ys[k]; \
+                if (++c[k] < it.d[k]) break; \
+                o_r -= it.rs[k]*it.d[k]; \
+                o_x -= it.xs[k]*it.d[k]; \
+                o_y -= it.ys[k]*it.d[k]; \
+                c[k] = 0; \
+            } \
+        } \
+    }
+
+mag_cpu_blas_impl_binary(f32, add, +)
+mag_cpu_blas_impl_binary(f32, sub, -)
+mag_cpu_blas_impl_binary(f32, mul, *)
+mag_cpu_blas_impl_binary(f32, div, /)
+
+mag_cpu_blas_impl_binary(f16, add, +)
+mag_cpu_blas_impl_binary(f16, sub, -)
+mag_cpu_blas_impl_binary(f16, mul, *)
+mag_cpu_blas_impl_binary(f16, div, /)
+
+/*
+** SGEMM engine: R = A x B with A[M×K], B[K×N], R[M×N], all row-major.
+** Classic Goto/BLIS layering: B is packed into KC×NC panels which live in L3, A into MC×KC panels which live in L2,
+** and a register-tiled MR×NR microkernel streams KC-long slivers of both through L1.
+** Packed slivers are zero padded to full MR/NR, so the microkernel never branches on edges inside the K-loop.
+*/
+#if (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+    typedef float32x4_t mag_sgemm_vf32_t;
+    #define MAG_SGEMM_VLEN 4
+    #define MAG_SGEMM_MR 8
+    #define MAG_SGEMM_NR 8
+    #define mag_sgemm_vzero() vdupq_n_f32(0.0f)
+    #define mag_sgemm_vload(p) vld1q_f32(p)
+    #define mag_sgemm_vstore(p, v) vst1q_f32((p), (v))
+    #define mag_sgemm_vbcast(p) vld1q_dup_f32(p)
+    #define mag_sgemm_vadd(a, b) vaddq_f32((a), (b))
+    #define mag_sgemm_vfma(acc, a, b) vfmaq_f32((acc), (a), (b))
+#elif defined(__AVX512F__) && defined(__FMA__)
+    typedef __m512 mag_sgemm_vf32_t;
+    #define MAG_SGEMM_VLEN 16
+    #define MAG_SGEMM_MR 6
+    #define MAG_SGEMM_NR 32
+    #define mag_sgemm_vzero() _mm512_setzero_ps()
+    #define mag_sgemm_vload(p) _mm512_loadu_ps(p)
+    #define mag_sgemm_vstore(p, v) _mm512_storeu_ps((p), (v))
+    #define mag_sgemm_vbcast(p) _mm512_set1_ps(*(p))
+    #define mag_sgemm_vadd(a, b) _mm512_add_ps((a), (b))
+    #define mag_sgemm_vfma(acc, a, b) _mm512_fmadd_ps((a), (b), (acc))
+#elif defined(__AVX__)
+    typedef __m256 mag_sgemm_vf32_t;
+    #define MAG_SGEMM_VLEN 8
+    #define MAG_SGEMM_MR 6
+    #define MAG_SGEMM_NR 16
+    #define mag_sgemm_vzero() _mm256_setzero_ps()
+    #define mag_sgemm_vload(p) _mm256_loadu_ps(p)
+    #define mag_sgemm_vstore(p, v) _mm256_storeu_ps((p), (v))
+    #define mag_sgemm_vbcast(p) _mm256_broadcast_ss(p)
+    #define mag_sgemm_vadd(a, b) _mm256_add_ps((a), (b))
+    #ifdef __FMA__
+        #define mag_sgemm_vfma(acc, a, b) _mm256_fmadd_ps((a), (b), (acc))
+    #else
+        #define mag_sgemm_vfma(acc, a, b) _mm256_add_ps((acc), _mm256_mul_ps((a), (b)))
+    #endif
+#elif defined(__SSE2__)
+    typedef __m128 mag_sgemm_vf32_t;
+    #define MAG_SGEMM_VLEN 4
+    #define MAG_SGEMM_MR 4
+    #define MAG_SGEMM_NR 8
+    #define mag_sgemm_vzero() _mm_setzero_ps()
+    #define mag_sgemm_vload(p) _mm_loadu_ps(p)
+    #define mag_sgemm_vstore(p, v) _mm_storeu_ps((p), (v))
+    #define mag_sgemm_vbcast(p) _mm_set1_ps(*(p))
+    #define mag_sgemm_vadd(a, b) _mm_add_ps((a), (b))
+    #define mag_sgemm_vfma(acc, a, b) _mm_add_ps((acc), _mm_mul_ps((a), (b)))
+#else
+    typedef mag_f32_t mag_sgemm_vf32_t;
+    #define MAG_SGEMM_VLEN 1
+    #define MAG_SGEMM_MR 4
+    #define MAG_SGEMM_NR 4
+    #define mag_sgemm_vzero() 0.0f
+    #define mag_sgemm_vload(p) (*(p))
+    #define mag_sgemm_vstore(p, v) (*(p) = (v))
+    #define mag_sgemm_vbcast(p) (*(p))
+    #define mag_sgemm_vadd(a, b) ((a)+(b))
+    #define mag_sgemm_vfma(acc, a, b) ((acc)+(a)*(b))
+#endif
+
+#define MAG_SGEMM_NV (MAG_SGEMM_NR/MAG_SGEMM_VLEN)  /* Vector registers per microtile row. */
+#define MAG_SGEMM_KC 256                            /* K-depth of packed panels: MR×KC + KC×NR slivers fit into L1. */
+#define MAG_SGEMM_MC (MAG_SGEMM_MR*24)              /* Rows of packed A panel: MC×KC fits into L2. */
+#define MAG_SGEMM_NC (MAG_SGEMM_NR*128)             /* Columns of packed B panel: KC×NC fits into L3. */
+mag_static_assert(MAG_SGEMM_NR % MAG_SGEMM_VLEN == 0);
+mag_static_assert(MAG_SGEMM_MR*MAG_SGEMM_NV <= 16); /* Accumulators must fit into the register file. */
+
+/*
+** Pack mc×kc block of A into MR-row slivers: pa[sliver][k][MR]. Rows past mc are zeroed.
+** Element (i, k) of A is at a[i*rsa + k*csa], so row-major (csa == 1) and transposed (rsa == 1) operands are packed without a copy.
+*/
+static void MAG_HOTPROC mag_sgemm_pack_a_f32(int64_t mc, int64_t kc, const mag_f32_t* a, int64_t rsa, int64_t csa, mag_f32_t* pa) {
+    for (int64_t i=0; i < mc; i += MAG_SGEMM_MR) {
+        int64_t mr = mag_xmin(MAG_SGEMM_MR, mc-i);
+        const mag_f32_t* pi = a + i*rsa;
+        if (rsa == 1 && mr == MAG_SGEMM_MR) { /* Transposed A (TN/TT): the MR rows of a column are contiguous. */
+            for (int64_t k=0; k < kc; ++k, pa += MAG_SGEMM_MR)
+                memcpy(pa, pi + k*csa, MAG_SGEMM_MR*sizeof(*pa));
+        } else {
+            for (int64_t k=0; k < kc; ++k) {
+                int64_t r=0;
+                for (; r < mr; ++r) *pa++ = pi[r*rsa + k*csa];
+                for (; r < MAG_SGEMM_MR; ++r) *pa++ = 0.0f;
+            }
+        }
+    }
+}
+
+/*
+** Pack kc×nc block of B into NR-column slivers: pb[sliver][k][NR]. Columns past nc are zeroed.
+** Element (k, j) of B is at b[k*rsb + j*csb], see mag_sgemm_pack_a_f32.
+*/
+static void MAG_HOTPROC mag_sgemm_pack_b_f32(int64_t kc, int64_t nc, const mag_f32_t* b, int64_t rsb, int64_t csb, mag_f32_t* pb) {
+    for (int64_t j=0; j < nc; j += MAG_SGEMM_NR, pb += kc*MAG_SGEMM_NR) {
+        int64_t nr = mag_xmin(MAG_SGEMM_NR, nc-j);
+        const mag_f32_t* pj = b + j*csb;
+        if (csb == 1 && nr == MAG_SGEMM_NR) { /* Row-major B (NN/TN): the NR columns of a row are contiguous. */
+            for (int64_t k=0; k < kc; ++k)
+                memcpy(pb + k*MAG_SGEMM_NR, pj + k*rsb, MAG_SGEMM_NR*sizeof(*pb));
+        } else if (rsb == 1) { /* Transposed B (NT/TT): stream each column along k and scatter into the sliver. */
+            for (int64_t c=0; c < nr; ++c) {
+                const mag_f32_t* pc = pj + c*csb;
+                for (int64_t k=0; k < kc; ++k)
+                    pb[k*MAG_SGEMM_NR + c] = pc[k];
+            }
+            for (int64_t k=0; k < kc; ++k)
+                for (int64_t c=nr; c < MAG_SGEMM_NR; ++c)
+                    pb[k*MAG_SGEMM_NR + c] = 0.0f;
+        } else {
+            for (int64_t k=0; k < kc; ++k) {
+                int64_t c=0;
+                for (; c < nr; ++c) pb[k*MAG_SGEMM_NR + c] = pj[k*rsb + c*csb];
+                for (; c < MAG_SGEMM_NR; ++c) pb[k*MAG_SGEMM_NR + c] = 0.0f;
+            }
+        }
+    }
+}
+
+/* Packs like mag_sgemm_pack_a_f32 from a F16 operand, widening to F32 on the fly. */
+static void MAG_HOTPROC mag_sgemm_pack_a_f16(int64_t mc, int64_t kc, const mag_f16_t* a, int64_t rsa, int64_t csa, mag_f32_t* pa) {
+    for (int64_t i=0; i < mc; i += MAG_SGEMM_MR) {
+        int64_t mr = mag_xmin(MAG_SGEMM_MR, mc-i);
+        const mag_f16_t* pi = a + i*rsa;
+        if (rsa == 1 && mr == MAG_SGEMM_MR) {
+            for (int64_t k=0; k < kc; ++k, pa += MAG_SGEMM_MR)
+                mag_vcvt_f32_f16(MAG_SGEMM_MR, pa, pi + k*csa);
+        } else {
+            for (int64_t k=0; k < kc; ++k) {
+                int64_t r=0;
+                for (; r < mr; ++r) *pa++ = mag_f16_to_f32(pi[r*rsa + k*csa]);
+                for (; r < MAG_SGEMM_MR; ++r) *pa++ = 0.0f;
+            }
+        }
+    }
+}
+
+/* Packs like mag_sgemm_pack_b_f32 from a F16 operand, widening to F32 on the fly. */
+static void MAG_HOTPROC mag_sgemm_pack_b_f16(int64_t kc, int64_t nc, const mag_f16_t* b, int64_t rsb, int64_t csb, mag_f32_t* pb) {
+    for (int64_t j=0; j < nc; j += MAG_SGEMM_NR, pb += kc*MAG_SGEMM_NR) {
+        int64_t nr = mag_xmin(MAG_SGEMM_NR, nc-j);
+        const mag_f16_t* pj = b + j*csb;
+        if (csb == 1 && nr == MAG_SGEMM_NR) {
+            for (int64_t k=0; k < kc; ++k)
+                mag_vcvt_f32_f16(MAG_SGEMM_NR, pb + k*MAG_SGEMM_NR, pj + k*rsb);
+        } else {
+            for (int64_t k=0; k < kc; ++k) {
+                int64_t c=0;
+                for (; c < nr; ++c) pb[k*MAG_SGEMM_NR + c] = mag_f16_to_f32(pj[k*rsb + c*csb]);
+                for (; c < MAG_SGEMM_NR; ++c) pb[k*MAG_SGEMM_NR + c] = 0.0f;
+            }
+        }
+    }
+}
+
+/* Packs like mag_sgemm_pack_a_f32 from a BF16 operand, widening to F32 on the fly (exact). */
+static void MAG_HOTPROC mag_sgemm_pack_a_bf16(int64_t mc, int64_t kc, const mag_bf16_t* a, int64_t rsa, int64_t csa, mag_f32_t* pa) {
+    for (int64_t i=0; i < mc; i += MAG_SGEMM_MR) {
+        int64_t mr = mag_xmin(MAG_SGEMM_MR, mc-i);
+        const mag_bf16_t* pi = a + i*rsa;
+        if (rsa == 1 && mr == MAG_SGEMM_MR) {
+            for (int64_t k=0; k < kc; ++k, pa += MAG_SGEMM_MR)
+                mag_vcvt_f32_bf16(MAG_SGEMM_MR, pa, pi + k*csa);
+        } else {
+            for (int64_t k=0; k < kc; ++k) {
+                int64_t r=0;
+                for (; r < mr; ++r) *pa++ = mag_bf16_to_f32(pi[r*rsa + k*csa]);
+                for (; r < MAG_SGEMM_MR; ++r) *pa++ = 0.0f;
+            }
+        }
+    }
+}
+
+/* Packs like mag_sgemm_pack_b_f32 from a BF16 operand, widening to F32 on the fly (exact). */
+static void MAG_HOTPROC mag_sgemm_pack_b_bf16(int64_t kc, int64_t nc, const mag_bf16_t* b, int64_t rsb, int64_t csb, mag_f32_t* pb) {
+    for (int64_t j=0; j < nc; j += MAG_SGEMM_NR, pb += kc*MAG_SGEMM_NR) {
+        int64_t nr = mag_xmin(MAG_SGEMM_NR, nc-j);
+        const mag_bf16_t* pj = b + j*csb;
+        if (csb == 1 && nr == MAG_SGEMM_NR) {
+            for (int64_t k=0; k < kc; ++k)
+                mag_vcvt_f32_bf16(MAG_SGEMM_NR, pb + k*MAG_SGEMM_NR, pj + k*rsb);
+        } else {
+            for (int64_t k=0; k < kc; ++k) {
+                int64_t c=0;
+                for (; c < nr; ++c) pb[k*MAG_SGEMM_NR + c] = mag_bf16_to_f32(pj[k*rsb + c*csb]);
+                for (; c < MAG_SGEMM_NR; ++c) pb[k*MAG_SGEMM_NR + c] = 0.0f;
+            }
+        }
+    }
+}
+
+/* Element offs of a F32, F16 or BF16 operand. */
+#define mag_sgemm_elem(p, type, offs) ((const void*)((const uint8_t*)(p) + (offs)*((type) == MAG_DTYPE_F32 ? sizeof(mag_f32_t) : sizeof(mag_f16_t))))
+
+static MAG_AINLINE void mag_sgemm_pack_a(int64_t mc, int64_t kc, const void* a, mag_dtype_t ta, int64_t rsa, int64_t csa, mag_f32_t* pa) {
+    if (ta == MAG_DTYPE_F16) mag_sgemm_pack_a_f16(mc, kc, a, rsa, csa, pa);
+    else if (ta == MAG_DTYPE_BF16) mag_sgemm_pack_a_bf16(mc, kc, a, rsa, csa, pa);
+    else mag_sgemm_pack_a_f32(mc, kc, a, rsa, csa, pa);
+}
+
+static MAG_AINLINE void mag_sgemm_pack_b(int64_t kc, int64_t nc, const void* b, mag_dtype_t tb, int64_t rsb, int64_t csb, mag_f32_t* pb) {
+    if (tb == MAG_DTYPE_F16) mag_sgemm_pack_b_f16(kc, nc, b, rsb, csb, pb);
+    else if (tb == MAG_DTYPE_BF16) mag_sgemm_pack_b_bf16(kc, nc, b, rsb, csb, pb);
+    else mag_sgemm_pack_b_f32(kc, nc, b, rsb, csb, pb);
+}
+
+/*
+** MR×NR microkernel: C[mr×nr] (+)= Ã[MR×kc] x B̃[kc×NR] with packed slivers Ã and B̃.
+** The full tile is accumulated in registers, only the valid mr×nr part is written back.
+*/
+static void MAG_HOTPROC mag_sgemm_ukernel_f32(
+    int64_t kc,
+    const mag_f32_t* pa,
+    const mag_f32_t* pb,
+    mag_f32_t* c,
+    int64_t ldc,
+    int64_t mr,
+    int64_t nr,
+    bool accumulate
+) {
+    mag_sgemm_vf32_t acc[MAG_SGEMM_MR][MAG_SGEMM_NV];
+    #pragma GCC unroll 8
+    for (int i=0; i < MAG_SGEMM_MR; ++i) {
+        #pragma GCC unroll 4
+        for (int v=0; v < MAG_SGEMM_NV; ++v)
+            acc[i][v] = mag_sgemm_vzero();
+    }
+    for (int64_t k=0; k < kc; ++k, pa += MAG_SGEMM_MR, pb += MAG_SGEMM_NR) {
+        mag_sgemm_vf32_t vb[MAG_SGEMM_NV];
+        #pragma GCC unroll 4
+        for (int v=0; v < MAG_SGEMM_NV; ++v)
+            vb[v] = mag_sgemm_vload(pb + v*MAG_SGEMM_VLEN);
+        #pragma GCC unroll 8
+        for (int i=0; i < MAG_SGEMM_MR; ++i) {
+            mag_sgemm_vf32_t va = mag_sgemm_vbcast(pa + i);
+            #pragma GCC unroll 4
+            for (int v=0; v < MAG_SGEMM_NV; ++v)
+                acc[i][v] = mag_sgemm_vfma(acc[i][v], va, vb[v]);
+        }
+    }
+    if (mag_likely(mr == MAG_SGEMM_MR && nr == MAG_SGEMM_NR)) { /* Full tile, store directly. */
+        #pragma GCC unroll 8
+        for (int i=0; i < MAG_SGEMM_MR; ++i) {
+            #pragma GCC unroll 4
+            for (int v=0; v < MAG_SGEMM_NV; ++v) {
+                mag_f32_t* pc = c + i*ldc + v*MAG_SGEMM_VLEN;
+                mag_sgemm_vstore(pc, accumulate ? mag_sgemm_vadd(mag_sgemm_vload(pc), acc[i][v]) : acc[i][v]);
+            }
+        }
+        return;
+    }
+    mag_f32_t tile[MAG_SGEMM_MR*MAG_SGEMM_NR]; /* Edge tile, spill and copy the valid part. */
+    for (int i=0; i < MAG_SGEMM_MR; ++i)
+        for (int v=0; v < MAG_SGEMM_NV; ++v)
+            mag_sgemm_vstore(tile + i*MAG_SGEMM_NR + v*MAG_SGEMM_VLEN, acc[i][v]);
+    for (int64_t i=0; i < mr; ++i) {
+        mag_f32_t* pc = c + i*ldc;
+        const mag_f32_t* pt = tile + i*MAG_SGEMM_NR;
+        if (accumulate) for (int64_t j=0; j < nr; ++j) pc[j] += pt[j];
+        else for (int64_t j=0; j < nr; ++j) pc[j] = pt[j];
+    }
+}
+
+/* Bias add and activation applied to the output tiles of a fused linear (MAG_OP_LINEAR), while they are still cache-hot. */
+typedef struct mag_sgemm_epilogue_t {
+    const mag_f32_t* bias;                                  /* Bias of the first output element, element (i, j) is at bias[i*brs + j*bcs]. */
+    int64_t brs;                                            /* Bias row stride, 0 if broadcasted. */
+    int64_t bcs;                                            /* Bias column stride, 0 if broadcasted, else 1. */
+    void (*act)(int64_t, mag_f32_t*, const mag_f32_t*);     /* Activation applied in place, NULL for identity. */
+} mag_sgemm_epilogue_t;
+
+static MAG_AINLINE void mag_sgemm_epilogue_run_f32(const mag_sgemm_epilogue_t* ep, mag_f32_t* c, int64_t n, const mag_f32_t* b, int64_t bs) {
+    if (bs) mag_vadd_f32(n, c, c, b);
+    else mag_vadds_f32(n, c, c, *b);
+    if (ep->act) (*ep->act)(n, c, c);
+}
+
+/* Applies the epilogue to the mr×nr block of C at c, which holds output element (i, j). */
+static void MAG_HOTPROC mag_sgemm_epilogue_f32(const mag_sgemm_epilogue_t* ep, mag_f32_t* c, int64_t ldc, int64_t i, int64_t j, int64_t mr, int64_t nr) {
+    if (nr == 1 && ldc == 1) { /* Single output column, the block is one contiguous run down the rows. */
+        mag_sgemm_epilogue_run_f32(ep, c, mr, ep->bias + i*ep->brs, ep->brs);
+        return;
+    }
+    for (int64_t r=0; r < mr; ++r)
+        mag_sgemm_epilogue_run_f32(ep, c + r*ldc, nr, ep->bias + (i+r)*ep->brs + j*ep->bcs, ep->bcs);
+}
+
+/* Sets up the epilogue of node r for the batch (ri5, ri4, ri3, ri2). Returns false if r is a plain matmul without epilogue. */
+static bool mag_sgemm_epilogue_init(const mag_tensor_t* r, int64_t ri5, int64_t ri4, int64_t ri3, int64_t ri2, mag_sgemm_epilogue_t* ep) {
+    static void (*const acts[MAG_ACTIVATION__NUM])(int64_t, mag_f32_t*, const mag_f32_t*) = {
+        [MAG_ACTIVATION_NONE] = NULL,
+        [MAG_ACTIVATION_SIGMOID] = &mag_vsigmoid_f32,
+        [MAG_ACTIVATION_RELU] = &mag_vrelu_f32,
+        [MAG_ACTIVATION_GELU] = &mag_vgelu_f32,
+        [MAG_ACTIVATION_SILU] = &mag_vsilu_f32,
+        [MAG_ACTIVATION_TANH] = &mag_vtanh_f32,
+    };
+    if (r->op != MAG_OP_LINEAR) return false;
+    const mag_tensor_t* bias = r->op_inputs[2];
+    mag_load_local_storage_group(bias, bd, shape);
+    mag_load_local_storage_group(bias, bs, strides);
+    ep->bias = mag_f32p(bias) + (ri5%bd5)*bs5 + (ri4%bd4)*bs4 + (ri3%bd3)*bs3 + (ri2%bd2)*bs2;
+    ep->brs = bd0 == 1 ? 0 : bd1;
+    ep->bcs = bd1 == 1 ? 0 : 1;
+    ep->act = acts[r->op_params[0].x.u32];
+    return true;
+}
+
+/*
+** Applies the MAG_OP_LINEAR epilogue of node r to a finished mt×nt block of C at c, which holds output element (i, j) of the batch.
+** Kernels computing whole output tiles without the microtile epilogue of mag_sgemm_f32 (GEMV, int8, block-quantized, BF16) call this per tile.
+*/
+static void mag_sgemm_epilogue_tile_f32(const mag_tensor_t* r, int64_t ri5, int64_t ri4, int64_t ri3, int64_t ri2, mag_f32_t* c, int64_t ldc, int64_t i, int64_t j, int64_t mt, int64_t nt) {
+    mag_sgemm_epilogue_t ep;
+    if (mag_sgemm_epilogue_init(r, ri5, ri4, ri3, ri2, &ep))
+        mag_sgemm_epilogue_f32(&ep, c, ldc, i, j, mt, nt);
+}
+
+/*
+** C[M×N] = A[M×K] x B[K×N], blocked for the cache hierarchy.
+** A and B are addressed through row and column strides (rs*, cs*), which covers all NN/NT/TN/TT layouts.
+** The layout only changes how the panels are packed, the microkernel always sees the same packed format.
+** pa and pb are packing scratch buffers, see mag_sgemm_scratch_size_a/b for their required sizes.
+** A and B are F32 or F16 (ta, tb). F16 operands are widened while packing, so the microkernel only ever sees F32.
+** If bp is not NULL, B was already packed over the full K depth by mag_sgemm_pack_b_f32 (see mag_blas_pack_matmul_rhs_f32),
+** bp points to the sliver of the first column and b, rsb, csb and pb are unused.
+** If ep is not NULL, it is applied to each microtile right after its last KC slice was accumulated.
+*/
+static void MAG_HOTPROC mag_sgemm_f32(
+    int64_t M,
+    int64_t N,
+    int64_t K,
+    const void* a,
+    mag_dtype_t ta,
+    int64_t rsa,
+    int64_t csa,
+    const void* b,
+    mag_dtype_t tb,
+    int64_t rsb,
+    int64_t csb,
+    mag_f32_t* c,
+    int64_t ldc,
+    mag_f32_t* pa,
+    mag_f32_t* pb,
+    const mag_f32_t* bp,
+    const mag_sgemm_epilogue_t* ep
+) {
+    if (mag_unlikely(M <= 0 || N <= 0)) return;
+    if (mag_unlikely(K <= 0)) {
+        for (int64_t i=0; i < M; ++i) memset(c + i*ldc, 0, N*sizeof(*c));
+        if (ep) mag_sgemm_epilogue_f32(ep, c, ldc, 0, 0, M, N);
+        return;
+    }
+    for (int64_t jc=0; jc < N; jc += MAG_SGEMM_NC) { /* L3: NC-wide column panels of B and C */
+        int64_t nc = mag_xmin(MAG_SGEMM_NC, N-jc);
+        for (int64_t pc=0; pc < K; pc += MAG_SGEMM_KC) { /* KC-deep slices of the inner dimension */
+            int64_t kc = mag_xmin(MAG_SGEMM_KC, K-pc);
+            const mag_f32_t* pbc = pb; /* KC×NC panel of B, NR-wide slivers are pbs elements apart */
+            int64_t pbs = kc*MAG_SGEMM_NR;
+            if (bp) { /* Pre-packed, slivers span the full K depth */
+                pbc = bp + jc*K + pc*MAG_SGEMM_NR;
+                pbs = K*MAG_SGEMM_NR;
+            } else {
+                mag_sgemm_pack_b(kc, nc, mag_sgemm_elem(b, tb, pc*rsb + jc*csb), tb, rsb, csb, pb);
+            }
+            for (int64_t ic=0; ic < M; ic += MAG_SGEMM_MC) { /* L2: MC-tall row panels of A and C */
+                int64_t mc = mag_xmin(MAG_SGEMM_MC, M-ic);
+                mag_sgemm_pack_a(mc, kc, mag_sgemm_elem(a, ta, ic*rsa + pc*csa), ta, rsa, csa, pa);
+                for (int64_t jr=0; jr < nc; jr += MAG_SGEMM_NR) { /* L1: microtiles */
+                    int64_t nr = mag_xmin(MAG_SGEMM_NR, nc-jr);
+                    for (int64_t ir=0; ir < mc; ir += MAG_SGEMM_MR) {
+                        int64_t mr = mag_xmin(MAG_SGEMM_MR, mc-ir);
+                        mag_sgemm_ukernel_f32(
+                            kc,
+                            pa + ir*kc,
+                            pbc + jr/MAG_SGEMM_NR*pbs,
+                            c + (ic+ir)*ldc + jc+jr,
+                            ldc,
+                            mr,
+                            nr,
+                            pc != 0
+                        );
+                        if (ep && pc+kc == K) /* Tile is final and still in L1 */
+                            mag_sgemm_epilogue_f32(ep, c + (ic+ir)*ldc + jc+jr, ldc, ic+ir, jc+jr, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static MAG_AINLINE int64_t mag_sgemm_scratch_size_a(int64_t M, int64_t K) { /* Elements of packed A panel for a M×K problem. */
+    return (mag_xmin(M, MAG_SGEMM_MC) + MAG_SGEMM_MR-1)/MAG_SGEMM_MR*MAG_SGEMM_MR * mag_xmin(K, MAG_SGEMM_KC);
+}
+
+static MAG_AINLINE int64_t mag_sgemm_scratch_size_b(int64_t N, int64_t K) { /* Elements of packed B panel for a K×N problem. */
+    return (mag_xmin(N, MAG_SGEMM_NC) + MAG_SGEMM_NR-1)/MAG_SGEMM_NR*MAG_SGEMM_NR * mag_xmin(K, MAG_SGEMM_KC);
+}
+
+static MAG_AINLINE int64_t mag_sgemm_packed_size_b(int64_t N, int64_t K) { /* Elements of a fully packed K×N B matrix. */
+    return (N + MAG_SGEMM_NR-1)/MAG_SGEMM_NR*MAG_SGEMM_NR * K;
+}
+
+/*
+** Row and column strides of a matmul operand. Operands are either row-major or the transpose of a row-major matrix
+** (a mag_transpose/mag_permute view of the two leading dims), which is read in place instead of being cloned first.
+** Batch dims are contiguous in both cases.
+*/
+static MAG_AINLINE void mag_sgemm_operand_strides(const mag_tensor_t* t, int64_t* rs, int64_t* cs) {
+    if (mag_tensor_is_transposed(t)) { *rs = 1; *cs = t->shape[0]; }
+    else { *rs = t->shape[1]; *cs = 1; }
+}
+
+#define MAG_SGEMM_TILES_PER_THREAD 4 /* Oversubscription of output tiles per thread, so the dynamic handout can balance uneven progress. */
+
+/*
+** Partition the M×N output into tm×tn tiles. Tiles start at the cache block sizes MC×NC and the larger side is halved
+** (in multiples of MR/NR) until there are enough tiles to keep all threads busy. This way tall-skinny and short-wide shapes
+** are split along whichever dimension has work left, instead of along rows only.
+*/
+static void mag_sgemm_tile_partition(int64_t M, int64_t N, int64_t batches, int64_t tc, int64_t* tm, int64_t* tn) {
+    *tm = (mag_xmin(M, MAG_SGEMM_MC) + MAG_SGEMM_MR-1)/MAG_SGEMM_MR*MAG_SGEMM_MR;
+    #ifdef MAG_ACCELERATE
+        *tn = N; /* vDSP_mmul needs contiguous rows, so only split M. */
+    #else
+        *tn = (mag_xmin(N, MAG_SGEMM_NC) + MAG_SGEMM_NR-1)/MAG_SGEMM_NR*MAG_SGEMM_NR;
+    #endif
+    if (tc <= 1) return;
+    int64_t want = tc*MAG_SGEMM_TILES_PER_THREAD;
+    while (batches*((M + *tm-1) / *tm)*((N + *tn-1) / *tn) < want) {
+        #ifdef MAG_ACCELERATE
+            bool split_n = false;
+        #else
+            bool split_n = *tn > MAG_SGEMM_NR && (*tn >= *tm || *tm <= MAG_SGEMM_MR);
+        #endif
+        if (split_n) *tn = (*tn/2 + MAG_SGEMM_NR-1)/MAG_SGEMM_NR*MAG_SGEMM_NR;
+        else if (*tm > MAG_SGEMM_MR) *tm = (*tm/2 + MAG_SGEMM_MR-1)/MAG_SGEMM_MR*MAG_SGEMM_MR;
+        else break; /* Can't split any further */
+    }
+}
+
+#define MAG_GEMV_MAX_VECS 8               /* Max vectors on one side of a matmul to take the GEMV path. */
+#define MAG_GEMV_CHUNK_BYTES (128<<10)     /* Matrix row chunk per work item, stays in L2 while all vectors are multiplied with it. */
+
+/*
+** Side of R = A x B streamed as the matrix by the GEMV path: 1 for A, 2 for B, 0 if neither side is a handful of vectors.
+** The matrix rows (A rows or B columns) must be contiguous, strided vectors (e.g. the columns of a row-major B) are packed.
+*/
+static MAG_AINLINE int mag_gemv_matrix_side(int64_t M, int64_t N, int64_t csx, int64_t rsy) {
+    bool a = N <= MAG_GEMV_MAX_VECS && csx == 1;
+    bool b = M <= MAG_GEMV_MAX_VECS && rsy == 1;
+    if (a && b) return N <= M ? 1 : 2; /* Stream the larger side */
+    return a ? 1 : b ? 2 : 0;
 }
 
-static void mag_blas_nop(const mag_compute_payload_t* payload) { (void)payload; }
-
-static void mag_blas_clone(const mag_compute_payload_t* payload) {
-    mag_tensor_t* r = payload->node;
-    const mag_tensor_t* x = r->op_inputs[0];
-    mag_assert2(mag_tensor_is_shape_eq(x, r));
-    mag_f32_t* b_r = mag_f32p_mut(r);
-    const mag_f32_t* b_x = mag_f32p(x);
-    memcpy(b_r, b_x, mag_tensor_data_size(r));
-}
-
-static void MAG_HOTPROC mag_blas_mean_f32(const mag_compute_payload_t* payload) {
+/*
+** Matrix-vector products in dot-product form: R[i, j] = A[i, :] · B[:, j], built on mag_vdot_f32.
+** Single-column operands make the blocked SGEMM pad each NR-wide microtile to a single lane, while the product is bound by
+** streaming the matrix from memory anyway. The matrix side (A if B is the vector side, else Bᵀ) is split into row chunks which
+** threads grab from the shared cursor. All vectors (columns of the vector side and batches sharing the same matrix)
+** are multiplied against a chunk while it is cache resident, so several vectors cost a single pass over the matrix.
+** Vectors with strided elements are packed once per batch into contiguous rows.
+*/
+static void MAG_HOTPROC mag_blas_gemv_f32(const mag_compute_payload_t* payload) {
     mag_tensor_t* r = payload->node;
     const mag_tensor_t* x = r->op_inputs[0];
-    mag_f32_t* b_r = mag_f32p_mut(r);
-    const mag_f32_t* b_x = mag_f32p(x);
-    mag_load_local_storage_group(r, r_s, strides);
-    mag_load_local_storage_group(x, x_d, shape);
-    mag_load_local_storage_group(x, x_s, strides);
-    mag_f64_t sum = 0.0;
-    for (int64_t i5=0; i5 < x_d5; ++i5) {
-        for (int64_t i4=0; i4 < x_d4; ++i4) {
-            for (int64_t i3=0; i3 < x_d3; ++i3) {
-                for (int64_t i2=0; i2 < x_d2; ++i2) {
-                    for (int64_t i1=0; i1 < x_d1; ++i1) {
-                        const mag_f32_t* p_x = b_x + i1*x_s1 + i2*x_s2 + i3*x_s3 + i4*x_s4 + i5*x_s5;
-                        mag_bnd_chk(p_x, b_x, mag_tensor_data_size(x));
-                        sum += mag_vsum_f64_f32(
-                            x_d0,
-                            p_x
-                        );
-                    }
-                }
+    const mag_tensor_t* y = r->op_inputs[1];
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    const mag_f32_t* by = mag_f32p(y);
+    mag_load_local_storage_group(r, rd, shape);
+    mag_load_local_storage_group(r, rs, strides);
+    mag_load_local_storage_group(x, xd, shape);
+    mag_load_local_storage_group(x, xs, strides);
+    mag_load_local_storage_group(y, yd, shape);
+    mag_load_local_storage_group(y, ys, strides);
+    int64_t M = xd0;
+    int64_t K = xd1;
+    int64_t N = yd1;
+    int64_t rsx, csx, rsy, csy;
+    mag_sgemm_operand_strides(x, &rsx, &csx);
+    mag_sgemm_operand_strides(y, &rsy, &csy);
+    bool mat_is_x = mag_gemv_matrix_side(M, N, csx, rsy) == 1;
+    int64_t nm = mat_is_x ? M : N; /* Matrix rows */
+    int64_t nv = mat_is_x ? N : M; /* Vectors */
+    int64_t ms = mat_is_x ? rsx : csy; /* Stride between matrix rows */
+    int64_t vs = mat_is_x ? csy : rsx; /* Stride between vectors */
+    int64_t ves = mat_is_x ? rsy : csx; /* Stride between vector elements */
+    mag_f32_t* pk = NULL; /* Packed vectors, if strided */
+    const mag_f32_t* pk_src = NULL;
+    int64_t rms = mat_is_x ? N : 1; /* Output stride along matrix rows */
+    int64_t rvs = mat_is_x ? 1 : N; /* Output stride along vectors */
+    int64_t tc = payload->thread_num;
+    int64_t batches = rd5*rd4*rd3*rd2;
+    int64_t chunk = mag_xmax(1, MAG_GEMV_CHUNK_BYTES/(K*(int64_t)sizeof(mag_f32_t)));
+    if (tc > 1) chunk = mag_xmin(chunk, mag_xmax(1, (nm + tc*MAG_SGEMM_TILES_PER_THREAD-1)/(tc*MAG_SGEMM_TILES_PER_THREAD)));
+    int64_t nchunks = (nm + chunk-1)/chunk;
+    int64_t nitems = nchunks*batches;
+    for (;;) {
+        int64_t ti = mag_atomic_fetch_add(payload->cursor, 1, MAG_MO_RELAXED); /* Grab next chunk */
+        if (ti >= nitems) break;
+        int64_t ro = ti % batches; /* Batches vary fastest, so a broadcasted matrix chunk is reused by all of them. */
+        int64_t ci = ti / batches;
+        int64_t ri2 = ro % rd2; ro /= rd2;
+        int64_t ri3 = ro % rd3; ro /= rd3;
+        int64_t ri4 = ro % rd4; ro /= rd4;
+        int64_t ri5 = ro;
+        int64_t m0 = ci*chunk;
+        int64_t m1 = mag_xmin(m0 + chunk, nm);
+        mag_f32_t* pr = br + ri5*rs5 + ri4*rs4 + ri3*rs3 + ri2*rs2;
+        const mag_f32_t* px = bx + (ri5%xd5)*xs5 + (ri4%xd4)*xs4 + (ri3%xd3)*xs3 + (ri2%xd2)*xs2;
+        const mag_f32_t* py = by + (ri5%yd5)*ys5 + (ri4%yd4)*ys4 + (ri3%yd3)*ys3 + (ri2%yd2)*ys2;
+        const mag_f32_t* pm = mat_is_x ? px : py;
+        const mag_f32_t* pv = mat_is_x ? py : px;
+        int64_t pvs = vs;
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        mag_bnd_chk(pm + m0*ms, mat_is_x ? bx : by, mag_tensor_data_size(mat_is_x ? x : y));
+        if (ves != 1) {
+            if (!pk) pk = mag_alloc_aligned(nv*K*sizeof(*pk), MAG_CACHE_LINE_SIZE);
+            if (pk_src != pv) { /* Batches sharing the vectors pack them once */
+                for (int64_t k=0; k < K; ++k)
+                    for (int64_t v=0; v < nv; ++v)
+                        pk[v*K + k] = pv[k*ves + v*vs];
+                pk_src = pv;
             }
+            pv = pk;
+            pvs = K;
         }
+        for (int64_t v=0; v < nv; ++v) {
+            const mag_f32_t* pvv = pv + v*pvs;
+            mag_f32_t* prv = pr + v*rvs;
+            for (int64_t m=m0; m < m1; ++m)
+                prv[m*rms] = mag_vdot_f32(K, pm + m*ms, pvv);
+        }
+        if (mat_is_x) mag_sgemm_epilogue_tile_f32(r, ri5, ri4, ri3, ri2, pr + m0*N, N, m0, 0, m1-m0, N);
+        else mag_sgemm_epilogue_tile_f32(r, ri5, ri4, ri3, ri2, pr + m0, N, 0, m0, M, m1-m0);
     }
-    sum /= (mag_f64_t)x->numel;
-    *b_r = (mag_f32_t)sum;
+    if (pk) mag_free_aligned(pk);
 }
 
-static void MAG_HOTPROC mag_blas_min_f32(const mag_compute_payload_t* payload) {
+#define MAG_Q8GEMM_TM 64 /* Output tile rows of the int8 matmul */
+#define MAG_Q8GEMM_TN 64 /* Output tile columns of the int8 matmul, the quantized B columns of a tile stay in L2 */
+
+/*
+** Int8 matrix multiplication: R = A x B with A int8 and B int8 or F32.
+** A is row-major and quantized in blocks of bs elements along K. B is read column-wise, which are contiguous for an int8
+** transposed view. F32 B columns are quantized on the fly with the same block size, once per output tile.
+** Each block contributes sa*sb*(qa · qb), where the dot product is accumulated exactly in int32 by mag_vdot_i8.
+*/
+static void MAG_HOTPROC mag_blas_matmul_q8(const mag_compute_payload_t* payload) {
     mag_tensor_t* r = payload->node;
-    const mag_tensor_t* const x = r->op_inputs[0];
-    mag_f32_t* b_r = mag_f32p_mut(r);
-    const mag_f32_t* b_x = mag_f32p(x);
-    mag_load_local_storage_group(r, r_s, strides);
-    mag_load_local_storage_group(x, x_d, shape);
-    mag_load_local_storage_group(x, x_s, strides);
-    mag_f32_t min = INFINITY;
-    for (int64_t i5=0; i5 < x_d5; ++i5) {
-        for (int64_t i4=0; i4 < x_d4; ++i4) {
-            for (int64_t i3=0; i3 < x_d3; ++i3) {
-                for (int64_t i2=0; i2 < x_d2; ++i2) {
-                    for (int64_t i1=0; i1 < x_d1; ++i1) {
-                        const mag_f32_t* p_x = b_x + i1*x_s1 + i2*x_s2 + i3*x_s3 + i4*x_s4 + i5*x_s5;
-                        mag_bnd_chk(p_x, b_x, mag_tensor_data_size(x));
-                        min = fminf(mag_vmin_f32(x_d0, p_x), min);
-                    }
+    const mag_tensor_t* x = r->op_inputs[0];
+    const mag_tensor_t* y = r->op_inputs[1];
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_i8_t* bx = mag_i8p(x);
+    const mag_f32_t* sx = mag_q8_scalesp(x);
+    mag_load_local_storage_group(r, rd, shape);
+    mag_load_local_storage_group(r, rs, strides);
+    mag_load_local_storage_group(x, xd, shape);
+    mag_load_local_storage_group(x, xs, strides);
+    mag_load_local_storage_group(y, yd, shape);
+    mag_load_local_storage_group(y, ys, strides);
+    int64_t M = xd0;
+    int64_t K = xd1;
+    int64_t N = yd1;
+    int64_t bs = x->qblock;
+    int64_t nb = K/bs;
+    bool yq = y->dtype == MAG_DTYPE_I8;
+    int64_t rsy, csy;
+    mag_sgemm_operand_strides(y, &rsy, &csy);
+    int64_t batches = rd5*rd4*rd3*rd2;
+    int64_t ntm = (M + MAG_Q8GEMM_TM-1)/MAG_Q8GEMM_TM;
+    int64_t ntn = (N + MAG_Q8GEMM_TN-1)/MAG_Q8GEMM_TN;
+    int64_t ntiles = batches*ntm*ntn;
+    mag_i8_t* qyb = NULL; /* Quantized B columns of the tile, if B is F32 */
+    mag_f32_t* syb = NULL;
+    mag_f32_t* col = NULL;
+    for (;;) {
+        int64_t ti = mag_atomic_fetch_add(payload->cursor, 1, MAG_MO_RELAXED); /* Grab next tile */
+        if (ti >= ntiles) break;
+        int64_t jt = ti % ntn; /* Column tiles vary fastest, so the A rows of a tile stay cached. */
+        int64_t it = ti / ntn % ntm;
+        int64_t ro = ti / (ntm*ntn);
+        int64_t ri2 = ro % rd2; ro /= rd2;
+        int64_t ri3 = ro % rd3; ro /= rd3;
+        int64_t ri4 = ro % rd4; ro /= rd4;
+        int64_t ri5 = ro;
+        int64_t i0 = it*MAG_Q8GEMM_TM;
+        int64_t j0 = jt*MAG_Q8GEMM_TN;
+        int64_t mt = mag_xmin(MAG_Q8GEMM_TM, M-i0);
+        int64_t nt = mag_xmin(MAG_Q8GEMM_TN, N-j0);
+        int64_t xo = (ri5%xd5)*xs5 + (ri4%xd4)*xs4 + (ri3%xd3)*xs3 + (ri2%xd2)*xs2 + i0*K; /* Element offset of the first A row */
+        int64_t yo = (ri5%yd5)*ys5 + (ri4%yd4)*ys4 + (ri3%yd3)*ys3 + (ri2%yd2)*ys2 + j0*csy; /* Element offset of the first B column */
+        mag_f32_t* pr = br + ri5*rs5 + ri4*rs4 + ri3*rs3 + ri2*rs2 + i0*N + j0;
+        const mag_i8_t* qa = bx + xo;
+        const mag_f32_t* sa = sx + xo/bs;
+        const mag_i8_t* qb;
+        const mag_f32_t* sb;
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        mag_bnd_chk(qa, bx, mag_tensor_data_size(x));
+        if (yq) { /* Columns of the transposed view are rows of its storage */
+            qb = mag_i8p(y) + yo;
+            sb = mag_q8_scalesp(y) + yo/bs;
+        } else {
+            if (!qyb) { /* Allocate quantization buffers once per thread on first use. */
+                qyb = mag_alloc_aligned(MAG_Q8GEMM_TN*K*sizeof(*qyb), MAG_CACHE_LINE_SIZE);
+                syb = mag_alloc_aligned(MAG_Q8GEMM_TN*nb*sizeof(*syb), MAG_CACHE_LINE_SIZE);
+                col = mag_alloc_aligned(K*sizeof(*col), MAG_CACHE_LINE_SIZE);
+            }
+            const mag_f32_t* py = mag_f32p(y) + yo;
+            for (int64_t j=0; j < nt; ++j) {
+                const mag_f32_t* pc = py + j*csy;
+                const mag_f32_t* pk = pc;
+                if (rsy != 1) { /* Gather strided column */
+                    for (int64_t k=0; k < K; ++k) col[k] = pc[k*rsy];
+                    pk = col;
                 }
+                for (int64_t b=0; b < nb; ++b)
+                    syb[j*nb + b] = mag_vquantize_i8_f32(bs, qyb + j*K + b*bs, pk + b*bs);
             }
+            qb = qyb;
+            sb = syb;
         }
-    }
-    *b_r = min;
-}
-
-static void MAG_HOTPROC mag_blas_max_f32(const mag_compute_payload_t* payload) {
-    mag_tensor_t* r = payload->node;
-    const mag_tensor_t* const x = r->op_inputs[0];
-    mag_f32_t* b_r = mag_f32p_mut(r);
-    const mag_f32_t* b_x = mag_f32p(x);
-    mag_load_local_storage_group(r, r_s, strides);
-    mag_load_local_storage_group(x, x_d, shape);
-    mag_load_local_storage_group(x, x_s, strides);
-    mag_f32_t max = -INFINITY;
-    for (int64_t i5=0; i5 < x_d5; ++i5) {
-        for (int64_t i4=0; i4 < x_d4; ++i4) {
-            for (int64_t i3=0; i3 < x_d3; ++i3) {
-                for (int64_t i2=0; i2 < x_d2; ++i2) {
-                    for (int64_t i1=0; i1 < x_d1; ++i1) {
-                        const mag_f32_t* p_x = b_x + i1*x_s1 + i2*x_s2 + i3*x_s3 + i4*x_s4 + i5*x_s5;
-                        mag_bnd_chk(p_x, b_x, mag_tensor_data_size(x));
-                        max = fmaxf(mag_vmax_f32(x_d0, p_x), max);
-                    }
-                }
+        for (int64_t i=0; i < mt; ++i) {
+            const mag_i8_t* qai = qa + i*K;
+            const mag_f32_t* sai = sa + i*nb;
+            for (int64_t j=0; j < nt; ++j) {
+                const mag_i8_t* qbj = qb + j*K;
+                const mag_f32_t* sbj = sb + j*nb;
+                mag_f32_t sum = 0.0f;
+                for (int64_t b=0; b < nb; ++b)
+                    sum += sai[b]*sbj[b]*(mag_f32_t)mag_vdot_i8(bs, qai + b*bs, qbj + b*bs);
+                pr[i*N + j] = sum;
             }
         }
+        mag_sgemm_epilogue_tile_f32(r, ri5, ri4, ri3, ri2, pr, N, i0, j0, mt, nt);
+    }
+    if (qyb) {
+        mag_free_aligned(qyb);
+        mag_free_aligned(syb);
+        mag_free_aligned(col);
     }
-    *b_r = max;
 }
 
-static void MAG_HOTPROC mag_blas_sum_f32(const mag_compute_payload_t* payload) {
+#define MAG_QBGEMM_TM 64 /* Quantized rows per tile of the block-quantized matmul */
+#define MAG_QBGEMM_TN 64 /* F32 vectors per tile of the block-quantized matmul, they stay in L2 while the quantized rows stream by */
+#define MAG_QBGEMM_SGEMM_MIN 16 /* From this many F32 vectors per tile on, the product is compute-bound: the quantized rows are dequantized once and multiplied by mag_sgemm_f32 */
+
+/*
+** Block-quantized matrix multiplication: R = A x B with one Q8 or Q4 operand and one F32 operand.
+** The quantized operand is read as rows of blocks along K: rows of a row-major A, or columns of a transposed B, which are rows of its storage.
+** Each quantized row is dotted with the F32 vectors of the other operand (columns of B or rows of A) by mag_vdot4_qb_f32,
+** which dequantizes in registers, so the weights are only read at 8.5 or 4.5 bits per element.
+** Strided F32 vectors are gathered once per tile, row tiles vary fastest so consecutive tiles of a thread reuse them.
+** Tiles with many F32 vectors (batched activations) amortize a dequantization of their quantized rows and take the blocked F32 kernel instead.
+*/
+static void MAG_HOTPROC mag_blas_matmul_qb(const mag_compute_payload_t* payload) {
     mag_tensor_t* r = payload->node;
-    const mag_tensor_t* const x = r->op_inputs[0];
-    mag_f32_t* b_r = mag_f32p_mut(r);
-    const mag_f32_t* b_x = mag_f32p(x);
-    mag_load_local_storage_group(r, r_s, strides);
-    mag_load_local_storage_group(x, x_d, shape);
-    mag_load_local_storage_group(x, x_s, strides);
-    mag_f64_t sum = 0.0;
-    for (int64_t i5=0; i5 < x_d5; ++i5) {
-        for (int64_t i4=0; i4 < x_d4; ++i4) {
-            for (int64_t i3=0; i3 < x_d3; ++i3) {
-                for (int64_t i2=0; i2 < x_d2; ++i2) {
-                    for (int64_t i1=0; i1 < x_d1; ++i1) {
-                        const mag_f32_t* p_x = b_x + i1*x_s1 + i2*x_s2 + i3*x_s3 + i4*x_s4 + i5*x_s5;
-                        mag_bnd_chk(p_x, b_x, mag_tensor_data_size(x));
-                        sum += mag_vsum_f64_f32(x_d0, p_x);
-                    }
+    const mag_tensor_t* x = r->op_inputs[0];
+    const mag_tensor_t* y = r->op_inputs[1];
+    bool qa = mag_dtype_is_qblock(x->dtype); /* Quantized A, else quantized (transposed) B */
+    const mag_tensor_t* q = qa ? x : y;
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_f32_t* bf = qa ? mag_f32p(y) : mag_f32p(x);
+    const void* bq = (const void*)q->storage.base;
+    mag_load_local_storage_group(r, rd, shape);
+    mag_load_local_storage_group(r, rs, strides);
+    mag_load_local_storage_group(x, xd, shape);
+    mag_load_local_storage_group(x, xs, strides);
+    mag_load_local_storage_group(y, yd, shape);
+    mag_load_local_storage_group(y, ys, strides);
+    int64_t M = xd0;
+    int64_t K = xd1;
+    int64_t N = yd1;
+    int64_t nb = K/MAG_QK;
+    int64_t rsx, csx, rsy, csy;
+    mag_sgemm_operand_strides(x, &rsx, &csx);
+    mag_sgemm_operand_strides(y, &rsy, &csy);
+    int64_t nq = qa ? M : N;        /* Quantized rows */
+    int64_t nf = qa ? N : M;        /* F32 vectors */
+    int64_t fvs = qa ? csy : rsx;   /* Stride between F32 vectors */
+    int64_t fks = qa ? rsy : csx;   /* Stride along K within a F32 vector */
+    int64_t ors = qa ? N : 1;       /* Output stride between quantized rows */
+    int64_t ofs = qa ? 1 : N;       /* Output stride between F32 vectors */
+    int64_t batches = rd5*rd4*rd3*rd2;
+    int64_t ntq = (nq + MAG_QBGEMM_TM-1)/MAG_QBGEMM_TM;
+    int64_t ntf = (nf + MAG_QBGEMM_TN-1)/MAG_QBGEMM_TN;
+    int64_t ntiles = batches*ntq*ntf;
+    mag_f32_t* fb = NULL; /* Gathered F32 vectors of the tile, if they are strided */
+    int64_t fbt = -1;     /* F32 tile held by fb */
+    mag_f32_t* wq = NULL; /* Dequantized rows of the tile and packing buffers for mag_sgemm_f32 */
+    mag_f32_t* pa = NULL;
+    mag_f32_t* pb = NULL;
+    for (;;) {
+        int64_t ti = mag_atomic_fetch_add(payload->cursor, 1, MAG_MO_RELAXED); /* Grab next tile */
+        if (ti >= ntiles) break;
+        int64_t it = ti % ntq;
+        int64_t ft = ti / ntq; /* F32 tile including the batch */
+        int64_t jt = ft % ntf;
+        int64_t ro = ft / ntf;
+        int64_t ri2 = ro % rd2; ro /= rd2;
+        int64_t ri3 = ro % rd3; ro /= rd3;
+        int64_t ri4 = ro % rd4; ro /= rd4;
+        int64_t ri5 = ro;
+        int64_t q0 = it*MAG_QBGEMM_TM;
+        int64_t f0 = jt*MAG_QBGEMM_TN;
+        int64_t mq = mag_xmin(MAG_QBGEMM_TM, nq-q0);
+        int64_t mf = mag_xmin(MAG_QBGEMM_TN, nf-f0);
+        int64_t xb = (ri5%xd5)*xs5 + (ri4%xd4)*xs4 + (ri3%xd3)*xs3 + (ri2%xd2)*xs2;
+        int64_t yb = (ri5%yd5)*ys5 + (ri4%yd4)*ys4 + (ri3%yd3)*ys3 + (ri2%yd2)*ys2;
+        const void* pq = mag_qb_block(bq, q->dtype, ((qa ? xb : yb) + q0*K)/MAG_QK); /* Rows of the quantized operand are K elements apart in both cases */
+        const mag_f32_t* pf = bf + (qa ? yb : xb) + f0*fvs;
+        mag_f32_t* pr = br + ri5*rs5 + ri4*rs4 + ri3*rs3 + ri2*rs2 + q0*ors + f0*ofs;
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        mag_bnd_chk(pq, bq, mag_tensor_data_size(q));
+        if (mf >= MAG_QBGEMM_SGEMM_MIN) {
+            if (!wq) { /* Allocate once per thread on first use. */
+                wq = mag_alloc_aligned(MAG_QBGEMM_TM*K*sizeof(*wq), MAG_CACHE_LINE_SIZE);
+                pa = mag_alloc_aligned(mag_sgemm_scratch_size_a(mag_xmax(MAG_QBGEMM_TM, MAG_QBGEMM_TN), K)*sizeof(*pa), MAG_CACHE_LINE_SIZE);
+                pb = mag_alloc_aligned(mag_sgemm_scratch_size_b(mag_xmax(MAG_QBGEMM_TM, MAG_QBGEMM_TN), K)*sizeof(*pb), MAG_CACHE_LINE_SIZE);
+            }
+            mag_vdequantize_f32_qb(mq*nb, wq, pq, q->dtype);
+            if (qa) mag_sgemm_f32(mq, mf, K, wq, MAG_DTYPE_F32, K, 1, pf, MAG_DTYPE_F32, fks, fvs, pr, N, pa, pb, NULL, NULL);
+            else mag_sgemm_f32(mf, mq, K, pf, MAG_DTYPE_F32, fvs, fks, wq, MAG_DTYPE_F32, 1, K, pr, N, pa, pb, NULL, NULL);
+        } else {
+            int64_t ldf = fvs;
+            if (fks != 1) { /* Gather strided vectors, unless this thread already holds them */
+                if (!fb) fb = mag_alloc_aligned(MAG_QBGEMM_TN*K*sizeof(*fb), MAG_CACHE_LINE_SIZE); /* Allocate once per thread on first use. */
+                if (fbt != ft) {
+                    for (int64_t j=0; j < mf; ++j)
+                        for (int64_t k=0; k < K; ++k)
+                            fb[j*K + k] = pf[j*fvs + k*fks];
+                    fbt = ft;
+                }
+                pf = fb;
+                ldf = K;
+            }
+            for (int64_t i=0; i < mq; ++i) {
+                const void* qi = mag_qb_block(pq, q->dtype, i*nb);
+                for (int64_t j=0; j < mf; j += 4) {
+                    int64_t nx = mag_xmin(4, mf-j);
+                    mag_f32_t o[4];
+                    mag_vdot4_qb_f32(nb, qi, q->dtype, pf + j*ldf, ldf, nx, o);
+                    for (int64_t v=0; v < nx; ++v)
+                        pr[i*ors + (j+v)*ofs] = o[v];
                 }
             }
         }
+        mag_sgemm_epilogue_tile_f32(r, ri5, ri4, ri3, ri2, pr, N, qa ? q0 : f0, qa ? f0 : q0, qa ? mq : mf, qa ? mf : mq);
+    }
+    if (fb) mag_free_aligned(fb);
+    if (wq) {
+        mag_free_aligned(wq);
+        mag_free_aligned(pa);
+        mag_free_aligned(pb);
     }
-    *b_r = (mag_f32_t)sum;
 }
 
-#define mag_cpu_blas_impl_unary(T, name) \
-    static void MAG_HOTPROC mag_blas_##name##_##T(const mag_compute_payload_t* payload) { \
-        mag_tensor_t* r = payload->node; \
-        const mag_tensor_t* x = r->op_inputs[0]; \
-        mag_##T##_t* br = mag_##T##p_mut(r); \
-        const mag_##T##_t* bx = mag_##T##p(x); \
-        mag_load_local_storage_group(r, r_s, strides); \
-        mag_load_local_storage_group(x, x_s, strides); \
-        int64_t tc = payload->thread_num; \
-        int64_t ti = payload->thread_idx; \
-        int64_t numel = r->numel; \
-        int64_t chunk = (numel + tc - 1)/tc; \
-        int64_t ra = ti*chunk; \
-        int64_t vmel = mag_xmin(ra + chunk, numel) - ra; \
-        if (mag_unlikely(vmel <= 0)) return; \
-        mag_##T##_t* pr = br + ra; \
-        const mag_##T##_t* px = bx + ra; \
-        mag_bnd_chk(pr, br, mag_tensor_data_size(r)); \
-        mag_bnd_chk(px, bx, mag_tensor_data_size(x)); \
-        mag_v##name##_##T(vmel, pr, px); \
+#if defined(__AVX512BF16__) /* Without VDPBF16PS, BF16 products take the blocked F32 kernel, see mag_blas_matmul_f32. */
+/*
+** 4x4 block of BF16 dot products o[i*ldo + j] = a_i · b_j along K, with a_i = a + i*lda and b_j = b + j*ldb.
+** Each loaded vector feeds four VDPBF16PS dot products.
+*/
+static void MAG_HOTPROC mag_vdot4x4_bf16(
+    int64_t numel,
+    const mag_bf16_t* a,
+    int64_t lda,
+    const mag_bf16_t* b,
+    int64_t ldb,
+    mag_f32_t* o,
+    int64_t ldo
+) {
+    __m512 acc[4][4];
+    for (int i=0; i < 4; ++i)
+        for (int j=0; j < 4; ++j)
+            acc[i][j] = _mm512_setzero_ps();
+    int64_t k=0;
+    for (; k+31 < numel; k += 32) {
+        __m512bh vb[4];
+        for (int j=0; j < 4; ++j) vb[j] = (__m512bh)_mm512_loadu_si512(b + j*ldb + k);
+        for (int i=0; i < 4; ++i) {
+            __m512bh va = (__m512bh)_mm512_loadu_si512(a + i*lda + k);
+            for (int j=0; j < 4; ++j)
+                acc[i][j] = _mm512_dpbf16_ps(acc[i][j], va, vb[j]);
+        }
     }
-
-mag_cpu_blas_impl_unary(f32, abs)
-mag_cpu_blas_impl_unary(f32, neg)
-mag_cpu_blas_impl_unary(f32, log)
-mag_cpu_blas_impl_unary(f32, sqr)
-mag_cpu_blas_impl_unary(f32, sqrt)
-mag_cpu_blas_impl_unary(f32, sin)
-mag_cpu_blas_impl_unary(f32, cos)
-mag_cpu_blas_impl_unary(f32, step)
-mag_cpu_blas_impl_unary(f32, softmax)
-mag_cpu_blas_impl_unary(f32, softmax_dv)
-mag_cpu_blas_impl_unary(f32, sigmoid)
-mag_cpu_blas_impl_unary(f32, sigmoid_dv)
-mag_cpu_blas_impl_unary(f32, hard_sigmoid)
-mag_cpu_blas_impl_unary(f32, silu)
-mag_cpu_blas_impl_unary(f32, silu_dv)
-mag_cpu_blas_impl_unary(f32, tanh)
-mag_cpu_blas_impl_unary(f32, tanh_dv)
-mag_cpu_blas_impl_unary(f32, relu)
-mag_cpu_blas_impl_unary(f32, relu_dv)
-mag_cpu_blas_impl_unary(f32, gelu)
-mag_cpu_blas_impl_unary(f32, gelu_dv)
-
-#undef mag_cpu_blas_impl_unary
-
-#define mag_cpu_blas_impl_unary_scalar(T, name) \
-    static void MAG_HOTPROC mag_blas_##name##s_##T(const mag_compute_payload_t* payload) { \
-        mag_tensor_t* r = payload->node; \
-        const mag_tensor_t* x = r->op_inputs[0]; \
-        mag_##T##_t xi = r->op_params->x.T; \
-        mag_##T##_t* br = mag_##T##p_mut(r); \
-        const mag_##T##_t* bx = mag_##T##p(x); \
-        mag_load_local_storage_group(r, r_s, strides); \
-        mag_load_local_storage_group(x, x_s, strides); \
-        int64_t tc = payload->thread_num; \
-        int64_t ti = payload->thread_idx; \
-        int64_t numel = r->numel; \
-        int64_t chunk = (numel + tc - 1)/tc; \
-        int64_t ra = ti*chunk; \
-        int64_t vmel = mag_xmin(ra + chunk, numel) - ra; \
-        if (mag_unlikely(vmel <= 0)) return; \
-        mag_##T##_t* pr = br + ra; \
-        const mag_##T##_t* px = bx + ra; \
-        mag_bnd_chk(pr, br, mag_tensor_data_size(r)); \
-        mag_bnd_chk(px, bx, mag_tensor_data_size(x)); \
-        mag_v##name##s_##T(vmel, pr, px, xi); \
+    for (int i=0; i < 4; ++i) {
+        for (int j=0; j < 4; ++j) {
+            mag_f32_t sum = _mm512_reduce_add_ps(acc[i][j]);
+            for (int64_t kk=k; kk < numel; ++kk) /* Process leftovers scalar-wise */
+                sum += mag_bf16_to_f32(a[i*lda + kk])*mag_bf16_to_f32(b[j*ldb + kk]);
+            o[i*ldo + j] = sum;
+        }
     }
+}
 
-mag_cpu_blas_impl_unary_scalar(f32, add)
-mag_cpu_blas_impl_unary_scalar(f32, sub)
-mag_cpu_blas_impl_unary_scalar(f32, mul)
-mag_cpu_blas_impl_unary_scalar(f32, div)
-
-#undef mag_cpu_blas_impl_unary_scalar
+#define MAG_BF16GEMM_TM 64 /* Output tile rows of the BF16 matmul */
+#define MAG_BF16GEMM_TN 64 /* Output tile columns of the BF16 matmul */
 
-#define mag_cpu_blas_impl_binary(T, name, op) \
-    static void MAG_HOTPROC mag_blas_##name##_##T(const mag_compute_payload_t* payload) { \
-        mag_tensor_t* r = payload->node; \
-        const mag_tensor_t* x = r->op_inputs[0]; \
-        const mag_tensor_t* y = r->op_inputs[1]; \
-        mag_##T##_t* br = mag_##T##p_mut(r); \
-        const mag_##T##_t* bx = mag_##T##p(x); \
-        const mag_##T##_t* by = mag_##T##p(y); \
-        mag_load_local_storage_group(r, rd, shape); \
-        mag_load_local_storage_group(r, rs, strides); \
-        mag_load_local_storage_group(x, xd, shape); \
-        mag_load_local_storage_group(x, xs, strides); \
-        mag_load_local_storage_group(y, yd, shape); \
-        mag_load_local_storage_group(y, ys, strides); \
-        int64_t tc = payload->thread_num; \
-        int64_t ti = payload->thread_idx; \
-        if (xd0==yd0 && xd1==yd1 && xd2==yd2 && xd3==yd3 && xd4==yd4 && xd5==yd5) { \
-            int64_t numel = r->numel; \
-            int64_t chunk = (numel + tc - 1)/tc; \
-            int64_t ra = ti*chunk; \
-            int64_t vmel = mag_xmin(ra + chunk, numel) - ra; \
-            if (mag_unlikely(vmel <= 0)) return; \
-            mag_##T##_t* pr = br + ra; \
-            const mag_##T##_t* px = bx + ra; \
-            const mag_##T##_t* py = by + ra; \
-            mag_bnd_chk(pr, br, mag_tensor_data_size(r)); \
-            mag_bnd_chk(px, bx, mag_tensor_data_size(x)); \
-            mag_bnd_chk(py, by, mag_tensor_data_size(y)); \
-            mag_v##name##_##T(vmel, pr, px, py); \
-            return; \
-        } \
-        int64_t numel = xd5*xd4*xd3*xd2*xd1; \
-        int64_t chunk = (numel + tc - 1)/tc; \
-        int64_t ra = chunk*ti; \
-        int64_t rb = mag_xmin(ra+chunk, numel); \
-        if (ys0 == 1) { \
-            for (int64_t ri=ra; ri < rb; ++ri) { \
-                int64_t ro = ri; \
-                int64_t xi1 = ro % xd1; ro /= xd1; \
-                int64_t xi2 = ro % xd2; ro /= xd2; \
-                int64_t xi3 = ro % xd3; ro /= xd3; \
-                int64_t xi4 = ro % xd4; ro /= xd4; \
-                int64_t xi5 = ro; \
-                int64_t yi5 = xi5 % yd5; \
-                int64_t yi4 = xi4 % yd4; \
-                int64_t yi3 = xi3 % yd3; \
-                int64_t yi2 = xi2 % yd2; \
-                int64_t yi1 = xi1 % yd1; \
-                mag_##T##_t* pr = br + xi5*rs5 + xi4*rs4 + xi3*rs3 + xi2*rs2 + xi1*rs1; \
-                const mag_##T##_t* px = bx + xi5*xs5 + xi4*xs4 + xi3*xs3 + xi2*xs2 + xi1*xs1; \
-                const mag_##T##_t* py = by + yi5*ys5 + yi4*ys4 + yi3*ys3 + yi2*ys2 + yi1*ys1; \
-                mag_bnd_chk(py, by, mag_tensor_data_size(y)); \
-                int64_t yor = xd0 / yd0; \
-                for (int64_t i=0; i < yor; ++i) { \
-                    mag_##T##_t* ppr = pr + i*yd0; \
-                    const mag_##T##_t* ppx = px + i*yd0; \
-                    mag_bnd_chk(ppr, br, mag_tensor_data_size(r)); \
-                    mag_bnd_chk(ppx, bx, mag_tensor_data_size(x)); \
-                    mag_v##name##_##T(yd0, ppr, ppx, py); \
-                } \
-            } \
-        } else { \
-            for (int64_t ri=ra; ri < rb; ++ri) { \
-                int64_t ro = ri; \
-                int64_t xi1 = ro % xd1; ro /= xd1; \
-                int64_t xi2 = ro % xd2; ro /= xd2; \
-                int64_t xi3 = ro % xd3; ro /= xd3; \
-                int64_t xi4 = ro % xd4; ro /= xd4; \
-                int64_t xi5 = ro; \
-                int64_t yi5 = xi5 % yd5; \
-                int64_t yi4 = xi4 % yd4; \
-                int64_t yi3 = xi3 % yd3; \
-                int64_t yi2 = xi2 % yd2; \
-                int64_t yi1 = xi1 % yd1; \
-                mag_##T##_t* pr = br + xi5*rs5 + xi4*rs4 + xi3*rs3 + xi2*rs2 + xi1*rs1; \
-                const mag_##T##_t* px = bx + xi5*xs5 + xi4*xs4 + xi3*xs3 + xi2*xs2 + xi1*xs1; \
-                for (int64_t i=0; i < rd0; ++i) { \
-                    const mag_##T##_t* py = by + yi5*ys5 + yi4*ys4 + yi3*ys3 + yi2*ys2 + yi1*ys1 + i%yd0*ys0; \
-                    mag_bnd_chk(pr+i, br, mag_tensor_data_size(r)); \
-                    mag_bnd_chk(px+i, bx, mag_tensor_data_size(x)); \
-                    mag_bnd_chk(py, by, mag_tensor_data_size(y)); \
-                    pr[i] = (px[i]) op (*py); \
-                } \
-            } \
-        } \
+/* Gathers n elements with stride s from offset offs of a F32 or BF16 tensor into a contiguous BF16 vector. */
+static void mag_bf16_gather(mag_bf16_t* o, const mag_tensor_t* t, int64_t offs, int64_t s, int64_t n) {
+    if (t->dtype == MAG_DTYPE_BF16) {
+        const mag_bf16_t* p = mag_bf16p(t) + offs;
+        for (int64_t k=0; k < n; ++k) o[k] = p[k*s];
+    } else if (s == 1) {
+        mag_vcvt_bf16_f32(n, o, mag_f32p(t) + offs);
+    } else {
+        const mag_f32_t* p = mag_f32p(t) + offs;
+        for (int64_t k=0; k < n; ++k) o[k] = mag_bf16_from_f32(p[k*s]);
     }
+}
 
-mag_cpu_blas_impl_binary(f32, add, +)
-mag_cpu_blas_impl_binary(f32, sub, -)
-mag_cpu_blas_impl_binary(f32, mul, *)
-mag_cpu_blas_impl_binary(f32, div, /)
+/*
+** BF16 matrix multiplication with VDPBF16PS: R = A x B with at least one BF16 operand, the other one F32 or BF16. Accumulates in F32.
+** Every output is a dot product along K of a row of A with a column of B, so BF16 rows of A and BF16 columns of B (a transposed view)
+** are read in place. Everything else is gathered and rounded into a contiguous BF16 tile buffer first,
+** the A tile only when the tile row changes. The instruction needs BF16 on both sides, so F32 operands lose their low mantissa bits here.
+*/
+static void MAG_HOTPROC mag_blas_matmul_bf16(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    const mag_tensor_t* y = r->op_inputs[1];
+    mag_f32_t* br = mag_f32p_mut(r);
+    mag_load_local_storage_group(r, rd, shape);
+    mag_load_local_storage_group(r, rs, strides);
+    mag_load_local_storage_group(x, xd, shape);
+    mag_load_local_storage_group(x, xs, strides);
+    mag_load_local_storage_group(y, yd, shape);
+    mag_load_local_storage_group(y, ys, strides);
+    int64_t M = xd0;
+    int64_t K = xd1;
+    int64_t N = yd1;
+    int64_t rsx, csx, rsy, csy;
+    mag_sgemm_operand_strides(x, &rsx, &csx);
+    mag_sgemm_operand_strides(y, &rsy, &csy);
+    bool xi = x->dtype == MAG_DTYPE_BF16 && csx == 1; /* A rows are read in place */
+    bool yi = y->dtype == MAG_DTYPE_BF16 && rsy == 1; /* B columns are read in place */
+    int64_t lda = xi ? rsx : K;
+    int64_t ldb = yi ? csy : K;
+    int64_t batches = rd5*rd4*rd3*rd2;
+    int64_t ntm = (M + MAG_BF16GEMM_TM-1)/MAG_BF16GEMM_TM;
+    int64_t ntn = (N + MAG_BF16GEMM_TN-1)/MAG_BF16GEMM_TN;
+    int64_t ntiles = batches*ntm*ntn;
+    mag_bf16_t* xb = NULL; /* Gathered A rows of the tile */
+    mag_bf16_t* yb = NULL; /* Gathered B columns of the tile */
+    int64_t xlast = -1;
+    for (;;) {
+        int64_t ti = mag_atomic_fetch_add(payload->cursor, 1, MAG_MO_RELAXED); /* Grab next tile */
+        if (ti >= ntiles) break;
+        int64_t jt = ti % ntn; /* Column tiles vary fastest, so the gathered A tile is reused. */
+        int64_t it = ti / ntn % ntm;
+        int64_t ro = ti / (ntm*ntn);
+        int64_t ri2 = ro % rd2; ro /= rd2;
+        int64_t ri3 = ro % rd3; ro /= rd3;
+        int64_t ri4 = ro % rd4; ro /= rd4;
+        int64_t ri5 = ro;
+        int64_t i0 = it*MAG_BF16GEMM_TM;
+        int64_t j0 = jt*MAG_BF16GEMM_TN;
+        int64_t mt = mag_xmin(MAG_BF16GEMM_TM, M-i0);
+        int64_t nt = mag_xmin(MAG_BF16GEMM_TN, N-j0);
+        int64_t xo = (ri5%xd5)*xs5 + (ri4%xd4)*xs4 + (ri3%xd3)*xs3 + (ri2%xd2)*xs2 + i0*rsx; /* Element offset of the first A row */
+        int64_t yo = (ri5%yd5)*ys5 + (ri4%yd4)*ys4 + (ri3%yd3)*ys3 + (ri2%yd2)*ys2 + j0*csy; /* Element offset of the first B column */
+        mag_f32_t* pr = br + ri5*rs5 + ri4*rs4 + ri3*rs3 + ri2*rs2 + i0*N + j0;
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        const mag_bf16_t* pa;
+        const mag_bf16_t* pb;
+        if (xi) {
+            pa = mag_bf16p(x) + xo;
+        } else {
+            if (!xb) xb = mag_alloc_aligned(MAG_BF16GEMM_TM*K*sizeof(*xb), MAG_CACHE_LINE_SIZE);
+            if (xo != xlast) {
+                for (int64_t i=0; i < mt; ++i)
+                    mag_bf16_gather(xb + i*K, x, xo + i*rsx, csx, K);
+                xlast = xo;
+            }
+            pa = xb;
+        }
+        if (yi) {
+            pb = mag_bf16p(y) + yo;
+        } else {
+            if (!yb) yb = mag_alloc_aligned(MAG_BF16GEMM_TN*K*sizeof(*yb), MAG_CACHE_LINE_SIZE);
+            for (int64_t j=0; j < nt; ++j)
+                mag_bf16_gather(yb + j*K, y, yo + j*csy, rsy, K);
+            pb = yb;
+        }
+        int64_t mt4 = mt&~3;
+        int64_t nt4 = nt&~3;
+        for (int64_t i=0; i < mt4; i += 4)
+            for (int64_t j=0; j < nt4; j += 4)
+                mag_vdot4x4_bf16(K, pa + i*lda, lda, pb + j*ldb, ldb, pr + i*N + j, N);
+        for (int64_t i=0; i < mt; ++i) /* Fringe rows and columns */
+            for (int64_t j=(i < mt4 ? nt4 : 0); j < nt; ++j)
+                pr[i*N + j] = mag_vdot_bf16(K, pa + i*lda, pb + j*ldb);
+        mag_sgemm_epilogue_tile_f32(r, ri5, ri4, ri3, ri2, pr, N, i0, j0, mt, nt);
+    }
+    if (xb) mag_free_aligned(xb);
+    if (yb) mag_free_aligned(yb);
+}
+#endif
 
 /*
-** Matrix multiplication.
-** R = A x B
+** Matrix multiplication and fused linear.
+** R = A x B (MAG_OP_MATMUL) or R = act(A x B + bias) (MAG_OP_LINEAR), see mag_sgemm_epilogue_t.
+** Batched over dims 2..5, batch dims of A and B are broadcasted (modulo) into the batch dims of R.
+** A and B may be transposed views, see mag_sgemm_operand_strides.
+** Products with a handful of vectors on one side are dispatched to mag_blas_gemv_f32, int8 products to mag_blas_matmul_q8,
+** BF16 products to mag_blas_matmul_bf16 if VDPBF16PS is available and Q8/Q4 products to mag_blas_matmul_qb.
+** F16 and BF16 operands of the blocked path are widened to F32 while packing, so F32 operands keep their precision.
+** The output of all batches is split into 2D tiles, which threads grab dynamically from the shared payload cursor until none are left.
 */
 static void MAG_HOTPROC mag_blas_matmul_f32(const mag_compute_payload_t* payload) {
     mag_tensor_t* r = payload->node;
     const mag_tensor_t* x = r->op_inputs[0];
     const mag_tensor_t* y = r->op_inputs[1];
+    if (x->dtype == MAG_DTYPE_I8) {
+        mag_blas_matmul_q8(payload);
+        return;
+    }
+#if defined(__AVX512BF16__)
+    if (x->dtype == MAG_DTYPE_BF16 || y->dtype == MAG_DTYPE_BF16) {
+        mag_blas_matmul_bf16(payload);
+        return;
+    }
+#endif
+    if (mag_dtype_is_qblock(x->dtype) || mag_dtype_is_qblock(y->dtype)) {
+        mag_blas_matmul_qb(payload);
+        return;
+    }
     mag_f32_t* br = mag_f32p_mut(r);
-    const mag_f32_t* bx = mag_f32p(x);
-    const mag_f32_t* by = mag_f32p(y);
+    const void* bx = (const void*)x->storage.base; /* F32, F16 or BF16 */
+    const void* by = (const void*)y->storage.base;
     mag_load_local_storage_group(r, rd, shape);
     mag_load_local_storage_group(r, rs, strides);
     mag_load_local_storage_group(x, xd, shape);
     mag_load_local_storage_group(x, xs, strides);
     mag_load_local_storage_group(y, yd, shape);
     mag_load_local_storage_group(y, ys, strides);
-    mag_assert2(xd2 == 1 && xd3 == 1 && xd4 == 1&& xd5 == 1);
-    mag_assert2(yd2 == 1 && yd3 == 1 && yd4 == 1&& yd5 == 1);
+    int64_t M = xd0;
+    int64_t K = xd1;
+    int64_t N = yd1;
+    int64_t rsx, csx, rsy, csy;
+    mag_sgemm_operand_strides(x, &rsx, &csx);
+    mag_sgemm_operand_strides(y, &rsy, &csy);
+    bool f32 = x->dtype == MAG_DTYPE_F32 && y->dtype == MAG_DTYPE_F32;
+    if (f32 && mag_gemv_matrix_side(M, N, csx, rsy)) {
+        mag_blas_gemv_f32(payload);
+        return;
+    }
     int64_t tc = payload->thread_num;
-    int64_t ti = payload->thread_idx;
-    int64_t numel = xd0;
-    int64_t chunk = (numel + tc - 1)/tc;
-    int64_t ra = chunk*ti;
-    int64_t rb = mag_xmin(ra+chunk, numel);
-    #ifdef MAG_ACCELERATE
-        int64_t vmel = rb - ra;
-        if (mag_unlikely(vmel <= 0)) return;
-        const mag_f32_t* px = bx + ra*xd1;
-        mag_f32_t* pr = br + ra*yd1;
-        memset(pr, 0, vmel*yd1*sizeof(float));
-        vDSP_mmul(
+    int64_t batches = rd5*rd4*rd3*rd2;
+    int64_t tm, tn;
+    mag_sgemm_tile_partition(M, N, batches, tc, &tm, &tn);
+    int64_t ntm = (M + tm-1)/tm;
+    int64_t ntn = (N + tn-1)/tn;
+    int64_t ntiles = batches*ntm*ntn;
+    mag_f32_t* pa = NULL;
+    mag_f32_t* pb = NULL;
+    for (;;) {
+        int64_t ti = mag_atomic_fetch_add(payload->cursor, 1, MAG_MO_RELAXED); /* Grab next tile */
+        if (ti >= ntiles) break;
+        int64_t it = ti % ntm; /* Row tiles vary fastest, so concurrently running tiles share the same B panel. */
+        int64_t jt = ti / ntm % ntn;
+        int64_t ro = ti / (ntm*ntn); /* Batch index */
+        int64_t ri2 = ro % rd2; ro /= rd2;
+        int64_t ri3 = ro % rd3; ro /= rd3;
+        int64_t ri4 = ro % rd4; ro /= rd4;
+        int64_t ri5 = ro;
+        int64_t i0 = it*tm;
+        int64_t j0 = jt*tn;
+        int64_t mt = mag_xmin(tm, M-i0);
+        int64_t nt = mag_xmin(tn, N-j0);
+        mag_f32_t* pr = br + ri5*rs5 + ri4*rs4 + ri3*rs3 + ri2*rs2 + i0*N + j0;
+        const void* px = mag_sgemm_elem(bx, x->dtype, (ri5%xd5)*xs5 + (ri4%xd4)*xs4 + (ri3%xd3)*xs3 + (ri2%xd2)*xs2 + i0*rsx);
+        const void* py = mag_sgemm_elem(by, y->dtype, (ri5%yd5)*ys5 + (ri4%yd4)*ys4 + (ri3%yd3)*ys3 + (ri2%yd2)*ys2 + j0*csy);
+        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
+        mag_bnd_chk(px, bx, mag_tensor_data_size(x));
+        mag_bnd_chk(py, by, mag_tensor_data_size(y));
+        mag_sgemm_epilogue_t ep;
+        bool has_ep = mag_sgemm_epilogue_init(r, ri5, ri4, ri3, ri2, &ep);
+        if (has_ep) ep.bias += i0*ep.brs + j0*ep.bcs; /* Relative to the tile */
+        #ifdef MAG_ACCELERATE
+            if (f32 && csx == 1 && csy == 1) { /* vDSP_mmul only takes row-major F32 operands, the others use the blocked path. */
+                mag_assert2(nt == N);
+                memset(pr, 0, mt*N*sizeof(float));
+                vDSP_mmul(
+                    px,
+                    1,
+                    py,
+                    1,
+                    pr,
+                    1,
+                    mt,
+                    N,
+                    K
+                );
+                if (has_ep) mag_sgemm_epilogue_f32(&ep, pr, N, 0, 0, mt, N);
+                continue;
+            }
+        #endif
+        const mag_f32_t* bpy = mag_tensor_packed_weights(y); /* Pre-packed weights skip packing B. */
+        if (bpy) {
+            int64_t yb = (((ri5%yd5)*yd4 + ri4%yd4)*yd3 + ri3%yd3)*yd2 + ri2%yd2;
+            bpy += yb*mag_sgemm_packed_size_b(N, K) + j0*K; /* j0 is a multiple of NR, so it starts a sliver. */
+        }
+        if (!pa) pa = mag_alloc_aligned(mag_sgemm_scratch_size_a(tm, K)*sizeof(*pa), MAG_CACHE_LINE_SIZE); /* Allocate packing buffers once per thread on first use. */
+        if (!pb && !bpy) pb = mag_alloc_aligned(mag_sgemm_scratch_size_b(tn, K)*sizeof(*pb), MAG_CACHE_LINE_SIZE);
+        mag_sgemm_f32(
+            mt,
+            nt,
+            K,
             px,
-            1,
-            by,
-            1,
+            x->dtype,
+            rsx,
+            csx,
+            py,
+            y->dtype,
+            rsy,
+            csy,
             pr,
-            1,
-            vmel,
-            yd1,
-            xd1
+            N,
+            pa,
+            pb,
+            bpy,
+            has_ep ? &ep : NULL
         );
+    }
+    if (pa) mag_free_aligned(pa);
+    if (pb) mag_free_aligned(pb);
+}
+
+/*
+** Packs the matmul rhs (weights) y[K×N] once into the native B panel layout of mag_sgemm_f32: NR-wide column slivers,
+** each spanning the full K depth, one packed matrix per batch. Matmuls against y then skip packing B entirely.
+*/
+static void* mag_blas_pack_matmul_rhs_f32(const mag_tensor_t* y) {
+    #ifdef MAG_ACCELERATE
+        (void)y;
+        return NULL; /* vDSP_mmul consumes the row-major layout directly. */
     #else
-        if (xd0==yd0 && xd1==yd1) { /* Square matrices */
-            for (int64_t i = ra; i < rb; ++i) { /* Rows */
-                for (int64_t j = 0; j < yd1; ++j) {
-                    float* xo = br + rd1*i + j;
-                    mag_bnd_chk(xo, br, mag_tensor_data_size(r));
-                    *xo = 0.0f;
-                }
-                for (int64_t k = 0; k < xd1; ++k) { /* Inner dim */
-                    const mag_f32_t* px = bx + xd1*i + k;
-                    mag_bnd_chk(px, bx, mag_tensor_data_size(x));
-                    for (int64_t j = 0; j < yd1; ++j) { /* Columns */
-                        mag_f32_t* pr = br + rd1*i + j;
-                        const mag_f32_t* py = by + yd1*k + j;
-                        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
-                        mag_bnd_chk(py, by, mag_tensor_data_size(y));
-                        *pr += (*px) * (*py);
-                    }
-                }
-            }
-        } else {
-            for (int64_t i = ra; i < rb; ++i) { /* Rows */
-                for (int64_t j = 0; j < yd1; ++j) {
-                    float* xo = br + rd1*i + j;
-                    mag_bnd_chk(xo, br, mag_tensor_data_size(r));
-                    *xo = 0.0f;
-                }
-                for (int64_t k = 0; k < xd1; ++k) { /* Inner dim */
-                    const mag_f32_t* px = bx + xd1*i + k;
-                    mag_bnd_chk(px, bx, mag_tensor_data_size(x));
-                    for (int64_t j = 0; j < yd1; ++j) { /* Columns */
-                        mag_f32_t* pr = br + rd1*i + j;
-                        const mag_f32_t* py = by + yd1*k + j;
-                        mag_bnd_chk(pr, br, mag_tensor_data_size(r));
-                        mag_bnd_chk(py, by, mag_tensor_data_size(y));
-                        *pr += (*px) * (*py);
-                    }
-                }
-            }
-        }
+        if (y->dtype != MAG_DTYPE_F32 && y->dtype != MAG_DTYPE_F16) return NULL; /* F16 weights are widened to F32 panels once. */
+        int64_t K = y->shape[0];
+        int64_t N = y->shape[1];
+        int64_t batches = y->numel/(K*N);
+        int64_t np = mag_sgemm_packed_size_b(N, K);
+        int64_t rsy, csy;
+        mag_sgemm_operand_strides(y, &rsy, &csy);
+        mag_f32_t* bp = mag_alloc_aligned(batches*np*sizeof(*bp), MAG_CACHE_LINE_SIZE);
+        for (int64_t i=0; i < batches; ++i)
+            mag_sgemm_pack_b(K, N, mag_sgemm_elem(y->storage.base, y->dtype, i*K*N), y->dtype, rsy, csy, bp + i*np);
+        return bp;
     #endif
 }
 
+/* Quantizes x to int8, blocks are never split across threads. */
+static void MAG_HOTPROC mag_blas_quantize_i8_f32(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    mag_i8_t* br = mag_i8p_mut(r);
+    mag_f32_t* sr = mag_q8_scalesp_mut(r);
+    const mag_f32_t* bx = mag_f32p(x);
+    int64_t bs = r->qblock;
+    int64_t nb = r->numel/bs;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t chunk = (nb + tc - 1)/tc;
+    int64_t b0 = ti*chunk;
+    int64_t b1 = mag_xmin(b0 + chunk, nb);
+    for (int64_t b=b0; b < b1; ++b)
+        sr[b] = mag_vquantize_i8_f32(bs, br + b*bs, bx + b*bs);
+}
+
+static void MAG_HOTPROC mag_blas_dequantize_f32_i8(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    mag_f32_t* br = mag_f32p_mut(r);
+    const mag_i8_t* bx = mag_i8p(x);
+    const mag_f32_t* sx = mag_q8_scalesp(x);
+    int64_t bs = x->qblock;
+    int64_t nb = x->numel/bs;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t chunk = (nb + tc - 1)/tc;
+    int64_t b0 = ti*chunk;
+    int64_t b1 = mag_xmin(b0 + chunk, nb);
+    for (int64_t b=b0; b < b1; ++b)
+        mag_vdequantize_f32_i8(bs, br + b*bs, bx + b*bs, sx[b]);
+}
+
+/* Widens n elements of a F32, BF16 or F16 buffer to F32. */
+static void mag_vcvt_f32_any(int64_t n, mag_f32_t* o, const void* x, mag_dtype_t type) {
+    switch (type) {
+        case MAG_DTYPE_BF16: mag_vcvt_f32_bf16(n, o, x); break;
+        case MAG_DTYPE_F16: mag_vcvt_f32_f16(n, o, x); break;
+        default: memcpy(o, x, n*sizeof(*o)); break;
+    }
+}
+
+/* Rounds n F32 elements to a F32, BF16 or F16 buffer. */
+static void mag_vcvt_any_f32(int64_t n, void* o, const mag_f32_t* x, mag_dtype_t type) {
+    switch (type) {
+        case MAG_DTYPE_BF16: mag_vcvt_bf16_f32(n, o, x); break;
+        case MAG_DTYPE_F16: mag_vcvt_f16_f32(n, o, x); break;
+        default: memcpy(o, x, n*sizeof(*x)); break;
+    }
+}
+
+/* Quantizes F32 to Q8/Q4 or dequantizes them back, blocks are never split across threads. */
+static void MAG_HOTPROC mag_blas_cast_qb(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    int64_t nb = r->numel/MAG_QK;
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    int64_t chunk = (nb + tc - 1)/tc;
+    int64_t b0 = ti*chunk;
+    int64_t b1 = mag_xmin(b0 + chunk, nb);
+    if (b1 <= b0) return;
+    if (x->dtype == r->dtype)
+        memcpy((void*)mag_qb_block(r->storage.base, r->dtype, b0), mag_qb_block(x->storage.base, x->dtype, b0), (b1-b0)*mag_dtype_meta_of(r->dtype)->size);
+    else if (mag_dtype_is_qblock(r->dtype))
+        mag_vquantize_qb_f32(b1-b0, (void*)mag_qb_block(r->storage.base, r->dtype, b0), r->dtype, mag_f32p(x) + b0*MAG_QK);
+    else
+        mag_vdequantize_f32_qb(b1-b0, mag_f32p_mut(r) + b0*MAG_QK, mag_qb_block(x->storage.base, x->dtype, b0), x->dtype);
+}
+
+/* Converts between floating-point types. Conversions from and to F32 are direct, F16 <-> BF16 goes through a F32 tile on the stack. */
+static void MAG_HOTPROC mag_blas_cast(const mag_compute_payload_t* payload) {
+    mag_tensor_t* r = payload->node;
+    const mag_tensor_t* x = r->op_inputs[0];
+    int64_t tc = payload->thread_num;
+    int64_t ti = payload->thread_idx;
+    if (mag_dtype_is_qblock(r->dtype) || mag_dtype_is_qblock(x->dtype)) {
+        mag_blas_cast_qb(payload);
+        return;
+    }
+    int64_t chunk = (r->numel + tc - 1)/tc;
+    int64_t v0 = ti*chunk;
+    int64_t numel = mag_xmin(v0 + chunk, r->numel) - v0;
+    if (numel <= 0) return;
+    size_t esr = mag_dtype_meta_of(r->dtype)->size;
+    size_t esx = mag_dtype_meta_of(x->dtype)->size;
+    uint8_t* pr = (uint8_t*)r->storage.base + v0*esr;
+    const uint8_t* px = (const uint8_t*)x->storage.base + v0*esx;
+    if (x->dtype == r->dtype) {
+        memcpy(pr, px, numel*esr);
+    } else if (x->dtype == MAG_DTYPE_F32) {
+        mag_vcvt_any_f32(numel, pr, (const mag_f32_t*)px, r->dtype);
+    } else if (r->dtype == MAG_DTYPE_F32) {
+        mag_vcvt_f32_any(numel, (mag_f32_t*)pr, px, x->dtype);
+    } else {
+        mag_f32_t tmp[MAG_F16_TILE];
+        for (int64_t i=0; i < numel; i += MAG_F16_TILE) {
+            int64_t n = mag_xmin(MAG_F16_TILE, numel-i);
+            mag_vcvt_f32_any(n, tmp, px + i*esx, x->dtype);
+            mag_vcvt_any_f32(n, pr + i*esr, tmp, r->dtype);
+        }
+    }
+}
+
 #ifndef MAG_BLAS_SPECIALIZATION
 #error "BLAS specialization undefined"
 #endif
@@ -1627,6 +5209,51 @@ static void (*const forward_kernels[MAG_OP__NUM])(const mag_compute_payload_t*)
     [MAG_OP_MULS] = &mag_blas_muls_f32,
     [MAG_OP_DIVS] = &mag_blas_divs_f32,
     [MAG_OP_MATMUL] = &mag_blas_matmul_f32,
+    [MAG_OP_LINEAR] = &mag_blas_matmul_f32,
+    [MAG_OP_QUANTIZE] = &mag_blas_quantize_i8_f32,
+    [MAG_OP_DEQUANTIZE] = &mag_blas_dequantize_f32_i8,
+    [MAG_OP_CAST] = &mag_blas_cast,
+    [MAG_OP_ARGMIN] = &mag_blas_argreduce_f32,
+    [MAG_OP_ARGMAX] = &mag_blas_argreduce_f32,
+    [MAG_OP_TOPK] = &mag_blas_topk_f32,
+    [MAG_OP_GATHER] = &mag_blas_gather_f32,
+    [MAG_OP_LAYER_NORM] = &mag_blas_norm_f32,
+    [MAG_OP_RMS_NORM] = &mag_blas_norm_f32,
+    [MAG_OP_CUMSUM] = &mag_blas_scan_f32,
+    [MAG_OP_CUMPROD] = &mag_blas_scan_f32,
+    [MAG_OP_FUSED] = &mag_blas_fused_f32,
+};
+
+static void (*const forward_kernels_f16[MAG_OP__NUM])(const mag_compute_payload_t*) = { /* Elementwise kernels for F16 tensors, all other ops handle F16 in forward_kernels */
+    [MAG_OP_ABS] = &mag_blas_abs_f16,
+    [MAG_OP_NEG] = &mag_blas_neg_f16,
+    [MAG_OP_LOG] = &mag_blas_log_f16,
+    [MAG_OP_SQR] = &mag_blas_sqr_f16,
+    [MAG_OP_SQRT] = &mag_blas_sqrt_f16,
+    [MAG_OP_SIN] = &mag_blas_sin_f16,
+    [MAG_OP_COS] = &mag_blas_cos_f16,
+    [MAG_OP_STEP] = &mag_blas_step_f16,
+    [MAG_OP_SOFTMAX] = &mag_blas_softmax_f16,
+    [MAG_OP_SOFTMAX_DV] = &mag_blas_softmax_dv_f16,
+    [MAG_OP_SIGMOID] = &mag_blas_sigmoid_f16,
+    [MAG_OP_SIGMOID_DV] = &mag_blas_sigmoid_dv_f16,
+    [MAG_OP_HARD_SIGMOID] = &mag_blas_hard_sigmoid_f16,
+    [MAG_OP_SILU] = &mag_blas_silu_f16,
+    [MAG_OP_SILU_DV] = &mag_blas_silu_dv_f16,
+    [MAG_OP_TANH] = &mag_blas_tanh_f16,
+    [MAG_OP_TANH_DV] = &mag_blas_tanh_dv_f16,
+    [MAG_OP_RELU] = &mag_blas_relu_f16,
+    [MAG_OP_RELU_DV] = &mag_blas_relu_dv_f16,
+    [MAG_OP_GELU] = &mag_blas_gelu_f16,
+    [MAG_OP_GELU_DV] = &mag_blas_gelu_dv_f16,
+    [MAG_OP_ADD] = &mag_blas_add_f16,
+    [MAG_OP_SUB] = &mag_blas_sub_f16,
+    [MAG_OP_MUL] = &mag_blas_mul_f16,
+    [MAG_OP_DIV] = &mag_blas_div_f16,
+    [MAG_OP_ADDS] = &mag_blas_adds_f16,
+    [MAG_OP_SUBS] = &mag_blas_subs_f16,
+    [MAG_OP_MULS] = &mag_blas_muls_f16,
+    [MAG_OP_DIVS] = &mag_blas_divs_f16,
 };
 
 static void (*const backward_kernels[MAG_OP__NUM])(const mag_compute_payload_t*) = {
@@ -1669,9 +5296,24 @@ static void (*const backward_kernels[MAG_OP__NUM])(const mag_compute_payload_t*)
     [MAG_OP_MULS] = &mag_blas_muls_f32,
     [MAG_OP_DIVS] = &mag_blas_divs_f32,
     [MAG_OP_MATMUL] = &mag_blas_matmul_f32,
+    [MAG_OP_LINEAR] = &mag_blas_matmul_f32,
+    [MAG_OP_QUANTIZE] = &mag_blas_quantize_i8_f32,
+    [MAG_OP_DEQUANTIZE] = &mag_blas_dequantize_f32_i8,
+    [MAG_OP_CAST] = &mag_blas_cast,
+    [MAG_OP_ARGMIN] = &mag_blas_argreduce_f32,
+    [MAG_OP_ARGMAX] = &mag_blas_argreduce_f32,
+    [MAG_OP_TOPK] = &mag_blas_topk_f32,
+    [MAG_OP_GATHER] = &mag_blas_gather_f32,
+    [MAG_OP_LAYER_NORM] = &mag_blas_norm_f32,
+    [MAG_OP_RMS_NORM] = &mag_blas_norm_f32,
+    [MAG_OP_CUMSUM] = &mag_blas_scan_f32,
+    [MAG_OP_CUMPROD] = &mag_blas_scan_f32,
+    [MAG_OP_FUSED] = &mag_blas_fused_f32,
 };
 
 void MAG_BLAS_SPECIALIZATION(mag_kernel_registry_t* kernels) {
     memcpy(kernels->fwd, forward_kernels, sizeof(forward_kernels));
+    memcpy(kernels->fwd_f16, forward_kernels_f16, sizeof(forward_kernels_f16));
     memcpy(kernels->bwd, backward_kernels, sizeof(backward_kernels));
+    kernels->pack_matmul_rhs = &mag_blas_pack_matmul_rhs_f32;
 }
@@ -52,7 +52,11 @@ namespace mag::cuda {
             .eager_exec_fwd = nullptr,
             .eager_exec_bwd = nullptr,
             .alloc_storage = nullptr,
-            .free_storage = nullptr
+            .free_storage = nullptr,
+            .pack_weights = nullptr,
+            .free_packed_weights = nullptr,
+            .exec_workers = nullptr,
+            .exec_fwd_workers = nullptr
         };
         double vram;
         const char* unit;
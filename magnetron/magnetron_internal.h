@@ -254,7 +254,7 @@ defined(__WIN32__) || defined(__TOS_WIN__) || defined(__WINDOWS__)
 
 #ifdef __cpp_lib_hardware_interference_size
 /* Hardware destructive interference size. */
-#define MAG_CACHE_LINE_SIZE hardware_destructive_interference_size
+#define MAG_CACHE_LINE_SIZE std::hardware_destructive_interference_size
 #else
 /* Hardware destructive interference size. */
 #define MAG_CACHE_LINE_SIZE 64
@@ -453,10 +453,23 @@ typedef enum mag_op_t {
     MAG_OP_MULS,
     MAG_OP_DIVS,
     MAG_OP_MATMUL,
+    MAG_OP_LINEAR,
+    MAG_OP_QUANTIZE,
+    MAG_OP_DEQUANTIZE,
+    MAG_OP_CAST,
+    MAG_OP_ARGMIN,
+    MAG_OP_ARGMAX,
+    MAG_OP_TOPK,
+    MAG_OP_GATHER,
+    MAG_OP_LAYER_NORM,
+    MAG_OP_RMS_NORM,
+    MAG_OP_CUMSUM,
+    MAG_OP_CUMPROD,
+    MAG_OP_FUSED,
     MAG_OP__NUM
 } mag_op_t;
 mag_static_assert(MAG_OP_NOP == 0);
-mag_static_assert(MAG_OP_MATMUL+1 == MAG_OP__NUM);
+mag_static_assert(MAG_OP_FUSED+1 == MAG_OP__NUM);
 mag_static_assert(MAG_OP__NUM <= 0xff);
 
 typedef enum mag_op_param_type_t {
@@ -480,6 +493,7 @@ typedef struct mag_op_param_t {
 typedef struct mag_op_meta_t {
     const char* mnemonic;                                   /* Operation mnemonic */
     uint8_t argcount;                                       /* Number of arguments */
+    uint8_t optargcount;                                    /* Number of trailing arguments which may be omitted */
     uint8_t paramcount;                                     /* Number of parameters */
     mag_op_param_type_t param_types[MAG_MAX_OP_PARAMS];     /* Parameter types */
     bool inplace;                                           /* Supports inplace execution */
@@ -540,6 +554,10 @@ struct mag_compute_device_t {
     void (*eager_exec_bwd)(mag_compute_device_t* dvc, mag_tensor_t* root);      /* Execute a single op backwards. */
     void (*alloc_storage)(mag_compute_device_t* dvc, mag_storage_buffer_t* out, size_t size);
     void (*free_storage)(mag_compute_device_t* dvc, mag_storage_buffer_t* buf);
+    void* (*pack_weights)(mag_compute_device_t* dvc, const mag_tensor_t* t);   /* Pack matmul rhs into the native kernel layout. NULL if unsupported. */
+    void (*free_packed_weights)(mag_compute_device_t* dvc, void* packed);       /* Free packed weights returned by pack_weights. */
+    uint32_t (*exec_workers)(mag_compute_device_t* dvc, const mag_tensor_t* root);      /* Number of workers eager_exec_fwd uses for the op. NULL if not applicable. */
+    void (*exec_fwd_workers)(mag_compute_device_t* dvc, mag_tensor_t* root, uint32_t workers); /* Execute a single op forward on a precomputed number of workers. */
 };
 
 /* Device creation and destruction. */
@@ -684,6 +702,7 @@ struct mag_ctx_t {
 #endif
     mag_fixed_intrusive_pool tensor_pool;           /* Fixed-size memory pool for tensors. */
     mag_exec_mode_t exec_mode;
+    mag_graph_t* capture;                           /* Graph recording the executed ops, see mag_ctx_capture_begin. NULL if not capturing. */
     bool profiler_enabled;
     mag_op_perf_info_t op_perf_mons_total[MAG_OP__NUM];
     union {
@@ -720,6 +739,58 @@ typedef enum mag_tensor_flags_t {
 } mag_tensor_flags_t;
 mag_static_assert(MAG_TFLAG_LEN <= 0xff);
 
+/*
+** Matmul right-hand side operand (weights), pre-packed into the kernel's native panel layout by mag_tensor_pack_weights.
+** The packed copy is stale as soon as the version of the storage root moves away from the version it was packed at.
+*/
+typedef struct mag_packed_weights_t {
+    void* data;             /* Packed panels, NULL if not packed. Owned by the compute device. */
+    uint64_t version;       /* Storage write version at packing time. */
+} mag_packed_weights_t;
+
+/*
+** Program of a MAG_OP_FUSED node: a chain of F32 elementwise ops (unary, scalar and binary), built by the fusion pass from a deferred graph.
+** Operand slots below MAG_FUSED_MAX_INPUTS name leaf tensors, the others temporary registers (slot - MAG_FUSED_MAX_INPUTS).
+** The backend evaluates the code tile by tile, so intermediates stay in cache and only the leaves are read and the result written once.
+*/
+#define MAG_FUSED_MAX_INPUTS 8
+#define MAG_FUSED_MAX_INSTRS 32
+#define MAG_FUSED_MAX_REGS 8
+typedef struct mag_fused_instr_t {
+    mag_op_t op;                                    /* Elementwise op, MAG_OP_ABS..MAG_OP_DIVS. */
+    uint8_t dst;                                    /* Destination register, the last instruction writes the result tensor instead. */
+    uint8_t a;                                      /* First operand slot. */
+    uint8_t b;                                      /* Second operand slot of binary ops. */
+    float s;                                        /* Scalar operand of MAG_OP_ADDS..MAG_OP_DIVS. */
+} mag_fused_instr_t;
+typedef struct mag_fused_program_t {
+    uint32_t num_inputs;
+    uint32_t num_instrs;
+    uint32_t num_regs;
+    mag_tensor_t* inputs[MAG_FUSED_MAX_INPUTS];                 /* Leaf tensors, not referenced (like op_inputs). */
+    int64_t strides[MAG_FUSED_MAX_INPUTS][MAG_MAX_DIMS];       /* Leaf strides over the result's shape, 0 along broadcast dims. */
+    mag_fused_instr_t code[MAG_FUSED_MAX_INSTRS];
+} mag_fused_program_t;
+
+/* Compiled deferred graph, see mag_graph_compile. */
+struct mag_graph_t {
+    mag_ctx_t* ctx;                                 /* Host context. */
+    uint32_t num_nodes;                             /* Number of scheduled op nodes. */
+    mag_tensor_t** nodes;                           /* Op nodes in execution order, every node after its inputs. Leaves are not scheduled. */
+    uint32_t num_outputs;
+    mag_tensor_t** outputs;                         /* Requested outputs. */
+    uint32_t num_views;
+    mag_tensor_t** views;                           /* Visited views (view ops and in-place nodes), they share the storage of their base. */
+    mag_storage_buffer_t arena;                     /* Storage of the planned intermediates, see mag_graph_plan_memory. Zero if not planned. */
+    size_t planned_bytes;                           /* Size of the arena. */
+    uint32_t* workers;                              /* Precomputed intra-op workers per node, NULL if the device has no exec_workers. */
+    uint32_t num_retained;
+    mag_tensor_t** retained;                        /* Strong references held by a captured graph (nodes and their inputs). */
+    uint32_t nodes_cap;                             /* Capacities of the growing arrays. */
+    uint32_t views_cap;
+    uint32_t retained_cap;
+};
+
 /*
 ** Tensor with up to 6 Dimensions.
 */
@@ -736,6 +807,7 @@ struct mag_tensor_t {
     int64_t shape[MAG_MAX_DIMS];                     /* Shape of the tensor. */
     int64_t strides[MAG_MAX_DIMS];                   /* Strides of the tensor. We store the strides in element counts and NOT in bytes. */
     mag_dtype_t dtype;                               /* Data type of the tensor. */
+    int64_t qblock;                                 /* Elements per scale of quantized (MAG_DTYPE_I8) tensors, 0 otherwise. */
     mag_storage_buffer_t storage;                      /* Storage buffer. */
     int64_t numel;                                  /* Number of elements in the tensor. */
     mag_tensor_flags_t flags;                        /* Tensor flags. */
@@ -748,8 +820,31 @@ struct mag_tensor_t {
     mag_perf_mon_t pmon;                             /* Performance monitor. */
     char name[MAG_MAX_TENSOR_NAME_LEN];              /* Tensor debug name. */
     void* ud;                                       /* User data. */
+    uint64_t version;                               /* Storage write version, bumped on every write. Only tracked on the storage root (views share the base storage). */
+    mag_packed_weights_t packed;                     /* Pre-packed matmul weights cache. */
+    mag_fused_program_t* fused;                      /* Program of a MAG_OP_FUSED node, NULL otherwise. Owned by the tensor. */
 };
 
+typedef struct mag_block_q8_t { /* Block of MAG_DTYPE_Q8 weights: w = d*q */
+    uint16_t d;             /* F16 scale */
+    int8_t qs[MAG_QK];      /* Quantized weights in [-127, 127] */
+} mag_block_q8_t;
+typedef struct mag_block_q4_t { /* Block of MAG_DTYPE_Q4 weights: w = d*(q - 8) */
+    uint16_t d;             /* F16 scale */
+    uint8_t qs[MAG_QK/2];   /* Element i in the low nibble of qs[i], element i + MAG_QK/2 in the high nibble */
+} mag_block_q4_t;
+mag_static_assert(sizeof(mag_block_q8_t) == sizeof(uint16_t) + MAG_QK && sizeof(mag_block_q4_t) == sizeof(uint16_t) + MAG_QK/2); /* Packed, so blocks serialize as is */
+#define mag_dtype_is_qblock(t) ((t) == MAG_DTYPE_Q8 || (t) == MAG_DTYPE_Q4) /* Block-quantized weight data type? */
+
+#define mag_q8_scales_offs(numel) (((numel)+3)&~(int64_t)3) /* Byte offset of the F32 scales behind the int8 values of a MAG_DTYPE_I8 buffer. */
+#define mag_tensor_storage_root(t) ((t)->view_uplink ? (t)->view_uplink : (t)) /* View chains are flattened, so one level is enough. */
+#define mag_tensor_mark_written(t) (++mag_tensor_storage_root(t)->version) /* Invalidates derived caches of all tensors sharing the storage. */
+
+/* Returns the packed weights of t or NULL if t is not packed or was written to since packing. */
+static MAG_AINLINE const void* mag_tensor_packed_weights(const mag_tensor_t* t) {
+    return t->packed.data && t->packed.version == mag_tensor_storage_root(t)->version ? t->packed.data : NULL;
+}
+
 #define mag_load_local_storage_group_arr(arr, prefix) \
     const int64_t prefix##0 = (arr)[0]; \
     const int64_t prefix##1 = (arr)[1]; \
@@ -764,15 +859,26 @@ struct mag_tensor_t {
     (void)prefix##4; \
     (void)prefix##5
 
+#define MAG_REDUCE_PARTIALS 64 /* Number of input segments of a full reduction. Fixed, so the combined result does not depend on the thread count. */
+
+/* Partial result of a full reduction, padded to a cache line so workers never share one. */
+typedef struct mag_reduce_partial_t {
+    mag_alignas(MAG_CACHE_LINE_SIZE) double v;
+} mag_reduce_partial_t;
+
 typedef struct mag_compute_payload_t {
     int64_t thread_num;
     int64_t thread_idx;
     mag_tensor_t* node;
+    volatile mag_atomic_t* cursor; /* Shared work item cursor for dynamic scheduling, reset to zero before each op. */
+    mag_reduce_partial_t* partials; /* MAG_REDUCE_PARTIALS slots shared by all workers of an op. */
 } mag_compute_payload_t;
 
 typedef struct mag_kernel_registry_t {
     void (*fwd[MAG_OP__NUM])(const mag_compute_payload_t*);
+    void (*fwd_f16[MAG_OP__NUM])(const mag_compute_payload_t*); /* Forward kernels for F16 results, NULL if fwd handles all data types. */
     void (*bwd[MAG_OP__NUM])(const mag_compute_payload_t*);
+    void* (*pack_matmul_rhs)(const mag_tensor_t*); /* Pack matmul rhs into the kernel's panel layout, free with mag_free_aligned. NULL if unsupported. */
 } mag_kernel_registry_t;
 
 #define mag_load_local_storage_group(xk, prefix, var) mag_load_local_storage_group_arr((xk)->var, prefix)
@@ -31,6 +31,15 @@ MAG_COLOR_CHANNELS_RGB,
 MAG_COLOR_CHANNELS_RGBA,
 MAG_COLOR_CHANNELS__NUM
 } mag_color_channels_t;
+typedef enum mag_activation_t {
+MAG_ACTIVATION_NONE = 0,
+MAG_ACTIVATION_SIGMOID = 1,
+MAG_ACTIVATION_RELU = 2,
+MAG_ACTIVATION_GELU = 3,
+MAG_ACTIVATION_SILU = 4,
+MAG_ACTIVATION_TANH = 5,
+MAG_ACTIVATION__NUM
+} mag_activation_t;
 extern   void* (*mag_get_alloc_fn(void))(void* blk, size_t size);
 extern   void mag_set_alloc_fn(void* (*alloc)(void* blk, size_t size));
 extern   void mag_set_log_mode(bool enabled);
@@ -64,6 +73,12 @@ extern   void mag_ctx_destroy(mag_ctx_t* _ptr);
 typedef struct mag_tensor_t mag_tensor_t;
 typedef enum mag_dtype_t {
 MAG_DTYPE_F32,
+MAG_DTYPE_I8,
+MAG_DTYPE_BF16,
+MAG_DTYPE_F16,
+MAG_DTYPE_Q8,
+MAG_DTYPE_Q4,
+MAG_DTYPE_I32,
 MAG_DTYPE__NUM
 } mag_dtype_t;
 typedef struct mag_dtype_meta_t {
@@ -91,6 +106,18 @@ extern   mag_tensor_t* mag_mean(mag_tensor_t* x);
 extern   mag_tensor_t* mag_min(mag_tensor_t* x);
 extern   mag_tensor_t* mag_max(mag_tensor_t* x);
 extern   mag_tensor_t* mag_sum(mag_tensor_t* x);
+extern   mag_tensor_t* mag_mean_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+extern   mag_tensor_t* mag_min_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+extern   mag_tensor_t* mag_max_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+extern   mag_tensor_t* mag_sum_axes(mag_tensor_t* x, const int64_t* axes, uint32_t num_axes, bool keepdim);
+extern   mag_tensor_t* mag_argmax(mag_tensor_t* x, int64_t axis, bool keepdim);
+extern   mag_tensor_t* mag_argmin(mag_tensor_t* x, int64_t axis, bool keepdim);
+extern   mag_tensor_t* mag_topk(mag_tensor_t* x, int64_t k, int64_t axis);
+extern   mag_tensor_t* mag_gather(mag_tensor_t* x, int64_t axis, mag_tensor_t* index);
+extern   mag_tensor_t* mag_layer_norm(mag_tensor_t* x, mag_tensor_t* weight, mag_tensor_t* bias, float eps);
+extern   mag_tensor_t* mag_rms_norm(mag_tensor_t* x, mag_tensor_t* weight, float eps);
+extern   mag_tensor_t* mag_cumsum(mag_tensor_t* x, int64_t axis);
+extern   mag_tensor_t* mag_cumprod(mag_tensor_t* x, int64_t axis);
 extern   mag_tensor_t* mag_abs(mag_tensor_t* x);
 extern   mag_tensor_t* mag_abs_(mag_tensor_t* x);
 extern   mag_tensor_t* mag_neg(mag_tensor_t* x);
@@ -150,12 +177,28 @@ extern   mag_tensor_t* mag_muls_(mag_tensor_t* x, float xi);
 extern   mag_tensor_t* mag_divs(mag_tensor_t* x, float xi);
 extern   mag_tensor_t* mag_divs_(mag_tensor_t* x, float xi);
 extern   mag_tensor_t* mag_matmul(mag_tensor_t* a, mag_tensor_t* b);
+extern   mag_tensor_t* mag_linear(mag_tensor_t* a, mag_tensor_t* b, mag_tensor_t* bias, mag_activation_t act);
+extern   mag_tensor_t* mag_quantize(mag_tensor_t* x, int64_t block);
+extern   mag_tensor_t* mag_dequantize(mag_tensor_t* x);
+extern   mag_tensor_t* mag_cast(mag_tensor_t* x, mag_dtype_t type);
 extern   void mag_tensor_incref(mag_tensor_t* t);
 extern   bool mag_tensor_decref(mag_tensor_t* t);
 extern   void mag_tensor_copy_buffer_from(mag_tensor_t* t, const void* data, size_t size);
 extern   void mag_tensor_fill(mag_tensor_t* t, float x);
 extern   void mag_tensor_fill_random_uniform(mag_tensor_t* t, float min, float max);
 extern   void mag_tensor_fill_random_normal(mag_tensor_t* t, float mean, float stddev);
+extern   bool mag_tensor_pack_weights(mag_tensor_t* t);
+extern   bool mag_tensor_is_packed(const mag_tensor_t* t);
+extern   void mag_tensor_unpack_weights(mag_tensor_t* t);
+extern   void mag_tensor_eval_fused(mag_tensor_t* t);
+typedef struct mag_graph_t mag_graph_t;
+extern   mag_graph_t* mag_graph_compile(mag_tensor_t** outputs, uint32_t num_outputs);
+extern   void mag_graph_execute(mag_graph_t* g);
+extern   uint32_t mag_graph_node_count(const mag_graph_t* g);
+extern   size_t mag_graph_plan_memory(mag_graph_t* g);
+extern   void mag_graph_destroy(mag_graph_t* g);
+extern   void mag_ctx_capture_begin(mag_ctx_t* ctx);
+extern   mag_graph_t* mag_ctx_capture_end(mag_ctx_t* ctx);
 extern   uint64_t mag_tensor_get_packed_refcounts(const mag_tensor_t* t);
 extern   void mag_tensor_retain(mag_tensor_t* t);
 extern   size_t mag_tensor_get_memory_usage(const mag_tensor_t* t);
@@ -167,6 +210,7 @@ extern   int64_t mag_tensor_rank(const mag_tensor_t* t);
 extern   const int64_t* mag_tensor_shape(const mag_tensor_t* t);
 extern   const int64_t* mag_tensor_strides(const mag_tensor_t* t);
 extern   mag_dtype_t mag_tensor_dtype(const mag_tensor_t* t);
+extern   int64_t mag_tensor_quant_block(const mag_tensor_t* t);
 extern   void* mag_tensor_data_ptr(const mag_tensor_t* t);
 extern   int64_t mag_tensor_data_size(const mag_tensor_t* t);
 extern   int64_t mag_tensor_numel(const mag_tensor_t* t);
@@ -108,6 +108,12 @@ class DType(Enum):
     Supported data types for tensors.
     """
     F32 = 0
+    I8 = 1
+    BF16 = 2
+    F16 = 3
+    Q8 = 4
+    Q4 = 5
+    I32 = 6
 
 
 class ColorChannels(Enum):
@@ -151,6 +157,18 @@ class ColorChannels(Enum):
         return self.argument_count == 2
 
 
+class Activation(Enum):
+    """
+    Activation functions fused into Tensor.linear.
+    """
+    NONE = 0  # Identity
+    SIGMOID = auto()
+    RELU = auto()
+    GELU = auto()
+    SILU = auto()
+    TANH = auto()
+
+
 class GraphEvalOrder(Enum):
     """
     Order in which the computation graph should be evaluated.
@@ -815,6 +833,18 @@ class Tensor:
         """
         return DType(C.mag_tensor_dtype(self._ptr))
 
+    @property
+    def quant_block(self) -> int:
+        """
+        Returns the number of elements sharing one scale of an int8 tensor.
+
+        Returns
+        -------
+        int
+            Elements per scale, 0 if the tensor is not quantized.
+        """
+        return C.mag_tensor_quant_block(self._ptr)
+
     @property
     def data_ptr(self) -> int:
         """
@@ -827,15 +857,17 @@ class Tensor:
         """
         return int(ffi.cast('uintptr_t', C.mag_tensor_data_ptr(self._ptr)))
 
-    def tolist(self) -> list[float]:
+    def tolist(self) -> list[float] | list[int]:
         """
-        Returns the tensor data as a Python list of floats.
+        Returns the tensor data as a Python list of floats, or of ints for DType.I32 tensors.
 
         Returns
         -------
-        list[float]
+        list[float] | list[int]
             A flat list containing all _ptr elements.
         """
+        if self.dtype == DType.I32:
+            return ffi.unpack(ffi.cast('int32_t*', C.mag_tensor_data_ptr(self._ptr)), self.numel)
         assert self.dtype == DType.F32, 'Invalid data type'
         return ffi.unpack(ffi.cast('float*', C.mag_tensor_data_ptr(self._ptr)), self.numel)
 
@@ -1055,6 +1087,31 @@ class Tensor:
         """
         return C.mag_tensor_is_contiguous(self._ptr)
 
+    def pack_weights(self) -> bool:
+        """
+        Pre-packs the tensor into the native matmul kernel layout, so repeated matmuls
+        with this tensor as right-hand side skip the per-call packing.
+        The packed copy is dropped automatically when the tensor is written to.
+
+        Returns
+        -------
+        bool
+            True if packed, False if not supported by the compute device or dtype.
+        """
+        return C.mag_tensor_pack_weights(self._ptr)
+
+    @property
+    def is_packed(self) -> bool:
+        """
+        Checks if the tensor has up-to-date packed weights.
+
+        Returns
+        -------
+        bool
+            True if packed, otherwise False.
+        """
+        return C.mag_tensor_is_packed(self._ptr)
+
     def is_close(self, other: 'Tensor', eps: float = -1.0, print_eq_percent: bool = False) -> (bool, float):
         """
         Checks if the tensor is close to another _ptr within a given epsilon.
@@ -1216,21 +1273,68 @@ class Tensor:
                 assert axes[i] != axes[j], f'Duplicate axis: {axes[i]}'
         return Tensor(C.mag_permute(self._ptr, *axes))
 
-    def mean(self) -> 'Tensor':
-        """Computes the mean of all elements in the tensor."""
-        return Tensor(C.mag_mean(self._ptr))
+    @staticmethod
+    def _reduce_axes(axis: int | tuple[int, ...] | None) -> tuple[ffi.CData, int]:
+        if axis is None:
+            return ffi.NULL, 0
+        axes = (axis,) if isinstance(axis, int) else tuple(axis)
+        return ffi.new(f'int64_t[{len(axes)}]', axes), len(axes)
+
+    def mean(self, axis: int | tuple[int, ...] | None = None, keepdim: bool = False) -> 'Tensor':
+        """Computes the mean of all elements in the tensor, or along the given axes."""
+        return Tensor(C.mag_mean_axes(self._ptr, *self._reduce_axes(axis), keepdim))
+
+    def min(self, axis: int | tuple[int, ...] | None = None, keepdim: bool = False) -> 'Tensor':
+        """Computes the minimum value in the tensor, or along the given axes."""
+        return Tensor(C.mag_min_axes(self._ptr, *self._reduce_axes(axis), keepdim))
+
+    def max(self, axis: int | tuple[int, ...] | None = None, keepdim: bool = False) -> 'Tensor':
+        """Computes the maximum value in the tensor, or along the given axes."""
+        return Tensor(C.mag_max_axes(self._ptr, *self._reduce_axes(axis), keepdim))
+
+    def sum(self, axis: int | tuple[int, ...] | None = None, keepdim: bool = False) -> 'Tensor':
+        """Computes the sum of all elements in the tensor, or along the given axes."""
+        return Tensor(C.mag_sum_axes(self._ptr, *self._reduce_axes(axis), keepdim))
+
+    def argmax(self, axis: int, keepdim: bool = False) -> 'Tensor':
+        """Indices of the maximum values along an axis as a DType.I32 tensor."""
+        return Tensor(C.mag_argmax(self._ptr, axis, keepdim))
+
+    def argmin(self, axis: int, keepdim: bool = False) -> 'Tensor':
+        """Indices of the minimum values along an axis as a DType.I32 tensor."""
+        return Tensor(C.mag_argmin(self._ptr, axis, keepdim))
+
+    def topk(self, k: int, axis: int) -> tuple['Tensor', 'Tensor']:
+        """
+        Selects the k largest elements along an axis.
+
+        Returns
+        -------
+        tuple[Tensor, Tensor]
+            The values and their DType.I32 indices, both in descending order of the values.
+        """
+        indices = Tensor(C.mag_topk(self._ptr, k, axis))
+        return self.gather(axis, indices), indices
 
-    def min(self) -> 'Tensor':
-        """Computes the minimum value in the tensor."""
-        return Tensor(C.mag_min(self._ptr))
+    def gather(self, axis: int, index: 'Tensor') -> 'Tensor':
+        """Gathers elements along an axis at the positions of the DType.I32 index tensor."""
+        return Tensor(C.mag_gather(self._ptr, axis, index._ptr))
 
-    def max(self) -> 'Tensor':
-        """Computes the maximum value in the tensor."""
-        return Tensor(C.mag_max(self._ptr))
+    def layer_norm(self, weight: 'Tensor | None' = None, bias: 'Tensor | None' = None, eps: float = 1e-5) -> 'Tensor':
+        """Layer normalization of every row along the contiguous axis 0, with optional affine weight and bias of shape[0] elements."""
+        return Tensor(C.mag_layer_norm(self._ptr, weight._ptr if weight is not None else ffi.NULL, bias._ptr if bias is not None else ffi.NULL, eps))
 
-    def sum(self) -> 'Tensor':
-        """Computes the sum of all elements in the tensor."""
-        return Tensor(C.mag_sum(self._ptr))
+    def rms_norm(self, weight: 'Tensor | None' = None, eps: float = 1e-6) -> 'Tensor':
+        """RMS normalization of every row along the contiguous axis 0, with an optional weight of shape[0] elements."""
+        return Tensor(C.mag_rms_norm(self._ptr, weight._ptr if weight is not None else ffi.NULL, eps))
+
+    def cumsum(self, axis: int) -> 'Tensor':
+        """Inclusive cumulative sum along an axis."""
+        return Tensor(C.mag_cumsum(self._ptr, axis))
+
+    def cumprod(self, axis: int) -> 'Tensor':
+        """Inclusive cumulative product along an axis."""
+        return Tensor(C.mag_cumprod(self._ptr, axis))
 
     def abs(self) -> 'Tensor':
         """Computes element-wise absolute value."""
@@ -1303,11 +1407,12 @@ class Tensor:
     def softmax(self, derivative: bool = False) -> 'Tensor':
         """
         Applies softmax or its derivative on the tensor.
+        Softmax is taken along the contiguous axis 0, so each row of shape[0] elements sums to 1.
 
         Parameters
         ----------
         derivative : bool, optional
-            If True, computes softmax derivative instead of softmax, by default False.
+            If True, computes the softmax derivative s * (1 - s) of a softmax output s instead of softmax, by default False.
 
         Returns
         -------
@@ -1472,6 +1577,75 @@ class Tensor:
         """Matrix multiplication with another _ptr: A @ B."""
         return Tensor(C.mag_matmul(self._ptr, other._ptr))
 
+    def linear(self, weight: 'Tensor', bias: 'Tensor', activation: Activation = Activation.NONE) -> 'Tensor':
+        """
+        Fused linear layer: activation(self @ weight + bias) in a single pass.
+        The bias add and activation are applied to each output tile right after it is computed.
+
+        Parameters
+        ----------
+        weight : Tensor
+            Right-hand side of the matrix multiplication.
+        bias : Tensor
+            Bias, either a per-row column (M, 1), a per-column row (1, N), a scalar (1, 1) or the full (M, N) matrix.
+        activation : Activation, optional
+            Activation applied after the bias add, by default Activation.NONE.
+
+        Returns
+        -------
+        Tensor
+            The result tensor.
+        """
+        return Tensor(C.mag_linear(self._ptr, weight._ptr, bias._ptr, activation.value))
+
+    def quantize(self, block: int = 0) -> 'Tensor':
+        """
+        Quantizes the tensor to DType.I8 with one scale per block of elements.
+        Int8 tensors can be used as matmul operands, int8 weights should be stored as (N, K) and transposed.
+
+        Parameters
+        ----------
+        block : int, optional
+            Elements per scale, a power of two dividing the row length. 0 uses one scale per row, by default 0.
+
+        Returns
+        -------
+        Tensor
+            The quantized tensor.
+        """
+        return Tensor(C.mag_quantize(self._ptr, block))
+
+    def dequantize(self) -> 'Tensor':
+        """
+        Dequantizes a DType.I8, DType.Q8 or DType.Q4 tensor back to DType.F32.
+
+        Returns
+        -------
+        Tensor
+            The dequantized tensor.
+        """
+        return Tensor(C.mag_dequantize(self._ptr))
+
+    def cast(self, dtype: DType) -> 'Tensor':
+        """
+        Converts the tensor between DType.F32, DType.F16 and DType.BF16, or between DType.F32 and the block-quantized DType.Q8 and DType.Q4.
+        16-bit tensors halve the memory of F32 weights and can be used directly as matmul operands,
+        F16 tensors also with elementwise operators.
+        Q8 and Q4 weights store blocks of 32 elements with one F16 scale, the row length must be a multiple of 32.
+        They are multiplied with F32 activations, either as left operand or as transposed right operand.
+
+        Parameters
+        ----------
+        dtype : DType
+            Target data type.
+
+        Returns
+        -------
+        Tensor
+            The converted tensor.
+        """
+        return Tensor(C.mag_cast(self._ptr, dtype.value))
+
     def __imatmul__(self, other: 'Tensor') -> 'Tensor':
         """In-place matrix multiplication: A @= B."""
         return Tensor(C.mag_matmul_(self._ptr, other._ptr))
@@ -4,7 +4,7 @@
 import time
 from abc import ABC
 
-from magnetron import Tensor
+from magnetron import Tensor, Activation
 
 
 class Layer(ABC):
@@ -47,25 +47,23 @@ class DenseLayer(Layer):
         self.weight = Tensor.uniform(shape=(out_features, in_features))
         self.bias = Tensor.uniform(shape=(out_features, 1))
         self._x = None
-        self._z = None
         self._out = None
 
     def forward(self, x: Tensor) -> Tensor:
         self._x = x
-        self._z = self.weight @ x + self.bias
-        self._out = self._z.sigmoid()
+        self._out = self.weight.linear(x, self.bias, Activation.SIGMOID)
         return self._out
 
     def backward(self, is_hidden_layer: bool, delta: Tensor, rate: float) -> Tensor:
-        self.weight -= (delta @ self._x.transpose().clone()) * rate
+        self.weight -= (delta @ self._x.transpose()) * rate
         batch_size = delta.shape[1]
         ones_vec = Tensor.const([[1.0] for _ in range(batch_size)])
         row_sums = delta @ ones_vec
         row_means = row_sums * (1.0 / batch_size)
         self.bias -= row_means * rate
         if is_hidden_layer:
-            d_in = self.weight.transpose().clone() @ delta
-            d_in *= self._z.sigmoid(derivative=True)
+            d_in = self.weight.transpose() @ delta
+            d_in *= self._x.sigmoid(derivative=True)
             return d_in
         else:
             return delta
@@ -6,6 +6,7 @@
 #include "prelude.hpp"
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 static constexpr std::int64_t k_lim_same_shape = 4;
 static constexpr std::int64_t k_lim_broadcast = 2;
@@ -123,11 +124,8 @@ impl_test_unary_op(step, 1e-9, step, [](float x) -> float {
     return x >= 0.0f ? 1.0f : 0.0f;
 })
 
-impl_test_unary_op(softmax, 1e-6, softmax, [](float x) -> float {
-    return std::exp(x);
-})
 impl_test_unary_op(softmax_dv, 1e-6, softmax_dv, [](float x) -> float {
-    return std::exp(x);
+    return x * (1.0f - x);
 })
 
 impl_test_unary_op(sigmoid, 1e-6, sigmoid, [](float x) -> float {
@@ -453,6 +451,572 @@ TEST(compute_cpu, matmul_f32_different_shape_2x2) {
     mag_ctx_destroy(ctx);
 }
 
+TEST(compute_cpu, matmul_f32_blocked_edge_tiles) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 67, K = 301, N = 83; // Not multiples of any micro tile or KC
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    mag_tensor_t* R = mag_matmul(A, B);
+    ASSERT_NE(R, nullptr);
+    ASSERT_EQ(mag_tensor_shape(R)[0], M);
+    ASSERT_EQ(mag_tensor_shape(R)[1], N);
+    std::vector<float> C(M*N);
+    mag__inner_matmul_naive(
+        static_cast<const float*>(mag_tensor_data_ptr(A)),
+        static_cast<const float*>(mag_tensor_data_ptr(B)),
+        C.data(),
+        M, N, K
+    );
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    for (std::int64_t i=0; i < M*N; ++i) {
+        ASSERT_NEAR(r[i], C[i], 1e-3f);
+    }
+    mag_tensor_decref(A);
+    mag_tensor_decref(B);
+    mag_tensor_decref(R);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, matmul_f32_batched_broadcast) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 5, K = 7, N = 9, B0 = 3, B1 = 2;
+    mag_tensor_t* A = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, M, K, B0, B1);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, K, N, B0); // Broadcasted over the last batch dim
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    mag_tensor_t* R = mag_matmul(A, B);
+    ASSERT_NE(R, nullptr);
+    ASSERT_EQ(mag_tensor_rank(R), 4);
+    ASSERT_EQ(mag_tensor_shape(R)[0], M);
+    ASSERT_EQ(mag_tensor_shape(R)[1], N);
+    ASSERT_EQ(mag_tensor_shape(R)[2], B0);
+    ASSERT_EQ(mag_tensor_shape(R)[3], B1);
+    const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+    const auto* b = static_cast<const float*>(mag_tensor_data_ptr(B));
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    std::vector<float> C(M*N);
+    for (std::int64_t i1=0; i1 < B1; ++i1) {
+        for (std::int64_t i0=0; i0 < B0; ++i0) {
+            mag__inner_matmul_naive(a + (i1*B0 + i0)*M*K, b + i0*K*N, C.data(), M, N, K);
+            const float* rr = r + (i1*B0 + i0)*M*N;
+            for (std::int64_t i=0; i < M*N; ++i) {
+                ASSERT_NEAR(rr[i], C[i], 1e-5f);
+            }
+        }
+    }
+    mag_tensor_decref(A);
+    mag_tensor_decref(B);
+    mag_tensor_decref(R);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, matmul_f32_transposed_views) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 37, K = 290, N = 45;
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    mag_tensor_t* At = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, M); // Row-major transposes, viewed back by mag_transpose
+    mag_tensor_t* Bt = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K);
+    const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+    const auto* b = static_cast<const float*>(mag_tensor_data_ptr(B));
+    auto* at = static_cast<float*>(mag_tensor_data_ptr(At));
+    auto* bt = static_cast<float*>(mag_tensor_data_ptr(Bt));
+    for (std::int64_t i=0; i < M; ++i)
+        for (std::int64_t k=0; k < K; ++k)
+            at[k*M + i] = a[i*K + k];
+    for (std::int64_t k=0; k < K; ++k)
+        for (std::int64_t j=0; j < N; ++j)
+            bt[j*K + k] = b[k*N + j];
+    mag_tensor_t* AtT = mag_transpose(At);
+    mag_tensor_t* BtT = mag_transpose(Bt);
+    std::vector<float> C(M*N);
+    mag__inner_matmul_naive(a, b, C.data(), M, N, K);
+    for (auto [x, y] : std::array<std::pair<mag_tensor_t*, mag_tensor_t*>, 3>{{{A, BtT}, {AtT, B}, {AtT, BtT}}}) { // NT, TN, TT
+        mag_tensor_t* R = mag_matmul(x, y);
+        ASSERT_NE(R, nullptr);
+        ASSERT_EQ(mag_tensor_shape(R)[0], M);
+        ASSERT_EQ(mag_tensor_shape(R)[1], N);
+        const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+        for (std::int64_t i=0; i < M*N; ++i) {
+            ASSERT_NEAR(r[i], C[i], 1e-3f);
+        }
+        mag_tensor_decref(R);
+    }
+    mag_tensor_decref(AtT);
+    mag_tensor_decref(BtT);
+    mag_tensor_decref(A);
+    mag_tensor_decref(B);
+    mag_tensor_decref(At);
+    mag_tensor_decref(Bt);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, matmul_f32_gemv) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 133, K = 71, B0 = 3;
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* V = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, K, 1, B0); // Several vectors against the same matrix
+    mag_tensor_fill_random_uniform(V, -1.0f, 1.0f);
+    mag_tensor_t* R = mag_matmul(A, V);
+    ASSERT_NE(R, nullptr);
+    ASSERT_EQ(mag_tensor_shape(R)[0], M);
+    ASSERT_EQ(mag_tensor_shape(R)[1], 1);
+    ASSERT_EQ(mag_tensor_shape(R)[2], B0);
+    const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+    const auto* v = static_cast<const float*>(mag_tensor_data_ptr(V));
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    std::vector<float> C(M);
+    for (std::int64_t i0=0; i0 < B0; ++i0) {
+        mag__inner_matmul_naive(a, v + i0*K, C.data(), M, 1, K);
+        for (std::int64_t i=0; i < M; ++i) {
+            ASSERT_NEAR(r[i0*M + i], C[i], 1e-4f);
+        }
+    }
+    mag_tensor_t* At = mag_transpose(A); // Row vector times matrix: vᵀ x Aᵀ
+    mag_tensor_t* Vt = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, K);
+    mag_tensor_copy_buffer_from(Vt, v, K*sizeof(float));
+    mag_tensor_t* Rt = mag_matmul(Vt, At);
+    ASSERT_NE(Rt, nullptr);
+    ASSERT_EQ(mag_tensor_shape(Rt)[0], 1);
+    ASSERT_EQ(mag_tensor_shape(Rt)[1], M);
+    mag__inner_matmul_naive(a, v, C.data(), M, 1, K);
+    const auto* rt = static_cast<const float*>(mag_tensor_data_ptr(Rt));
+    for (std::int64_t i=0; i < M; ++i) {
+        ASSERT_NEAR(rt[i], C[i], 1e-4f);
+    }
+    // Strided vectors: the columns of a row-major B and the rows of a transposed A are packed
+    static constexpr std::int64_t N = 5, Mt = 3;
+    mag_tensor_t* Bn = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_uniform(Bn, -1.0f, 1.0f);
+    mag_tensor_t* Rn = mag_matmul(A, Bn);
+    std::vector<float> Cn(M*N);
+    mag__inner_matmul_naive(a, static_cast<const float*>(mag_tensor_data_ptr(Bn)), Cn.data(), M, N, K);
+    const auto* rn = static_cast<const float*>(mag_tensor_data_ptr(Rn));
+    for (std::int64_t i=0; i < M*N; ++i) {
+        ASSERT_NEAR(rn[i], Cn[i], 1e-4f);
+    }
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, Mt);
+    mag_tensor_fill_random_uniform(W, -1.0f, 1.0f);
+    mag_tensor_t* Wt = mag_transpose(W);
+    mag_tensor_t* Rw = mag_matmul(Wt, At);
+    const auto* w = static_cast<const float*>(mag_tensor_data_ptr(W));
+    const auto* rw = static_cast<const float*>(mag_tensor_data_ptr(Rw));
+    for (std::int64_t i=0; i < Mt; ++i) {
+        for (std::int64_t j=0; j < M; ++j) {
+            float c = 0.0f;
+            for (std::int64_t k=0; k < K; ++k) c += w[k*Mt + i]*a[j*K + k];
+            ASSERT_NEAR(rw[i*M + j], c, 1e-4f);
+        }
+    }
+    for (mag_tensor_t* t : {Bn, Rn, W, Wt, Rw}) mag_tensor_decref(t);
+    mag_tensor_decref(A);
+    mag_tensor_decref(V);
+    mag_tensor_decref(R);
+    mag_tensor_decref(At);
+    mag_tensor_decref(Vt);
+    mag_tensor_decref(Rt);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, matmul_f32_fused_linear) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 67, K = 45, N = 37;
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    mag_tensor_t* bias = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, N); // Per-column bias row
+    mag_tensor_fill_random_uniform(bias, -1.0f, 1.0f);
+    mag_tensor_t* R = mag_linear(A, B, bias, MAG_ACTIVATION_RELU);
+    ASSERT_NE(R, nullptr);
+    ASSERT_EQ(mag_tensor_shape(R)[0], M);
+    ASSERT_EQ(mag_tensor_shape(R)[1], N);
+    const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+    const auto* b = static_cast<const float*>(mag_tensor_data_ptr(B));
+    const auto* bb = static_cast<const float*>(mag_tensor_data_ptr(bias));
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    std::vector<float> C(M*N);
+    mag__inner_matmul_naive(a, b, C.data(), M, N, K);
+    for (std::int64_t i=0; i < M; ++i) {
+        for (std::int64_t j=0; j < N; ++j) {
+            ASSERT_NEAR(r[i*N + j], std::max(C[i*N + j] + bb[j], 0.0f), 1e-4f);
+        }
+    }
+    mag_tensor_t* X = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, 1); // Dense layer on a single sample: σ(W x + b)
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    mag_tensor_t* Bv = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, 1);
+    mag_tensor_fill_random_uniform(Bv, -1.0f, 1.0f);
+    mag_tensor_t* Rf = mag_linear(A, X, Bv, MAG_ACTIVATION_SIGMOID);
+    ASSERT_NE(Rf, nullptr);
+    mag_tensor_t* Z = mag_matmul(A, X);
+    mag_tensor_t* Zb = mag_add(Z, Bv);
+    mag_tensor_t* Ru = mag_sigmoid(Zb);
+    const auto* rf = static_cast<const float*>(mag_tensor_data_ptr(Rf));
+    const auto* ru = static_cast<const float*>(mag_tensor_data_ptr(Ru));
+    for (std::int64_t i=0; i < M; ++i) {
+        ASSERT_NEAR(rf[i], ru[i], 1e-5f);
+    }
+    mag_tensor_t* bias_h = mag_cast(bias, MAG_DTYPE_F16);
+    ASSERT_EQ(mag_linear(A, B, bias_h, MAG_ACTIVATION_RELU), nullptr); // The epilogue reads F32 bias only
+    ASSERT_EQ(mag_linear(A, B, bias, MAG_ACTIVATION__NUM), nullptr);
+    mag_tensor_decref(bias_h);
+    mag_tensor_decref(A);
+    mag_tensor_decref(B);
+    mag_tensor_decref(bias);
+    mag_tensor_decref(R);
+    mag_tensor_decref(X);
+    mag_tensor_decref(Bv);
+    mag_tensor_decref(Rf);
+    mag_tensor_decref(Z);
+    mag_tensor_decref(Zb);
+    mag_tensor_decref(Ru);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, quantize_i8_roundtrip_and_matmul) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 37, K = 128, N = 71, BS = 32;
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* Aq = mag_quantize(A, BS);
+    ASSERT_NE(Aq, nullptr);
+    ASSERT_EQ(mag_tensor_dtype(Aq), MAG_DTYPE_I8);
+    ASSERT_EQ(mag_tensor_quant_block(Aq), BS);
+    ASSERT_EQ(mag_tensor_data_size(Aq), M*K + M*K/BS*sizeof(float));
+    mag_tensor_t* Ad = mag_dequantize(Aq);
+    const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+    const auto* ad = static_cast<const float*>(mag_tensor_data_ptr(Ad));
+    for (std::int64_t i=0; i < M*K; ++i) { // Rounding error is at most half a quantization step
+        ASSERT_NEAR(ad[i], a[i], 0.5f/127.0f + 1e-6f);
+    }
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N); // int8 x f32, B is quantized on the fly
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    mag_tensor_t* R = mag_matmul(Aq, B);
+    ASSERT_NE(R, nullptr);
+    ASSERT_EQ(mag_tensor_dtype(R), MAG_DTYPE_F32);
+    const auto* b = static_cast<const float*>(mag_tensor_data_ptr(B));
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    std::vector<float> C(M*N);
+    mag__inner_matmul_naive(a, b, C.data(), M, N, K);
+    for (std::int64_t i=0; i < M*N; ++i) {
+        ASSERT_NEAR(r[i], C[i], 0.1f);
+    }
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K); // int8 x int8, weights stored as [N, K] and transposed
+    mag_tensor_fill_random_uniform(W, -1.0f, 1.0f);
+    mag_tensor_t* Wq = mag_quantize(W, BS);
+    mag_tensor_t* Wt = mag_transpose(Wq);
+    mag_tensor_t* Rq = mag_matmul(Aq, Wt);
+    ASSERT_NE(Rq, nullptr);
+    const auto* w = static_cast<const float*>(mag_tensor_data_ptr(W));
+    const auto* rq = static_cast<const float*>(mag_tensor_data_ptr(Rq));
+    for (std::int64_t i=0; i < M; ++i) {
+        for (std::int64_t j=0; j < N; ++j) {
+            float sum = 0.0f;
+            for (std::int64_t k=0; k < K; ++k) sum += a[i*K + k]*w[j*K + k];
+            ASSERT_NEAR(rq[i*N + j], sum, 0.1f);
+        }
+    }
+    mag_tensor_t* bias = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, N); // Per output tile epilogue, N spans two tiles
+    mag_tensor_fill_random_uniform(bias, -1.0f, 1.0f);
+    mag_tensor_t* L = mag_linear(Aq, Wt, bias, MAG_ACTIVATION_RELU);
+    ASSERT_NE(L, nullptr);
+    const auto* pbias = static_cast<const float*>(mag_tensor_data_ptr(bias));
+    const auto* l = static_cast<const float*>(mag_tensor_data_ptr(L));
+    for (std::int64_t i=0; i < M*N; ++i) {
+        ASSERT_NEAR(l[i], std::max(rq[i] + pbias[i%N], 0.0f), 1e-5f);
+    }
+    mag_tensor_decref(L);
+    mag_tensor_decref(bias);
+    mag_tensor_t* V = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, K); // int8 x int8 with a single column, its strides are equal
+    mag_tensor_fill_random_uniform(V, -1.0f, 1.0f);
+    mag_tensor_t* Vq = mag_quantize(V, BS);
+    mag_tensor_t* Vt = mag_transpose(Vq);
+    mag_tensor_t* Rv = mag_matmul(Aq, Vt);
+    ASSERT_NE(Rv, nullptr);
+    const auto* v = static_cast<const float*>(mag_tensor_data_ptr(V));
+    const auto* rv = static_cast<const float*>(mag_tensor_data_ptr(Rv));
+    for (std::int64_t i=0; i < M; ++i) {
+        float sum = 0.0f;
+        for (std::int64_t k=0; k < K; ++k) sum += a[i*K + k]*v[k];
+        ASSERT_NEAR(rv[i], sum, 0.1f);
+    }
+    mag_tensor_t* B2 = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, 2*BS);
+    mag_tensor_fill_random_uniform(B2, -1.0f, 1.0f);
+    mag_tensor_t* Bq = mag_quantize(B2, BS);
+    ASSERT_EQ(mag_matmul(Aq, Bq), nullptr); // Columns of a row-major int8 B are strided along K
+    ASSERT_EQ(mag_dequantize(A), nullptr); // Only int8 tensors are dequantized
+    ASSERT_EQ(mag_quantize(Aq, BS), nullptr); // Only F32 tensors are quantized
+    mag_tensor_decref(V);
+    mag_tensor_decref(Vq);
+    mag_tensor_decref(Vt);
+    mag_tensor_decref(Rv);
+    mag_tensor_decref(B2);
+    mag_tensor_decref(Bq);
+    mag_tensor_decref(A);
+    mag_tensor_decref(Aq);
+    mag_tensor_decref(Ad);
+    mag_tensor_decref(B);
+    mag_tensor_decref(R);
+    mag_tensor_decref(W);
+    mag_tensor_decref(Wq);
+    mag_tensor_decref(Wt);
+    mag_tensor_decref(Rq);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, cast_bf16_roundtrip_and_matmul) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 37, K = 100, N = 71;
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* Ab = mag_cast(A, MAG_DTYPE_BF16);
+    ASSERT_NE(Ab, nullptr);
+    ASSERT_EQ(mag_tensor_dtype(Ab), MAG_DTYPE_BF16);
+    ASSERT_EQ(mag_tensor_data_size(Ab), M*K*sizeof(std::uint16_t));
+    mag_tensor_t* Af = mag_cast(Ab, MAG_DTYPE_F32);
+    const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+    const auto* af = static_cast<const float*>(mag_tensor_data_ptr(Af));
+    for (std::int64_t i=0; i < M*K; ++i) { // Round to nearest: at most half an ulp of the 8-bit mantissa
+        ASSERT_NEAR(af[i], a[i], std::abs(a[i])*(1.0f/256.0f));
+    }
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    const auto* b = static_cast<const float*>(mag_tensor_data_ptr(B));
+    std::vector<float> C(M*N);
+    mag__inner_matmul_naive(a, b, C.data(), M, N, K);
+    mag_tensor_t* Bb = mag_cast(B, MAG_DTYPE_BF16);
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K); // Weights stored as [N, K] and transposed
+    mag_tensor_fill_random_uniform(W, -1.0f, 1.0f);
+    mag_tensor_t* Wb = mag_cast(W, MAG_DTYPE_BF16);
+    mag_tensor_t* Wt = mag_transpose(Wb);
+    const auto* w = static_cast<const float*>(mag_tensor_data_ptr(W));
+    std::vector<float> Cw(M*N);
+    for (std::int64_t i=0; i < M; ++i) {
+        for (std::int64_t j=0; j < N; ++j) {
+            float sum = 0.0f;
+            for (std::int64_t k=0; k < K; ++k) sum += a[i*K + k]*w[j*K + k];
+            Cw[i*N + j] = sum;
+        }
+    }
+    auto check = [&](mag_tensor_t* R, const std::vector<float>& ref) {
+        ASSERT_NE(R, nullptr);
+        ASSERT_EQ(mag_tensor_dtype(R), MAG_DTYPE_F32);
+        const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+        for (std::int64_t i=0; i < M*N; ++i) {
+            ASSERT_NEAR(r[i], ref[i], 0.05f);
+        }
+        mag_tensor_decref(R);
+    };
+    check(mag_matmul(A, Bb), C);    // f32 x bf16
+    check(mag_matmul(Ab, B), C);    // bf16 x f32
+    check(mag_matmul(Ab, Bb), C);   // bf16 x bf16, gathered columns
+    check(mag_matmul(Ab, Wt), Cw);  // bf16 x bf16, columns read in place
+    check(mag_matmul(A, Wt), Cw);   // f32 x bf16 weights
+    mag_tensor_t* bias = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, N);
+    mag_tensor_fill_random_uniform(bias, -1.0f, 1.0f);
+    const auto* pbias = static_cast<const float*>(mag_tensor_data_ptr(bias));
+    std::vector<float> Cl(M*N);
+    for (std::int64_t i=0; i < M*N; ++i) Cl[i] = std::max(Cw[i] + pbias[i], 0.0f);
+    check(mag_linear(Ab, Wt, bias, MAG_ACTIVATION_RELU), Cl); // Epilogue per output tile
+    mag_tensor_decref(bias);
+    mag_tensor_decref(A);
+    mag_tensor_decref(Ab);
+    mag_tensor_decref(Af);
+    mag_tensor_decref(B);
+    mag_tensor_decref(Bb);
+    mag_tensor_decref(W);
+    mag_tensor_decref(Wb);
+    mag_tensor_decref(Wt);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, f16_elementwise_and_matmul) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 37, K = 100, N = 71;
+    auto data = [](mag_tensor_t* t) { return static_cast<const float*>(mag_tensor_data_ptr(t)); };
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    mag_tensor_t* Ah = mag_cast(A, MAG_DTYPE_F16);
+    mag_tensor_t* Bh = mag_cast(B, MAG_DTYPE_F16);
+    ASSERT_EQ(mag_tensor_dtype(Ah), MAG_DTYPE_F16);
+    ASSERT_EQ(mag_tensor_data_size(Ah), M*K*sizeof(std::uint16_t));
+    mag_tensor_t* Af = mag_cast(Ah, MAG_DTYPE_F32);
+    for (std::int64_t i=0; i < M*K; ++i) { // 11 bit mantissa, round to nearest
+        ASSERT_NEAR(data(Af)[i], data(A)[i], std::abs(data(A)[i])*(1.0f/2048.0f) + 1e-7f);
+    }
+    mag_tensor_t* Bb = mag_cast(Bh, MAG_DTYPE_BF16); // F16 -> BF16 goes through F32
+    mag_tensor_t* Bbf = mag_cast(Bb, MAG_DTYPE_F32);
+    for (std::int64_t i=0; i < M*K; ++i) {
+        ASSERT_NEAR(data(Bbf)[i], data(B)[i], std::abs(data(B)[i])*(1.0f/128.0f) + 1e-6f);
+    }
+    auto check_f16 = [&](mag_tensor_t* Rh, mag_tensor_t* R) { // F16 result against F32 reference
+        ASSERT_NE(Rh, nullptr);
+        ASSERT_EQ(mag_tensor_dtype(Rh), MAG_DTYPE_F16);
+        mag_tensor_t* Rf = mag_cast(Rh, MAG_DTYPE_F32);
+        for (std::int64_t i=0; i < mag_tensor_numel(R); ++i) {
+            ASSERT_NEAR(data(Rf)[i], data(R)[i], std::abs(data(R)[i])*(1.0f/256.0f) + 1e-3f);
+        }
+        mag_tensor_decref(Rf);
+        mag_tensor_decref(Rh);
+        mag_tensor_decref(R);
+    };
+    check_f16(mag_add(Ah, Bh), mag_add(A, B));
+    check_f16(mag_mul(Ah, Bh), mag_mul(A, B));
+    check_f16(mag_muls(Ah, 3.0f), mag_muls(A, 3.0f));
+    check_f16(mag_sigmoid(Ah), mag_sigmoid(A));
+    mag_tensor_t* Row = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, K);
+    mag_tensor_fill_random_uniform(Row, -1.0f, 1.0f);
+    mag_tensor_t* Rowh = mag_cast(Row, MAG_DTYPE_F16);
+    mag_tensor_t* Rowf = mag_cast(Rowh, MAG_DTYPE_F32);
+    check_f16(mag_sub(Ah, Rowh), mag_sub(Af, Rowf)); // Broadcasting
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+    mag_tensor_fill_random_uniform(W, -1.0f, 1.0f);
+    mag_tensor_t* Wh = mag_cast(W, MAG_DTYPE_F16);
+    mag_tensor_t* Wt = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K); // Weights stored as [N, K] and transposed
+    mag_tensor_fill_random_uniform(Wt, -1.0f, 1.0f);
+    mag_tensor_t* Wth = mag_cast(Wt, MAG_DTYPE_F16);
+    mag_tensor_t* WthT = mag_transpose(Wth);
+    mag_tensor_t* Wtf = mag_cast(Wth, MAG_DTYPE_F32);
+    mag_tensor_t* WtfT = mag_transpose(Wtf);
+    mag_tensor_t* Whf = mag_cast(Wh, MAG_DTYPE_F32);
+    auto check = [&](mag_tensor_t* R, mag_tensor_t* Ref) { // F32 result against F32 matmul of the widened operands
+        ASSERT_NE(R, nullptr);
+        ASSERT_EQ(mag_tensor_dtype(R), MAG_DTYPE_F32);
+        for (std::int64_t i=0; i < M*N; ++i) {
+            ASSERT_NEAR(data(R)[i], data(Ref)[i], 1e-4f);
+        }
+        mag_tensor_decref(R);
+        mag_tensor_decref(Ref);
+    };
+    check(mag_matmul(Ah, Wh), mag_matmul(Af, Whf));     // f16 x f16
+    check(mag_matmul(Af, Wh), mag_matmul(Af, Whf));     // f32 x f16
+    check(mag_matmul(Ah, WthT), mag_matmul(Af, WtfT));  // f16 x f16ᵀ
+    check(mag_matmul(Ah, Whf), mag_matmul(Af, Whf));    // f16 x f32
+    ASSERT_TRUE(mag_tensor_pack_weights(Wh));           // F16 weights packed into F32 panels
+    check(mag_matmul(Af, Wh), mag_matmul(Af, Whf));
+    mag_tensor_t* tensors[] = {A, B, Ah, Bh, Af, Bb, Bbf, Row, Rowh, Rowf, W, Wh, Wt, Wth, WthT, Wtf, WtfT, Whf};
+    for (mag_tensor_t* t : tensors)
+        mag_tensor_decref(t);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, qblock_roundtrip_and_matmul) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 37, K = 160, N = 71;
+    for (mag_dtype_t type : {MAG_DTYPE_Q8, MAG_DTYPE_Q4}) {
+        float qmax = type == MAG_DTYPE_Q8 ? 127.0f : 7.0f;
+        mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, M, K);
+        mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+        mag_tensor_t* Aq = mag_cast(A, type);
+        ASSERT_NE(Aq, nullptr);
+        ASSERT_EQ(mag_tensor_dtype(Aq), type);
+        ASSERT_EQ(mag_tensor_data_size(Aq), M*K/MAG_QK*mag_dtype_meta_of(type)->size);
+        mag_tensor_t* Ad = mag_dequantize(Aq);
+        ASSERT_EQ(mag_tensor_dtype(Ad), MAG_DTYPE_F32);
+        const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+        const auto* ad = static_cast<const float*>(mag_tensor_data_ptr(Ad));
+        for (std::int64_t i=0; i < M*K; ++i) { // Half a quantization step, plus the F16 rounding of the scale
+            ASSERT_NEAR(ad[i], a[i], 0.5f/qmax + 1e-3f);
+        }
+        // Quantized A times row-major and transposed F32 B, compared against the dequantized weights
+        mag_tensor_t* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, K, N);
+        mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+        mag_tensor_t* Bs = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, N, K);
+        mag_tensor_fill_random_uniform(Bs, -1.0f, 1.0f);
+        mag_tensor_t* Bt = mag_transpose(Bs);
+        for (mag_tensor_t* b : {B, Bt}) {
+            mag_tensor_t* R = mag_matmul(Aq, b);
+            ASSERT_NE(R, nullptr);
+            ASSERT_EQ(mag_tensor_dtype(R), MAG_DTYPE_F32);
+            const auto* pb = static_cast<const float*>(mag_tensor_data_ptr(b));
+            const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+            for (std::int64_t i=0; i < M; ++i) {
+                for (std::int64_t j=0; j < N; ++j) {
+                    float sum = 0.0f;
+                    for (std::int64_t k=0; k < K; ++k) sum += ad[i*K + k]*(b == B ? pb[k*N + j] : pb[j*K + k]);
+                    ASSERT_NEAR(r[i*N + j], sum, 1e-3f);
+                }
+            }
+            mag_tensor_decref(R);
+        }
+        // F32 activations times quantized weights stored as [N, K] and transposed, with bias and activation
+        mag_tensor_t* W = mag_cast(Bs, type);
+        mag_tensor_t* Wd = mag_dequantize(W);
+        mag_tensor_t* Wt = mag_transpose(W);
+        mag_tensor_t* bias = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, N);
+        mag_tensor_fill_random_uniform(bias, -1.0f, 1.0f);
+        mag_tensor_t* L = mag_linear(A, Wt, bias, MAG_ACTIVATION_RELU);
+        ASSERT_NE(L, nullptr);
+        const auto* wd = static_cast<const float*>(mag_tensor_data_ptr(Wd));
+        const auto* pbias = static_cast<const float*>(mag_tensor_data_ptr(bias));
+        const auto* l = static_cast<const float*>(mag_tensor_data_ptr(L));
+        for (std::int64_t i=0; i < M; ++i) {
+            for (std::int64_t j=0; j < N; ++j) {
+                float sum = pbias[j];
+                for (std::int64_t k=0; k < K; ++k) sum += a[i*K + k]*wd[j*K + k];
+                ASSERT_NEAR(l[i*N + j], std::max(sum, 0.0f), 1e-3f);
+            }
+        }
+        mag_tensor_decref(A);
+        mag_tensor_decref(Aq);
+        mag_tensor_decref(Ad);
+        mag_tensor_decref(B);
+        mag_tensor_decref(Bs);
+        mag_tensor_decref(Bt);
+        mag_tensor_decref(W);
+        mag_tensor_decref(Wd);
+        mag_tensor_decref(Wt);
+        mag_tensor_decref(bias);
+        mag_tensor_decref(L);
+    }
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, matmul_f32_prepacked_weights) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t M = 3, K = 300, N = 75, B0 = 2;
+    mag_tensor_t* A = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, M, K, B0);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* B = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, K, N, B0);
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    ASSERT_FALSE(mag_tensor_is_packed(B));
+    mag_tensor_t* R0 = mag_matmul(A, B);
+    ASSERT_TRUE(mag_tensor_pack_weights(B));
+    ASSERT_TRUE(mag_tensor_is_packed(B));
+    mag_tensor_t* R1 = mag_matmul(A, B);
+    ASSERT_EQ(std::memcmp(mag_tensor_data_ptr(R0), mag_tensor_data_ptr(R1), mag_tensor_data_size(R0)), 0); // Same blocking, bitwise equal
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f); // Write drops the packed copy
+    ASSERT_FALSE(mag_tensor_is_packed(B));
+    mag_tensor_t* R2 = mag_matmul(A, B);
+    const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+    const auto* b = static_cast<const float*>(mag_tensor_data_ptr(B));
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R2));
+    std::vector<float> C(M*N);
+    for (std::int64_t i0=0; i0 < B0; ++i0) {
+        mag__inner_matmul_naive(a + i0*M*K, b + i0*K*N, C.data(), M, N, K);
+        for (std::int64_t i=0; i < M*N; ++i) {
+            ASSERT_NEAR(r[i0*M*N + i], C[i], 1e-3f);
+        }
+    }
+    ASSERT_TRUE(mag_tensor_pack_weights(B));
+    mag_tensor_t* V = mag_muls_(B, 2.0f); // Inplace op writes through a view of B
+    ASSERT_FALSE(mag_tensor_is_packed(B));
+    mag_tensor_decref(A);
+    mag_tensor_decref(B);
+    mag_tensor_decref(V);
+    mag_tensor_decref(R0);
+    mag_tensor_decref(R1);
+    mag_tensor_decref(R2);
+    mag_ctx_destroy(ctx);
+}
+
 TEST(compute_cpu, arithmetic_mean) {
     mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
     mag_tensor_t* A = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, 4, 1, 3, 2);
@@ -510,6 +1074,574 @@ TEST(compute_cpu, hsum) {
     mag_ctx_destroy(ctx);
 }
 
+TEST(compute_cpu, reduce_axes) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    const std::vector<std::vector<std::int64_t>> shapes = {{7, 5, 3, 4}, {3000, 4, 3}}; // The second one has rows longer than a reduction tile
+    const std::vector<std::vector<std::int64_t>> axes = {{0}, {1}, {2}, {0, 2}, {1, 2}, {2, 1, 0}};
+    for (const auto& shape : shapes) {
+        mag_tensor_t* A = shape.size() == 4
+            ? mag_tensor_create_4d(ctx, MAG_DTYPE_F32, shape[0], shape[1], shape[2], shape[3])
+            : mag_tensor_create_3d(ctx, MAG_DTYPE_F32, shape[0], shape[1], shape[2]);
+        mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+        const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+        std::int64_t d[4] = {1, 1, 1, 1};
+        for (std::size_t i=0; i < shape.size(); ++i) d[i] = shape[i];
+        for (const auto& ax : axes) {
+            for (bool keepdim : {false, true}) {
+                mag_tensor_t* R[4] = {
+                    mag_sum_axes(A, ax.data(), static_cast<std::uint32_t>(ax.size()), keepdim),
+                    mag_mean_axes(A, ax.data(), static_cast<std::uint32_t>(ax.size()), keepdim),
+                    mag_min_axes(A, ax.data(), static_cast<std::uint32_t>(ax.size()), keepdim),
+                    mag_max_axes(A, ax.data(), static_cast<std::uint32_t>(ax.size()), keepdim)
+                };
+                bool red[4] = {};
+                for (std::int64_t k : ax) red[k] = true;
+                std::int64_t rd[4], rank = 0, count = 1;
+                for (std::size_t k=0; k < shape.size(); ++k) {
+                    if (!red[k]) rd[rank++] = d[k];
+                    else if (keepdim) rd[rank++] = 1;
+                    if (red[k]) count *= d[k];
+                }
+                if (!rank) rd[rank++] = 1; // Full reductions yield shape (1)
+                ASSERT_EQ(mag_tensor_rank(R[0]), rank);
+                for (std::int64_t k=0; k < rank; ++k)
+                    ASSERT_EQ(mag_tensor_shape(R[0])[k], rd[k]);
+                std::vector<double> sum(mag_tensor_numel(R[0]), 0.0);
+                std::vector<float> mn(sum.size(), INFINITY), mx(sum.size(), -INFINITY);
+                for (std::int64_t i3=0; i3 < d[3]; ++i3)
+                for (std::int64_t i2=0; i2 < d[2]; ++i2)
+                for (std::int64_t i1=0; i1 < d[1]; ++i1)
+                for (std::int64_t i0=0; i0 < d[0]; ++i0) {
+                    std::int64_t i[4] = {i0, i1, i2, i3};
+                    std::int64_t o = 0, os = 1;
+                    for (std::int64_t k=0; k < 4; ++k) {
+                        if (!red[k]) { o += i[k]*os; os *= d[k]; }
+                    }
+                    float v = a[i0 + d[0]*(i1 + d[1]*(i2 + d[2]*i3))];
+                    sum[o] += v;
+                    mn[o] = std::min(mn[o], v);
+                    mx[o] = std::max(mx[o], v);
+                }
+                const auto* rsum = static_cast<const float*>(mag_tensor_data_ptr(R[0]));
+                const auto* rmean = static_cast<const float*>(mag_tensor_data_ptr(R[1]));
+                const auto* rmin = static_cast<const float*>(mag_tensor_data_ptr(R[2]));
+                const auto* rmax = static_cast<const float*>(mag_tensor_data_ptr(R[3]));
+                for (std::size_t o=0; o < sum.size(); ++o) {
+                    ASSERT_NEAR(rsum[o], sum[o], 1e-3);
+                    ASSERT_NEAR(rmean[o], sum[o]/static_cast<double>(count), 1e-5);
+                    ASSERT_EQ(rmin[o], mn[o]);
+                    ASSERT_EQ(rmax[o], mx[o]);
+                }
+                for (mag_tensor_t* t : R) mag_tensor_decref(t);
+            }
+        }
+        mag_tensor_decref(A);
+    }
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, reduce_full_thread_count_invariant) {
+    float ref[4] = {};
+    for (std::uint32_t threads : {1u, 2u, 3u, 8u}) {
+        mag_device_descriptor_t desc = {.type = MAG_COMPUTE_DEVICE_TYPE_CPU, .thread_count = threads};
+        mag_ctx_t* ctx = mag_ctx_create2(&desc);
+        mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 4096, 1031);
+        auto* a = static_cast<float*>(mag_tensor_data_ptr(A));
+        std::uint32_t state = 0x9e3779b9u;
+        for (std::int64_t i=0; i < mag_tensor_numel(A); ++i) { // Same data for every context
+            state = state*1664525u + 1013904223u;
+            a[i] = static_cast<float>(state>>8)*0x1.0p-24f*2.0f - 1.0f;
+        }
+        mag_tensor_t* R[4] = {mag_sum(A), mag_mean(A), mag_min(A), mag_max(A)};
+        for (int k=0; k < 4; ++k) {
+            float v = *static_cast<const float*>(mag_tensor_data_ptr(R[k]));
+            if (threads == 1) ref[k] = v;
+            else ASSERT_EQ(v, ref[k]); // Bitwise identical partial combine for every thread count
+            mag_tensor_decref(R[k]);
+        }
+        mag_tensor_decref(A);
+        mag_ctx_destroy(ctx);
+    }
+}
+
+TEST(compute_cpu, reduce_nan_lanes) { // Min/max skip NaNs like fminf/fmaxf, sum propagates them
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    const std::int64_t axis[] = {0};
+    for (std::int64_t n : {1, 3, 17, 33, 1031}) { // Covers the scalar tail after every vector width
+        std::int64_t rows = n+2; // Row r < n has a NaN in lane r, row n is all NaN, row n+1 has none
+        mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, n, rows);
+        auto* a = static_cast<float*>(mag_tensor_data_ptr(A));
+        for (std::int64_t r=0; r < rows; ++r) {
+            for (std::int64_t i=0; i < n; ++i) {
+                float v = static_cast<float>((i*37 + r*11) % 101) - 50.0f;
+                a[r*n + i] = r == n || r == i ? NAN : v;
+            }
+        }
+        mag_tensor_t* R[3] = {mag_sum_axes(A, axis, 1, false), mag_min_axes(A, axis, 1, false), mag_max_axes(A, axis, 1, false)};
+        const auto* rsum = static_cast<const float*>(mag_tensor_data_ptr(R[0]));
+        const auto* rmin = static_cast<const float*>(mag_tensor_data_ptr(R[1]));
+        const auto* rmax = static_cast<const float*>(mag_tensor_data_ptr(R[2]));
+        for (std::int64_t r=0; r < rows; ++r) {
+            double sum = 0.0;
+            float mn = INFINITY, mx = -INFINITY;
+            for (std::int64_t i=0; i < n; ++i) {
+                sum += a[r*n + i];
+                mn = std::fmin(mn, a[r*n + i]);
+                mx = std::fmax(mx, a[r*n + i]);
+            }
+            if (r < rows-1) ASSERT_TRUE(std::isnan(rsum[r])) << "n=" << n << " row=" << r;
+            else ASSERT_NEAR(rsum[r], sum, 1e-3);
+            ASSERT_EQ(rmin[r], mn) << "n=" << n << " row=" << r;
+            ASSERT_EQ(rmax[r], mx) << "n=" << n << " row=" << r;
+        }
+        ASSERT_EQ(rmin[n], INFINITY); // All NaN rows reduce to the identity
+        ASSERT_EQ(rmax[n], -INFINITY);
+        for (mag_tensor_t* t : R) mag_tensor_decref(t);
+        mag_tensor_decref(A);
+    }
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, topk_signed_zero_ties) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    mag_tensor_t* A = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, 5);
+    auto* a = static_cast<float*>(mag_tensor_data_ptr(A));
+    const float v[5] = {-0.0f, 0.0f, 1.0f, -0.0f, -1.0f};
+    std::copy(v, v+5, a);
+    mag_tensor_t* top = mag_topk(A, 4, 0);
+    const auto* r = static_cast<const std::int32_t*>(mag_tensor_data_ptr(top));
+    const std::int32_t expected[4] = {2, 0, 1, 3}; // -0 and +0 compare equal, so they keep index order
+    for (int i=0; i < 4; ++i)
+        ASSERT_EQ(r[i], expected[i]);
+    mag_tensor_decref(top);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, argmax_argmin_topk) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    const std::int64_t d[3] = {37, 6, 5};
+    mag_tensor_t* A = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, d[0], d[1], d[2]);
+    mag_tensor_fill_random_uniform(A, -20.0f, 20.0f);
+    auto* a = static_cast<float*>(mag_tensor_data_ptr(A));
+    for (std::int64_t i=0; i < mag_tensor_numel(A); ++i) a[i] = std::round(a[i]); // Few distinct values, so there are ties
+    a[3] = NAN;
+    auto at = [&](std::int64_t i0, std::int64_t i1, std::int64_t i2) { return a[i0 + d[0]*(i1 + d[1]*i2)]; };
+    for (std::int64_t axis=0; axis < 3; ++axis) {
+        std::int64_t o[2], od[2], n = d[axis], rank = 0;
+        for (std::int64_t k=0; k < 3; ++k) if (k != axis) od[rank++] = d[k];
+        mag_tensor_t* amax = mag_argmax(A, axis, false);
+        mag_tensor_t* amin = mag_argmin(A, axis, true);
+        ASSERT_EQ(mag_tensor_dtype(amax), MAG_DTYPE_I32);
+        ASSERT_EQ(mag_tensor_rank(amax), 2);
+        ASSERT_EQ(mag_tensor_rank(amin), 3);
+        ASSERT_EQ(mag_tensor_shape(amin)[axis], 1);
+        const std::int64_t k = 4;
+        mag_tensor_t* top = mag_topk(A, k, axis);
+        mag_tensor_t* vals = mag_gather(A, axis, top);
+        ASSERT_EQ(mag_tensor_shape(top)[axis], k);
+        const auto* rmax = static_cast<const std::int32_t*>(mag_tensor_data_ptr(amax));
+        const auto* rmin = static_cast<const std::int32_t*>(mag_tensor_data_ptr(amin));
+        const auto* rtop = static_cast<const std::int32_t*>(mag_tensor_data_ptr(top));
+        const auto* rvals = static_cast<const float*>(mag_tensor_data_ptr(vals));
+        std::int64_t inner = 1;
+        for (std::int64_t q=0; q < axis; ++q) inner *= d[q];
+        for (o[1]=0; o[1] < od[1]; ++o[1]) {
+            for (o[0]=0; o[0] < od[0]; ++o[0]) {
+                std::vector<std::pair<float, std::int64_t>> row;
+                for (std::int64_t j=0; j < n; ++j) {
+                    std::int64_t i[3], r = 0;
+                    for (std::int64_t q=0; q < 3; ++q) i[q] = q == axis ? j : o[r++];
+                    float v = at(i[0], i[1], i[2]);
+                    if (!std::isnan(v)) row.emplace_back(v, j);
+                }
+                std::int64_t ri = o[0] + od[0]*o[1];
+                auto mx = std::max_element(row.begin(), row.end(), [](auto& x, auto& y) { return x.first < y.first; }); // First of the equal maxima
+                auto mn = std::min_element(row.begin(), row.end(), [](auto& x, auto& y) { return x.first < y.first; });
+                ASSERT_EQ(rmax[ri], mx->second);
+                ASSERT_EQ(rmin[ri], mn->second);
+                std::stable_sort(row.begin(), row.end(), [](auto& x, auto& y) { return x.first > y.first; });
+                std::int64_t ro = ri%inner + ri/inner*k*inner; // Same row in the [outer, k, inner] result
+                for (std::int64_t j=0; j < k; ++j) {
+                    ASSERT_EQ(rtop[ro + j*inner], row[j].second);
+                    ASSERT_EQ(rvals[ro + j*inner], row[j].first);
+                }
+            }
+        }
+        for (mag_tensor_t* t : {amax, amin, top, vals}) mag_tensor_decref(t);
+    }
+    // Invalid indices are diagnosed instead of failing inside the kernel
+    mag_tensor_t* I = mag_topk(A, 2, 1);
+    auto* idx = static_cast<std::int32_t*>(mag_tensor_data_ptr(I));
+    mag_tensor_t* G = mag_gather(A, 1, I);
+    ASSERT_NE(G, nullptr);
+    mag_tensor_decref(G);
+    idx[7] = 6;
+    ASSERT_EQ(mag_gather(A, 1, I), nullptr);
+    idx[7] = -1;
+    ASSERT_EQ(mag_gather(A, 1, I), nullptr);
+    ASSERT_EQ(mag_gather(A, 0, I), nullptr); // Extent 2 instead of 6 along axis 1
+    ASSERT_EQ(mag_gather(A, 1, A), nullptr);
+    mag_tensor_t* I1 = mag_tensor_create_1d(ctx, MAG_DTYPE_I32, 4);
+    ASSERT_EQ(mag_gather(A, 0, I1), nullptr);
+    mag_tensor_decref(I1);
+    mag_tensor_decref(I);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, softmax_rows) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    auto data = [](mag_tensor_t* t) { return static_cast<float*>(mag_tensor_data_ptr(t)); };
+    auto check = [&](mag_tensor_t* X, mag_tensor_t* R, float eps) { // Double precision reference per contiguous row
+        std::int64_t n = mag_tensor_shape(X)[0];
+        for (std::int64_t r=0; r < mag_tensor_numel(X)/n; ++r) {
+            const float* x = data(X) + r*n;
+            double m = -INFINITY, s = 0.0;
+            for (std::int64_t i=0; i < n; ++i) m = std::max(m, static_cast<double>(x[i]));
+            for (std::int64_t i=0; i < n; ++i) s += std::exp(x[i] - m);
+            for (std::int64_t i=0; i < n; ++i) {
+                ASSERT_NEAR(data(R)[r*n + i], std::exp(x[i] - m)/s, eps);
+            }
+        }
+    };
+    mag_tensor_t* A = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, 37, 5, 3);
+    mag_tensor_fill_random_uniform(A, -50.0f, 50.0f);
+    for (std::int64_t i=0; i < 37; ++i) data(A)[37*4 + i] += 1000.0f; // Large logits overflow a naive e^x
+    data(A)[37*7] = -INFINITY;
+    mag_tensor_t* R = mag_softmax(A);
+    check(A, R, 1e-6f);
+    ASSERT_EQ(data(R)[37*7], 0.0f);
+    mag_tensor_t* Ah = mag_cast(A, MAG_DTYPE_F16);
+    mag_tensor_t* Rh = mag_softmax(Ah);
+    ASSERT_EQ(mag_tensor_dtype(Rh), MAG_DTYPE_F16);
+    mag_tensor_t* Af = mag_cast(Ah, MAG_DTYPE_F32);
+    mag_tensor_t* Rf = mag_cast(Rh, MAG_DTYPE_F32);
+    check(Af, Rf, 1e-3f);
+    mag_tensor_t* Ai = mag_clone(A);
+    mag_tensor_t* Ri = mag_softmax_(Ai);
+    ASSERT_EQ(mag_tensor_data_ptr(Ri), mag_tensor_data_ptr(Ai));
+    for (std::int64_t i=0; i < mag_tensor_numel(A); ++i) ASSERT_EQ(data(Ai)[i], data(R)[i]);
+    for (mag_tensor_t* t : {A, R, Ah, Rh, Af, Rf, Ai, Ri}) mag_tensor_decref(t);
+    for (std::int64_t n : {5000, 300000}) { // Rising logits raise the running max in every block, the long row takes the unfused path
+        mag_tensor_t* X = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, n);
+        mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+        for (std::int64_t i=0; i < n; ++i) data(X)[i] += 20.0f*static_cast<float>(i)/static_cast<float>(n);
+        mag_tensor_t* Y = mag_softmax(X);
+        check(X, Y, 1e-7f);
+        double s = 0.0;
+        for (std::int64_t i=0; i < n; ++i) s += data(Y)[i];
+        ASSERT_NEAR(s, 1.0, 1e-4);
+        mag_tensor_t* Xi = mag_clone(X);
+        mag_tensor_t* Yi = mag_softmax_(Xi);
+        for (std::int64_t i=0; i < n; ++i) ASSERT_EQ(data(Xi)[i], data(Y)[i]);
+        for (mag_tensor_t* t : {X, Y, Xi, Yi}) mag_tensor_decref(t);
+    }
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, layer_norm_rms_norm) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    auto data = [](mag_tensor_t* t) { return static_cast<float*>(mag_tensor_data_ptr(t)); };
+    const std::int64_t n = 67, rows = 9*4;
+    mag_tensor_t* X = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, n, 9, 4);
+    mag_tensor_fill_random_uniform(X, -3.0f, 3.0f);
+    for (std::int64_t i=0; i < n; ++i) data(X)[n*5 + i] = 1000.0f + 0.01f*data(X)[n*5 + i]; // |mean| >> std
+    mag_tensor_t* W = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, n);
+    mag_tensor_t* B = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, n);
+    mag_tensor_fill_random_uniform(W, 0.5f, 1.5f);
+    mag_tensor_fill_random_uniform(B, -1.0f, 1.0f);
+    const float eps = 1e-5f;
+    for (int rms=0; rms < 2; ++rms) {
+        for (int affine=0; affine < 4; ++affine) {
+            if (rms && (affine & 2)) continue; // RMSNorm has no bias
+            mag_tensor_t* w = affine & 1 ? W : nullptr;
+            mag_tensor_t* b = affine & 2 ? B : nullptr;
+            mag_tensor_t* R = rms ? mag_rms_norm(X, w, eps) : mag_layer_norm(X, w, b, eps);
+            ASSERT_EQ(mag_tensor_numel(R), mag_tensor_numel(X));
+            for (std::int64_t r=0; r < rows; ++r) { // Double precision two-pass reference
+                const float* x = data(X) + r*n;
+                double mean = 0.0, var = 0.0;
+                for (std::int64_t i=0; i < n; ++i) mean += x[i];
+                mean = rms ? 0.0 : mean/n;
+                for (std::int64_t i=0; i < n; ++i) var += (x[i] - mean)*(x[i] - mean);
+                double rstd = 1.0/std::sqrt(var/n + eps);
+                for (std::int64_t i=0; i < n; ++i) {
+                    double y = (x[i] - mean)*rstd;
+                    if (w) y *= data(W)[i];
+                    if (b) y += data(B)[i];
+                    ASSERT_NEAR(data(R)[r*n + i], y, 1e-4);
+                }
+            }
+            mag_tensor_decref(R);
+        }
+    }
+    for (mag_tensor_t* t : {X, W, B}) mag_tensor_decref(t);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, cumsum_cumprod) {
+    const std::int64_t d[3] = {37, 6, 5};
+    for (std::uint32_t threads : {1u, 4u}) {
+        mag_device_descriptor_t desc = {.type = MAG_COMPUTE_DEVICE_TYPE_CPU, .thread_count = threads};
+        mag_ctx_t* ctx = mag_ctx_create2(&desc);
+        mag_tensor_t* A = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, d[0], d[1], d[2]);
+        mag_tensor_fill_random_uniform(A, 0.8f, 1.2f);
+        const auto* a = static_cast<const float*>(mag_tensor_data_ptr(A));
+        for (std::int64_t axis=0; axis < 3; ++axis) {
+            mag_tensor_t* S = mag_cumsum(A, axis);
+            mag_tensor_t* P = mag_cumprod(A, axis);
+            ASSERT_EQ(mag_tensor_numel(S), mag_tensor_numel(A));
+            const auto* s = static_cast<const float*>(mag_tensor_data_ptr(S));
+            const auto* p = static_cast<const float*>(mag_tensor_data_ptr(P));
+            std::int64_t stride = 1;
+            for (std::int64_t k=0; k < axis; ++k) stride *= d[k];
+            for (std::int64_t i=0; i < mag_tensor_numel(A); ++i) {
+                std::int64_t j = i/stride%d[axis]; // Coordinate along axis
+                double rs = 0.0, rp = 1.0;
+                for (std::int64_t q=0; q <= j; ++q) {
+                    rs += a[i - (j-q)*stride];
+                    rp *= a[i - (j-q)*stride];
+                }
+                ASSERT_NEAR(s[i], rs, 1e-5*rs);
+                ASSERT_NEAR(p[i], rp, 1e-5*rp);
+            }
+            mag_tensor_decref(S);
+            mag_tensor_decref(P);
+        }
+        mag_tensor_decref(A);
+        const std::int64_t n = 1<<20; // Few long rows, scanned as one block per thread
+        mag_tensor_t* X = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, n, 2);
+        auto* x = static_cast<float*>(mag_tensor_data_ptr(X));
+        for (std::int64_t i=0; i < 2*n; ++i) x[i] = static_cast<float>(i%7) - 3.0f; // Small integers, so the sums are exact
+        mag_tensor_t* S = mag_cumsum(X, 0);
+        const auto* s = static_cast<const float*>(mag_tensor_data_ptr(S));
+        for (std::int64_t r=0; r < 2; ++r) {
+            float acc = 0.0f;
+            for (std::int64_t i=0; i < n; ++i) {
+                acc += x[r*n + i];
+                ASSERT_EQ(s[r*n + i], acc);
+            }
+        }
+        mag_tensor_decref(S);
+        mag_tensor_decref(X);
+        mag_ctx_destroy(ctx);
+    }
+}
+
+TEST(compute_cpu, unary_strided_views) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    mag_tensor_t* A = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, 5, 7, 3, 300);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* views[3] = {
+        mag_transpose(A),                  // Strided innermost axis
+        mag_permute(A, 0, 2, 1, 3, 4, 5),  // Contiguous rows, permuted outer axes
+        mag_permute(A, 3, 1, 2, 0, 4, 5)   // Innermost axis with the largest stride
+    };
+    for (mag_tensor_t* V : views) {
+        mag_tensor_t* R[3] = {mag_abs(V), mag_tanh(V), mag_muls(V, 3.0f)};
+        const auto* shape = mag_tensor_shape(V);
+        for (int k=0; k < 3; ++k) {
+            const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R[k]));
+            std::int64_t i = 0;
+            for (std::int64_t i3=0; i3 < shape[3]; ++i3)
+            for (std::int64_t i2=0; i2 < shape[2]; ++i2)
+            for (std::int64_t i1=0; i1 < shape[1]; ++i1)
+            for (std::int64_t i0=0; i0 < shape[0]; ++i0, ++i) { // Result is contiguous, the view is read through its strides
+                float x = mag_tensor_get_scalar_physical_index(V, i0, i1, i2, i3, 0, 0);
+                float y = k == 0 ? std::abs(x) : k == 1 ? std::tanh(x) : x*3.0f;
+                ASSERT_NEAR(r[i], y, 1e-3f);
+            }
+            mag_tensor_decref(R[k]);
+        }
+        mag_tensor_decref(V);
+    }
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+TEST(compute_cpu, softmax_strided_views) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 4, 3);
+    mag_tensor_t* B = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, 5, 7, 3, 40);
+    mag_tensor_fill_random_uniform(A, -5.0f, 5.0f);
+    mag_tensor_fill_random_uniform(B, -5.0f, 5.0f);
+    mag_tensor_t* views[3] = {
+        mag_transpose(A),                  // Strided rows
+        mag_permute(B, 0, 2, 1, 3, 4, 5),  // Contiguous rows, permuted outer axes
+        mag_permute(B, 3, 1, 2, 0, 4, 5)   // Rows along the largest stride
+    };
+    for (mag_tensor_t* V : views) {
+        mag_tensor_t* R = mag_softmax(V);
+        ASSERT_NE(R, nullptr);
+        const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+        const auto* shape = mag_tensor_shape(V);
+        std::vector<float> ref(mag_tensor_numel(V));
+        std::int64_t i = 0;
+        for (std::int64_t i3=0; i3 < shape[3]; ++i3)
+        for (std::int64_t i2=0; i2 < shape[2]; ++i2)
+        for (std::int64_t i1=0; i1 < shape[1]; ++i1) {
+            double m = -INFINITY, s = 0.0;
+            for (std::int64_t i0=0; i0 < shape[0]; ++i0) m = std::max(m, static_cast<double>(mag_tensor_get_scalar_physical_index(V, i0, i1, i2, i3, 0, 0)));
+            for (std::int64_t i0=0; i0 < shape[0]; ++i0) s += std::exp(mag_tensor_get_scalar_physical_index(V, i0, i1, i2, i3, 0, 0) - m);
+            for (std::int64_t i0=0; i0 < shape[0]; ++i0, ++i) { // Result is contiguous
+                ref[i] = static_cast<float>(std::exp(mag_tensor_get_scalar_physical_index(V, i0, i1, i2, i3, 0, 0) - m)/s);
+                ASSERT_NEAR(r[i], ref[i], 1e-6f);
+            }
+        }
+        mag_tensor_decref(mag_softmax_(V)); // In-place on the view normalizes the same logical rows, read back through the view
+        i = 0;
+        for (std::int64_t i3=0; i3 < shape[3]; ++i3)
+        for (std::int64_t i2=0; i2 < shape[2]; ++i2)
+        for (std::int64_t i1=0; i1 < shape[1]; ++i1)
+        for (std::int64_t i0=0; i0 < shape[0]; ++i0, ++i)
+            ASSERT_NEAR(mag_tensor_get_scalar_physical_index(V, i0, i1, i2, i3, 0, 0), ref[i], 1e-6f);
+        mag_tensor_decref(R);
+        mag_tensor_decref(V);
+    }
+    mag_tensor_decref(B);
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}
+
+
+TEST(compute_cpu, unary_simd_ranges) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    constexpr std::int64_t numel = 4099; // Full vectors of every ISA plus a scalar tail
+    mag_tensor_t* X = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, numel);
+    mag_tensor_fill_random_uniform(X, -100.0f, 100.0f);
+    auto* x = static_cast<float*>(mag_tensor_data_ptr(X));
+    x[0] = 0.0f; x[1] = -0.0f; x[2] = 1e30f; x[3] = -1e-40f; x[4] = std::numeric_limits<float>::infinity();
+    mag_tensor_t* S = mag_sin(X);
+    mag_tensor_t* C = mag_cos(X);
+    mag_tensor_t* N = mag_neg(X);
+    mag_tensor_t* T = mag_step(X);
+    const auto* s = static_cast<const float*>(mag_tensor_data_ptr(S));
+    const auto* c = static_cast<const float*>(mag_tensor_data_ptr(C));
+    const auto* n = static_cast<const float*>(mag_tensor_data_ptr(N));
+    const auto* t = static_cast<const float*>(mag_tensor_data_ptr(T));
+    for (std::int64_t i=0; i < numel; ++i) {
+        if (std::isnan(std::sin(x[i]))) {
+            ASSERT_TRUE(std::isnan(s[i]));
+            ASSERT_TRUE(std::isnan(c[i]));
+        } else {
+            ASSERT_NEAR(s[i], std::sin(x[i]), 1e-6f);
+            ASSERT_NEAR(c[i], std::cos(x[i]), 1e-6f);
+        }
+        ASSERT_EQ(std::signbit(n[i]), !std::signbit(x[i]));
+        ASSERT_EQ(t[i], x[i] >= 0.0f ? 1.0f : 0.0f);
+    }
+    for (std::int64_t i=0; i < numel; ++i) x[i] = std::abs(x[i])*(i&1 ? 1e-30f : 1e3f); // Tiny, subnormal and large inputs
+    x[0] = 0.0f; x[1] = -1.0f; x[2] = std::numeric_limits<float>::infinity(); x[3] = 1e-42f; x[4] = std::numeric_limits<float>::max();
+    mag_tensor_t* L = mag_log(X);
+    const auto* l = static_cast<const float*>(mag_tensor_data_ptr(L));
+    ASSERT_EQ(l[0], -std::numeric_limits<float>::infinity());
+    ASSERT_TRUE(std::isnan(l[1]));
+    ASSERT_EQ(l[2], std::numeric_limits<float>::infinity());
+    for (std::int64_t i=3; i < numel; ++i) {
+        ASSERT_NEAR(l[i], std::log(x[i]), 1e-5f*std::max(1.0f, std::abs(std::log(x[i]))));
+    }
+    mag_tensor_decref(L);
+    mag_tensor_decref(T);
+    mag_tensor_decref(N);
+    mag_tensor_decref(C);
+    mag_tensor_decref(S);
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, binary_broadcast_shapes) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    constexpr std::int64_t xd[4] = {300, 5, 4, 60};
+    constexpr std::int64_t yds[][4] = {
+        {300, 5, 4, 60}, // Same shape
+        {1, 5, 4, 60},   // Scalar splat along the innermost axis
+        {300, 1, 4, 1},  // Contiguous rows, outer repeats
+        {150, 5, 2, 30}, // Tiled: y repeats inside every axis
+        {1, 1, 1, 1}
+    };
+    mag_tensor_t* X = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, xd[0], xd[1], xd[2], xd[3]);
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    const auto* x = static_cast<const float*>(mag_tensor_data_ptr(X));
+    for (const auto& yd : yds) {
+        mag_tensor_t* Y = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, yd[0], yd[1], yd[2], yd[3]);
+        mag_tensor_fill_random_uniform(Y, 0.5f, 2.0f);
+        const auto* y = static_cast<const float*>(mag_tensor_data_ptr(Y));
+        mag_tensor_t* R[2] = {mag_sub(X, Y), mag_div(X, Y)};
+        for (int k=0; k < 2; ++k) {
+            const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R[k]));
+            std::int64_t i = 0;
+            for (std::int64_t i3=0; i3 < xd[3]; ++i3)
+            for (std::int64_t i2=0; i2 < xd[2]; ++i2)
+            for (std::int64_t i1=0; i1 < xd[1]; ++i1)
+            for (std::int64_t i0=0; i0 < xd[0]; ++i0, ++i) {
+                float b = y[i0%yd[0] + yd[0]*(i1%yd[1] + yd[1]*(i2%yd[2] + yd[2]*(i3%yd[3])))];
+                ASSERT_FLOAT_EQ(r[i], k == 0 ? x[i] - b : x[i] / b);
+            }
+            mag_tensor_decref(R[k]);
+        }
+        mag_tensor_decref(Y);
+    }
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(compute_cpu, fused_elementwise) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    mag_tensor_t* X = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, 300, 5, 4, 60);
+    mag_tensor_t* Y = mag_tensor_create_4d(ctx, MAG_DTYPE_F32, 1, 5, 4, 1);
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    mag_tensor_fill_random_uniform(Y, 0.5f, 2.0f);
+    const auto* x = static_cast<const float*>(mag_tensor_data_ptr(X));
+    const auto* y = static_cast<const float*>(mag_tensor_data_ptr(Y));
+    mag_ctx_set_exec_mode(ctx, MAG_EXEC_MODE_DEFERRED);
+    std::vector<mag_tensor_t*> keep {};
+    auto rec = [&](mag_tensor_t* t) { keep.emplace_back(t); return t; };
+
+    // (x - y)^2 * y + 3 with y broadcast along the inner and outer axes
+    mag_tensor_t* R = rec(mag_adds(rec(mag_mul(rec(mag_sqr(rec(mag_sub(X, Y)))), Y)), 3.0f));
+    // Chain longer than MAG_FUSED_MAX_INSTRS, split into several fused kernels
+    mag_tensor_t* L = X;
+    for (int i=0; i < 40; ++i)
+        L = rec(i & 1 ? mag_adds(L, 0.25f) : mag_muls(L, 0.5f));
+    mag_tensor_eval_fused(R);
+    mag_tensor_eval_fused(L);
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    const auto* l = static_cast<const float*>(mag_tensor_data_ptr(L));
+    for (std::int64_t i=0; i < mag_tensor_numel(X); ++i) {
+        float b = y[(i/300)%20];
+        float d = x[i] - b;
+        ASSERT_FLOAT_EQ(r[i], d*d*b + 3.0f);
+        float e = x[i];
+        for (int k=0; k < 40; ++k) e = k & 1 ? e + 0.25f : e * 0.5f;
+        ASSERT_FLOAT_EQ(l[i], e);
+    }
+
+    // Re-evaluating the fused tensor picks up changed leaves
+    mag_tensor_fill(Y, 1.0f);
+    mag_tensor_eval_fused(R);
+    for (std::int64_t i=0; i < mag_tensor_numel(X); ++i)
+        ASSERT_FLOAT_EQ(r[i], (x[i] - 1.0f)*(x[i] - 1.0f) + 3.0f);
+
+    // In-place nodes write their base, they run before the chain reads it
+    mag_tensor_t* Z = rec(mag_tensor_create_1d(ctx, MAG_DTYPE_F32, 100));
+    mag_tensor_fill(Z, 1.0f);
+    mag_tensor_t* N = rec(mag_neg_(Z));
+    mag_tensor_t* S = rec(mag_add(N, Z));
+    mag_tensor_eval_fused(S);
+    const auto* s = static_cast<const float*>(mag_tensor_data_ptr(S));
+    const auto* z = static_cast<const float*>(mag_tensor_data_ptr(Z));
+    for (std::int64_t i=0; i < 100; ++i) {
+        ASSERT_EQ(s[i], -2.0f);
+        ASSERT_EQ(z[i], -1.0f);
+    }
+
+    for (auto it = keep.rbegin(); it != keep.rend(); ++it)
+        mag_tensor_decref(*it);
+    mag_tensor_decref(Y);
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
 TEST(compute_cpu, heavy_compute_single_op) {
     mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
     mag_tensor_t* A = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, 8192, 8192, 3);
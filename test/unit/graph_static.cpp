@@ -3,3 +3,261 @@
 #include "prelude.hpp"
 
 
+
+TEST(graph_static, simple) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+
+    // ((W * X) + B).relu(), with X computed eagerly and an unused branch
+
+    auto* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 2, 2);
+    mag_tensor_fill(W, 0.6f);
+    auto* X0 = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 2, 2);
+    mag_tensor_fill(X0, 2.0f);
+    auto* X = mag_adds(X0, 0.11f);
+    auto* B = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 2, 2);
+    mag_tensor_fill(B, 0.1f);
+
+    mag_ctx_set_exec_mode(ctx, MAG_EXEC_MODE_DEFERRED);
+    auto* WX = mag_mul(W, X);
+    auto* WXB = mag_add(WX, B);
+    auto* R = mag_relu(WXB);
+    auto* unused = mag_sin(WX);
+
+    mag_graph_t* g = mag_graph_compile(&R, 1);
+    ASSERT_EQ(mag_graph_node_count(g), 1); // mul, add and relu fused
+    mag_graph_execute(g);
+    auto* buf = static_cast<const float*>(mag_tensor_data_ptr(R));
+    for (std::int64_t i=0; i < mag_tensor_numel(R); ++i)
+        ASSERT_FLOAT_EQ(buf[i], 0.6f*2.11f + 0.1f);
+
+    mag_tensor_fill(B, -10.0f); // Leaves changed, run again
+    mag_graph_execute(g);
+    for (std::int64_t i=0; i < mag_tensor_numel(R); ++i)
+        ASSERT_EQ(buf[i], 0.0f);
+
+    mag_graph_destroy(g);
+    mag_tensor_decref(unused);
+    mag_tensor_decref(R);
+    mag_tensor_decref(WXB);
+    mag_tensor_decref(WX);
+    mag_tensor_decref(B);
+    mag_tensor_decref(X);
+    mag_tensor_decref(X0);
+    mag_tensor_decref(W);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(graph_static, shared_nodes_and_outputs) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    auto* X = mag_tensor_create_1d(ctx, MAG_DTYPE_F32, 1000);
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    const auto* x = static_cast<const float*>(mag_tensor_data_ptr(X));
+
+    mag_ctx_set_exec_mode(ctx, MAG_EXEC_MODE_DEFERRED);
+    std::vector<mag_tensor_t*> keep {};
+    auto rec = [&](mag_tensor_t* t) { keep.emplace_back(t); return t; };
+    // Deep chain, the walk must not recurse
+    mag_tensor_t* A = X;
+    for (int i=0; i < 20000; ++i)
+        A = rec(mag_adds(A, 1.0f));
+    mag_tensor_t* S = rec(mag_sqr(A)); // Diamond: A feeds both branches
+    mag_tensor_t* D = rec(mag_sub(S, A));
+    mag_tensor_t* outs[3] = {D, S, D};
+    mag_graph_t* g = mag_graph_compile(outs, 3);
+    ASSERT_EQ(mag_graph_node_count(g), 20000/32 + 2); // The chain is fused in pieces of MAG_FUSED_MAX_INSTRS, A is read twice
+    mag_graph_execute(g);
+    const auto* d = static_cast<const float*>(mag_tensor_data_ptr(D));
+    const auto* s = static_cast<const float*>(mag_tensor_data_ptr(S));
+    for (std::int64_t i=0; i < mag_tensor_numel(X); ++i) {
+        float a = x[i];
+        for (int k=0; k < 20000; ++k) a += 1.0f;
+        ASSERT_FLOAT_EQ(s[i], a*a);
+        ASSERT_FLOAT_EQ(d[i], a*a - a);
+    }
+
+    mag_graph_destroy(g);
+    for (auto it = keep.rbegin(); it != keep.rend(); ++it)
+        mag_tensor_decref(*it);
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(graph_static, fused_chains) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    auto* X = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 64, 32);
+    auto* Y = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 64, 32);
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    mag_tensor_fill_random_uniform(Y, -1.0f, 1.0f);
+    const auto* x = static_cast<const float*>(mag_tensor_data_ptr(X));
+    const auto* y = static_cast<const float*>(mag_tensor_data_ptr(Y));
+
+    mag_ctx_set_exec_mode(ctx, MAG_EXEC_MODE_DEFERRED);
+    // Mean squared error: (x - y).sqr_().mean(), the in-place square is the root of the fused chain
+    auto* D = mag_sub(X, Y);
+    auto* S = mag_sqr_(D);
+    auto* M = mag_mean(S);
+    // E is read by two nodes and computed on its own
+    auto* E = mag_abs(X);
+    auto* E2 = mag_muls(E, 2.0f);
+    auto* F = mag_add(E2, E);
+    mag_tensor_t* outs[2] = {M, F};
+    mag_graph_t* g = mag_graph_compile(outs, 2);
+    ASSERT_EQ(mag_graph_node_count(g), 4);
+    mag_graph_execute(g);
+    double mse = 0.0;
+    for (std::int64_t i=0; i < 64*32; ++i) mse += (x[i] - y[i])*(x[i] - y[i]);
+    ASSERT_NEAR(*static_cast<const float*>(mag_tensor_data_ptr(M)), mse/(64*32), 1e-5);
+    const auto* f = static_cast<const float*>(mag_tensor_data_ptr(F));
+    for (std::int64_t i=0; i < 64*32; ++i)
+        ASSERT_FLOAT_EQ(f[i], 3.0f*std::abs(x[i]));
+
+    mag_graph_destroy(g);
+    mag_tensor_decref(F);
+    mag_tensor_decref(E2);
+    mag_tensor_decref(E);
+    mag_tensor_decref(M);
+    mag_tensor_decref(S);
+    mag_tensor_decref(D);
+    mag_tensor_decref(Y);
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(graph_static, memory_plan_mlp) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t B = 64, D = 128;
+    static constexpr int layers = 8;
+    mag_tensor_t* X = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, B, D);
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    mag_tensor_t* W[layers];
+    mag_tensor_t* b[layers];
+    for (int l=0; l < layers; ++l) {
+        W[l] = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, D, D);
+        mag_tensor_fill_random_uniform(W[l], -0.15f, 0.15f);
+        b[l] = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, D);
+        mag_tensor_fill_random_uniform(b[l], -0.1f, 0.1f);
+    }
+    std::vector<mag_tensor_t*> keep {};
+    auto rec = [&](mag_tensor_t* t) { keep.emplace_back(t); return t; };
+    auto mlp = [&] {
+        mag_tensor_t* H = X;
+        for (int l=0; l < layers; ++l)
+            H = rec(mag_relu(rec(mag_add(rec(mag_matmul(H, W[l])), b[l]))));
+        return H;
+    };
+    mag_tensor_t* ref = mlp(); // Eager reference
+    mag_ctx_set_exec_mode(ctx, MAG_EXEC_MODE_DEFERRED);
+    mag_tensor_t* R = mlp();
+    mag_graph_t* g = mag_graph_compile(&R, 1);
+    ASSERT_EQ(mag_graph_node_count(g), 2*layers); // Bias and relu fused
+    // matmul needs its input alive next to its result, so does the fused bias and relu: two buffers instead of one per intermediate
+    std::size_t planned = mag_graph_plan_memory(g);
+    ASSERT_EQ(planned, 2*B*D*sizeof(float));
+    ASSERT_EQ(mag_graph_plan_memory(g), planned);
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    const auto* rr = static_cast<const float*>(mag_tensor_data_ptr(ref));
+    for (int run=0; run < 2; ++run) {
+        mag_graph_execute(g);
+        for (std::int64_t i=0; i < B*D; ++i)
+            ASSERT_FLOAT_EQ(r[i], rr[i]);
+    }
+
+    mag_graph_destroy(g);
+    mag_tensor_t* Z = keep[3*layers]; // First deferred matmul, a planned intermediate
+    ASSERT_EQ(mag_tensor_data_ptr(Z), nullptr); // Detached from the freed arena
+    ASSERT_EQ(mag_tensor_data_ptr(R), r); // The output keeps its own buffer
+    for (auto it = keep.rbegin(); it != keep.rend(); ++it)
+        mag_tensor_decref(*it);
+    for (int l=0; l < layers; ++l) {
+        mag_tensor_decref(W[l]);
+        mag_tensor_decref(b[l]);
+    }
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(graph_static, capture_replay) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+    static constexpr std::int64_t B = 16, D = 96;
+    mag_tensor_t* X = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, B, D);
+    mag_tensor_t* W = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, D, D);
+    mag_tensor_fill_random_uniform(W, -0.2f, 0.2f);
+    mag_tensor_t* b = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 1, D);
+    mag_tensor_fill_random_uniform(b, -0.1f, 0.1f);
+    auto forward = [&] { // Intermediates are released right away, like in a serving loop
+        mag_tensor_t* Z = mag_matmul(X, W);
+        mag_tensor_t* Zb = mag_add(Z, b);
+        mag_tensor_decref(Z);
+        mag_tensor_t* H = mag_tanh(Zb);
+        mag_tensor_decref(Zb);
+        mag_tensor_t* R = mag_muls(H, 2.0f);
+        mag_tensor_decref(H);
+        return R;
+    };
+
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    mag_ctx_capture_begin(ctx);
+    mag_tensor_t* R = forward();
+    mag_graph_t* g = mag_ctx_capture_end(ctx);
+    ASSERT_EQ(mag_graph_node_count(g), 4);
+    const auto* r = static_cast<const float*>(mag_tensor_data_ptr(R));
+    for (int run=0; run < 3; ++run) {
+        mag_tensor_fill_random_uniform(X, -1.0f, 1.0f); // New input data, same buffer
+        mag_graph_execute(g);
+        mag_tensor_t* ref = forward();
+        const auto* rr = static_cast<const float*>(mag_tensor_data_ptr(ref));
+        for (std::int64_t i=0; i < B*D; ++i)
+            ASSERT_FLOAT_EQ(r[i], rr[i]);
+        mag_tensor_decref(ref);
+    }
+
+    mag_tensor_decref(R);
+    mag_graph_destroy(g);
+    mag_tensor_decref(b);
+    mag_tensor_decref(W);
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
+
+TEST(graph_static, capture_replay_multithreaded) { // Above the intra-op thresholds, so replay splits every node across workers
+    mag_device_descriptor_t desc = {.type = MAG_COMPUTE_DEVICE_TYPE_CPU, .thread_count = 4};
+    mag_ctx_t* ctx = mag_ctx_create2(&desc);
+    static constexpr std::int64_t B = 512, D = 768;
+    mag_tensor_t* X = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, B, D);
+    auto forward = [&](mag_tensor_t** S) {
+        mag_tensor_t* Xs = mag_muls(X, 0.5f);
+        mag_tensor_t* H = mag_tanh(Xs);
+        mag_tensor_decref(Xs);
+        mag_tensor_t* C = mag_cumsum(H, 0);
+        mag_tensor_decref(H);
+        *S = mag_sum(C);
+        return C;
+    };
+
+    mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+    mag_ctx_capture_begin(ctx);
+    mag_tensor_t* S = nullptr;
+    mag_tensor_t* C = forward(&S);
+    mag_graph_t* g = mag_ctx_capture_end(ctx);
+    ASSERT_EQ(mag_graph_node_count(g), 4);
+    const auto* c = static_cast<const float*>(mag_tensor_data_ptr(C));
+    const auto* s = static_cast<const float*>(mag_tensor_data_ptr(S));
+    for (int run=0; run < 3; ++run) {
+        mag_tensor_fill_random_uniform(X, -1.0f, 1.0f);
+        mag_graph_execute(g);
+        mag_tensor_t* ref_s = nullptr;
+        mag_tensor_t* ref_c = forward(&ref_s);
+        const auto* rc = static_cast<const float*>(mag_tensor_data_ptr(ref_c));
+        for (std::int64_t i=0; i < B*D; ++i)
+            ASSERT_FLOAT_EQ(c[i], rc[i]);
+        ASSERT_FLOAT_EQ(*s, *static_cast<const float*>(mag_tensor_data_ptr(ref_s))); // Same partial combine for the same worker count
+        mag_tensor_decref(ref_s);
+        mag_tensor_decref(ref_c);
+    }
+
+    mag_tensor_decref(S);
+    mag_tensor_decref(C);
+    mag_graph_destroy(g);
+    mag_tensor_decref(X);
+    mag_ctx_destroy(ctx);
+}
@@ -52,3 +52,107 @@ TEST(storage, load_store_image) {
     mag_ctx_destroy(ctx);
     ASSERT_TRUE(std::filesystem::remove("test_data/car.magnetron"));
 }
+
+TEST(storage, load_store_f16) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+
+    mag_tensor_t* A = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, 10, 7, 3);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* H = mag_cast(A, MAG_DTYPE_F16);
+
+    if (std::filesystem::exists("test_data/test_f16.magnetron"))
+        std::filesystem::remove("test_data/test_f16.magnetron");
+    mag_tensor_save(H, "test_data/test_f16.magnetron");
+    ASSERT_TRUE(std::filesystem::exists("test_data/test_f16.magnetron"));
+    ASSERT_LT(std::filesystem::file_size("test_data/test_f16.magnetron"), 10 * 7 * 3 * sizeof(float));
+    mag_tensor_t* B = mag_tensor_load(ctx, "test_data/test_f16.magnetron");
+    ASSERT_EQ(mag_tensor_dtype(B), MAG_DTYPE_F16);
+    ASSERT_EQ(mag_tensor_rank(B), 3);
+    ASSERT_EQ(mag_tensor_data_size(B), 10 * 7 * 3 * sizeof(std::uint16_t));
+    ASSERT_EQ(std::memcmp(mag_tensor_data_ptr(H), mag_tensor_data_ptr(B), mag_tensor_data_size(B)), 0);
+
+    mag_tensor_decref(A);
+    mag_tensor_decref(H);
+    mag_tensor_decref(B);
+    mag_ctx_destroy(ctx);
+    ASSERT_TRUE(std::filesystem::remove("test_data/test_f16.magnetron"));
+}
+
+TEST(storage, load_store_f16_odd_numel) { /* 9 halves leave the data record unaligned */
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 3, 3);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* H = mag_cast(A, MAG_DTYPE_F16);
+
+    if (std::filesystem::exists("test_data/test_f16_odd.magnetron"))
+        std::filesystem::remove("test_data/test_f16_odd.magnetron");
+    mag_tensor_save(H, "test_data/test_f16_odd.magnetron");
+    ASSERT_TRUE(std::filesystem::exists("test_data/test_f16_odd.magnetron"));
+    ASSERT_EQ(std::filesystem::file_size("test_data/test_f16_odd.magnetron") & 3, 0);
+    mag_tensor_t* B = mag_tensor_load(ctx, "test_data/test_f16_odd.magnetron");
+    ASSERT_EQ(mag_tensor_dtype(B), MAG_DTYPE_F16);
+    ASSERT_EQ(mag_tensor_rank(B), 2);
+    ASSERT_EQ(mag_tensor_data_size(B), 3 * 3 * sizeof(std::uint16_t));
+    ASSERT_EQ(std::memcmp(mag_tensor_data_ptr(H), mag_tensor_data_ptr(B), mag_tensor_data_size(B)), 0);
+
+    mag_tensor_decref(A);
+    mag_tensor_decref(H);
+    mag_tensor_decref(B);
+    mag_ctx_destroy(ctx);
+    ASSERT_TRUE(std::filesystem::remove("test_data/test_f16_odd.magnetron"));
+}
+
+TEST(storage, load_store_q4) {
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+
+    mag_tensor_t* A = mag_tensor_create_3d(ctx, MAG_DTYPE_F32, 10, 64, 3);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    mag_tensor_t* Q = mag_cast(A, MAG_DTYPE_Q4);
+
+    if (std::filesystem::exists("test_data/test_q4.magnetron"))
+        std::filesystem::remove("test_data/test_q4.magnetron");
+    mag_tensor_save(Q, "test_data/test_q4.magnetron");
+    ASSERT_TRUE(std::filesystem::exists("test_data/test_q4.magnetron"));
+    ASSERT_LT(std::filesystem::file_size("test_data/test_q4.magnetron"), 10 * 64 * 3 * sizeof(float) / 4);
+    mag_tensor_t* B = mag_tensor_load(ctx, "test_data/test_q4.magnetron");
+    ASSERT_EQ(mag_tensor_dtype(B), MAG_DTYPE_Q4);
+    ASSERT_EQ(mag_tensor_rank(B), 3);
+    ASSERT_EQ(mag_tensor_data_size(B), 10 * 64 * 3 / MAG_QK * sizeof(std::uint16_t) + 10 * 64 * 3 / 2);
+    ASSERT_EQ(std::memcmp(mag_tensor_data_ptr(Q), mag_tensor_data_ptr(B), mag_tensor_data_size(B)), 0);
+
+    mag_tensor_decref(A);
+    mag_tensor_decref(Q);
+    mag_tensor_decref(B);
+    mag_ctx_destroy(ctx);
+    ASSERT_TRUE(std::filesystem::remove("test_data/test_q4.magnetron"));
+}
+
+TEST(storage, load_store_q_odd_blocks) { /* Q8 (34 byte) and Q4 (18 byte) blocks leave odd block counts unaligned */
+    mag_ctx_t* ctx = mag_ctx_create(MAG_COMPUTE_DEVICE_TYPE_CPU);
+
+    mag_tensor_t* A = mag_tensor_create_2d(ctx, MAG_DTYPE_F32, 3, MAG_QK);
+    mag_tensor_fill_random_uniform(A, -1.0f, 1.0f);
+    for (mag_dtype_t dt : {MAG_DTYPE_Q8, MAG_DTYPE_Q4}) {
+        mag_tensor_t* Q = mag_cast(A, dt);
+        ASSERT_NE(mag_tensor_data_size(Q) & 3, 0);
+
+        if (std::filesystem::exists("test_data/test_q_odd.magnetron"))
+            std::filesystem::remove("test_data/test_q_odd.magnetron");
+        mag_tensor_save(Q, "test_data/test_q_odd.magnetron");
+        ASSERT_TRUE(std::filesystem::exists("test_data/test_q_odd.magnetron"));
+        ASSERT_EQ(std::filesystem::file_size("test_data/test_q_odd.magnetron") & 3, 0);
+        mag_tensor_t* B = mag_tensor_load(ctx, "test_data/test_q_odd.magnetron");
+        ASSERT_EQ(mag_tensor_dtype(B), dt);
+        ASSERT_EQ(mag_tensor_rank(B), 2);
+        ASSERT_EQ(mag_tensor_data_size(B), mag_tensor_data_size(Q));
+        ASSERT_EQ(std::memcmp(mag_tensor_data_ptr(Q), mag_tensor_data_ptr(B), mag_tensor_data_size(B)), 0);
+
+        mag_tensor_decref(Q);
+        mag_tensor_decref(B);
+        ASSERT_TRUE(std::filesystem::remove("test_data/test_q_odd.magnetron"));
+    }
+
+    mag_tensor_decref(A);
+    mag_ctx_destroy(ctx);
+}